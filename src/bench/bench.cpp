@@ -0,0 +1,177 @@
+//@	{"target":{"name":"bench.o"}}
+
+#include "./bench.hpp"
+
+#include "src/os_services/fs/file.hpp"
+#include "src/os_services/io/io.hpp"
+
+#include <jopp/serializer.hpp>
+#include <jopp/types.hpp>
+
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+	struct registered_benchmark
+	{
+		char const* name;
+		Pipe::bench::benchmark_function func;
+	};
+
+	std::vector<registered_benchmark>& benchmarks()
+	{
+		static std::vector<registered_benchmark> ret;
+		return ret;
+	}
+
+	struct command_line
+	{
+		std::optional<std::filesystem::path> output;
+		std::string_view filter;
+		Pipe::bench::run_config cfg;
+	};
+
+	command_line parse_command_line(std::span<char const* const> args)
+	{
+		command_line ret;
+		for(std::string_view arg : args)
+		{
+			if(arg.starts_with("--output="))
+			{ ret.output = arg.substr(std::size(std::string_view{"--output="})); }
+			else
+			if(arg.starts_with("--filter="))
+			{ ret.filter = arg.substr(std::size(std::string_view{"--filter="})); }
+			else
+			if(arg.starts_with("--min-time-ms="))
+			{
+				auto const value = arg.substr(std::size(std::string_view{"--min-time-ms="}));
+				unsigned int ms{};
+				auto const res = std::from_chars(std::data(value), std::data(value) + std::size(value), ms);
+				if(res.ec != std::errc{} || res.ptr != std::data(value) + std::size(value))
+				{ throw std::runtime_error{std::format("Invalid min time `{}`", value)}; }
+				ret.cfg.min_time = std::chrono::milliseconds{ms};
+			}
+			else
+			{ throw std::runtime_error{std::format("Unknown option `{}`", arg)}; }
+		}
+		return ret;
+	}
+
+	double per_second(uint64_t count, Pipe::bench::clock::duration elapsed)
+	{ return static_cast<double>(count)/std::chrono::duration<double>(elapsed).count(); }
+
+	jopp::object to_jopp_object(Pipe::bench::measurement const& item)
+	{
+		jopp::object parameters;
+		for(auto const& param : item.parameters)
+		{ parameters.insert(param.name, static_cast<jopp::number>(param.value)); }
+
+		auto const elapsed_ns = static_cast<double>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(item.elapsed).count()
+		);
+
+		jopp::object ret;
+		ret.insert("name", item.name);
+		ret.insert("parameters", std::move(parameters));
+		ret.insert("iterations", static_cast<jopp::number>(item.iterations));
+		ret.insert("elapsed_ns", elapsed_ns);
+		ret.insert("ns_per_iteration", elapsed_ns/static_cast<double>(item.iterations));
+		ret.insert("items", static_cast<jopp::number>(item.work.items));
+		ret.insert("items_per_second", per_second(item.work.items, item.elapsed));
+		ret.insert("bytes", static_cast<jopp::number>(item.work.bytes));
+		ret.insert("bytes_per_second", per_second(item.work.bytes, item.elapsed));
+		return ret;
+	}
+
+	void write(jopp::object const& obj, Pipe::os_services::io::output_file_descriptor_ref output)
+	{
+		jopp::serializer serializer{obj};
+		std::array<char, 65536> buffer;
+		std::span<char> const buffer_range{buffer};
+		while(true)
+		{
+			auto const serialize_result = serializer.serialize(buffer_range);
+			std::span data_to_write(std::begin(buffer_range), serialize_result.ptr);
+			while(std::size(data_to_write) != 0)
+			{
+				auto const write_result = Pipe::os_services::io::write(output, std::as_bytes(data_to_write));
+				data_to_write = data_to_write.subspan(write_result.bytes_transferred());
+			}
+			if(serialize_result.ec == jopp::serializer_error_code::completed)
+			{ return; }
+		}
+	}
+}
+
+Pipe::bench::measurement const& Pipe::bench::run_context::add(measurement&& item)
+{
+	std::string params;
+	for(auto const& param : item.parameters)
+	{ params.append(std::format(" {}={}", param.name, param.value)); }
+	fprintf(
+		stderr,
+		"%s%s: %.1f ns/iteration, %.0f items/s\n",
+		item.name.c_str(),
+		params.c_str(),
+		static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(item.elapsed).count())
+			/static_cast<double>(item.iterations),
+		per_second(item.work.items, item.elapsed)
+	);
+	return m_measurements.emplace_back(std::move(item));
+}
+
+Pipe::bench::registration::registration(char const* name, benchmark_function func)
+{ benchmarks().push_back(registered_benchmark{name, func}); }
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		auto const cmdline = parse_command_line(std::span{argv + 1, static_cast<size_t>(argc - 1)});
+		auto const started_at = std::chrono::system_clock::now();
+
+		Pipe::bench::run_context context{cmdline.cfg};
+		for(auto const& item : benchmarks())
+		{
+			if(std::string_view{item.name}.find(cmdline.filter) == std::string_view::npos)
+			{ continue; }
+			item.func(context);
+		}
+
+		jopp::array results;
+		for(auto const& item : context.measurements())
+		{ results.push_back(to_jopp_object(item)); }
+
+		jopp::object report;
+		report.insert("executable", std::string{argv[0]});
+		report.insert(
+			"started_at",
+			std::chrono::duration<double>(started_at.time_since_epoch()).count()
+		);
+		report.insert("hardware_concurrency", static_cast<jopp::number>(std::thread::hardware_concurrency()));
+		report.insert("results", std::move(results));
+
+		if(cmdline.output.has_value())
+		{
+			auto const file = Pipe::os_services::fs::replace(*cmdline.output);
+			write(report, file.get());
+		}
+		else
+		{ write(report, Pipe::os_services::io::output_file_descriptor_ref{STDOUT_FILENO}); }
+
+		return 0;
+	}
+	catch(std::exception const& e)
+	{
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
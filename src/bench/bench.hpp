@@ -0,0 +1,179 @@
+//@	{"dependencies_extra":[{"ref":"./bench.o", "rel":"implementation"}]}
+
+#ifndef PIPE_BENCH_HPP
+#define PIPE_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * \brief A minimal benchmark framework
+ *
+ * Each `*.bench.cpp` file is linked into a separate executable, that runs all benchmarks
+ * defined in that file, and writes the results as JSON. The executable accepts the following
+ * options:
+ *
+ * * `--output=<path>` Writes the results to path instead of stdout
+ * * `--filter=<text>` Only runs benchmarks whose name contains text
+ * * `--min-time-ms=<ms>` The min time to spend on each measurement
+ */
+namespace Pipe::bench
+{
+	/**
+	 * \brief The clock used to measure benchmarks
+	 */
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * \brief The amount of work performed during a measurement
+	 */
+	struct work_done
+	{
+		/**
+		 * \brief The number of items processed, such as messages or dispatched events
+		 */
+		uint64_t items{0};
+
+		/**
+		 * \brief The number of bytes processed
+		 */
+		uint64_t bytes{0};
+	};
+
+	/**
+	 * \brief A named parameter of a measurement, such as a chunk size or a thread count
+	 */
+	struct parameter
+	{
+		std::string name;
+		int64_t value;
+	};
+
+	/**
+	 * \brief The result of measuring a benchmark with a specific set of parameters
+	 */
+	struct measurement
+	{
+		std::string name;
+		std::vector<parameter> parameters;
+		uint64_t iterations;
+		clock::duration elapsed;
+		work_done work;
+	};
+
+	/**
+	 * \brief Controls how long each measurement runs
+	 */
+	struct run_config
+	{
+		/**
+		 * \brief The min time to spend on each measurement
+		 */
+		clock::duration min_time{std::chrono::milliseconds{500}};
+
+		/**
+		 * \brief The max number of iterations for each measurement
+		 */
+		uint64_t max_iterations{uint64_t{1} << 32};
+	};
+
+	/**
+	 * \brief Collects the measurements made by benchmarks
+	 */
+	class run_context
+	{
+	public:
+		explicit run_context(run_config const& cfg):
+			m_cfg{cfg}
+		{}
+
+		/**
+		 * \brief Measures func
+		 *
+		 * func is called with the number of iterations to run, and should return the work it
+		 * has done. The number of iterations is increased until a call to func takes at least
+		 * run_config::min_time.
+		 *
+		 * \param name The name of the measurement
+		 * \param parameters The parameters used by func
+		 * \param func The function to measure
+		 */
+		template<class Func>
+		requires(std::is_invocable_r_v<work_done, Func, uint64_t>)
+		measurement const& measure(std::string_view name, std::vector<parameter> parameters, Func&& func)
+		{
+			uint64_t iterations = 1;
+			while(true)
+			{
+				auto const start = clock::now();
+				auto const work = func(iterations);
+				auto const elapsed = clock::now() - start;
+				if(elapsed >= m_cfg.min_time || iterations >= m_cfg.max_iterations)
+				{
+					return add(measurement{
+						.name = std::string{name},
+						.parameters = std::move(parameters),
+						.iterations = iterations,
+						.elapsed = elapsed,
+						.work = work
+					});
+				}
+				iterations = next_iteration_count(iterations, elapsed);
+			}
+		}
+
+		/**
+		 * \brief Returns all measurements made so far
+		 */
+		std::span<measurement const> measurements() const noexcept
+		{ return m_measurements; }
+
+	private:
+		uint64_t next_iteration_count(uint64_t iterations, clock::duration elapsed) const noexcept
+		{
+			// Aim slightly above min_time, but do not grow too fast when the timer resolution
+			// dominates the elapsed time
+			auto const ratio = static_cast<double>(m_cfg.min_time.count())
+				/static_cast<double>(std::max(elapsed.count(), clock::duration::rep{1}));
+			auto const factor = std::clamp(1.25*ratio, 2.0, 100.0);
+			return std::min(
+				static_cast<uint64_t>(static_cast<double>(iterations)*factor),
+				m_cfg.max_iterations
+			);
+		}
+
+		measurement const& add(measurement&& item);
+
+		run_config m_cfg;
+		std::vector<measurement> m_measurements;
+	};
+
+	/**
+	 * \brief A function that runs a benchmark
+	 */
+	using benchmark_function = void (*)(run_context&);
+
+	/**
+	 * \brief Registers a benchmark, so it is run by the benchmark executable
+	 */
+	struct registration
+	{
+		explicit registration(char const* name, benchmark_function func);
+	};
+}
+
+/**
+ * \brief Defines a benchmark called name, that receives its run_context in the variable context
+ */
+#define BENCHMARK(name, context) \
+	static void name(Pipe::bench::run_context&); \
+	static Pipe::bench::registration const name##_registration{#name, name}; \
+	static void name(Pipe::bench::run_context& context)
+
+#endif
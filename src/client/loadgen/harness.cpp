@@ -0,0 +1,213 @@
+//@	{"target":{"name":"harness.o"}}
+
+#include "./loadgen.hpp"
+
+#include "src/json_log/writer.hpp"
+#include "src/log/log.hpp"
+#include "src/os_services/ipc/pipe.hpp"
+#include "src/os_services/proc_mgmt/proc_mgmt.hpp"
+
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+	using stream_pipe = Pipe::os_services::ipc::pipe<
+		Pipe::os_services::fd::io_mode::blocking,
+		Pipe::os_services::fd::io_mode::blocking
+	>;
+
+	struct running_client
+	{
+		std::string name;
+		std::pair<pid_t, Pipe::os_services::proc_mgmt::pidfd> process;
+	};
+
+	running_client spawn_client(
+		std::string_view name,
+		std::vector<std::string> const& args,
+		Pipe::os_services::proc_mgmt::io_redirection&& io_redir
+	)
+	{
+		// Clients are expected to be installed next to the harness
+		auto const path = std::filesystem::read_symlink("/proc/self/exe").parent_path()
+			/ std::format("loadgen_{}", name);
+
+		std::vector<char const*> argv;
+		argv.reserve(std::size(args));
+		for(auto const& arg : args)
+		{ argv.push_back(arg.c_str()); }
+
+		return running_client{
+			.name = std::string{name},
+			.process = Pipe::os_services::proc_mgmt::spawn(path.c_str(), argv, {}, io_redir)
+		};
+	}
+
+	std::string read_all(Pipe::os_services::io::input_file_descriptor_ref input)
+	{
+		std::string ret;
+		std::array<char, 4096> buffer;
+		while(true)
+		{
+			auto const res = Pipe::os_services::io::read(input, std::as_writable_bytes(std::span{buffer}));
+			if(res.bytes_transferred() == 0)
+			{ return ret; }
+			ret.append(std::data(buffer), res.bytes_transferred());
+		}
+	}
+
+	/**
+	 * \brief Copies everything from input to all outputs
+	 *
+	 * \note Batches may be split across chunks. This is fine since sinks reassemble the stream.
+	 */
+	void relay(
+		Pipe::os_services::io::input_file_descriptor_ref input,
+		std::span<Pipe::os_services::io::output_file_descriptor const> outputs
+	)
+	{
+		std::vector<std::byte> buffer(65536);
+		while(true)
+		{
+			auto const res = Pipe::os_services::io::read(input, buffer);
+			if(res.bytes_transferred() == 0)
+			{ return; }
+
+			auto const chunk = std::span{buffer}.first(res.bytes_transferred());
+			for(auto const& output : outputs)
+			{ Pipe::loadgen::write_all(output.get(), chunk); }
+		}
+	}
+
+	std::string run_harness(Pipe::loadgen::harness_config const& cfg)
+	{
+		std::vector<running_client> clients;
+		auto const consumer_args = Pipe::loadgen::to_args(
+			Pipe::loadgen::consumer_config{.record_size = cfg.producer.record_size}
+		);
+
+		stream_pipe producer_output;
+		clients.push_back(spawn_client(
+			"producer",
+			Pipe::loadgen::to_args(cfg.producer),
+			Pipe::os_services::proc_mgmt::io_redirection{
+				.sysin = {},
+				.sysout = producer_output.take_write_end(),
+				.syserr = {}
+			}
+		));
+		auto stream = producer_output.take_read_end();
+
+		for(size_t k = 0; k != cfg.stages; ++k)
+		{
+			stream_pipe stage_output;
+			clients.push_back(spawn_client(
+				"passthrough",
+				consumer_args,
+				Pipe::os_services::proc_mgmt::io_redirection{
+					.sysin = std::move(stream),
+					.sysout = stage_output.take_write_end(),
+					.syserr = {}
+				}
+			));
+			stream = stage_output.take_read_end();
+		}
+
+		std::vector<Pipe::os_services::io::output_file_descriptor> sink_inputs;
+		std::vector<Pipe::os_services::io::input_file_descriptor> reports;
+		for(size_t k = 0; k != cfg.fanout; ++k)
+		{
+			stream_pipe report;
+			Pipe::os_services::io::input_file_descriptor sysin;
+			if(cfg.fanout == 1)
+			{ sysin = std::move(stream); }
+			else
+			{
+				stream_pipe sink_input;
+				sysin = sink_input.take_read_end();
+				sink_inputs.push_back(sink_input.take_write_end());
+			}
+
+			clients.push_back(spawn_client(
+				"sink",
+				consumer_args,
+				Pipe::os_services::proc_mgmt::io_redirection{
+					.sysin = std::move(sysin),
+					.sysout = report.take_write_end(),
+					.syserr = {}
+				}
+			));
+			reports.push_back(report.take_read_end());
+		}
+
+		if(!sink_inputs.empty())
+		{
+			relay(stream.get(), sink_inputs);
+			// Closing the inputs signals end of stream to the sinks
+			sink_inputs.clear();
+		}
+
+		// Sink reports are JSON objects, and can be spliced into the output as is
+		std::string sinks;
+		for(auto const& report : reports)
+		{
+			if(!sinks.empty())
+			{ sinks.append(","); }
+			sinks.append(read_all(report.get()));
+		}
+
+		for(auto const& client : clients)
+		{
+			auto const status = wait(client.process.second.get());
+			if(auto const exited = std::get_if<Pipe::os_services::proc_mgmt::process_exited>(&status);
+				exited == nullptr || exited->return_value != 0)
+			{ throw std::runtime_error{std::format("Load generator {} failed", client.name)}; }
+		}
+
+		return std::format(
+			R"({{"stages":{},"fanout":{},"record_size":{},"record_count":{},"rate":{},"sinks":[{}]}})",
+			cfg.stages,
+			cfg.fanout,
+			cfg.producer.record_size,
+			cfg.producer.record_count,
+			cfg.producer.rate,
+			sinks
+		);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::chrono::system_clock std_system_clock;
+	Pipe::json_log::writer log_writer;
+
+	Pipe::log::context log_ctxt{
+		Pipe::log::configuration{
+			.writer = std::ref(log_writer),
+			.timestamp_generator = std::ref(std_system_clock)
+		}
+	};
+
+	try
+	{
+		auto const cfg = Pipe::loadgen::make_harness_config(std::span{argv + 1, static_cast<size_t>(argc - 1)});
+		if(!cfg.has_value())
+		{ throw std::runtime_error{std::format("Invalid command line: {}", cfg.error())}; }
+
+		auto const result = run_harness(*cfg);
+		Pipe::loadgen::write_all(
+			Pipe::os_services::io::output_file_descriptor_ref{STDOUT_FILENO},
+			std::as_bytes(std::span{result})
+		);
+	}
+	catch(std::exception const& err)
+	{
+		write_message(Pipe::log::item::severity::error, err.what());
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,522 @@
+#ifndef PIPE_CLIENT_LOADGEN_LOADGEN_HPP
+#define PIPE_CLIENT_LOADGEN_LOADGEN_HPP
+
+#include "src/client_ctl/record_framing.hpp"
+#include "src/os_services/io/io.hpp"
+#include "src/utils/histogram.hpp"
+
+#include <jopp/types.hpp>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Synthetic clients used to measure the throughput and latency of pipelines
+ *
+ * A producer writes timestamped records to stdout, pass-through stages copy records from stdin
+ * to stdout, and a sink measures the end-to-end latency of the records it reads from stdin.
+ * Records are sent in batches, encoded by client_ctl::record_batch_writer.
+ */
+namespace Pipe::loadgen
+{
+	/**
+	 * \brief The clock used to timestamp records
+	 *
+	 * The clock is CLOCK_MONOTONIC, so timestamps can be compared between processes on the same
+	 * machine.
+	 */
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * \brief The fields at the start of each record: a sequence number, and the time the record
+	 *        was produced, in nanoseconds
+	 *
+	 * The rest of the record is payload.
+	 */
+	using record_header = client_ctl::record_layout<uint64_t, uint64_t>;
+
+	/**
+	 * \brief Converts t to a timestamp, as stored in a record
+	 */
+	inline uint64_t to_timestamp(clock::time_point t) noexcept
+	{
+		return static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count()
+		);
+	}
+
+	/**
+	 * \brief Returns the current time, as stored in a record
+	 */
+	inline uint64_t timestamp_now() noexcept
+	{ return to_timestamp(clock::now()); }
+
+	/**
+	 * \brief Controls the time between two records
+	 */
+	enum class arrival_distribution
+	{
+		/**
+		 * \brief Records are produced at a fixed interval
+		 */
+		constant,
+
+		/**
+		 * \brief Records are produced by a Poisson process, so the time between two records is
+		 *        exponentially distributed
+		 */
+		poisson
+	};
+
+	/**
+	 * \brief Converts an arrival_distribution to a string
+	 */
+	constexpr char const* to_string(arrival_distribution value) noexcept
+	{
+		switch(value)
+		{
+			case arrival_distribution::constant:
+				return "constant";
+			case arrival_distribution::poisson:
+				return "poisson";
+		}
+		return "unknown";
+	}
+
+	/**
+	 * \brief Converts a string to an arrival_distribution
+	 */
+	inline std::expected<arrival_distribution, char const*> make_arrival_distribution(std::string_view str)
+	{
+		if(str == "constant")
+		{ return arrival_distribution::constant; }
+		if(str == "poisson")
+		{ return arrival_distribution::poisson; }
+		return std::unexpected("Unknown arrival distribution");
+	}
+
+	/**
+	 * \brief Configuration of a producer
+	 */
+	struct producer_config
+	{
+		/**
+		 * \brief The number of records to produce per second, or 0 to produce records as fast as
+		 *        possible
+		 */
+		double rate{0.0};
+
+		/**
+		 * \brief The size of each record, including the record_header
+		 *
+		 * \note All records have the same size, since client_ctl::record_batch_writer only
+		 *       encodes records of a fixed size, and consumers reject batches of any other size.
+		 *       To measure a mix of sizes, run one load test per size.
+		 */
+		size_t record_size{64};
+
+		/**
+		 * \brief The total number of records to produce
+		 */
+		uint64_t record_count{100000};
+
+		/**
+		 * \brief The max number of records in a batch
+		 */
+		size_t batch_size{64};
+
+		/**
+		 * \brief The distribution of the time between two records
+		 */
+		arrival_distribution distribution{arrival_distribution::constant};
+
+		/**
+		 * \brief Seed used for random arrival times
+		 */
+		uint64_t seed{0};
+	};
+
+	/**
+	 * \brief Configuration of a pass-through stage, or a sink
+	 */
+	struct consumer_config
+	{
+		/**
+		 * \brief The expected size of each record
+		 */
+		size_t record_size{64};
+	};
+
+	/**
+	 * \brief Splits an argument on the form `--key=value`
+	 */
+	inline std::expected<std::pair<std::string_view, std::string_view>, char const*>
+	split_option(std::string_view arg)
+	{
+		if(!arg.starts_with("--"))
+		{ return std::unexpected("Options must start with --"); }
+
+		arg.remove_prefix(2);
+		auto const separator = arg.find('=');
+		if(separator == std::string_view::npos)
+		{ return std::unexpected("Options must have the form --key=value"); }
+
+		return std::pair{arg.substr(0, separator), arg.substr(separator + 1)};
+	}
+
+	/**
+	 * \brief Converts str to a number
+	 */
+	template<class T>
+	std::expected<T, char const*> parse_number(std::string_view str)
+	{
+		T ret{};
+		auto const res = std::from_chars(std::data(str), std::data(str) + std::size(str), ret);
+		if(res.ec != std::errc{} || res.ptr != std::data(str) + std::size(str))
+		{ return std::unexpected("Expected a number"); }
+		return ret;
+	}
+
+	/**
+	 * \brief Updates cfg from the option key, with the given value
+	 * \return true if key is an option of a producer
+	 */
+	inline std::expected<bool, char const*> set_option(producer_config& cfg, std::string_view key, std::string_view value)
+	{
+		auto const assign = [](auto& field, auto const& parsed) -> std::expected<bool, char const*> {
+			if(!parsed.has_value())
+			{ return std::unexpected(parsed.error()); }
+			field = *parsed;
+			return true;
+		};
+
+		if(key == "rate")
+		{ return assign(cfg.rate, parse_number<double>(value)); }
+		if(key == "record-size")
+		{ return assign(cfg.record_size, parse_number<size_t>(value)); }
+		if(key == "count")
+		{ return assign(cfg.record_count, parse_number<uint64_t>(value)); }
+		if(key == "batch-size")
+		{ return assign(cfg.batch_size, parse_number<size_t>(value)); }
+		if(key == "distribution")
+		{ return assign(cfg.distribution, make_arrival_distribution(value)); }
+		if(key == "seed")
+		{ return assign(cfg.seed, parse_number<uint64_t>(value)); }
+		return false;
+	}
+
+	/**
+	 * \brief Checks that the values of cfg can be used by a producer
+	 */
+	inline std::expected<producer_config, char const*> validate(producer_config const& cfg)
+	{
+		if(cfg.record_size < record_header::size)
+		{ return std::unexpected("Record size must be at least 16 bytes"); }
+		if(cfg.batch_size == 0)
+		{ return std::unexpected("Batch size must be at least 1"); }
+		if(cfg.rate < 0.0)
+		{ return std::unexpected("Rate must not be negative"); }
+		return cfg;
+	}
+
+	/**
+	 * \brief Creates a producer_config from command line arguments on the form `--key=value`
+	 *
+	 * Valid keys are `rate`, `record-size`, `count`, `batch-size`, `distribution`, and `seed`.
+	 */
+	inline std::expected<producer_config, char const*> make_producer_config(std::span<char const* const> args)
+	{
+		producer_config ret;
+		for(std::string_view arg : args)
+		{
+			auto const option = split_option(arg);
+			if(!option.has_value())
+			{ return std::unexpected(option.error()); }
+
+			auto const res = set_option(ret, option->first, option->second);
+			if(!res.has_value())
+			{ return std::unexpected(res.error()); }
+			if(!*res)
+			{ return std::unexpected("Unknown option"); }
+		}
+		return validate(ret);
+	}
+
+	/**
+	 * \brief Converts cfg to command line arguments accepted by make_producer_config
+	 */
+	inline std::vector<std::string> to_args(producer_config const& cfg)
+	{
+		return std::vector<std::string>{
+			std::format("--rate={}", cfg.rate),
+			std::format("--record-size={}", cfg.record_size),
+			std::format("--count={}", cfg.record_count),
+			std::format("--batch-size={}", cfg.batch_size),
+			std::format("--distribution={}", to_string(cfg.distribution)),
+			std::format("--seed={}", cfg.seed)
+		};
+	}
+
+	/**
+	 * \brief Creates a consumer_config from command line arguments on the form `--key=value`
+	 *
+	 * The only valid key is `record-size`.
+	 */
+	inline std::expected<consumer_config, char const*> make_consumer_config(std::span<char const* const> args)
+	{
+		consumer_config ret;
+		for(std::string_view arg : args)
+		{
+			auto const option = split_option(arg);
+			if(!option.has_value())
+			{ return std::unexpected(option.error()); }
+
+			if(option->first != "record-size")
+			{ return std::unexpected("Unknown option"); }
+
+			auto const value = parse_number<size_t>(option->second);
+			if(!value.has_value())
+			{ return std::unexpected(value.error()); }
+			ret.record_size = *value;
+		}
+
+		if(ret.record_size < record_header::size)
+		{ return std::unexpected("Record size must be at least 16 bytes"); }
+
+		return ret;
+	}
+
+	/**
+	 * \brief Converts cfg to command line arguments accepted by make_consumer_config
+	 */
+	inline std::vector<std::string> to_args(consumer_config const& cfg)
+	{ return std::vector<std::string>{std::format("--record-size={}", cfg.record_size)}; }
+
+	/**
+	 * \brief Configuration of a load test
+	 *
+	 * A load test runs one producer, followed by a chain of pass-through stages. The output of
+	 * the last stage, or of the producer if there are no stages, is fanned out to one or more
+	 * sinks.
+	 */
+	struct harness_config
+	{
+		/**
+		 * \brief The configuration of the producer
+		 */
+		producer_config producer;
+
+		/**
+		 * \brief The number of pass-through stages between the producer and the sinks
+		 */
+		size_t stages{0};
+
+		/**
+		 * \brief The number of sinks
+		 */
+		size_t fanout{1};
+	};
+
+	/**
+	 * \brief Creates a harness_config from command line arguments on the form `--key=value`
+	 *
+	 * Valid keys are `stages`, `fanout`, and all keys accepted by make_producer_config.
+	 */
+	inline std::expected<harness_config, char const*> make_harness_config(std::span<char const* const> args)
+	{
+		harness_config ret;
+		for(std::string_view arg : args)
+		{
+			auto const option = split_option(arg);
+			if(!option.has_value())
+			{ return std::unexpected(option.error()); }
+
+			if(option->first == "stages" || option->first == "fanout")
+			{
+				auto const value = parse_number<size_t>(option->second);
+				if(!value.has_value())
+				{ return std::unexpected(value.error()); }
+				(option->first == "stages"? ret.stages : ret.fanout) = *value;
+				continue;
+			}
+
+			auto const res = set_option(ret.producer, option->first, option->second);
+			if(!res.has_value())
+			{ return std::unexpected(res.error()); }
+			if(!*res)
+			{ return std::unexpected("Unknown option"); }
+		}
+
+		if(ret.fanout == 0)
+		{ return std::unexpected("There must be at least one sink"); }
+
+		auto const producer = validate(ret.producer);
+		if(!producer.has_value())
+		{ return std::unexpected(producer.error()); }
+
+		return ret;
+	}
+
+	/**
+	 * \brief Writes all of data to fd
+	 */
+	inline void write_all(os_services::io::output_file_descriptor_ref fd, std::span<std::byte const> data)
+	{
+		while(!data.empty())
+		{ data = data.subspan(os_services::io::write(fd, data).bytes_transferred()); }
+	}
+
+	/**
+	 * \brief Splits a stream of bytes into record batches
+	 */
+	class record_stream_reader
+	{
+	public:
+		/**
+		 * \brief Constructs a record_stream_reader
+		 * \param record_size The expected size of each record
+		 * \param initial_capacity The initial size of the input buffer. It grows if a batch
+		 *        does not fit.
+		 */
+		explicit record_stream_reader(size_t record_size, size_t initial_capacity = 65536):
+			m_record_size{record_size},
+			m_buffer(initial_capacity)
+		{}
+
+		/**
+		 * \brief Reads from fd, and calls func for each complete batch
+		 *
+		 * func is called with the client_ctl::record_batch_view, and the encoded batch, including
+		 * its header.
+		 *
+		 * \return false if the end of the stream has been reached
+		 * \throw std::runtime_error if the stream ends within a batch
+		 */
+		template<class Func>
+		bool read_and_process(os_services::io::input_file_descriptor_ref fd, Func&& func)
+		{
+			if(m_end == std::size(m_buffer))
+			{ make_room(); }
+
+			auto const res = os_services::io::read(fd, std::span{m_buffer}.subspan(m_end));
+			if(res.bytes_transferred() == 0)
+			{
+				if(m_begin != m_end)
+				{ throw std::runtime_error{"Record stream ended within a batch"}; }
+				return false;
+			}
+			m_end += res.bytes_transferred();
+
+			while(true)
+			{
+				auto const available = std::span{m_buffer}.subspan(m_begin, m_end - m_begin);
+				auto const batch = client_ctl::read_record_batch(available, m_record_size);
+				if(!batch.has_value())
+				{ break; }
+
+				auto const size = client_ctl::encoded_batch_size(batch->record_size(), batch->size());
+				func(*batch, available.first(size));
+				m_begin += size;
+			}
+
+			if(m_begin == m_end)
+			{
+				m_begin = 0;
+				m_end = 0;
+			}
+			return true;
+		}
+
+	private:
+		void make_room()
+		{
+			if(m_begin != 0)
+			{
+				memmove(std::data(m_buffer), std::data(m_buffer) + m_begin, m_end - m_begin);
+				m_end -= m_begin;
+				m_begin = 0;
+				return;
+			}
+
+			// The buffer is full, but does not contain a complete batch
+			m_buffer.resize(2*std::size(m_buffer));
+		}
+
+		size_t m_record_size;
+		std::vector<std::byte> m_buffer;
+		size_t m_begin{0};
+		size_t m_end{0};
+	};
+
+	/**
+	 * \brief Measurements made by a sink
+	 */
+	struct sink_report
+	{
+		/**
+		 * \brief The number of records received
+		 */
+		uint64_t records{0};
+
+		/**
+		 * \brief The number of bytes received, including batch headers
+		 */
+		uint64_t bytes{0};
+
+		/**
+		 * \brief The number of times a sequence number was not the successor of the previous one
+		 */
+		uint64_t sequence_gaps{0};
+
+		/**
+		 * \brief The time from the first to the last received batch
+		 */
+		clock::duration elapsed{0};
+
+		/**
+		 * \brief The time from when each record was produced to when it was received, in
+		 *        nanoseconds
+		 */
+		utils::log_histogram latency;
+	};
+
+	/**
+	 * \brief Converts a sink_report to a jopp::object
+	 */
+	inline jopp::object to_jopp_object(sink_report const& report)
+	{
+		auto const elapsed = std::chrono::duration<double>(report.elapsed).count();
+		auto const per_second = [elapsed](uint64_t value) {
+			return elapsed == 0.0? 0.0 : static_cast<double>(value)/elapsed;
+		};
+
+		jopp::object latency;
+		latency.insert("min", static_cast<jopp::number>(report.latency.min()));
+		latency.insert("mean", report.latency.mean());
+		latency.insert("p50", static_cast<jopp::number>(report.latency.value_at_quantile(0.5)));
+		latency.insert("p90", static_cast<jopp::number>(report.latency.value_at_quantile(0.9)));
+		latency.insert("p99", static_cast<jopp::number>(report.latency.value_at_quantile(0.99)));
+		latency.insert("p999", static_cast<jopp::number>(report.latency.value_at_quantile(0.999)));
+		latency.insert("max", static_cast<jopp::number>(report.latency.max()));
+
+		jopp::object ret;
+		ret.insert("records", static_cast<jopp::number>(report.records));
+		ret.insert("bytes", static_cast<jopp::number>(report.bytes));
+		ret.insert("sequence_gaps", static_cast<jopp::number>(report.sequence_gaps));
+		ret.insert("elapsed_s", elapsed);
+		ret.insert("records_per_second", per_second(report.records));
+		ret.insert("bytes_per_second", per_second(report.bytes));
+		ret.insert("latency_ns", std::move(latency));
+		return ret;
+	}
+}
+
+#endif
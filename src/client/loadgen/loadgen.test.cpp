@@ -0,0 +1,157 @@
+//@	{"target":{"name": "loadgen.test"}}
+
+#include "./loadgen.hpp"
+
+#include "src/os_services/ipc/pipe.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <array>
+#include <thread>
+
+TESTCASE(Pipe_loadgen_make_producer_config)
+{
+	std::array<char const*, 4> const args{
+		"--rate=1000",
+		"--record-size=128",
+		"--count=50",
+		"--distribution=poisson"
+	};
+	auto const cfg = Pipe::loadgen::make_producer_config(args);
+	REQUIRE_EQ(cfg.has_value(), true);
+	EXPECT_EQ(cfg->rate, 1000.0);
+	EXPECT_EQ(cfg->record_size, 128);
+	EXPECT_EQ(cfg->record_count, 50);
+	EXPECT_EQ(cfg->batch_size, 64);
+	EXPECT_EQ(cfg->distribution, Pipe::loadgen::arrival_distribution::poisson);
+
+	// Converting back to arguments gives the same configuration
+	auto const strings = Pipe::loadgen::to_args(*cfg);
+	std::vector<char const*> round_trip_args;
+	for(auto const& item : strings)
+	{ round_trip_args.push_back(item.c_str()); }
+	auto const round_trip = Pipe::loadgen::make_producer_config(round_trip_args);
+	REQUIRE_EQ(round_trip.has_value(), true);
+	EXPECT_EQ(round_trip->rate, cfg->rate);
+	EXPECT_EQ(round_trip->record_size, cfg->record_size);
+	EXPECT_EQ(round_trip->record_count, cfg->record_count);
+	EXPECT_EQ(round_trip->batch_size, cfg->batch_size);
+	EXPECT_EQ(round_trip->distribution, cfg->distribution);
+	EXPECT_EQ(round_trip->seed, cfg->seed);
+}
+
+TESTCASE(Pipe_loadgen_make_producer_config_invalid)
+{
+	{
+		std::array<char const*, 1> const args{"--record-size=8"};
+		EXPECT_EQ(Pipe::loadgen::make_producer_config(args).has_value(), false);
+	}
+
+	{
+		std::array<char const*, 1> const args{"--distribution=uniform"};
+		EXPECT_EQ(Pipe::loadgen::make_producer_config(args).has_value(), false);
+	}
+
+	{
+		std::array<char const*, 1> const args{"--stages=2"};
+		EXPECT_EQ(Pipe::loadgen::make_producer_config(args).has_value(), false);
+	}
+
+	{
+		std::array<char const*, 1> const args{"rate=10"};
+		EXPECT_EQ(Pipe::loadgen::make_producer_config(args).has_value(), false);
+	}
+}
+
+TESTCASE(Pipe_loadgen_make_harness_config)
+{
+	std::array<char const*, 3> const args{"--stages=3", "--fanout=2", "--count=10"};
+	auto const cfg = Pipe::loadgen::make_harness_config(args);
+	REQUIRE_EQ(cfg.has_value(), true);
+	EXPECT_EQ(cfg->stages, 3);
+	EXPECT_EQ(cfg->fanout, 2);
+	EXPECT_EQ(cfg->producer.record_count, 10);
+
+	std::array<char const*, 1> const no_sinks{"--fanout=0"};
+	EXPECT_EQ(Pipe::loadgen::make_harness_config(no_sinks).has_value(), false);
+}
+
+TESTCASE(Pipe_loadgen_record_stream_reader)
+{
+	Pipe::os_services::ipc::pipe<
+		Pipe::os_services::fd::io_mode::blocking,
+		Pipe::os_services::fd::io_mode::blocking
+	> stream;
+
+	constexpr size_t record_size = 32;
+	constexpr uint64_t record_count = 1000;
+	std::jthread producer{[write_end = stream.take_write_end()]() {
+		Pipe::client_ctl::record_batch_writer batch{record_size, 7};
+		for(uint64_t k = 0; k != record_count; ++k)
+		{
+			auto const record = batch.append();
+			Pipe::loadgen::record_header::set<0>(record.first(Pipe::loadgen::record_header::size), k);
+			Pipe::loadgen::record_header::set<1>(record.first(Pipe::loadgen::record_header::size), 2*k);
+			if(batch.full() || k + 1 == record_count)
+			{
+				Pipe::loadgen::write_all(write_end.get(), batch.finish());
+				batch.clear();
+			}
+		}
+	}};
+
+	// Use a small buffer to force it to grow
+	Pipe::loadgen::record_stream_reader reader{record_size, 16};
+	auto const read_end = stream.take_read_end();
+	uint64_t expected_sequence = 0;
+	size_t bytes = 0;
+	while(reader.read_and_process(read_end.get(), [&](auto const& batch, std::span<std::byte const> encoded) {
+		bytes += std::size(encoded);
+		for(size_t k = 0; k != batch.size(); ++k)
+		{
+			auto const header = batch[k].first(Pipe::loadgen::record_header::size);
+			EXPECT_EQ(Pipe::loadgen::record_header::get<0>(header), expected_sequence);
+			EXPECT_EQ(Pipe::loadgen::record_header::get<1>(header), 2*expected_sequence);
+			++expected_sequence;
+		}
+	}));
+
+	EXPECT_EQ(expected_sequence, record_count);
+	EXPECT_EQ(
+		bytes,
+		(record_count/7)*Pipe::client_ctl::encoded_batch_size(record_size, 7)
+			+ Pipe::client_ctl::encoded_batch_size(record_size, record_count%7)
+	);
+}
+
+TESTCASE(Pipe_loadgen_record_stream_reader_truncated)
+{
+	Pipe::os_services::ipc::pipe<
+		Pipe::os_services::fd::io_mode::blocking,
+		Pipe::os_services::fd::io_mode::blocking
+	> stream;
+
+	constexpr size_t record_size = 16;
+	{
+		Pipe::client_ctl::record_batch_writer batch{record_size, 4};
+		std::ignore = batch.append();
+		std::ignore = batch.append();
+		auto const write_end = stream.take_write_end();
+		Pipe::loadgen::write_all(write_end.get(), batch.finish().first(20));
+	}
+
+	Pipe::loadgen::record_stream_reader reader{record_size};
+	auto const read_end = stream.take_read_end();
+	size_t batch_count = 0;
+	auto const func = [&batch_count](auto const&, std::span<std::byte const>) {
+		++batch_count;
+	};
+	EXPECT_EQ(reader.read_and_process(read_end.get(), func), true);
+	try
+	{
+		std::ignore = reader.read_and_process(read_end.get(), func);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Record stream ended within a batch"}); }
+	EXPECT_EQ(batch_count, 0);
+}
@@ -0,0 +1,57 @@
+//@	{"target":{"name":"passthrough.o"}}
+
+#include "./loadgen.hpp"
+
+#include "src/json_log/writer.hpp"
+#include "src/log/log.hpp"
+
+#include <unistd.h>
+
+namespace
+{
+	void run_passthrough(
+		Pipe::loadgen::consumer_config const& cfg,
+		Pipe::os_services::io::input_file_descriptor_ref input,
+		Pipe::os_services::io::output_file_descriptor_ref output
+	)
+	{
+		// Batches are forwarded as they are, without waiting for more records
+		Pipe::loadgen::record_stream_reader reader{cfg.record_size};
+		while(reader.read_and_process(input, [output](auto const&, std::span<std::byte const> encoded) {
+			Pipe::loadgen::write_all(output, encoded);
+		}));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::chrono::system_clock std_system_clock;
+	Pipe::json_log::writer log_writer;
+
+	Pipe::log::context log_ctxt{
+		Pipe::log::configuration{
+			.writer = std::ref(log_writer),
+			.timestamp_generator = std::ref(std_system_clock)
+		}
+	};
+
+	try
+	{
+		auto const cfg = Pipe::loadgen::make_consumer_config(std::span{argv + 1, static_cast<size_t>(argc - 1)});
+		if(!cfg.has_value())
+		{ throw std::runtime_error{std::format("Invalid command line: {}", cfg.error())}; }
+
+		run_passthrough(
+			*cfg,
+			Pipe::os_services::io::input_file_descriptor_ref{STDIN_FILENO},
+			Pipe::os_services::io::output_file_descriptor_ref{STDOUT_FILENO}
+		);
+	}
+	catch(std::exception const& err)
+	{
+		write_message(Pipe::log::item::severity::error, err.what());
+		return -1;
+	}
+
+	return 0;
+}
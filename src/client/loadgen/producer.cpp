@@ -0,0 +1,112 @@
+//@	{"target":{"name":"producer.o"}}
+
+#include "./loadgen.hpp"
+
+#include "src/json_log/writer.hpp"
+#include "src/log/log.hpp"
+
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+	class arrival_schedule
+	{
+	public:
+		explicit arrival_schedule(Pipe::loadgen::producer_config const& cfg):
+			m_rng{cfg.seed},
+			m_rate{cfg.rate},
+			m_distribution{cfg.distribution},
+			m_next{Pipe::loadgen::clock::now()}
+		{}
+
+		/**
+		 * \brief Returns the time when the next record is due, or nullopt if records should be
+		 *        produced as fast as possible
+		 */
+		std::optional<Pipe::loadgen::clock::time_point> next()
+		{
+			if(m_rate == 0.0)
+			{ return std::nullopt; }
+
+			auto const ret = m_next;
+			auto const interval = m_distribution == Pipe::loadgen::arrival_distribution::poisson?
+				std::exponential_distribution<double>{m_rate}(m_rng) : 1.0/m_rate;
+			m_next += std::chrono::duration_cast<Pipe::loadgen::clock::duration>(
+				std::chrono::duration<double>{interval}
+			);
+			return ret;
+		}
+
+	private:
+		std::mt19937_64 m_rng;
+		double m_rate;
+		Pipe::loadgen::arrival_distribution m_distribution;
+		Pipe::loadgen::clock::time_point m_next;
+	};
+
+	void run_producer(
+		Pipe::loadgen::producer_config const& cfg,
+		Pipe::os_services::io::output_file_descriptor_ref output
+	)
+	{
+		Pipe::client_ctl::record_batch_writer batch{cfg.record_size, cfg.batch_size};
+		auto const flush = [&batch, output]() {
+			if(batch.empty())
+			{ return; }
+			Pipe::loadgen::write_all(output, batch.finish());
+			batch.clear();
+		};
+
+		arrival_schedule schedule{cfg};
+		for(uint64_t k = 0; k != cfg.record_count; ++k)
+		{
+			// Do not hold back records that are already due while waiting for the next one
+			if(auto const due = schedule.next(); due.has_value() && *due > Pipe::loadgen::clock::now())
+			{
+				flush();
+				std::this_thread::sleep_until(*due);
+			}
+
+			auto const record = batch.append();
+			Pipe::loadgen::record_header::set<0>(record.first(Pipe::loadgen::record_header::size), k);
+			Pipe::loadgen::record_header::set<1>(
+				record.first(Pipe::loadgen::record_header::size),
+				Pipe::loadgen::timestamp_now()
+			);
+			if(batch.full())
+			{ flush(); }
+		}
+		flush();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::chrono::system_clock std_system_clock;
+	Pipe::json_log::writer log_writer;
+
+	Pipe::log::context log_ctxt{
+		Pipe::log::configuration{
+			.writer = std::ref(log_writer),
+			.timestamp_generator = std::ref(std_system_clock)
+		}
+	};
+
+	try
+	{
+		auto const cfg = Pipe::loadgen::make_producer_config(std::span{argv + 1, static_cast<size_t>(argc - 1)});
+		if(!cfg.has_value())
+		{ throw std::runtime_error{std::format("Invalid command line: {}", cfg.error())}; }
+
+		run_producer(*cfg, Pipe::os_services::io::output_file_descriptor_ref{STDOUT_FILENO});
+	}
+	catch(std::exception const& err)
+	{
+		write_message(Pipe::log::item::severity::error, err.what());
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+//@	{"target":{"name":"sink.o"}}
+
+#include "./loadgen.hpp"
+
+#include "src/json_log/writer.hpp"
+#include "src/log/log.hpp"
+
+#include <jopp/serializer.hpp>
+#include <optional>
+#include <unistd.h>
+
+namespace
+{
+	Pipe::loadgen::sink_report run_sink(
+		Pipe::loadgen::consumer_config const& cfg,
+		Pipe::os_services::io::input_file_descriptor_ref input
+	)
+	{
+		Pipe::loadgen::sink_report ret;
+		std::optional<Pipe::loadgen::clock::time_point> first_batch;
+		Pipe::loadgen::clock::time_point last_batch;
+		uint64_t expected_sequence = 0;
+
+		Pipe::loadgen::record_stream_reader reader{cfg.record_size};
+		while(reader.read_and_process(input, [&](auto const& batch, std::span<std::byte const> encoded) {
+			// All records in a batch arrive at the same time
+			auto const now = Pipe::loadgen::clock::now();
+			auto const now_ns = Pipe::loadgen::to_timestamp(now);
+			if(!first_batch.has_value())
+			{ first_batch = now; }
+			last_batch = now;
+
+			for(size_t k = 0; k != batch.size(); ++k)
+			{
+				auto const header = batch[k].first(Pipe::loadgen::record_header::size);
+				auto const sequence = Pipe::loadgen::record_header::get<0>(header);
+				auto const timestamp = Pipe::loadgen::record_header::get<1>(header);
+				if(sequence != expected_sequence)
+				{ ++ret.sequence_gaps; }
+				expected_sequence = sequence + 1;
+				ret.latency.record(now_ns >= timestamp? now_ns - timestamp : 0);
+			}
+			ret.records += batch.size();
+			ret.bytes += std::size(encoded);
+		}));
+
+		if(first_batch.has_value())
+		{ ret.elapsed = last_batch - *first_batch; }
+		return ret;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::chrono::system_clock std_system_clock;
+	Pipe::json_log::writer log_writer;
+
+	Pipe::log::context log_ctxt{
+		Pipe::log::configuration{
+			.writer = std::ref(log_writer),
+			.timestamp_generator = std::ref(std_system_clock)
+		}
+	};
+
+	try
+	{
+		auto const cfg = Pipe::loadgen::make_consumer_config(std::span{argv + 1, static_cast<size_t>(argc - 1)});
+		if(!cfg.has_value())
+		{ throw std::runtime_error{std::format("Invalid command line: {}", cfg.error())}; }
+
+		auto const report = run_sink(*cfg, Pipe::os_services::io::input_file_descriptor_ref{STDIN_FILENO});
+		auto const str = to_string(to_jopp_object(report));
+		Pipe::loadgen::write_all(
+			Pipe::os_services::io::output_file_descriptor_ref{STDOUT_FILENO},
+			std::as_bytes(std::span{str})
+		);
+	}
+	catch(std::exception const& err)
+	{
+		write_message(Pipe::log::item::severity::error, err.what());
+		return -1;
+	}
+
+	return 0;
+}
@@ -2,12 +2,209 @@
 
 #include "src/json_log/writer.hpp"
 #include "src/log/log.hpp"
-#include "src/client_ctl/startup_config.hpp"
+#include "src/client_ctl/flat_startup_config.hpp"
+#include "src/client_ctl/message_buffer.hpp"
+#include "src/client_ctl/flow_control.hpp"
+#include "src/client_ctl/standalone_runtime.hpp"
+#include "src/client_ctl/client_application_info.hpp"
+#include "src/os_services/io/io.hpp"
 
 #include <cstdio>
+#include <map>
 #include <jopp/parser.hpp>
+#include <jopp/serializer.hpp>
 #include <unistd.h>
 
+namespace
+{
+	template<auto SocketType>
+	void send_all(
+		Pipe::client_ctl::message_writer& writer,
+		Pipe::os_services::ipc::connected_socket_ref<SocketType, sockaddr_un> socket
+	)
+	{
+		while(!writer.empty())
+		{
+			auto const data = SocketType == SOCK_SEQPACKET? writer.next_message() : writer.pending();
+			writer.consume(Pipe::os_services::io::write(socket, data).bytes_transferred());
+		}
+	}
+
+	template<class Payload>
+	void respond(
+		Pipe::client_ctl::message_writer& writer,
+		Pipe::client_ctl::message_header const& request,
+		Payload const& payload,
+		Pipe::client_ctl::message_flags flags = Pipe::client_ctl::message_flags::none
+	)
+	{
+		writer.push(
+			Pipe::client_ctl::message_header{
+				.payload_size = 0,
+				.type = request.type,
+				.flags = Pipe::client_ctl::message_flags::response | flags,
+				.correlation_id = request.correlation_id
+			},
+			payload
+		);
+	}
+
+	template<auto SocketType>
+	void serve_host(
+		Pipe::os_services::ipc::connected_socket_ref<SocketType, sockaddr_un> socket,
+		char const* display_name
+	)
+	{
+		Pipe::client_ctl::message_writer writer;
+		writer.push(
+			Pipe::client_ctl::hello{
+				.protocol_version = Pipe::client_ctl::protocol_version,
+				.pid = static_cast<uint32_t>(::getpid()),
+				.display_name = display_name
+			},
+			0
+		);
+		// All initialization has been done by the time the host is served
+		writer.push(Pipe::client_ctl::ready{}, 0);
+		send_all(writer, socket);
+
+		// The socket is blocking, and on a seqpacket socket each read returns one complete message,
+		// so a plain message_reader works for both socket types
+		Pipe::client_ctl::message_reader reader;
+		std::map<std::string, Pipe::client_ctl::credit_balance, std::less<>> output_credit;
+		auto running = true;
+		while(running)
+		{
+			auto const read_result = Pipe::os_services::io::read(socket, reader.free_space());
+			if(read_result.bytes_transferred() == 0)
+			{ throw std::runtime_error{"Host closed the control connection"}; }
+
+			reader.commit(read_result.bytes_transferred());
+			reader.for_each_message([&writer, &running, &output_credit](auto const& msg) {
+				if(has_flag(msg.header.flags, Pipe::client_ctl::message_flags::response))
+				{ throw std::runtime_error{"Host sent an unexpected response"}; }
+
+				switch(msg.header.type)
+				{
+					case Pipe::client_ctl::message_type::start:
+					case Pipe::client_ctl::message_type::pause:
+					case Pipe::client_ctl::message_type::drain:
+						respond(writer, msg.header, Pipe::client_ctl::acknowledgement{});
+						break;
+
+					case Pipe::client_ctl::message_type::shutdown:
+						respond(writer, msg.header, Pipe::client_ctl::acknowledgement{});
+						running = false;
+						break;
+
+					case Pipe::client_ctl::message_type::stats:
+						respond(
+							writer,
+							msg.header,
+							Pipe::client_ctl::stats_report{
+								.bytes_read = 0,
+								.bytes_written = 0,
+								.items_processed = 0
+							}
+						);
+						break;
+
+					case Pipe::client_ctl::message_type::credit_grant:
+					{
+						// Not a request, so there is no response
+						auto const grant = Pipe::client_ctl::decode<Pipe::client_ctl::credit_grant>(msg);
+						if(!grant.has_value())
+						{ throw std::runtime_error{grant.error()}; }
+
+						auto i = output_credit.find(grant->port);
+						if(i == std::end(output_credit))
+						{ i = output_credit.emplace(std::string{grant->port}, Pipe::client_ctl::credit_balance{}).first; }
+						i->second.grant(Pipe::client_ctl::credit{.bytes = grant->bytes, .messages = grant->messages});
+						break;
+					}
+
+					default:
+						respond(
+							writer,
+							msg.header,
+							Pipe::client_ctl::error_info{.message = "Unsupported request"},
+							Pipe::client_ctl::message_flags::error
+						);
+				}
+			});
+			send_all(writer, socket);
+		}
+	}
+
+	void write_client_application_info(char const* display_name)
+	{
+		Pipe::client_ctl::client_application_info const info{
+			.display_name = display_name,
+			.inputs = {},
+			.outputs = {}
+		};
+
+		auto const str = to_string(to_jopp_object(info));
+		auto data = std::as_bytes(std::span{str});
+		Pipe::os_services::io::output_file_descriptor_ref const output_fd{STDOUT_FILENO};
+		while(!data.empty())
+		{ data = data.subspan(Pipe::os_services::io::write(output_fd, data).bytes_transferred()); }
+	}
+
+	template<class StandaloneConfig>
+	void run_standalone(StandaloneConfig const& cfg)
+	{
+		Pipe::client_ctl::standalone_runtime runtime{cfg};
+		write_message(
+			Pipe::log::item::severity::info,
+			"Running standalone with {} input ports and {} output ports",
+			std::size(runtime.inputs()),
+			std::size(runtime.outputs())
+		);
+		runtime.flush();
+	}
+
+	void run(Pipe::client_ctl::host_info const& host, char const* display_name)
+	{
+		std::visit(
+			[display_name](auto socket) { serve_host(socket, display_name); },
+			host.address
+		);
+	}
+
+	void run(std::string_view startup_config_arg, char const* display_name)
+	{
+		if(auto const fd = Pipe::client_ctl::parse_startup_config_fd_argument(startup_config_arg); fd.has_value())
+		{
+			// Use the mapped config in place, rather than converting it to a startup_config
+			Pipe::client_ctl::mapped_startup_config const cfg{*fd};
+			auto const& view = cfg.view();
+			if(view.operational_mode() == Pipe::client_ctl::flat_operational_mode::connected_to_host)
+			{
+				run(
+					Pipe::client_ctl::host_info{
+						.address = Pipe::client_ctl::make_host_address(
+							Pipe::client_ctl::validate_socket_fd(static_cast<jopp::number>(view.socket_fd()))
+						)
+					},
+					display_name
+				);
+			}
+			else
+			{ run_standalone(view); }
+			return;
+		}
+
+		auto const startup_config = Pipe::client_ctl::make_startup_config(
+			jopp::parse(startup_config_arg).get<jopp::object>()
+		);
+		if(auto const host = std::get_if<Pipe::client_ctl::host_info>(&startup_config); host != nullptr)
+		{ run(*host, display_name); }
+		else
+		{ run_standalone(std::get<Pipe::client_ctl::standalone_config>(startup_config)); }
+	}
+}
+
 int main(int argc, char** argv)
 {
 	std::chrono::system_clock std_system_clock;
@@ -29,9 +226,13 @@ int main(int argc, char** argv)
 			};
 		}
 
-		auto const startup_config = Pipe::client_ctl::make_startup_config(
-			jopp::parse(std::string_view{argv[1]}).get<jopp::object>()
-		);
+		if(argv[1] == Pipe::client_ctl::discovery_option)
+		{
+			write_client_application_info(argv[0]);
+			return 0;
+		}
+
+		run(argv[1], argv[0]);
 	}
 	catch(std::exception const& err)
 	{
@@ -5,7 +5,9 @@
 #include "src/os_services/proc_mgmt/proc_mgmt.hpp"
 #include "src/os_services/ipc/pipe.hpp"
 #include "src/json_log/item_converter.hpp"
-#include "src/client_ctl/startup_config.hpp"
+#include "src/client_ctl/flat_startup_config.hpp"
+#include "src/client_ctl/message_buffer.hpp"
+#include "src/host/client_info_cache.hpp"
 
 #include <jopp/parser.hpp>
 #include <jopp/serializer.hpp>
@@ -96,41 +98,109 @@ TESTCASE(Pipe_client_main_to_many_args)
 	EXPECT_EQ(std::get<Pipe::os_services::proc_mgmt::process_exited>(proc_res).return_value, 255);
 }
 
-TESTCASE(Pipe_client_main_sucessful_start)
+TESTCASE(Pipe_client_main_discover)
 {
 	auto const exe_file = testclient_exe();
-	Pipe::os_services::ipc::pipe proc_output;
-	Pipe::os_services::ipc::socket_pair<SOCK_STREAM> sockets;
+	auto const info = Pipe::host::discover_client_application_info(exe_file);
+	EXPECT_EQ(info.display_name, exe_file.string());
+	EXPECT_EQ(std::size(info.inputs), 0);
+	EXPECT_EQ(std::size(info.outputs), 0);
+}
 
-	auto const startup_config = to_string(
-		Pipe::client_ctl::to_jopp_object(
-			Pipe::client_ctl::startup_config{
-				Pipe::client_ctl::host_info{
-					.address = sockets.socket_b()
-				}
+namespace
+{
+	enum class config_transport{json_argument, memfd};
+
+	template<auto SocketType, config_transport Transport = config_transport::json_argument>
+	void test_sucessful_start()
+	{
+		auto const exe_file = testclient_exe();
+		Pipe::os_services::ipc::pipe proc_output;
+		Pipe::os_services::ipc::socket_pair<SocketType> sockets;
+
+		Pipe::client_ctl::startup_config const cfg{
+			Pipe::client_ctl::host_info{
+				.address = sockets.socket_b()
 			}
-		)
-	);
+		};
 
-	std::array fds_to_keep{Pipe::os_services::fd::make_generic_file_descriptor(sockets.take_socket_b())};
-	std::array args_cstr{startup_config.c_str()};
+		std::vector<Pipe::os_services::fd::file_descriptor> fds_to_keep;
+		std::string startup_config;
+		if constexpr(Transport == config_transport::memfd)
+		{
+			auto cfg_fd = Pipe::client_ctl::make_startup_config_memfd(cfg);
+			startup_config = Pipe::client_ctl::make_startup_config_fd_argument(cfg_fd.get());
+			fds_to_keep.push_back(Pipe::os_services::fd::make_generic_file_descriptor(std::move(cfg_fd)));
+		}
+		else
+		{ startup_config = to_string(Pipe::client_ctl::to_jopp_object(cfg)); }
+
+		fds_to_keep.push_back(Pipe::os_services::fd::make_generic_file_descriptor(sockets.take_socket_b()));
+		std::array args_cstr{startup_config.c_str()};
+
+		auto const res = Pipe::os_services::proc_mgmt::spawn(
+			exe_file.c_str(),
+			std::span<char const*>{args_cstr},
+			std::span<char const*>{},
+			Pipe::os_services::proc_mgmt::io_redirection{
+				.sysin = {},
+				.sysout = {},
+				.syserr = proc_output.take_write_end()
+			},
+			std::span{fds_to_keep}
+		);
+
+		Pipe::client_ctl::message_writer writer;
+		writer.push(Pipe::client_ctl::stats_request{}, 1);
+		writer.push(Pipe::client_ctl::shutdown{}, 2);
+		while(!writer.empty())
+		{
+			auto const data = SocketType == SOCK_SEQPACKET? writer.next_message() : writer.pending();
+			writer.consume(Pipe::os_services::io::write(sockets.socket_a(), data).bytes_transferred());
+		}
 
-	auto const res = Pipe::os_services::proc_mgmt::spawn(
-		exe_file.c_str(),
-		std::span<char const*>{args_cstr},
-		std::span<char const*>{},
-		Pipe::os_services::proc_mgmt::io_redirection{
-			.sysin = {},
-			.sysout = {},
-			.syserr = proc_output.take_write_end()
-		},
-		std::span{fds_to_keep}
-	);
+		std::vector<Pipe::client_ctl::message_header> received;
+		std::optional<uint32_t> client_pid;
+		Pipe::client_ctl::message_reader reader;
+		while(std::size(received) != 4)
+		{
+			auto const read_result = Pipe::os_services::io::read(sockets.socket_a(), reader.free_space());
+			REQUIRE_NE(read_result.bytes_transferred(), 0);
+			reader.commit(read_result.bytes_transferred());
+			reader.for_each_message([&received, &client_pid](auto const& msg) {
+				received.push_back(msg.header);
+				if(msg.header.type == Pipe::client_ctl::message_type::hello)
+				{
+					auto const decoded = Pipe::client_ctl::decode<Pipe::client_ctl::hello>(msg);
+					REQUIRE_EQ(decoded.has_value(), true);
+					EXPECT_EQ(decoded->protocol_version, Pipe::client_ctl::protocol_version);
+					client_pid = decoded->pid;
+				}
+			});
+		}
 
-	auto const log_item = fetch_log_item(proc_output.read_end());
-	EXPECT_EQ(log_item.severity, Pipe::log::item::severity::info);
-	EXPECT_EQ(log_item.message, "Process exited normally");
+		EXPECT_EQ(client_pid, static_cast<uint32_t>(res.first));
+		EXPECT_EQ(received[1].type, Pipe::client_ctl::message_type::ready);
+		EXPECT_EQ(received[2].type, Pipe::client_ctl::message_type::stats);
+		EXPECT_EQ(received[2].correlation_id, 1);
+		EXPECT_EQ(received[3].type, Pipe::client_ctl::message_type::shutdown);
+		EXPECT_EQ(received[3].correlation_id, 2);
+		EXPECT_EQ(has_flag(received[3].flags, Pipe::client_ctl::message_flags::response), true);
 
-	auto const proc_res = Pipe::os_services::proc_mgmt::wait(res.second.get());
-	EXPECT_EQ(std::get<Pipe::os_services::proc_mgmt::process_exited>(proc_res).return_value, 0);
-}
\ No newline at end of file
+		auto const log_item = fetch_log_item(proc_output.read_end());
+		EXPECT_EQ(log_item.severity, Pipe::log::item::severity::info);
+		EXPECT_EQ(log_item.message, "Process exited normally");
+
+		auto const proc_res = Pipe::os_services::proc_mgmt::wait(res.second.get());
+		EXPECT_EQ(std::get<Pipe::os_services::proc_mgmt::process_exited>(proc_res).return_value, 0);
+	}
+}
+
+TESTCASE(Pipe_client_main_sucessful_start_stream)
+{ test_sucessful_start<SOCK_STREAM>(); }
+
+TESTCASE(Pipe_client_main_sucessful_start_seqpacket)
+{ test_sucessful_start<SOCK_SEQPACKET>(); }
+
+TESTCASE(Pipe_client_main_sucessful_start_memfd_config)
+{ test_sucessful_start<SOCK_SEQPACKET, config_transport::memfd>(); }
\ No newline at end of file
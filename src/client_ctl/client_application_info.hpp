@@ -3,10 +3,17 @@
 
 #include <jopp/types.hpp>
 #include <string>
+#include <string_view>
 #include <map>
 
 namespace Pipe::client_ctl
 {
+	/**
+	 * \brief The command line argument that makes a client write its client_application_info, as
+	 *        JSON, to stdout, and then exit
+	 */
+	constexpr std::string_view discovery_option = "--discover";
+
 	/**
 	 * \brief Contains information about a port
 	 */
@@ -14,8 +21,10 @@ namespace Pipe::client_ctl
 	{
 		/**
 		 * \brief The expected/promised content type of a port
-		 * \note There is no list of valid types, but a contract should be established within a
-		 * particular system
+		 *
+		 * The content type is parsed by make_content_type. Apart from record streams, whose
+		 * layout is checked by the host, there is no list of valid types, but a contract should
+		 * be established within a particular system.
 		 */
 		std::string stream_content_type;
 	};
@@ -108,7 +117,7 @@ namespace Pipe::client_ctl
 		return client_application_info{
 			.display_name = obj.get_field_as<std::string>("display_name"),
 			.inputs = make_port_info_map(obj.get_field_as<jopp::object>("inputs")),
-			.outputs = make_port_info_map(obj.get_field_as<jopp::object>("output"))
+			.outputs = make_port_info_map(obj.get_field_as<jopp::object>("outputs"))
 		};
 	}
 }
@@ -2,4 +2,18 @@
 
 #include "./client_application_info.hpp"
 
-#include <testfwk/testfwk.hpp>
\ No newline at end of file
+#include <testfwk/testfwk.hpp>
+TESTCASE(Pipe_client_ctl_client_application_info_roundtrip)
+{
+	Pipe::client_ctl::client_application_info info{.display_name = "Client", .inputs = {}, .outputs = {}};
+	info.inputs.insert(std::pair{"stdin", Pipe::client_ctl::port_info{.stream_content_type = "text/plain"}});
+	info.outputs.insert(std::pair{"stdout", Pipe::client_ctl::port_info{.stream_content_type = "image/png"}});
+
+	auto const obj = to_jopp_object(info);
+	auto const restored = Pipe::client_ctl::make_client_application_info(obj);
+	EXPECT_EQ(restored.display_name, "Client");
+	REQUIRE_EQ(std::size(restored.inputs), 1);
+	EXPECT_EQ(restored.inputs.at("stdin").stream_content_type, "text/plain");
+	REQUIRE_EQ(std::size(restored.outputs), 1);
+	EXPECT_EQ(restored.outputs.at("stdout").stream_content_type, "image/png");
+}
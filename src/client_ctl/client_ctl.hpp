@@ -4,7 +4,7 @@
 /**
  * \brief Definitions for the protocol used to control clients
  */
-namespace client_ctl
+namespace Pipe::client_ctl
 {}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,315 @@
+#ifndef PIPE_CLIENT_CTL_CONTENT_TYPE_HPP
+#define PIPE_CLIENT_CTL_CONTENT_TYPE_HPP
+
+#include "./client_application_info.hpp"
+
+#include "src/utils/utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Pipe::client_ctl
+{
+	/**
+	 * \brief The content type of a port that does not say anything about its content
+	 */
+	constexpr std::string_view octet_stream_content_type = "application/octet-stream";
+
+	/**
+	 * \brief The media type of a stream of fixed-size records
+	 *
+	 * The layout of each record is given by the fields parameter, which is a comma-separated
+	 * list of field types, for example `application/x-pipe-records; fields=u32,f64`. Fields are
+	 * laid out in order, with the same alignment rules as a C struct.
+	 */
+	constexpr std::string_view record_stream_media_type = "application/x-pipe-records";
+
+	/**
+	 * \brief The type of a field in a record
+	 */
+	enum class record_field_type:uint8_t{i8, u8, i16, u16, i32, u32, i64, u64, f32, f64};
+
+	/**
+	 * \brief The name of each record_field_type, as used in a content type
+	 */
+	constexpr std::array<std::string_view, 10> record_field_type_names{
+		"i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32", "f64"
+	};
+
+	/**
+	 * \brief Converts a record_field_type to a string
+	 */
+	constexpr std::string_view to_string(record_field_type value) noexcept
+	{ return record_field_type_names[static_cast<size_t>(value)]; }
+
+	/**
+	 * \brief Converts a string to a record_field_type
+	 */
+	constexpr std::optional<record_field_type> make_record_field_type(std::string_view name) noexcept
+	{
+		auto const i = std::ranges::find(record_field_type_names, name);
+		if(i == std::end(record_field_type_names))
+		{ return std::nullopt; }
+		return static_cast<record_field_type>(i - std::begin(record_field_type_names));
+	}
+
+	/**
+	 * \brief Returns the size, and alignment, of a field of type value
+	 * \note All field types are naturally aligned
+	 */
+	constexpr size_t field_size(record_field_type value) noexcept
+	{
+		switch(value)
+		{
+			case record_field_type::i8:
+			case record_field_type::u8:
+				return 1;
+			case record_field_type::i16:
+			case record_field_type::u16:
+				return 2;
+			case record_field_type::i32:
+			case record_field_type::u32:
+			case record_field_type::f32:
+				return 4;
+			case record_field_type::i64:
+			case record_field_type::u64:
+			case record_field_type::f64:
+				return 8;
+		}
+		return 0;
+	}
+
+	/**
+	 * \brief Maps a C++ type to a record_field_type
+	 */
+	template<class T>
+	struct record_field_type_of;
+
+	template<> struct record_field_type_of<int8_t>{ static constexpr auto value = record_field_type::i8; };
+	template<> struct record_field_type_of<uint8_t>{ static constexpr auto value = record_field_type::u8; };
+	template<> struct record_field_type_of<int16_t>{ static constexpr auto value = record_field_type::i16; };
+	template<> struct record_field_type_of<uint16_t>{ static constexpr auto value = record_field_type::u16; };
+	template<> struct record_field_type_of<int32_t>{ static constexpr auto value = record_field_type::i32; };
+	template<> struct record_field_type_of<uint32_t>{ static constexpr auto value = record_field_type::u32; };
+	template<> struct record_field_type_of<int64_t>{ static constexpr auto value = record_field_type::i64; };
+	template<> struct record_field_type_of<uint64_t>{ static constexpr auto value = record_field_type::u64; };
+	template<> struct record_field_type_of<float>{ static constexpr auto value = record_field_type::f32; };
+	template<> struct record_field_type_of<double>{ static constexpr auto value = record_field_type::f64; };
+
+	/**
+	 * \brief A parsed content type
+	 */
+	struct content_type
+	{
+		/**
+		 * \brief The media type, without any parameters
+		 */
+		std::string media_type;
+
+		/**
+		 * \brief The fields of each record, if media_type is record_stream_media_type
+		 */
+		std::vector<record_field_type> fields;
+
+		bool operator==(content_type const&) const = default;
+
+		/**
+		 * \brief Checks whether or not this content type is a stream of records
+		 */
+		bool is_record_stream() const noexcept
+		{ return media_type == record_stream_media_type; }
+
+		/**
+		 * \brief Checks whether or not this content type accepts any data
+		 */
+		bool is_opaque() const noexcept
+		{ return media_type == octet_stream_content_type || media_type == "*/*"; }
+
+		/**
+		 * \brief Computes the size of each record, and the offset of each field
+		 * \param offsets Receives the offset of each field. It must have the same size as fields.
+		 */
+		size_t record_layout(std::span<size_t> offsets) const
+		{
+			std::vector<utils::struct_field_info> field_info;
+			field_info.reserve(std::size(fields));
+			for(auto const field : fields)
+			{ field_info.push_back(utils::struct_field_info{.size = field_size(field), .alignment = field_size(field)}); }
+			return utils::compute_struct_layout(field_info, offsets);
+		}
+
+		/**
+		 * \brief Returns the size of each record
+		 */
+		size_t record_size() const
+		{
+			std::vector<size_t> offsets(std::size(fields));
+			return record_layout(offsets);
+		}
+	};
+
+	/**
+	 * \brief Converts a content_type to a string, in the form accepted by make_content_type
+	 */
+	inline std::string to_string(content_type const& value)
+	{
+		if(!value.is_record_stream())
+		{ return value.media_type; }
+
+		std::string ret{value.media_type};
+		ret.append("; fields=");
+		for(size_t k = 0; k != std::size(value.fields); ++k)
+		{
+			if(k != 0)
+			{ ret.push_back(','); }
+			ret.append(to_string(value.fields[k]));
+		}
+		return ret;
+	}
+
+	/**
+	 * \brief Parses a content type string
+	 *
+	 * An empty string is treated as octet_stream_content_type. Parameters other than fields are
+	 * ignored.
+	 */
+	inline std::expected<content_type, char const*> make_content_type(std::string_view str)
+	{
+		auto const trim = [](std::string_view val) {
+			auto const begin = val.find_first_not_of(" \t");
+			if(begin == std::string_view::npos)
+			{ return std::string_view{}; }
+			return val.substr(begin, val.find_last_not_of(" \t") - begin + 1);
+		};
+
+		auto const media_type_end = str.find(';');
+		auto const media_type = trim(str.substr(0, media_type_end));
+		if(media_type.empty())
+		{
+			if(!trim(str).empty())
+			{ return std::unexpected("Content type has no media type"); }
+			return content_type{.media_type = std::string{octet_stream_content_type}, .fields = {}};
+		}
+
+		content_type ret{.media_type = std::string{media_type}, .fields = {}};
+		auto params = media_type_end == std::string_view::npos?
+			std::string_view{} : str.substr(media_type_end + 1);
+		auto has_fields = false;
+		while(!params.empty())
+		{
+			auto const param_end = params.find(';');
+			auto const param = trim(params.substr(0, param_end));
+			params = param_end == std::string_view::npos? std::string_view{} : params.substr(param_end + 1);
+
+			auto const eq = param.find('=');
+			if(eq == std::string_view::npos || trim(param.substr(0, eq)) != "fields")
+			{ continue; }
+
+			has_fields = true;
+			auto field_list = trim(param.substr(eq + 1));
+			while(true)
+			{
+				auto const comma = field_list.find(',');
+				auto const field = make_record_field_type(trim(field_list.substr(0, comma)));
+				if(!field.has_value())
+				{ return std::unexpected("Content type contains an unknown field type"); }
+				ret.fields.push_back(*field);
+
+				if(comma == std::string_view::npos)
+				{ break; }
+				field_list = field_list.substr(comma + 1);
+			}
+		}
+
+		if(ret.is_record_stream() && !has_fields)
+		{ return std::unexpected("Record stream content type has no fields"); }
+
+		if(!ret.is_record_stream() && has_fields)
+		{ return std::unexpected("Only record streams may have fields"); }
+
+		return ret;
+	}
+
+	/**
+	 * \brief Determines the content type of a connection from a producer to a consumer
+	 *
+	 * A consumer that accepts opaque data can be connected to any producer. Otherwise, the media
+	 * types must be equal, and for record streams, so must the record layouts.
+	 *
+	 * \return The content type of the data flowing through the connection
+	 */
+	inline std::expected<content_type, char const*> negotiate(content_type const& producer, content_type const& consumer)
+	{
+		if(consumer.is_opaque())
+		{ return producer; }
+
+		if(producer.media_type != consumer.media_type)
+		{ return std::unexpected("Media types do not match"); }
+
+		if(producer.fields != consumer.fields)
+		{ return std::unexpected("Record layouts do not match"); }
+
+		return producer;
+	}
+
+	/**
+	 * \brief Determines the content type of a connection from output_port of producer to
+	 *        input_port of consumer
+	 *
+	 * \throw std::runtime_error if the ports do not exist, if any of the content types is
+	 *        invalid, or if they are incompatible
+	 */
+	inline content_type negotiate(
+		client_application_info const& producer,
+		std::string_view output_port,
+		client_application_info const& consumer,
+		std::string_view input_port
+	)
+	{
+		auto const output = producer.outputs.find(std::string{output_port});
+		if(output == std::end(producer.outputs))
+		{ throw std::runtime_error{std::format("{} has no output port named {}", producer.display_name, output_port)}; }
+
+		auto const input = consumer.inputs.find(std::string{input_port});
+		if(input == std::end(consumer.inputs))
+		{ throw std::runtime_error{std::format("{} has no input port named {}", consumer.display_name, input_port)}; }
+
+		auto const describe = [](client_application_info const& client, std::string_view port) {
+			return std::format("{}.{}", client.display_name, port);
+		};
+
+		auto const produced = make_content_type(output->second.stream_content_type);
+		if(!produced.has_value())
+		{ throw std::runtime_error{std::format("{}: {}", describe(producer, output_port), produced.error())}; }
+
+		auto const consumed = make_content_type(input->second.stream_content_type);
+		if(!consumed.has_value())
+		{ throw std::runtime_error{std::format("{}: {}", describe(consumer, input_port), consumed.error())}; }
+
+		auto ret = negotiate(*produced, *consumed);
+		if(!ret.has_value())
+		{
+			throw std::runtime_error{
+				std::format(
+					"Cannot connect {} ({}) to {} ({}): {}",
+					describe(producer, output_port),
+					to_string(*produced),
+					describe(consumer, input_port),
+					to_string(*consumed),
+					ret.error()
+				)
+			};
+		}
+		return std::move(*ret);
+	}
+}
+
+#endif
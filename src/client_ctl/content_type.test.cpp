@@ -0,0 +1,107 @@
+//@	{"target":{"name": "content_type.test"}}
+
+#include "./content_type.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+TESTCASE(Pipe_client_ctl_content_type_parse)
+{
+	{
+		auto const res = Pipe::client_ctl::make_content_type("");
+		REQUIRE_EQ(res.has_value(), true);
+		EXPECT_EQ(res->media_type, Pipe::client_ctl::octet_stream_content_type);
+		EXPECT_EQ(res->is_opaque(), true);
+	}
+
+	{
+		auto const res = Pipe::client_ctl::make_content_type("text/plain; charset=utf-8");
+		REQUIRE_EQ(res.has_value(), true);
+		EXPECT_EQ(res->media_type, "text/plain");
+		EXPECT_EQ(res->fields.empty(), true);
+	}
+
+	{
+		auto const res = Pipe::client_ctl::make_content_type("application/x-pipe-records; fields=u8, f64 ,u16");
+		REQUIRE_EQ(res.has_value(), true);
+		EXPECT_EQ(res->is_record_stream(), true);
+		REQUIRE_EQ(std::size(res->fields), 3);
+		EXPECT_EQ(res->fields[1], Pipe::client_ctl::record_field_type::f64);
+		EXPECT_EQ(to_string(*res), "application/x-pipe-records; fields=u8,f64,u16");
+
+		std::array<size_t, 3> offsets{};
+		EXPECT_EQ(res->record_layout(offsets), 24);
+		EXPECT_EQ(offsets[1], 8);
+		EXPECT_EQ(offsets[2], 16);
+	}
+
+	EXPECT_EQ(
+		Pipe::client_ctl::make_content_type("application/x-pipe-records; fields=u8,bool").error(),
+		std::string_view{"Content type contains an unknown field type"}
+	);
+	EXPECT_EQ(
+		Pipe::client_ctl::make_content_type("application/x-pipe-records").error(),
+		std::string_view{"Record stream content type has no fields"}
+	);
+	EXPECT_EQ(
+		Pipe::client_ctl::make_content_type("text/plain; fields=u8").error(),
+		std::string_view{"Only record streams may have fields"}
+	);
+}
+
+TESTCASE(Pipe_client_ctl_content_type_negotiate)
+{
+	auto const records = *Pipe::client_ctl::make_content_type("application/x-pipe-records; fields=u32,f32");
+	auto const other_records = *Pipe::client_ctl::make_content_type("application/x-pipe-records; fields=f32,u32");
+	auto const text = *Pipe::client_ctl::make_content_type("text/plain");
+	auto const opaque = *Pipe::client_ctl::make_content_type("");
+
+	EXPECT_EQ((Pipe::client_ctl::negotiate(records, records).value() == records), true);
+	EXPECT_EQ((Pipe::client_ctl::negotiate(records, opaque).value() == records), true);
+	EXPECT_EQ(Pipe::client_ctl::negotiate(records, other_records).error(), std::string_view{"Record layouts do not match"});
+	EXPECT_EQ(Pipe::client_ctl::negotiate(text, records).error(), std::string_view{"Media types do not match"});
+	EXPECT_EQ(Pipe::client_ctl::negotiate(opaque, text).error(), std::string_view{"Media types do not match"});
+}
+
+TESTCASE(Pipe_client_ctl_content_type_negotiate_ports)
+{
+	Pipe::client_ctl::client_application_info const producer{
+		.display_name = "producer",
+		.inputs = {},
+		.outputs = {{"out", Pipe::client_ctl::port_info{.stream_content_type = "text/plain"}}}
+	};
+
+	Pipe::client_ctl::client_application_info const consumer{
+		.display_name = "consumer",
+		.inputs = {
+			{"in", Pipe::client_ctl::port_info{.stream_content_type = "application/x-pipe-records; fields=u8"}},
+			{"raw", Pipe::client_ctl::port_info{.stream_content_type = ""}}
+		},
+		.outputs = {}
+	};
+
+	EXPECT_EQ(Pipe::client_ctl::negotiate(producer, "out", consumer, "raw").media_type, "text/plain");
+
+	try
+	{
+		std::ignore = Pipe::client_ctl::negotiate(producer, "out", consumer, "in");
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{
+		EXPECT_EQ(
+			err.what(),
+			std::string_view{
+				"Cannot connect producer.out (text/plain) to consumer.in "
+				"(application/x-pipe-records; fields=u8): Media types do not match"
+			}
+		);
+	}
+
+	try
+	{
+		std::ignore = Pipe::client_ctl::negotiate(producer, "in", consumer, "in");
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"producer has no output port named in"}); }
+}
@@ -0,0 +1,513 @@
+#ifndef PIPE_CLIENT_CTL_FLAT_STARTUP_CONFIG_HPP
+#define PIPE_CLIENT_CTL_FLAT_STARTUP_CONFIG_HPP
+
+#include "./startup_config.hpp"
+
+#include "src/os_services/memory/mapped_region.hpp"
+#include "src/os_services/memory/memfd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Pipe::client_ctl
+{
+	/**
+	 * \brief The operational mode stored in a flat startup config
+	 */
+	enum class flat_operational_mode:uint32_t{connected_to_host = 1, standalone = 2};
+
+	/**
+	 * \brief The first part of a flat startup config
+	 *
+	 * The header is followed by input_count flat_input_port entries, output_count
+	 * flat_output_port entries, path_count flat_string entries holding the paths of all output
+	 * ports, and finally the characters of all strings. Ports are sorted by name, so a port can
+	 * be found by binary search. All values are stored in native byte order, since the config
+	 * never leaves the machine it was written on.
+	 */
+	struct flat_config_header
+	{
+		std::array<char, 8> magic;
+		uint32_t version;
+		flat_operational_mode operational_mode;
+		int32_t socket_fd;
+		uint32_t input_count;
+		uint32_t output_count;
+		uint32_t path_count;
+		uint64_t total_size;
+	};
+
+	static_assert(sizeof(flat_config_header) == 40);
+
+	/**
+	 * \brief The magic number identifying a flat startup config
+	 */
+	constexpr std::array<char, 8> flat_config_magic{'P', 'I', 'P', 'E', 'C', 'F', 'G', '\0'};
+
+	/**
+	 * \brief The current version of the flat startup config layout
+	 */
+	constexpr uint32_t flat_config_version = 1;
+
+	/**
+	 * \brief Refers to a string within a flat startup config
+	 * \note offset is counted from the start of the config
+	 */
+	struct flat_string
+	{
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	/**
+	 * \brief An entry describing an input port
+	 */
+	struct flat_input_port
+	{
+		flat_string name;
+		flat_string path;
+	};
+
+	/**
+	 * \brief An entry describing an output port
+	 * \note first_path is an index into the path table
+	 */
+	struct flat_output_port
+	{
+		flat_string name;
+		uint32_t first_path;
+		uint32_t path_count;
+	};
+
+	/**
+	 * \brief Serializes cfg to the flat startup config layout
+	 */
+	inline std::vector<std::byte> to_flat_startup_config(startup_config const& cfg)
+	{
+		flat_config_header header{
+			.magic = flat_config_magic,
+			.version = flat_config_version,
+			.operational_mode = flat_operational_mode::connected_to_host,
+			.socket_fd = -1,
+			.input_count = 0,
+			.output_count = 0,
+			.path_count = 0,
+			.total_size = 0
+		};
+
+		input_port_file_map const* inputs = nullptr;
+		output_port_file_map const* outputs = nullptr;
+		if(auto const host = std::get_if<host_info>(&cfg); host != nullptr)
+		{ header.socket_fd = std::visit([](auto fd){ return fd.native_handle(); }, host->address); }
+		else
+		{
+			auto const& standalone = std::get<standalone_config>(cfg);
+			header.operational_mode = flat_operational_mode::standalone;
+			inputs = &standalone.inputs;
+			outputs = &standalone.outputs;
+			header.input_count = static_cast<uint32_t>(std::size(standalone.inputs));
+			header.output_count = static_cast<uint32_t>(std::size(standalone.outputs));
+			for(auto const& item : standalone.outputs)
+			{ header.path_count += static_cast<uint32_t>(std::size(item.second)); }
+		}
+
+		auto const tables_size = sizeof(flat_config_header)
+			+ header.input_count*sizeof(flat_input_port)
+			+ header.output_count*sizeof(flat_output_port)
+			+ header.path_count*sizeof(flat_string);
+
+		std::vector<std::byte> ret(tables_size);
+		auto add_string = [&ret](std::string_view str) {
+			if(std::size(ret) + std::size(str) > std::numeric_limits<uint32_t>::max())
+			{ throw std::runtime_error{"Startup config is too large"}; }
+
+			flat_string const ret_str{
+				.offset = static_cast<uint32_t>(std::size(ret)),
+				.size = static_cast<uint32_t>(std::size(str))
+			};
+			auto const bytes = std::as_bytes(std::span{str});
+			ret.insert(std::end(ret), std::begin(bytes), std::end(bytes));
+			return ret_str;
+		};
+
+		auto write_ptr = sizeof(flat_config_header);
+		if(inputs != nullptr)
+		{
+			for(auto const& item : *inputs)
+			{
+				flat_input_port const entry{
+					.name = add_string(item.first),
+					.path = add_string(item.second.native())
+				};
+				memcpy(std::data(ret) + write_ptr, &entry, sizeof(entry));
+				write_ptr += sizeof(entry);
+			}
+		}
+
+		if(outputs != nullptr)
+		{
+			auto path_ptr = write_ptr + header.output_count*sizeof(flat_output_port);
+			uint32_t path_index = 0;
+			for(auto const& item : *outputs)
+			{
+				flat_output_port const entry{
+					.name = add_string(item.first),
+					.first_path = path_index,
+					.path_count = static_cast<uint32_t>(std::size(item.second))
+				};
+				memcpy(std::data(ret) + write_ptr, &entry, sizeof(entry));
+				write_ptr += sizeof(entry);
+
+				for(auto const& path : item.second)
+				{
+					auto const path_entry = add_string(path.native());
+					memcpy(std::data(ret) + path_ptr, &path_entry, sizeof(path_entry));
+					path_ptr += sizeof(path_entry);
+					++path_index;
+				}
+			}
+		}
+
+		header.total_size = std::size(ret);
+		memcpy(std::data(ret), &header, sizeof(header));
+		return ret;
+	}
+
+	/**
+	 * \brief A view of an input port within a flat startup config
+	 */
+	struct flat_input_port_view
+	{
+		std::string_view name;
+		std::string_view path;
+	};
+
+	/**
+	 * \brief Provides in-place access to a flat startup config
+	 *
+	 * All offsets are validated when the view is constructed. After that, strings are returned
+	 * as views into the underlying buffer, so nothing is parsed or copied.
+	 */
+	class flat_startup_config_view
+	{
+	public:
+		/**
+		 * \brief Constructs a flat_startup_config_view
+		 * \throw std::runtime_error if data does not hold a valid flat startup config
+		 */
+		explicit flat_startup_config_view(std::span<std::byte const> data):m_data{data}
+		{
+			if(std::size(data) < sizeof(flat_config_header))
+			{ throw std::runtime_error{"Startup config is truncated"}; }
+
+			memcpy(&m_header, std::data(data), sizeof(m_header));
+			if(m_header.magic != flat_config_magic)
+			{ throw std::runtime_error{"Startup config has an unexpected magic number"}; }
+
+			if(m_header.version != flat_config_version)
+			{ throw std::runtime_error{"Startup config has an unsupported version"}; }
+
+			if(m_header.total_size != std::size(data))
+			{ throw std::runtime_error{"Startup config has an unexpected size"}; }
+
+			if(m_header.operational_mode != flat_operational_mode::connected_to_host
+				&& m_header.operational_mode != flat_operational_mode::standalone)
+			{ throw std::runtime_error{"Startup config has an unsupported operational mode"}; }
+
+			auto const tables_size = sizeof(flat_config_header)
+				+ static_cast<size_t>(m_header.input_count)*sizeof(flat_input_port)
+				+ static_cast<size_t>(m_header.output_count)*sizeof(flat_output_port)
+				+ static_cast<size_t>(m_header.path_count)*sizeof(flat_string);
+			if(tables_size > std::size(data))
+			{ throw std::runtime_error{"Startup config is truncated"}; }
+
+			for(size_t k = 0; k != input_count(); ++k)
+			{
+				auto const entry = input_entry(k);
+				validate(entry.name);
+				validate(entry.path);
+			}
+
+			for(size_t k = 0; k != output_count(); ++k)
+			{
+				auto const entry = output_entry(k);
+				validate(entry.name);
+				if(static_cast<uint64_t>(entry.first_path) + entry.path_count > m_header.path_count)
+				{ throw std::runtime_error{"Startup config has an invalid path range"}; }
+			}
+
+			for(size_t k = 0; k != m_header.path_count; ++k)
+			{ validate(path_entry(k)); }
+		}
+
+		/**
+		 * \brief Returns the operational mode
+		 */
+		flat_operational_mode operational_mode() const noexcept
+		{ return m_header.operational_mode; }
+
+		/**
+		 * \brief Returns the control socket, when running connected to a host
+		 */
+		int socket_fd() const noexcept
+		{ return m_header.socket_fd; }
+
+		/**
+		 * \brief Returns the number of input ports
+		 */
+		size_t input_count() const noexcept
+		{ return m_header.input_count; }
+
+		/**
+		 * \brief Returns the input port at index k
+		 */
+		flat_input_port_view input(size_t k) const
+		{
+			auto const entry = input_entry(k);
+			return flat_input_port_view{.name = get(entry.name), .path = get(entry.path)};
+		}
+
+		/**
+		 * \brief Returns the path of the input port called name, if there is any
+		 */
+		std::optional<std::string_view> find_input(std::string_view name) const
+		{
+			auto const k = lower_bound(input_count(), name, [this](size_t k){
+				return get(input_entry(k).name);
+			});
+			if(k == input_count() || get(input_entry(k).name) != name)
+			{ return std::nullopt; }
+			return get(input_entry(k).path);
+		}
+
+		/**
+		 * \brief Returns the number of output ports
+		 */
+		size_t output_count() const noexcept
+		{ return m_header.output_count; }
+
+		/**
+		 * \brief Returns the name of the output port at index k
+		 */
+		std::string_view output_name(size_t k) const
+		{ return get(output_entry(k).name); }
+
+		/**
+		 * \brief Returns the number of paths used by the output port at index k
+		 */
+		size_t output_path_count(size_t k) const
+		{ return output_entry(k).path_count; }
+
+		/**
+		 * \brief Returns path number i of the output port at index k
+		 */
+		std::string_view output_path(size_t k, size_t i) const
+		{ return get(path_entry(output_entry(k).first_path + i)); }
+
+		/**
+		 * \brief Returns the index of the output port called name, if there is any
+		 */
+		std::optional<size_t> find_output(std::string_view name) const
+		{
+			auto const k = lower_bound(output_count(), name, [this](size_t k){
+				return output_name(k);
+			});
+			if(k == output_count() || output_name(k) != name)
+			{ return std::nullopt; }
+			return k;
+		}
+
+	private:
+		template<class T>
+		T load(size_t offset) const
+		{
+			T ret{};
+			memcpy(&ret, std::data(m_data) + offset, sizeof(T));
+			return ret;
+		}
+
+		flat_input_port input_entry(size_t k) const
+		{ return load<flat_input_port>(sizeof(flat_config_header) + k*sizeof(flat_input_port)); }
+
+		flat_output_port output_entry(size_t k) const
+		{
+			return load<flat_output_port>(
+				sizeof(flat_config_header)
+				+ input_count()*sizeof(flat_input_port)
+				+ k*sizeof(flat_output_port)
+			);
+		}
+
+		flat_string path_entry(size_t k) const
+		{
+			return load<flat_string>(
+				sizeof(flat_config_header)
+				+ input_count()*sizeof(flat_input_port)
+				+ output_count()*sizeof(flat_output_port)
+				+ k*sizeof(flat_string)
+			);
+		}
+
+		void validate(flat_string str) const
+		{
+			if(static_cast<uint64_t>(str.offset) + str.size > std::size(m_data))
+			{ throw std::runtime_error{"Startup config has an invalid string"}; }
+		}
+
+		std::string_view get(flat_string str) const
+		{ return std::string_view{reinterpret_cast<char const*>(std::data(m_data)) + str.offset, str.size}; }
+
+		template<class GetName>
+		static size_t lower_bound(size_t count, std::string_view name, GetName&& get_name)
+		{
+			size_t first = 0;
+			while(count != 0)
+			{
+				auto const half = count/2;
+				if(get_name(first + half) < name)
+				{
+					first += half + 1;
+					count -= half + 1;
+				}
+				else
+				{ count = half; }
+			}
+			return first;
+		}
+
+		std::span<std::byte const> m_data;
+		flat_config_header m_header;
+	};
+
+	/**
+	 * \brief Converts a flat_startup_config_view to a startup_config
+	 *
+	 * When connected to a host, the socket type is queried from the socket itself.
+	 */
+	inline startup_config make_startup_config(flat_startup_config_view const& view)
+	{
+		if(view.operational_mode() == flat_operational_mode::connected_to_host)
+		{
+			return host_info{
+				.address = make_host_address(validate_socket_fd(static_cast<jopp::number>(view.socket_fd())))
+			};
+		}
+
+		standalone_config ret;
+		for(size_t k = 0; k != view.input_count(); ++k)
+		{
+			auto const port = view.input(k);
+			ret.inputs.insert(std::pair{port_name{port.name}, std::filesystem::path{port.path}});
+		}
+
+		for(size_t k = 0; k != view.output_count(); ++k)
+		{
+			std::vector<std::filesystem::path> paths;
+			for(size_t i = 0; i != view.output_path_count(k); ++i)
+			{ paths.push_back(view.output_path(k, i)); }
+			ret.outputs.insert(std::pair{port_name{view.output_name(k)}, std::move(paths)});
+		}
+		return ret;
+	}
+
+	/**
+	 * \brief Stores cfg in a sealed memfd, that can be passed to a client
+	 */
+	inline os_services::memory::memfd make_startup_config_memfd(startup_config const& cfg)
+	{
+		auto const data = to_flat_startup_config(cfg);
+		auto ret = os_services::memory::make_memfd("startup_config");
+		os_services::memory::truncate(ret.get(), std::size(data));
+		{
+			os_services::memory::mapped_region region{
+				ret.get(),
+				std::size(data),
+				os_services::memory::access_mode::read_write
+			};
+			memcpy(region.data(), std::data(data), std::size(data));
+		}
+		os_services::memory::seal(ret.get());
+		return ret;
+	}
+
+	/**
+	 * \brief A flat startup config mapped from a memfd
+	 */
+	class mapped_startup_config
+	{
+	public:
+		/**
+		 * \brief Maps the startup config stored in fd
+		 * \throw std::runtime_error if fd has not been sealed, or does not hold a valid config
+		 */
+		explicit mapped_startup_config(os_services::memory::memfd_ref fd):
+			m_region{map(fd)},
+			m_view{m_region.bytes()}
+		{}
+
+		/**
+		 * \brief Returns a view of the config
+		 * \note The view is valid as long as this object exists
+		 */
+		flat_startup_config_view const& view() const noexcept
+		{ return m_view; }
+
+	private:
+		static os_services::memory::mapped_region map(os_services::memory::memfd_ref fd)
+		{
+			if(!os_services::memory::is_sealed(fd))
+			{ throw std::runtime_error{"Startup config has not been sealed"}; }
+
+			return os_services::memory::mapped_region{
+				fd,
+				os_services::memory::get_size(fd),
+				os_services::memory::access_mode::read_only
+			};
+		}
+
+		os_services::memory::mapped_region m_region;
+		flat_startup_config_view m_view;
+	};
+
+	/**
+	 * \brief The command line option used to pass a startup config memfd to a client
+	 */
+	constexpr std::string_view startup_config_fd_option{"--startup-config-fd="};
+
+	/**
+	 * \brief Creates the command line argument used to pass fd to a client
+	 */
+	inline std::string make_startup_config_fd_argument(os_services::memory::memfd_ref fd)
+	{ return std::format("{}{}", startup_config_fd_option, fd.native_handle()); }
+
+	/**
+	 * \brief Extracts the memfd from a command line argument created by
+	 *        make_startup_config_fd_argument
+	 * \return The memfd, or an empty optional if arg does not refer to a memfd
+	 * \throw std::runtime_error if arg has the right prefix, but no valid file descriptor
+	 */
+	inline std::optional<os_services::memory::memfd_ref> parse_startup_config_fd_argument(std::string_view arg)
+	{
+		if(!arg.starts_with(startup_config_fd_option))
+		{ return std::nullopt; }
+
+		arg.remove_prefix(std::size(startup_config_fd_option));
+		int fd{};
+		auto const res = std::from_chars(std::data(arg), std::data(arg) + std::size(arg), fd);
+		if(res.ec != std::errc{} || res.ptr != std::data(arg) + std::size(arg) || fd < 0)
+		{ throw std::runtime_error{"Invalid startup config fd"}; }
+
+		return os_services::memory::memfd_ref{fd};
+	}
+}
+
+#endif
@@ -0,0 +1,149 @@
+//@	{"target":{"name":"flat_startup_config.test"}}
+
+#include "./flat_startup_config.hpp"
+
+#include "src/os_services/ipc/socket_pair.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	Pipe::client_ctl::standalone_config make_standalone_config()
+	{
+		return Pipe::client_ctl::standalone_config{
+			.inputs = Pipe::client_ctl::input_port_file_map{
+				{"port_b", "Brick_Victorian_Red_Normal.exr"},
+				{"port_a", "Concrete_Scuffed_Industrial_BaseColor.exr"},
+				{"port_c", "Steel_Galvanized_Rusted_Metallic.exr"}
+			},
+			.outputs = Pipe::client_ctl::output_port_file_map{
+				{"out_1", {"a.exr", "b.exr"}},
+				{"out_2", {}},
+				{"out_3", {"c.exr"}}
+			}
+		};
+	}
+}
+
+TESTCASE(Pipe_client_ctl_flat_startup_config_standalone_round_trip)
+{
+	auto const cfg = make_standalone_config();
+	auto const data = Pipe::client_ctl::to_flat_startup_config(cfg);
+
+	Pipe::client_ctl::flat_startup_config_view const view{data};
+	EXPECT_EQ(view.operational_mode(), Pipe::client_ctl::flat_operational_mode::standalone);
+	REQUIRE_EQ(view.input_count(), 3);
+	EXPECT_EQ(view.input(0).name, "port_a");
+	EXPECT_EQ(view.input(0).path, "Concrete_Scuffed_Industrial_BaseColor.exr");
+	EXPECT_EQ(view.find_input("port_c"), "Steel_Galvanized_Rusted_Metallic.exr");
+	EXPECT_EQ(view.find_input("port_d").has_value(), false);
+	EXPECT_EQ(view.find_input("").has_value(), false);
+
+	// Strings should refer to the buffer
+	auto const path = view.input(1).path;
+	EXPECT_GE(reinterpret_cast<std::byte const*>(std::data(path)), std::data(data));
+	EXPECT_LT(reinterpret_cast<std::byte const*>(std::data(path)), std::data(data) + std::size(data));
+
+	REQUIRE_EQ(view.output_count(), 3);
+	auto const out_1 = view.find_output("out_1");
+	REQUIRE_EQ(out_1.has_value(), true);
+	REQUIRE_EQ(view.output_path_count(*out_1), 2);
+	EXPECT_EQ(view.output_path(*out_1, 1), "b.exr");
+	EXPECT_EQ(view.output_path_count(*view.find_output("out_2")), 0);
+	EXPECT_EQ(view.output_path(*view.find_output("out_3"), 0), "c.exr");
+
+	auto const result = std::get<Pipe::client_ctl::standalone_config>(
+		Pipe::client_ctl::make_startup_config(view)
+	);
+	EXPECT_EQ(result.inputs, cfg.inputs);
+	EXPECT_EQ(result.outputs, cfg.outputs);
+}
+
+TESTCASE(Pipe_client_ctl_flat_startup_config_host_info)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET> sockets;
+	auto const data = Pipe::client_ctl::to_flat_startup_config(
+		Pipe::client_ctl::host_info{
+			.address = Pipe::client_ctl::seqpacket_socket_fd_ref{sockets.socket_a().native_handle()}
+		}
+	);
+
+	Pipe::client_ctl::flat_startup_config_view const view{data};
+	EXPECT_EQ(view.operational_mode(), Pipe::client_ctl::flat_operational_mode::connected_to_host);
+	EXPECT_EQ(view.socket_fd(), sockets.socket_a().native_handle());
+	EXPECT_EQ(view.input_count(), 0);
+
+	auto const result = std::get<Pipe::client_ctl::host_info>(Pipe::client_ctl::make_startup_config(view));
+	EXPECT_EQ(
+		std::get<Pipe::client_ctl::seqpacket_socket_fd_ref>(result.address).native_handle(),
+		sockets.socket_a().native_handle()
+	);
+}
+
+TESTCASE(Pipe_client_ctl_flat_startup_config_invalid)
+{
+	auto const data = Pipe::client_ctl::to_flat_startup_config(make_standalone_config());
+
+	auto expect_error = [](std::span<std::byte const> data, std::string_view expected_message) {
+		try
+		{
+			Pipe::client_ctl::flat_startup_config_view view{data};
+			abort();
+		}
+		catch(std::runtime_error const& err)
+		{ EXPECT_EQ(err.what(), expected_message); }
+	};
+
+	expect_error(std::span{data}.first(16), "Startup config is truncated");
+	expect_error(std::span{data}.first(std::size(data) - 1), "Startup config has an unexpected size");
+
+	auto bad_magic = data;
+	bad_magic[0] = std::byte{'X'};
+	expect_error(bad_magic, "Startup config has an unexpected magic number");
+
+	// Point the first input name outside the buffer
+	auto bad_string = data;
+	Pipe::client_ctl::flat_string const str{.offset = static_cast<uint32_t>(std::size(data)), .size = 1};
+	memcpy(std::data(bad_string) + sizeof(Pipe::client_ctl::flat_config_header), &str, sizeof(str));
+	expect_error(bad_string, "Startup config has an invalid string");
+}
+
+TESTCASE(Pipe_client_ctl_flat_startup_config_memfd)
+{
+	auto const fd = Pipe::client_ctl::make_startup_config_memfd(make_standalone_config());
+	EXPECT_EQ(Pipe::os_services::memory::is_sealed(fd.get()), true);
+
+	auto const arg = Pipe::client_ctl::make_startup_config_fd_argument(fd.get());
+	auto const parsed_fd = Pipe::client_ctl::parse_startup_config_fd_argument(arg);
+	REQUIRE_EQ(parsed_fd.has_value(), true);
+	EXPECT_EQ(parsed_fd->native_handle(), fd.get().native_handle());
+
+	Pipe::client_ctl::mapped_startup_config const cfg{*parsed_fd};
+	EXPECT_EQ(cfg.view().find_input("port_b"), "Brick_Victorian_Red_Normal.exr");
+}
+
+TESTCASE(Pipe_client_ctl_flat_startup_config_memfd_not_sealed)
+{
+	auto const fd = Pipe::os_services::memory::make_memfd("foo");
+	try
+	{
+		Pipe::client_ctl::mapped_startup_config cfg{fd.get()};
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Startup config has not been sealed"}); }
+}
+
+TESTCASE(Pipe_client_ctl_flat_startup_config_parse_fd_argument)
+{
+	EXPECT_EQ(Pipe::client_ctl::parse_startup_config_fd_argument(R"({"foo": "bar"})").has_value(), false);
+	EXPECT_EQ(Pipe::client_ctl::parse_startup_config_fd_argument("--startup-config-fd=12")->native_handle(), 12);
+
+	try
+	{
+		std::ignore = Pipe::client_ctl::parse_startup_config_fd_argument("--startup-config-fd=12a");
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Invalid startup config fd"}); }
+}
@@ -0,0 +1,163 @@
+#ifndef PIPE_CLIENT_CTL_FLOW_CONTROL_HPP
+#define PIPE_CLIENT_CTL_FLOW_CONTROL_HPP
+
+#include "./message.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace Pipe::client_ctl
+{
+	/**
+	 * \brief An amount of credit, in bytes and in messages
+	 */
+	struct credit
+	{
+		uint64_t bytes{0};
+		uint64_t messages{0};
+
+		constexpr bool operator==(credit const&) const noexcept = default;
+	};
+
+	/**
+	 * \brief Adds two amounts of credit, saturating at the max value of uint64_t
+	 */
+	constexpr credit saturating_add(credit a, credit b) noexcept
+	{
+		constexpr auto max = std::numeric_limits<uint64_t>::max();
+		return credit{
+			.bytes = a.bytes > max - b.bytes? max : a.bytes + b.bytes,
+			.messages = a.messages > max - b.messages? max : a.messages + b.messages
+		};
+	}
+
+	/**
+	 * \brief Creates a credit_grant message for port
+	 */
+	constexpr credit_grant make_credit_grant(std::string_view port, credit amount) noexcept
+	{
+		return credit_grant{
+			.port = port,
+			.bytes = amount.bytes,
+			.messages = amount.messages
+		};
+	}
+
+	/**
+	 * \brief The credit that a producer has left for one of its output ports
+	 *
+	 * A producer must not write to the port unless can_send returns true. When the balance
+	 * runs out, the producer should stop writing and wait for the next grant, instead of
+	 * retrying a write that would block.
+	 */
+	class credit_balance
+	{
+	public:
+		/**
+		 * \brief Adds amount to the balance
+		 */
+		constexpr void grant(credit amount) noexcept
+		{ m_available = saturating_add(m_available, amount); }
+
+		/**
+		 * \brief Checks whether or not a message of size bytes may be sent
+		 */
+		constexpr bool can_send(uint64_t size) const noexcept
+		{ return m_available.messages != 0 && m_available.bytes >= size; }
+
+		/**
+		 * \brief Returns the max number of bytes that may be sent in a single message
+		 */
+		constexpr uint64_t max_message_size() const noexcept
+		{ return m_available.messages == 0? 0 : m_available.bytes; }
+
+		/**
+		 * \brief Removes the credit used by sending a message of size bytes
+		 * \throw std::runtime_error if there is not enough credit left
+		 */
+		constexpr void consume(uint64_t size)
+		{
+			if(!can_send(size))
+			{ throw std::runtime_error{"Credit exhausted"}; }
+
+			m_available.bytes -= size;
+			--m_available.messages;
+		}
+
+		/**
+		 * \brief Checks whether or not the balance is too low to send anything
+		 */
+		constexpr bool exhausted() const noexcept
+		{ return m_available.messages == 0 || m_available.bytes == 0; }
+
+		/**
+		 * \brief Returns the credit left
+		 */
+		constexpr credit available() const noexcept
+		{ return m_available; }
+
+	private:
+		credit m_available{};
+	};
+
+	/**
+	 * \brief Decides when a consumer should grant more credit for one of its input ports
+	 *
+	 * The consumer starts by granting the whole window. After that, consumed data is
+	 * accumulated, and granted back once it reaches half the window in either dimension. This
+	 * way, the amount of data in flight never exceeds the window, and the number of grants is
+	 * kept low.
+	 */
+	class credit_window
+	{
+	public:
+		/**
+		 * \brief Constructs a credit_window
+		 * \param size The max amount of data the consumer is willing to buffer
+		 */
+		constexpr explicit credit_window(credit size) noexcept:
+			m_size{size},
+			m_threshold{
+				.bytes = std::max(size.bytes/2, uint64_t{1}),
+				.messages = std::max(size.messages/2, uint64_t{1})
+			}
+		{}
+
+		/**
+		 * \brief Returns the credit to grant when the port is connected
+		 */
+		constexpr credit initial_grant() const noexcept
+		{ return m_size; }
+
+		/**
+		 * \brief Records that the consumer has processed a message of size bytes
+		 * \return The credit to grant, if it is time to grant more credit
+		 */
+		constexpr std::optional<credit> on_consumed(uint64_t size) noexcept
+		{
+			m_consumed = saturating_add(m_consumed, credit{.bytes = size, .messages = 1});
+			if(m_consumed.bytes < m_threshold.bytes && m_consumed.messages < m_threshold.messages)
+			{ return std::nullopt; }
+
+			return std::exchange(m_consumed, credit{});
+		}
+
+		/**
+		 * \brief Returns the size of the window
+		 */
+		constexpr credit size() const noexcept
+		{ return m_size; }
+
+	private:
+		credit m_size;
+		credit m_threshold;
+		credit m_consumed{};
+	};
+}
+
+#endif
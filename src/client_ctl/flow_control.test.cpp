@@ -0,0 +1,61 @@
+//@	{"target":{"name": "flow_control.test"}}
+
+#include "./flow_control.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+TESTCASE(Pipe_client_ctl_flow_control_credit_balance)
+{
+	Pipe::client_ctl::credit_balance balance;
+	EXPECT_EQ(balance.exhausted(), true);
+	EXPECT_EQ(balance.can_send(0), false);
+
+	balance.grant(Pipe::client_ctl::credit{.bytes = 100, .messages = 2});
+	EXPECT_EQ(balance.max_message_size(), 100);
+	EXPECT_EQ(balance.can_send(101), false);
+	balance.consume(60);
+	EXPECT_EQ(balance.can_send(40), true);
+	EXPECT_EQ(balance.can_send(41), false);
+	balance.consume(10);
+	EXPECT_EQ(balance.exhausted(), true);
+	EXPECT_EQ(balance.max_message_size(), 0);
+	EXPECT_EQ((balance.available() == Pipe::client_ctl::credit{.bytes = 30, .messages = 0}), true);
+
+	try
+	{
+		balance.consume(1);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Credit exhausted"}); }
+
+	balance.grant(
+		Pipe::client_ctl::credit{
+			.bytes = std::numeric_limits<uint64_t>::max(),
+			.messages = 1
+		}
+	);
+	EXPECT_EQ(balance.available().bytes, std::numeric_limits<uint64_t>::max());
+}
+
+TESTCASE(Pipe_client_ctl_flow_control_credit_window)
+{
+	Pipe::client_ctl::credit_window window{Pipe::client_ctl::credit{.bytes = 1000, .messages = 8}};
+	EXPECT_EQ((window.initial_grant() == Pipe::client_ctl::credit{.bytes = 1000, .messages = 8}), true);
+
+	EXPECT_EQ(window.on_consumed(200).has_value(), false);
+	EXPECT_EQ(window.on_consumed(200).has_value(), false);
+
+	// Reaching half the window in bytes triggers a grant of everything consumed so far
+	auto const grant = window.on_consumed(100);
+	REQUIRE_EQ(grant.has_value(), true);
+	EXPECT_EQ((*grant == Pipe::client_ctl::credit{.bytes = 500, .messages = 3}), true);
+
+	// So does reaching half the window in messages
+	EXPECT_EQ(window.on_consumed(1).has_value(), false);
+	EXPECT_EQ(window.on_consumed(1).has_value(), false);
+	EXPECT_EQ(window.on_consumed(1).has_value(), false);
+	auto const small_grant = window.on_consumed(1);
+	REQUIRE_EQ(small_grant.has_value(), true);
+	EXPECT_EQ((*small_grant == Pipe::client_ctl::credit{.bytes = 4, .messages = 4}), true);
+}
@@ -0,0 +1,460 @@
+#ifndef PIPE_CLIENT_CTL_MESSAGE_HPP
+#define PIPE_CLIENT_CTL_MESSAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace Pipe::client_ctl
+{
+	/**
+	 * \brief The version of the client_ctl protocol implemented by this file
+	 */
+	constexpr uint32_t protocol_version = 1;
+
+	/**
+	 * \brief Identifies the kind of a message
+	 *
+	 * A response has the same type as the request it responds to.
+	 */
+	enum class message_type:uint16_t
+	{
+		hello = 1,         /**< Sent by the client after it has connected to the host */
+		port_announce = 2, /**< Sent by the client for each port it provides */
+		start = 3,         /**< Requests the client to start processing data */
+		pause = 4,         /**< Requests the client to stop processing data, without losing any data */
+		drain = 5,         /**< Requests the client to process all buffered data, and then pause */
+		shutdown = 6,      /**< Requests the client to exit */
+		stats = 7,         /**< Requests statistics from the client */
+		ready = 8,         /**< Sent by the client when it has finished its initialization */
+		credit_grant = 9   /**< Allows the receiver to send more data through a port */
+	};
+
+	/**
+	 * \brief Converts value to a string
+	 */
+	constexpr char const* to_string(message_type value)
+	{
+		switch(value)
+		{
+			case message_type::hello:
+				return "hello";
+			case message_type::port_announce:
+				return "port_announce";
+			case message_type::start:
+				return "start";
+			case message_type::pause:
+				return "pause";
+			case message_type::drain:
+				return "drain";
+			case message_type::shutdown:
+				return "shutdown";
+			case message_type::stats:
+				return "stats";
+			case message_type::ready:
+				return "ready";
+			case message_type::credit_grant:
+				return "credit_grant";
+		}
+		return "unknown";
+	}
+
+	/**
+	 * \brief Modifies the meaning of a message
+	 */
+	enum class message_flags:uint16_t
+	{
+		none = 0x0,     /**< The message is a request, or an announcement */
+		response = 0x1, /**< The message is a response to the request with the same correlation_id */
+		error = 0x2     /**< The request failed. The payload is an error_info */
+	};
+
+	/**
+	 * \brief Combines two sets of message_flags
+	 */
+	constexpr message_flags operator|(message_flags a, message_flags b)
+	{ return static_cast<message_flags>(static_cast<uint16_t>(a) | static_cast<uint16_t>(b)); }
+
+	/**
+	 * \brief Checks whether or not flag is set in flags
+	 */
+	constexpr bool has_flag(message_flags flags, message_flags flag)
+	{ return (static_cast<uint16_t>(flags) & static_cast<uint16_t>(flag)) != 0; }
+
+	/**
+	 * \brief The fixed part of a message
+	 *
+	 * The header is followed by payload_size bytes of payload. All values are stored in native byte
+	 * order, since the host and its clients always run on the same machine.
+	 */
+	struct message_header
+	{
+		uint32_t payload_size;
+		message_type type;
+		message_flags flags;
+		uint64_t correlation_id;
+	};
+
+	static_assert(sizeof(message_header) == 16);
+	static_assert(std::is_trivially_copyable_v<message_header>);
+
+	/**
+	 * \brief The max size of a message, including its header
+	 *
+	 * Control messages are small, so this is kept low to bound the receive buffer of each client.
+	 */
+	constexpr size_t max_message_size = 4096;
+
+	/**
+	 * \brief The max size of the payload of a message
+	 */
+	constexpr size_t max_payload_size = max_message_size - sizeof(message_header);
+
+	/**
+	 * \brief A received message, referring to the buffer it was received into
+	 */
+	struct message_view
+	{
+		message_header header;
+		std::span<std::byte const> payload;
+	};
+
+	/**
+	 * \brief Computes the size of a payload
+	 */
+	class payload_size_counter
+	{
+	public:
+		template<class ... Fields>
+		void operator()(Fields const& ... fields)
+		{ (add(fields), ...); }
+
+		size_t value() const noexcept
+		{ return m_value; }
+
+	private:
+		void add(std::string_view str)
+		{ m_value += sizeof(uint16_t) + std::size(str); }
+
+		template<class T>
+		requires(std::is_trivially_copyable_v<T>)
+		void add(T const&)
+		{ m_value += sizeof(T); }
+
+		size_t m_value{0};
+	};
+
+	/**
+	 * \brief Writes the fields of a payload to a buffer
+	 * \note Strings are prefixed with their size as an uint16_t
+	 */
+	class payload_writer
+	{
+	public:
+		explicit payload_writer(std::byte* output):m_output{output}
+		{}
+
+		template<class ... Fields>
+		void operator()(Fields const& ... fields)
+		{ (write(fields), ...); }
+
+	private:
+		void write(std::string_view str)
+		{
+			write(static_cast<uint16_t>(std::size(str)));
+			memcpy(m_output, std::data(str), std::size(str));
+			m_output += std::size(str);
+		}
+
+		template<class T>
+		requires(std::is_trivially_copyable_v<T>)
+		void write(T const& value)
+		{
+			memcpy(m_output, &value, sizeof(T));
+			m_output += sizeof(T);
+		}
+
+		std::byte* m_output;
+	};
+
+	/**
+	 * \brief Reads the fields of a payload from a buffer
+	 * \note Strings refer to the buffer they are read from, so no data is copied
+	 */
+	class payload_reader
+	{
+	public:
+		explicit payload_reader(std::span<std::byte const> input):m_input{input}
+		{}
+
+		template<class ... Fields>
+		void operator()(Fields& ... fields)
+		{ (read(fields), ...); }
+
+		/**
+		 * \brief Checks whether or not all fields were read successfully, and the entire input was
+		 *        consumed
+		 */
+		bool completed() const noexcept
+		{ return m_ok && std::size(m_input) == 0; }
+
+	private:
+		void read(std::string_view& str)
+		{
+			uint16_t size{};
+			read(size);
+			if(!m_ok || std::size(m_input) < size)
+			{
+				m_ok = false;
+				return;
+			}
+
+			str = std::string_view{reinterpret_cast<char const*>(std::data(m_input)), size};
+			m_input = m_input.subspan(size);
+		}
+
+		template<class T>
+		requires(std::is_trivially_copyable_v<T>)
+		void read(T& value)
+		{
+			if(!m_ok || std::size(m_input) < sizeof(T))
+			{
+				m_ok = false;
+				return;
+			}
+
+			memcpy(&value, std::data(m_input), sizeof(T));
+			m_input = m_input.subspan(sizeof(T));
+		}
+
+		std::span<std::byte const> m_input;
+		bool m_ok{true};
+	};
+
+	/**
+	 * \brief Sent by a client, after it has connected to the host
+	 */
+	struct hello
+	{
+		static constexpr message_type type = message_type::hello;
+
+		uint32_t protocol_version;
+		uint32_t pid;
+		std::string_view display_name;
+
+		template<class Self, class Archive>
+		static void serialize(Self& self, Archive& ar)
+		{ ar(self.protocol_version, self.pid, self.display_name); }
+	};
+
+	/**
+	 * \brief The direction of a port
+	 */
+	enum class port_direction:uint8_t{input, output};
+
+	/**
+	 * \brief Sent by a client, for each port it provides
+	 */
+	struct port_announce
+	{
+		static constexpr message_type type = message_type::port_announce;
+
+		port_direction direction;
+		std::string_view name;
+		std::string_view content_type;
+
+		template<class Self, class Archive>
+		static void serialize(Self& self, Archive& ar)
+		{ ar(self.direction, self.name, self.content_type); }
+	};
+
+	/**
+	 * \brief Helper for messages without any payload
+	 */
+	template<message_type Type>
+	struct empty_message
+	{
+		static constexpr message_type type = Type;
+
+		template<class Self, class Archive>
+		static void serialize(Self&, Archive&)
+		{}
+	};
+
+	/**
+	 * \brief Requests the client to start processing data
+	 */
+	using start = empty_message<message_type::start>;
+
+	/**
+	 * \brief Requests the client to stop processing data
+	 */
+	using pause = empty_message<message_type::pause>;
+
+	/**
+	 * \brief Requests the client to process all buffered data, and then pause
+	 */
+	using drain = empty_message<message_type::drain>;
+
+	/**
+	 * \brief Requests the client to exit
+	 */
+	using shutdown = empty_message<message_type::shutdown>;
+
+	/**
+	 * \brief Requests statistics from the client
+	 */
+	using stats_request = empty_message<message_type::stats>;
+
+	/**
+	 * \brief Tells the host that the client has finished its initialization, and is ready to
+	 *        process data
+	 */
+	using ready = empty_message<message_type::ready>;
+
+	/**
+	 * \brief Grants credits for sending data through a port
+	 *
+	 * A consumer sends this message for one of its input ports, when it has room for more data.
+	 * The host forwards the grant to the client that produces the data, naming the output port
+	 * that is connected to that input port. Credits add up, so a producer may send data as long
+	 * as it has both byte credits and message credits left.
+	 */
+	struct credit_grant
+	{
+		static constexpr message_type type = message_type::credit_grant;
+
+		std::string_view port;
+		uint64_t bytes;
+		uint64_t messages;
+
+		template<class Self, class Archive>
+		static void serialize(Self& self, Archive& ar)
+		{ ar(self.port, self.bytes, self.messages); }
+	};
+
+	/**
+	 * \brief Statistics reported by a client, as a response to a stats_request
+	 */
+	struct stats_report
+	{
+		static constexpr message_type type = message_type::stats;
+
+		uint64_t bytes_read;
+		uint64_t bytes_written;
+		uint64_t items_processed;
+
+		template<class Self, class Archive>
+		static void serialize(Self& self, Archive& ar)
+		{ ar(self.bytes_read, self.bytes_written, self.items_processed); }
+	};
+
+	/**
+	 * \brief The payload of a response without any data
+	 */
+	struct acknowledgement
+	{
+		template<class Self, class Archive>
+		static void serialize(Self&, Archive&)
+		{}
+	};
+
+	/**
+	 * \brief The payload of a response with the error flag set
+	 */
+	struct error_info
+	{
+		std::string_view message;
+
+		template<class Self, class Archive>
+		static void serialize(Self& self, Archive& ar)
+		{ ar(self.message); }
+	};
+
+	/**
+	 * \brief Computes the number of bytes needed to encode payload, including the message header
+	 */
+	template<class Payload>
+	size_t encoded_size(Payload const& payload)
+	{
+		payload_size_counter counter;
+		Payload::serialize(payload, counter);
+		return sizeof(message_header) + counter.value();
+	}
+
+	/**
+	 * \brief Encodes a message into output
+	 *
+	 * \pre std::size(output) >= encoded_size(payload)
+	 *
+	 * \param output The buffer to write the message to
+	 * \param header The header of the message. The payload size is set by this function.
+	 * \param payload The payload to encode
+	 *
+	 * \return The number of bytes written
+	 */
+	template<class Payload>
+	size_t encode(std::span<std::byte> output, message_header header, Payload const& payload)
+	{
+		auto const size = encoded_size(payload);
+		if(size > max_message_size)
+		{ throw std::runtime_error{"Message is too large"}; }
+
+		header.payload_size = static_cast<uint32_t>(size - sizeof(message_header));
+		memcpy(std::data(output), &header, sizeof(header));
+		payload_writer writer{std::data(output) + sizeof(header)};
+		Payload::serialize(payload, writer);
+		return size;
+	}
+
+	/**
+	 * \brief Decodes the payload of msg
+	 *
+	 * \note Any strings within the returned object refer to the payload of msg
+	 * \note If decoding fails, a message wrapped in an std::unexpected is returned
+	 */
+	template<class Payload>
+	std::expected<Payload, char const*> decode(message_view const& msg)
+	{
+		Payload ret{};
+		payload_reader reader{msg.payload};
+		Payload::serialize(ret, reader);
+		if(!reader.completed())
+		{ return std::unexpected{"Message payload has an unexpected size"}; }
+		return ret;
+	}
+
+	/**
+	 * \brief Reads a message from input
+	 *
+	 * \return The message at the start of input, or an empty optional if input does not start
+	 *         with a complete message
+	 * \throw std::runtime_error if the header announces a payload larger than max_payload_size
+	 */
+	inline std::optional<message_view> read_message(std::span<std::byte const> input)
+	{
+		if(std::size(input) < sizeof(message_header))
+		{ return std::nullopt; }
+
+		message_header header{};
+		memcpy(&header, std::data(input), sizeof(header));
+		if(header.payload_size > max_payload_size)
+		{ throw std::runtime_error{"Message is too large"}; }
+
+		if(std::size(input) - sizeof(header) < header.payload_size)
+		{ return std::nullopt; }
+
+		return message_view{
+			.header = header,
+			.payload = input.subspan(sizeof(header), header.payload_size)
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,110 @@
+//@	{"target":{"name":"message.test"}}
+
+#include "./message.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <array>
+
+TESTCASE(Pipe_client_ctl_message_encode_decode_hello)
+{
+	Pipe::client_ctl::hello const msg{
+		.protocol_version = Pipe::client_ctl::protocol_version,
+		.pid = 1234,
+		.display_name = "My client"
+	};
+
+	std::array<std::byte, 64> buffer{};
+	auto const size = encode(
+		buffer,
+		Pipe::client_ctl::message_header{
+			.payload_size = 0,
+			.type = Pipe::client_ctl::hello::type,
+			.flags = Pipe::client_ctl::message_flags::none,
+			.correlation_id = 42
+		},
+		msg
+	);
+	EXPECT_EQ(size, encoded_size(msg));
+	EXPECT_EQ(size, sizeof(Pipe::client_ctl::message_header) + 4 + 4 + 2 + 9);
+
+	// An incomplete message should not be returned
+	EXPECT_EQ(Pipe::client_ctl::read_message(std::span{std::data(buffer), size - 1}).has_value(), false);
+
+	auto const view = Pipe::client_ctl::read_message(std::span{std::data(buffer), size});
+	REQUIRE_EQ(view.has_value(), true);
+	EXPECT_EQ(view->header.type, Pipe::client_ctl::message_type::hello);
+	EXPECT_EQ(view->header.correlation_id, 42);
+	EXPECT_EQ(view->header.payload_size, size - sizeof(Pipe::client_ctl::message_header));
+
+	auto const decoded = Pipe::client_ctl::decode<Pipe::client_ctl::hello>(*view);
+	REQUIRE_EQ(decoded.has_value(), true);
+	EXPECT_EQ(decoded->protocol_version, Pipe::client_ctl::protocol_version);
+	EXPECT_EQ(decoded->pid, 1234);
+	EXPECT_EQ(decoded->display_name, "My client");
+
+	// The decoded string should refer to the buffer
+	EXPECT_EQ(
+		reinterpret_cast<std::byte const*>(std::data(decoded->display_name)),
+		std::data(buffer) + size - 9
+	);
+}
+
+TESTCASE(Pipe_client_ctl_message_decode_wrong_size)
+{
+	Pipe::client_ctl::stats_report const msg{
+		.bytes_read = 1,
+		.bytes_written = 2,
+		.items_processed = 3
+	};
+
+	std::array<std::byte, 64> buffer{};
+	auto const size = encode(
+		buffer,
+		Pipe::client_ctl::message_header{
+			.payload_size = 0,
+			.type = Pipe::client_ctl::stats_report::type,
+			.flags = Pipe::client_ctl::message_flags::response,
+			.correlation_id = 1
+		},
+		msg
+	);
+
+	auto const view = Pipe::client_ctl::read_message(std::span{std::data(buffer), size});
+	REQUIRE_EQ(view.has_value(), true);
+	EXPECT_EQ(has_flag(view->header.flags, Pipe::client_ctl::message_flags::response), true);
+	EXPECT_EQ(has_flag(view->header.flags, Pipe::client_ctl::message_flags::error), false);
+
+	auto const report = Pipe::client_ctl::decode<Pipe::client_ctl::stats_report>(*view);
+	REQUIRE_EQ(report.has_value(), true);
+	EXPECT_EQ(report->items_processed, 3);
+
+	EXPECT_EQ(Pipe::client_ctl::decode<Pipe::client_ctl::hello>(*view).has_value(), false);
+	EXPECT_EQ(Pipe::client_ctl::decode<Pipe::client_ctl::acknowledgement>(*view).has_value(), false);
+	EXPECT_EQ(
+		Pipe::client_ctl::decode<Pipe::client_ctl::stats_report>(
+			Pipe::client_ctl::message_view{
+				.header = view->header,
+				.payload = view->payload.first(8)
+			}
+		).has_value(),
+		false
+	);
+}
+
+TESTCASE(Pipe_client_ctl_message_read_too_large)
+{
+	Pipe::client_ctl::message_header const header{
+		.payload_size = Pipe::client_ctl::max_payload_size + 1,
+		.type = Pipe::client_ctl::message_type::hello,
+		.flags = Pipe::client_ctl::message_flags::none,
+		.correlation_id = 0
+	};
+
+	try
+	{
+		(void)Pipe::client_ctl::read_message(std::as_bytes(std::span{&header, 1}));
+		abort();
+	}
+	catch(std::runtime_error const&)
+	{}
+}
@@ -0,0 +1,426 @@
+#ifndef PIPE_CLIENT_CTL_MESSAGE_BUFFER_HPP
+#define PIPE_CLIENT_CTL_MESSAGE_BUFFER_HPP
+
+#include "./message.hpp"
+
+#include "src/os_services/ipc/socket.hpp"
+
+#include <array>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace Pipe::client_ctl
+{
+	/**
+	 * \brief A budget that is never exhausted
+	 *
+	 * This is the default budget used when receiving messages. An event handler should pass
+	 * a function that forwards to activity_event::consume_budget instead.
+	 */
+	struct unlimited_budget
+	{
+		constexpr bool operator()(size_t) const noexcept
+		{ return true; }
+	};
+
+	/**
+	 * \brief Splits a byte stream into messages
+	 *
+	 * Data is received directly into an internal buffer, which is reused for all messages. Each
+	 * complete message is passed to the caller as a message_view referring to that buffer, so
+	 * decoding a message does not copy any data. After all complete messages have been
+	 * processed, any partial message is moved to the start of the buffer.
+	 */
+	class message_reader
+	{
+	public:
+		/**
+		 * \brief Constructs a message_reader
+		 * \param buffer_size The size of the receive buffer. It is never less than max_message_size.
+		 */
+		explicit message_reader(size_t buffer_size = 2*max_message_size):
+			m_capacity{std::max(buffer_size, max_message_size)},
+			m_buffer{std::make_unique_for_overwrite<std::byte[]>(m_capacity)}
+		{}
+
+		/**
+		 * \brief Returns the part of the buffer that new data should be written to
+		 */
+		std::span<std::byte> free_space() const noexcept
+		{ return std::span{m_buffer.get() + m_end, m_capacity - m_end}; }
+
+		/**
+		 * \brief Marks n bytes of free_space() as received
+		 */
+		void commit(size_t n) noexcept
+		{ m_end += n; }
+
+		/**
+		 * \brief Calls func with each complete message in the buffer
+		 *
+		 * \note The message_view passed to func is only valid until func returns
+		 * \throw std::runtime_error if a message announces a payload larger than max_payload_size
+		 */
+		template<class Func>
+		void for_each_message(Func&& func)
+		{
+			size_t begin = 0;
+			while(true)
+			{
+				auto const msg = read_message(std::span{m_buffer.get() + begin, m_end - begin});
+				if(!msg.has_value())
+				{ break; }
+
+				func(*msg);
+				begin += sizeof(message_header) + std::size(msg->payload);
+			}
+
+			if(begin != 0)
+			{
+				memmove(m_buffer.get(), m_buffer.get() + begin, m_end - begin);
+				m_end -= begin;
+			}
+		}
+
+		/**
+		 * \brief Returns the number of bytes belonging to messages that have not yet been completed
+		 */
+		size_t pending() const noexcept
+		{ return m_end; }
+
+	private:
+		size_t m_capacity;
+		size_t m_end{0};
+		std::unique_ptr<std::byte[]> m_buffer;
+	};
+
+	/**
+	 * \brief Receives data from socket, and calls func with each complete message
+	 *
+	 * This function reads until the operation would block, or until consume_budget returns
+	 * false, so socket should be non-blocking, or used together with an io_multiplexer.
+	 * consume_budget is called with the number of bytes received by each read.
+	 *
+	 * \return false if the peer has closed the connection, true otherwise
+	 */
+	template<auto SocketType, class AddressType, class Func, class ConsumeBudget = unlimited_budget>
+	bool receive_messages(
+		message_reader& reader,
+		os_services::ipc::connected_socket_ref<SocketType, AddressType> socket,
+		Func&& func,
+		ConsumeBudget&& consume_budget = ConsumeBudget{}
+	)
+	{
+		while(true)
+		{
+			auto const read_result = receive_nonblocking(socket, reader.free_space());
+			if(read_result.operation_would_have_blocked())
+			{ return true; }
+
+			if(read_result.bytes_transferred() == 0)
+			{ return false; }
+
+			reader.commit(read_result.bytes_transferred());
+			reader.for_each_message(func);
+
+			if(!consume_budget(read_result.bytes_transferred()))
+			{ return true; }
+		}
+	}
+
+	/**
+	 * \brief Receives messages from a socket that keeps message boundaries
+	 *
+	 * Each message is received into its own slot, so no message is ever split, and no data has
+	 * to be moved. Up to batch_size messages are received by a single syscall.
+	 */
+	class message_batch_reader
+	{
+	public:
+		/**
+		 * \brief Constructs a message_batch_reader
+		 * \param batch_size The max number of messages to receive at once
+		 */
+		explicit message_batch_reader(size_t batch_size = 8):
+			m_buffer{std::make_unique_for_overwrite<std::byte[]>(std::max(batch_size, size_t{1})*max_message_size)},
+			m_iovecs(std::max(batch_size, size_t{1})),
+			m_headers(std::max(batch_size, size_t{1}))
+		{
+			for(size_t k = 0; k != std::size(m_iovecs); ++k)
+			{
+				m_iovecs[k] = iovec{
+					.iov_base = m_buffer.get() + k*max_message_size,
+					.iov_len = max_message_size
+				};
+			}
+		}
+
+		/**
+		 * \brief Receives messages from socket, and calls func with each of them
+		 *
+		 * After each batch, consume_budget is called with the number of bytes in the batch. If
+		 * it returns false, this function returns, even if more messages are available.
+		 *
+		 * \return false if the peer has closed the connection, true if no more messages are
+		 *         available for now, or the budget has been exhausted
+		 * \throw std::runtime_error if a message does not contain exactly one complete message
+		 */
+		template<class AddressType, class Func, class ConsumeBudget = unlimited_budget>
+		bool receive(
+			os_services::ipc::connected_socket_ref<SOCK_SEQPACKET, AddressType> socket,
+			Func&& func,
+			ConsumeBudget&& consume_budget = ConsumeBudget{}
+		)
+		{
+			while(true)
+			{
+				for(size_t k = 0; k != std::size(m_headers); ++k)
+				{
+					m_headers[k] = mmsghdr{
+						.msg_hdr = msghdr{
+							.msg_name = nullptr,
+							.msg_namelen = 0,
+							.msg_iov = &m_iovecs[k],
+							.msg_iovlen = 1,
+							.msg_control = nullptr,
+							.msg_controllen = 0,
+							.msg_flags = 0
+						},
+						.msg_len = 0
+					};
+				}
+
+				auto const count = receive_multiple_nonblocking(socket, std::span{m_headers});
+				if(count == 0)
+				{ return true; }
+
+				size_t bytes_received = 0;
+				for(size_t k = 0; k != count; ++k)
+				{
+					auto const& header = m_headers[k];
+					// Every message has a header, so an empty message means end of stream
+					if(header.msg_len == 0)
+					{ return false; }
+
+					if(header.msg_hdr.msg_flags & MSG_TRUNC)
+					{ throw std::runtime_error{"Message is too large"}; }
+
+					std::span const data{
+						static_cast<std::byte const*>(m_iovecs[k].iov_base),
+						header.msg_len
+					};
+					auto const msg = read_message(data);
+					if(!msg.has_value() || sizeof(message_header) + std::size(msg->payload) != std::size(data))
+					{ throw std::runtime_error{"Message framing is corrupt"}; }
+
+					func(*msg);
+					bytes_received += std::size(data);
+				}
+
+				if(count != std::size(m_headers) || !consume_budget(bytes_received))
+				{ return true; }
+			}
+		}
+
+	private:
+		std::unique_ptr<std::byte[]> m_buffer;
+		std::vector<iovec> m_iovecs;
+		std::vector<mmsghdr> m_headers;
+	};
+
+	/**
+	 * \brief Receives available messages from socket, until consume_budget returns false, and
+	 *        calls func with each of them
+	 * \return false if the peer has closed the connection, true otherwise
+	 */
+	template<class AddressType, class Func, class ConsumeBudget = unlimited_budget>
+	bool receive_messages(
+		message_batch_reader& reader,
+		os_services::ipc::connected_socket_ref<SOCK_SEQPACKET, AddressType> socket,
+		Func&& func,
+		ConsumeBudget&& consume_budget = ConsumeBudget{}
+	)
+	{
+		return reader.receive(
+			socket,
+			std::forward<Func>(func),
+			std::forward<ConsumeBudget>(consume_budget)
+		);
+	}
+
+	/**
+	 * \brief Selects the reader to use for SocketType
+	 */
+	template<auto SocketType>
+	using message_reader_for = std::conditional_t<
+		SocketType == SOCK_SEQPACKET,
+		message_batch_reader,
+		message_reader
+	>;
+
+	/**
+	 * \brief Queues encoded messages until they can be sent
+	 *
+	 * Messages are encoded into a buffer that is reused, so on a stream socket, a burst of
+	 * pipelined requests results in a single send call.
+	 */
+	class message_writer
+	{
+	public:
+		/**
+		 * \brief Appends a message to the queue
+		 */
+		template<class Payload>
+		void push(message_header const& header, Payload const& payload)
+		{
+			auto const offset = std::size(m_buffer);
+			m_buffer.resize(offset + encoded_size(payload));
+			encode(std::span{std::data(m_buffer) + offset, std::size(m_buffer) - offset}, header, payload);
+		}
+
+		/**
+		 * \brief Appends a message to the queue, using the message type of payload
+		 */
+		template<class Payload>
+		void push(Payload const& payload, uint64_t correlation_id, message_flags flags = message_flags::none)
+		{
+			push(
+				message_header{
+					.payload_size = 0,
+					.type = Payload::type,
+					.flags = flags,
+					.correlation_id = correlation_id
+				},
+				payload
+			);
+		}
+
+		/**
+		 * \brief Returns the data that has not yet been sent
+		 */
+		std::span<std::byte const> pending() const noexcept
+		{ return std::span{std::data(m_buffer) + m_offset, std::size(m_buffer) - m_offset}; }
+
+		/**
+		 * \brief Returns the first message that has not yet been sent
+		 * \pre The first message has not been partially consumed
+		 */
+		std::span<std::byte const> next_message() const
+		{
+			auto const data = pending();
+			auto const msg = read_message(data);
+			return msg.has_value()?
+				data.first(sizeof(message_header) + std::size(msg->payload)) :
+				std::span<std::byte const>{};
+		}
+
+		/**
+		 * \brief Checks whether or not all messages have been sent
+		 */
+		bool empty() const noexcept
+		{ return m_offset == std::size(m_buffer); }
+
+		/**
+		 * \brief Marks n bytes of pending() as sent
+		 */
+		void consume(size_t n) noexcept
+		{
+			m_offset += n;
+			if(m_offset == std::size(m_buffer))
+			{
+				m_buffer.clear();
+				m_offset = 0;
+			}
+		}
+
+	private:
+		std::vector<std::byte> m_buffer;
+		size_t m_offset{0};
+	};
+
+	/**
+	 * \brief The max number of messages sent by a single syscall, on a socket that keeps message
+	 *        boundaries
+	 */
+	constexpr size_t max_send_batch_size = 16;
+
+	/**
+	 * \brief Sends as much queued data as possible to socket, without blocking
+	 *
+	 * If socket keeps message boundaries, each message is sent as its own packet, so the peer
+	 * receives exactly one message at a time. Up to max_send_batch_size messages are sent by a
+	 * single syscall.
+	 *
+	 * \return true if all queued messages were sent
+	 */
+	template<auto SocketType, class AddressType>
+	bool send_messages(
+		message_writer& writer,
+		os_services::ipc::connected_socket_ref<SocketType, AddressType> socket
+	)
+	{
+		if constexpr(os_services::ipc::message_socket_type<SocketType>)
+		{
+			std::array<iovec, max_send_batch_size> iovecs;
+			std::array<mmsghdr, max_send_batch_size> headers;
+			while(!writer.empty())
+			{
+				auto pending = writer.pending();
+				size_t count = 0;
+				while(count != max_send_batch_size)
+				{
+					auto const msg = read_message(pending);
+					if(!msg.has_value())
+					{ break; }
+
+					auto const size = sizeof(message_header) + std::size(msg->payload);
+					iovecs[count] = iovec{
+						.iov_base = const_cast<std::byte*>(std::data(pending)),
+						.iov_len = size
+					};
+					headers[count] = mmsghdr{
+						.msg_hdr = msghdr{
+							.msg_name = nullptr,
+							.msg_namelen = 0,
+							.msg_iov = &iovecs[count],
+							.msg_iovlen = 1,
+							.msg_control = nullptr,
+							.msg_controllen = 0,
+							.msg_flags = 0
+						},
+						.msg_len = 0
+					};
+					pending = pending.subspan(size);
+					++count;
+				}
+
+				auto const sent = send_multiple_nonblocking(socket, std::span{std::data(headers), count});
+				if(sent == 0)
+				{ return false; }
+
+				size_t bytes_sent = 0;
+				for(size_t k = 0; k != sent; ++k)
+				{ bytes_sent += iovecs[k].iov_len; }
+				writer.consume(bytes_sent);
+			}
+			return true;
+		}
+		else
+		{
+			while(!writer.empty())
+			{
+				auto const write_result = send_nonblocking(socket, writer.pending());
+				if(write_result.operation_would_have_blocked())
+				{ return false; }
+
+				writer.consume(write_result.bytes_transferred());
+			}
+			return true;
+		}
+	}
+}
+
+#endif
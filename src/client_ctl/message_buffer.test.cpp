@@ -0,0 +1,180 @@
+//@	{"target":{"name":"message_buffer.test"}}
+
+#include "./message_buffer.hpp"
+
+#include "src/os_services/ipc/socket_pair.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <string>
+#include <vector>
+
+TESTCASE(Pipe_client_ctl_message_reader_partial_messages)
+{
+	Pipe::client_ctl::message_writer writer;
+	writer.push(Pipe::client_ctl::start{}, 1);
+	writer.push(
+		Pipe::client_ctl::port_announce{
+			.direction = Pipe::client_ctl::port_direction::output,
+			.name = "stdout",
+			.content_type = "text/plain"
+		},
+		2
+	);
+	writer.push(Pipe::client_ctl::shutdown{}, 3);
+
+	auto const data = writer.pending();
+	Pipe::client_ctl::message_reader reader;
+	std::vector<uint64_t> ids;
+	std::string port_name;
+
+	// Feed the reader one byte at a time, so every message is split
+	for(auto item : data)
+	{
+		auto const free_space = reader.free_space();
+		REQUIRE_GE(std::size(free_space), 1);
+		free_space[0] = item;
+		reader.commit(1);
+		reader.for_each_message([&ids, &port_name](auto const& msg) {
+			ids.push_back(msg.header.correlation_id);
+			if(msg.header.type == Pipe::client_ctl::message_type::port_announce)
+			{
+				auto const decoded = Pipe::client_ctl::decode<Pipe::client_ctl::port_announce>(msg);
+				REQUIRE_EQ(decoded.has_value(), true);
+				port_name = decoded->name;
+			}
+		});
+	}
+
+	EXPECT_EQ(ids, (std::vector<uint64_t>{1, 2, 3}));
+	EXPECT_EQ(port_name, "stdout");
+	EXPECT_EQ(reader.pending(), 0);
+}
+
+TESTCASE(Pipe_client_ctl_message_writer_consume)
+{
+	Pipe::client_ctl::message_writer writer;
+	EXPECT_EQ(writer.empty(), true);
+
+	writer.push(Pipe::client_ctl::pause{}, 1);
+	EXPECT_EQ(writer.empty(), false);
+	EXPECT_EQ(std::size(writer.pending()), sizeof(Pipe::client_ctl::message_header));
+
+	writer.consume(4);
+	EXPECT_EQ(std::size(writer.pending()), sizeof(Pipe::client_ctl::message_header) - 4);
+
+	writer.consume(sizeof(Pipe::client_ctl::message_header) - 4);
+	EXPECT_EQ(writer.empty(), true);
+	EXPECT_EQ(std::size(writer.pending()), 0);
+}
+
+TESTCASE(Pipe_client_ctl_message_send_and_receive_pipelined)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_STREAM> sockets;
+
+	Pipe::client_ctl::message_writer writer;
+	for(uint64_t k = 0; k != 1000; ++k)
+	{ writer.push(Pipe::client_ctl::stats_request{}, k); }
+	EXPECT_EQ(send_messages(writer, sockets.socket_a()), true);
+
+	Pipe::client_ctl::message_reader reader{Pipe::client_ctl::max_message_size};
+	uint64_t expected_id = 0;
+	while(expected_id != 1000)
+	{
+		auto const status = receive_messages(reader, sockets.socket_b(), [&expected_id](auto const& msg){
+			EXPECT_EQ(msg.header.type, Pipe::client_ctl::message_type::stats);
+			EXPECT_EQ(msg.header.correlation_id, expected_id);
+			++expected_id;
+		});
+		REQUIRE_EQ(status, true);
+	}
+
+	sockets.close_socket_a();
+	EXPECT_EQ(receive_messages(reader, sockets.socket_b(), [](auto const&){ abort(); }), false);
+}
+
+TESTCASE(Pipe_client_ctl_message_batch_reader_seqpacket)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET> sockets;
+
+	Pipe::client_ctl::message_writer writer;
+	for(uint64_t k = 0; k != 20; ++k)
+	{
+		writer.push(
+			Pipe::client_ctl::port_announce{
+				.direction = Pipe::client_ctl::port_direction::input,
+				.name = std::string_view{"abcdefghijklmnopqrst"}.substr(0, k),
+				.content_type = "text/plain"
+			},
+			k
+		);
+	}
+	EXPECT_EQ(send_messages(writer, sockets.socket_a()), true);
+
+	Pipe::client_ctl::message_batch_reader reader{8};
+	uint64_t expected_id = 0;
+	auto const status = receive_messages(reader, sockets.socket_b(), [&expected_id](auto const& msg){
+		EXPECT_EQ(msg.header.correlation_id, expected_id);
+		auto const decoded = Pipe::client_ctl::decode<Pipe::client_ctl::port_announce>(msg);
+		REQUIRE_EQ(decoded.has_value(), true);
+		EXPECT_EQ(std::size(decoded->name), expected_id);
+		++expected_id;
+	});
+	EXPECT_EQ(status, true);
+	EXPECT_EQ(expected_id, 20);
+
+	sockets.close_socket_a();
+	EXPECT_EQ(receive_messages(reader, sockets.socket_b(), [](auto const&){ abort(); }), false);
+}
+
+TESTCASE(Pipe_client_ctl_message_batch_reader_seqpacket_budget)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET> sockets;
+
+	Pipe::client_ctl::message_writer writer;
+	for(uint64_t k = 0; k != 20; ++k)
+	{ writer.push(Pipe::client_ctl::start{}, k); }
+	EXPECT_EQ(send_messages(writer, sockets.socket_a()), true);
+
+	Pipe::client_ctl::message_batch_reader reader{8};
+	uint64_t expected_id = 0;
+	auto const check_id = [&expected_id](auto const& msg){
+		EXPECT_EQ(msg.header.correlation_id, expected_id);
+		++expected_id;
+	};
+
+	// The budget is exhausted after the first batch, so the remaining messages are left in
+	// the socket
+	size_t budget_calls = 0;
+	auto const exhausted = [&budget_calls](size_t num_bytes) {
+		EXPECT_EQ(num_bytes, 8*sizeof(Pipe::client_ctl::message_header));
+		++budget_calls;
+		return false;
+	};
+	EXPECT_EQ(receive_messages(reader, sockets.socket_b(), check_id, exhausted), true);
+	EXPECT_EQ(budget_calls, 1);
+	EXPECT_EQ(expected_id, 8);
+
+	EXPECT_EQ(receive_messages(reader, sockets.socket_b(), check_id), true);
+	EXPECT_EQ(expected_id, 20);
+}
+
+TESTCASE(Pipe_client_ctl_message_batch_reader_seqpacket_bad_framing)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET> sockets;
+
+	Pipe::client_ctl::message_writer writer;
+	writer.push(Pipe::client_ctl::start{}, 1);
+	writer.push(Pipe::client_ctl::pause{}, 2);
+
+	// Two messages in one packet is not valid on a seqpacket socket
+	Pipe::os_services::io::write(sockets.socket_a(), writer.pending());
+
+	Pipe::client_ctl::message_batch_reader reader;
+	try
+	{
+		(void)receive_messages(reader, sockets.socket_b(), [](auto const&){});
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Message framing is corrupt"}); }
+}
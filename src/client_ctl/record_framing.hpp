@@ -0,0 +1,287 @@
+#ifndef PIPE_CLIENT_CTL_RECORD_FRAMING_HPP
+#define PIPE_CLIENT_CTL_RECORD_FRAMING_HPP
+
+#include "./content_type.hpp"
+
+#include "src/utils/utils.hpp"
+
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace Pipe::client_ctl
+{
+	/**
+	 * \brief The compile-time layout of a record with fields of type Fields
+	 *
+	 * The layout is computed by utils::compute_struct_info, so a struct with the same members,
+	 * in the same order, has the same layout.
+	 */
+	template<class ... Fields>
+	requires(sizeof...(Fields) != 0 && (std::is_arithmetic_v<Fields> && ...))
+	struct record_layout
+	{
+		/**
+		 * \brief The size and the offset of each field
+		 */
+		static constexpr auto info = utils::compute_struct_info(
+			std::array{utils::struct_field_info{.size = sizeof(Fields), .alignment = alignof(Fields)}...}
+		);
+
+		/**
+		 * \brief The size of each record
+		 */
+		static constexpr size_t size = info.total_size;
+
+		/**
+		 * \brief The type of field K
+		 */
+		template<size_t K>
+		using field_type = std::tuple_element_t<K, std::tuple<Fields...>>;
+
+		/**
+		 * \brief Returns the content type of a stream of records with this layout
+		 */
+		static content_type get_content_type()
+		{
+			return content_type{
+				.media_type = std::string{record_stream_media_type},
+				.fields = {record_field_type_of<Fields>::value...}
+			};
+		}
+
+		/**
+		 * \brief Reads field K of record
+		 * \pre std::size(record) == size
+		 */
+		template<size_t K>
+		static field_type<K> get(std::span<std::byte const> record) noexcept
+		{
+			field_type<K> ret;
+			memcpy(&ret, std::data(record) + info.offsets[K], sizeof(ret));
+			return ret;
+		}
+
+		/**
+		 * \brief Writes value to field K of record
+		 * \pre std::size(record) == size
+		 */
+		template<size_t K>
+		static void set(std::span<std::byte> record, field_type<K> value) noexcept
+		{ memcpy(std::data(record) + info.offsets[K], &value, sizeof(value)); }
+	};
+
+	/**
+	 * \brief The header of a batch of records
+	 *
+	 * The records follow the header directly. Since the header is 8 bytes, records are properly
+	 * aligned if the batch itself is 8-byte aligned.
+	 */
+	struct record_batch_header
+	{
+		uint32_t record_size;
+		uint32_t record_count;
+	};
+
+	static_assert(sizeof(record_batch_header) == 8);
+
+	/**
+	 * \brief The max alignment of any record
+	 */
+	constexpr size_t max_record_alignment = 8;
+
+	/**
+	 * \brief A batch of records, referring to the buffer it was received into
+	 */
+	class record_batch_view
+	{
+	public:
+		/**
+		 * \brief Constructs a record_batch_view
+		 * \pre std::size(data) == record_size*record_count
+		 */
+		explicit record_batch_view(size_t record_size, std::span<std::byte const> data) noexcept:
+			m_record_size{record_size},
+			m_data{data}
+		{}
+
+		/**
+		 * \brief Returns the size of each record
+		 */
+		size_t record_size() const noexcept
+		{ return m_record_size; }
+
+		/**
+		 * \brief Returns the number of records in the batch
+		 */
+		size_t size() const noexcept
+		{ return m_record_size == 0? 0 : std::size(m_data)/m_record_size; }
+
+		/**
+		 * \brief Returns record k
+		 */
+		std::span<std::byte const> operator[](size_t k) const noexcept
+		{ return m_data.subspan(k*m_record_size, m_record_size); }
+
+		/**
+		 * \brief Returns all records, without copying them, as objects of type T
+		 *
+		 * \throw std::runtime_error if the size of T is not equal to the record size, or if the
+		 *        records are not properly aligned for T
+		 */
+		template<class T>
+		requires(std::is_trivially_copyable_v<T>)
+		std::span<T const> as() const
+		{
+			if(sizeof(T) != m_record_size)
+			{ throw std::runtime_error{"Record type does not match the record size"}; }
+
+			if(std::bit_cast<uintptr_t>(std::data(m_data)) % alignof(T) != 0)
+			{ throw std::runtime_error{"Records are not properly aligned"}; }
+
+			// The bytes were written by a syscall, or by memcpy, which implicitly creates objects
+			// of trivially copyable type
+			return std::span{reinterpret_cast<T const*>(std::data(m_data)), size()};
+		}
+
+	private:
+		size_t m_record_size;
+		std::span<std::byte const> m_data;
+	};
+
+	/**
+	 * \brief Returns the total size of a batch of record_count records of size record_size
+	 */
+	constexpr size_t encoded_batch_size(size_t record_size, size_t record_count) noexcept
+	{ return sizeof(record_batch_header) + record_size*record_count; }
+
+	/**
+	 * \brief Reads a batch from the beginning of buffer
+	 *
+	 * \return The batch, or nullopt if buffer does not yet contain a complete batch
+	 * \throw std::runtime_error if the record size of the batch is not expected_record_size
+	 */
+	inline std::optional<record_batch_view> read_record_batch(
+		std::span<std::byte const> buffer,
+		size_t expected_record_size
+	)
+	{
+		if(std::size(buffer) < sizeof(record_batch_header))
+		{ return std::nullopt; }
+
+		record_batch_header header;
+		memcpy(&header, std::data(buffer), sizeof(header));
+		if(header.record_size != expected_record_size)
+		{ throw std::runtime_error{"Record batch has an unexpected record size"}; }
+
+		auto const size = encoded_batch_size(header.record_size, header.record_count);
+		if(std::size(buffer) < size)
+		{ return std::nullopt; }
+
+		return record_batch_view{
+			header.record_size,
+			buffer.subspan(sizeof(record_batch_header), size - sizeof(record_batch_header))
+		};
+	}
+
+	/**
+	 * \brief Builds batches of records
+	 *
+	 * Records are constructed in place, directly in the buffer that will be sent, so the writer
+	 * never copies a record.
+	 */
+	class record_batch_writer
+	{
+	public:
+		/**
+		 * \brief Constructs a record_batch_writer
+		 * \param record_size The size of each record
+		 * \param max_record_count The max number of records in a batch
+		 */
+		explicit record_batch_writer(size_t record_size, size_t max_record_count):
+			m_record_size{record_size},
+			m_max_record_count{max_record_count},
+			m_buffer(
+				(encoded_batch_size(record_size, max_record_count) + max_record_alignment - 1)
+					/max_record_alignment
+			)
+		{
+			if(record_size == 0 || record_size > std::numeric_limits<uint32_t>::max())
+			{ throw std::runtime_error{"Invalid record size"}; }
+
+			if(max_record_count > std::numeric_limits<uint32_t>::max())
+			{ throw std::runtime_error{"Too many records in a batch"}; }
+		}
+
+		/**
+		 * \brief Appends a record to the batch, and returns the memory to write it to
+		 * \pre !full()
+		 */
+		std::span<std::byte> append() noexcept
+		{
+			auto const ret = std::span{bytes() + encoded_batch_size(m_record_size, m_record_count), m_record_size};
+			++m_record_count;
+			return ret;
+		}
+
+		/**
+		 * \brief Appends a record with layout Layout
+		 * \pre !full()
+		 */
+		template<class Layout>
+		std::span<std::byte> append_as()
+		{
+			if(Layout::size != m_record_size)
+			{ throw std::runtime_error{"Record layout does not match the record size"}; }
+			return append();
+		}
+
+		/**
+		 * \brief Checks whether or not the batch is full
+		 */
+		bool full() const noexcept
+		{ return m_record_count == m_max_record_count; }
+
+		/**
+		 * \brief Checks whether or not the batch is empty
+		 */
+		bool empty() const noexcept
+		{ return m_record_count == 0; }
+
+		/**
+		 * \brief Returns the encoded batch, including its header
+		 */
+		std::span<std::byte const> finish() noexcept
+		{
+			record_batch_header const header{
+				.record_size = static_cast<uint32_t>(m_record_size),
+				.record_count = static_cast<uint32_t>(m_record_count)
+			};
+			memcpy(bytes(), &header, sizeof(header));
+			return std::span{bytes(), encoded_batch_size(m_record_size, m_record_count)};
+		}
+
+		/**
+		 * \brief Starts a new batch
+		 */
+		void clear() noexcept
+		{ m_record_count = 0; }
+
+	private:
+		std::byte* bytes() noexcept
+		{ return reinterpret_cast<std::byte*>(std::data(m_buffer)); }
+
+		size_t m_record_size;
+		size_t m_max_record_count;
+		size_t m_record_count{0};
+		std::vector<uint64_t> m_buffer;
+	};
+}
+
+#endif
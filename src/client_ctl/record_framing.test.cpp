@@ -0,0 +1,72 @@
+//@	{"target":{"name": "record_framing.test"}}
+
+#include "./record_framing.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	using sample_layout = Pipe::client_ctl::record_layout<uint8_t, double, uint16_t>;
+
+	struct sample
+	{
+		uint8_t channel;
+		double value;
+		uint16_t flags;
+	};
+
+	static_assert(sample_layout::size == sizeof(sample));
+	static_assert(sample_layout::info.offsets[1] == offsetof(sample, value));
+	static_assert(sample_layout::info.offsets[2] == offsetof(sample, flags));
+}
+
+TESTCASE(Pipe_client_ctl_record_framing_layout)
+{
+	auto const type = sample_layout::get_content_type();
+	EXPECT_EQ(to_string(type), "application/x-pipe-records; fields=u8,f64,u16");
+	EXPECT_EQ(type.record_size(), sample_layout::size);
+}
+
+TESTCASE(Pipe_client_ctl_record_framing_write_and_read)
+{
+	Pipe::client_ctl::record_batch_writer writer{sample_layout::size, 3};
+	EXPECT_EQ(writer.empty(), true);
+	for(uint8_t k = 0; k != 3; ++k)
+	{
+		auto const record = writer.append_as<sample_layout>();
+		sample_layout::set<0>(record, k);
+		sample_layout::set<1>(record, 0.5*k);
+		sample_layout::set<2>(record, static_cast<uint16_t>(100 + k));
+	}
+	EXPECT_EQ(writer.full(), true);
+
+	auto const encoded = writer.finish();
+	EXPECT_EQ(std::size(encoded), Pipe::client_ctl::encoded_batch_size(sample_layout::size, 3));
+
+	// An incomplete batch is not returned
+	EXPECT_EQ(Pipe::client_ctl::read_record_batch(encoded.first(30), sample_layout::size).has_value(), false);
+
+	auto const batch = Pipe::client_ctl::read_record_batch(encoded, sample_layout::size);
+	REQUIRE_EQ(batch.has_value(), true);
+	REQUIRE_EQ(batch->size(), 3);
+	EXPECT_EQ(sample_layout::get<2>((*batch)[1]), 101);
+
+	// Reinterpret in place
+	auto const records = batch->as<sample>();
+	REQUIRE_EQ(std::size(records), 3);
+	EXPECT_EQ(static_cast<void const*>(std::data(records)), static_cast<void const*>(std::data(encoded) + 8));
+	EXPECT_EQ(records[2].channel, 2);
+	EXPECT_EQ(records[2].value, 1.0);
+	EXPECT_EQ(records[2].flags, 102);
+
+	try
+	{
+		std::ignore = Pipe::client_ctl::read_record_batch(encoded, 16);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Record batch has an unexpected record size"}); }
+
+	writer.clear();
+	EXPECT_EQ(std::size(writer.finish()), sizeof(Pipe::client_ctl::record_batch_header));
+}
@@ -0,0 +1,238 @@
+#ifndef PIPE_CLIENT_CTL_STANDALONE_RUNTIME_HPP
+#define PIPE_CLIENT_CTL_STANDALONE_RUNTIME_HPP
+
+#include "./flat_startup_config.hpp"
+
+#include "src/os_services/fs/file.hpp"
+#include "src/os_services/io/io.hpp"
+#include "src/os_services/memory/mapped_region.hpp"
+
+#include <format>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace Pipe::client_ctl
+{
+	/**
+	 * \brief An input file that has been mapped into memory
+	 *
+	 * The mapping is read-only, and the kernel is told that it will be read sequentially, so it
+	 * can read ahead aggressively, and drop pages that have already been consumed.
+	 */
+	class mapped_input_file
+	{
+	public:
+		/**
+		 * \brief Maps the file at path
+		 */
+		explicit mapped_input_file(std::filesystem::path const& path):
+			m_file{os_services::fs::open(path, os_services::fs::open_mode::read_only)},
+			m_region{
+				m_file.get(),
+				os_services::fs::get_size(m_file.get()),
+				os_services::memory::access_mode::read_only
+			}
+		{ m_region.advise(os_services::memory::access_pattern::sequential); }
+
+		/**
+		 * \brief Returns the contents of the file
+		 */
+		std::span<std::byte const> data() const noexcept
+		{ return m_region.bytes(); }
+
+	private:
+		os_services::fs::file m_file;
+		os_services::memory::mapped_region m_region;
+	};
+
+	/**
+	 * \brief Writes the same data to a list of output files
+	 *
+	 * Data is written once, from the buffer of the producer, to the first file. The other files
+	 * are filled by copying ranges of the first file within the kernel. To keep the number of
+	 * syscalls low, ranges are copied in chunks of at least copy_threshold bytes, and when flush
+	 * is called.
+	 */
+	class output_file_fanout
+	{
+	public:
+		/**
+		 * \brief The default min number of bytes to copy to the other files at once
+		 */
+		static constexpr size_t default_copy_threshold = 1024*1024;
+
+		/**
+		 * \brief Creates, or truncates, all files in paths
+		 */
+		explicit output_file_fanout(
+			std::span<std::filesystem::path const> paths,
+			size_t copy_threshold = default_copy_threshold
+		):
+			m_copy_threshold{copy_threshold}
+		{
+			m_files.reserve(std::size(paths));
+			for(auto const& path : paths)
+			{ m_files.push_back(os_services::fs::replace(path)); }
+		}
+
+		/**
+		 * \brief Writes buffer to all files
+		 */
+		void write(std::span<std::byte const> buffer)
+		{
+			if(std::empty(m_files))
+			{
+				m_bytes_written += std::size(buffer);
+				return;
+			}
+
+			while(!std::empty(buffer))
+			{
+				auto const res = os_services::io::write(m_files.front().get(), buffer);
+				buffer = buffer.subspan(res.bytes_transferred());
+				m_bytes_written += res.bytes_transferred();
+			}
+
+			if(m_bytes_written - m_bytes_replicated >= m_copy_threshold)
+			{ flush(); }
+		}
+
+		/**
+		 * \brief Copies all data written so far to the other files
+		 */
+		void flush()
+		{
+			if(m_bytes_written == m_bytes_replicated)
+			{ return; }
+
+			auto const count = m_bytes_written - m_bytes_replicated;
+			auto const offset = static_cast<off_t>(m_bytes_replicated);
+			for(size_t k = 1; k < std::size(m_files); ++k)
+			{
+				auto const res = os_services::fs::copy_range(
+					m_files.front().get(),
+					offset,
+					m_files[k].get(),
+					offset,
+					count
+				);
+				if(res != count)
+				{ throw std::runtime_error{"Output file was truncated while being copied"}; }
+			}
+			m_bytes_replicated = m_bytes_written;
+		}
+
+		/**
+		 * \brief Returns the number of bytes written to the port
+		 */
+		size_t bytes_written() const noexcept
+		{ return m_bytes_written; }
+
+		/**
+		 * \brief Returns the number of files written to
+		 */
+		size_t file_count() const noexcept
+		{ return std::size(m_files); }
+
+	private:
+		std::vector<os_services::fs::file> m_files;
+		size_t m_copy_threshold;
+		size_t m_bytes_written{0};
+		size_t m_bytes_replicated{0};
+	};
+
+	/**
+	 * \brief The data plane of a client running in standalone mode
+	 *
+	 * Each input port is backed by a mapped_input_file, and each output port by an
+	 * output_file_fanout.
+	 */
+	class standalone_runtime
+	{
+		template<class Map>
+		static auto& find_port(Map& ports, std::string_view name, char const* kind)
+		{
+			auto const i = ports.find(name);
+			if(i == std::end(ports))
+			{ throw std::runtime_error{std::format("There is no {} port named {}", kind, name)}; }
+			return i->second;
+		}
+
+	public:
+		/**
+		 * \brief Opens all files referred to by cfg
+		 */
+		explicit standalone_runtime(standalone_config const& cfg)
+		{
+			for(auto const& item : cfg.inputs)
+			{ m_inputs.emplace(item.first, mapped_input_file{item.second}); }
+
+			for(auto const& item : cfg.outputs)
+			{ m_outputs.emplace(item.first, output_file_fanout{std::span{item.second}}); }
+		}
+
+		/**
+		 * \brief Opens all files referred to by cfg, without converting it to a standalone_config
+		 */
+		explicit standalone_runtime(flat_startup_config_view const& cfg)
+		{
+			for(size_t k = 0; k != cfg.input_count(); ++k)
+			{
+				auto const port = cfg.input(k);
+				m_inputs.emplace(port_name{port.name}, mapped_input_file{std::filesystem::path{port.path}});
+			}
+
+			std::vector<std::filesystem::path> paths;
+			for(size_t k = 0; k != cfg.output_count(); ++k)
+			{
+				paths.clear();
+				for(size_t i = 0; i != cfg.output_path_count(k); ++i)
+				{ paths.push_back(cfg.output_path(k, i)); }
+				m_outputs.emplace(port_name{cfg.output_name(k)}, output_file_fanout{std::span{paths}});
+			}
+		}
+
+		/**
+		 * \brief Returns the contents of the input port name
+		 * \throw std::runtime_error if there is no such port
+		 */
+		std::span<std::byte const> input(std::string_view name) const
+		{ return find_port(m_inputs, name, "input").data(); }
+
+		/**
+		 * \brief Returns the output port name
+		 * \throw std::runtime_error if there is no such port
+		 */
+		output_file_fanout& output(std::string_view name)
+		{ return find_port(m_outputs, name, "output"); }
+
+		/**
+		 * \brief Returns all input ports
+		 */
+		auto const& inputs() const noexcept
+		{ return m_inputs; }
+
+		/**
+		 * \brief Returns all output ports
+		 */
+		auto& outputs() noexcept
+		{ return m_outputs; }
+
+		/**
+		 * \brief Copies all pending data to all output files
+		 */
+		void flush()
+		{
+			for(auto& item : m_outputs)
+			{ item.second.flush(); }
+		}
+
+	private:
+		std::map<port_name, mapped_input_file, std::less<>> m_inputs;
+		std::map<port_name, output_file_fanout, std::less<>> m_outputs;
+	};
+}
+
+#endif
@@ -0,0 +1,112 @@
+//@	{"target":{"name": "standalone_runtime.test"}}
+
+#include "./standalone_runtime.hpp"
+
+#include "src/test_utils/temp_dir.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	std::string read_file(std::filesystem::path const& path)
+	{
+		std::ifstream input{path};
+		std::stringstream ret;
+		ret << input.rdbuf();
+		return ret.str();
+	}
+}
+
+TESTCASE(Pipe_client_ctl_standalone_runtime_inputs_and_outputs)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_standalone"};
+	{
+		std::ofstream input{dir.path()/"input"};
+		input << "Hello, World";
+	}
+
+	Pipe::client_ctl::standalone_config const cfg{
+		.inputs = Pipe::client_ctl::input_port_file_map{{"stdin", dir.path()/"input"}},
+		.outputs = Pipe::client_ctl::output_port_file_map{
+			{"stdout", std::vector{dir.path()/"out_a", dir.path()/"out_b", dir.path()/"out_c"}},
+			{"discard", std::vector<std::filesystem::path>{}}
+		}
+	};
+
+	{
+		Pipe::client_ctl::standalone_runtime runtime{cfg};
+		auto const input = runtime.input("stdin");
+		EXPECT_EQ((std::string_view{reinterpret_cast<char const*>(std::data(input)), std::size(input)}), "Hello, World");
+
+		auto& output = runtime.output("stdout");
+		EXPECT_EQ(output.file_count(), 3);
+		output.write(input.first(5));
+		output.write(input.subspan(5));
+		runtime.output("discard").write(input);
+		EXPECT_EQ(runtime.output("discard").bytes_written(), 12);
+		runtime.flush();
+
+		try
+		{
+			std::ignore = runtime.input("stdout");
+			abort();
+		}
+		catch(std::runtime_error const& err)
+		{ EXPECT_EQ(err.what(), std::string_view{"There is no input port named stdout"}); }
+	}
+
+	EXPECT_EQ(read_file(dir.path()/"out_a"), "Hello, World");
+	EXPECT_EQ(read_file(dir.path()/"out_b"), "Hello, World");
+	EXPECT_EQ(read_file(dir.path()/"out_c"), "Hello, World");
+}
+
+TESTCASE(Pipe_client_ctl_standalone_runtime_fanout_copies_in_chunks)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_standalone"};
+	std::array const paths{dir.path()/"a", dir.path()/"b"};
+	Pipe::client_ctl::output_file_fanout output{std::span{paths}, 4};
+
+	output.write(std::as_bytes(std::span{std::string_view{"ab"}}));
+	EXPECT_EQ(read_file(dir.path()/"b"), "");
+
+	output.write(std::as_bytes(std::span{std::string_view{"cd"}}));
+	EXPECT_EQ(read_file(dir.path()/"b"), "abcd");
+
+	output.write(std::as_bytes(std::span{std::string_view{"e"}}));
+	EXPECT_EQ(read_file(dir.path()/"b"), "abcd");
+	output.flush();
+	EXPECT_EQ(read_file(dir.path()/"a"), "abcde");
+	EXPECT_EQ(read_file(dir.path()/"b"), "abcde");
+}
+
+TESTCASE(Pipe_client_ctl_standalone_runtime_from_flat_config)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_standalone"};
+	{
+		std::ofstream input{dir.path()/"input"};
+		input << "Hello, World";
+	}
+
+	auto const data = Pipe::client_ctl::to_flat_startup_config(
+		Pipe::client_ctl::standalone_config{
+			.inputs = Pipe::client_ctl::input_port_file_map{{"stdin", dir.path()/"input"}},
+			.outputs = Pipe::client_ctl::output_port_file_map{
+				{"stdout", std::vector{dir.path()/"out_a", dir.path()/"out_b"}}
+			}
+		}
+	);
+
+	{
+		Pipe::client_ctl::standalone_runtime runtime{Pipe::client_ctl::flat_startup_config_view{data}};
+		EXPECT_EQ(std::size(runtime.inputs()), 1);
+		auto& output = runtime.output("stdout");
+		EXPECT_EQ(output.file_count(), 2);
+		output.write(runtime.input("stdin"));
+		runtime.flush();
+	}
+
+	EXPECT_EQ(read_file(dir.path()/"out_a"), "Hello, World");
+	EXPECT_EQ(read_file(dir.path()/"out_b"), "Hello, World");
+}
@@ -22,10 +22,17 @@ namespace Pipe::client_ctl
 	{};
 
 	/**
-	 * \brief The type of socket to use for the client_ctl protocol
+	 * \brief The type of socket to use for the client_ctl protocol, when messages are framed by
+	 *        the client_ctl layer
 	 */
 	using socket_fd_ref = os_services::ipc::connected_socket_ref<SOCK_STREAM, sockaddr_un>;
 
+	/**
+	 * \brief The type of socket to use for the client_ctl protocol, when message boundaries are
+	 *        kept by the kernel
+	 */
+	using seqpacket_socket_fd_ref = os_services::ipc::connected_socket_ref<SOCK_SEQPACKET, sockaddr_un>;
+
 	/**
 	 * \brief Specialization of host_address_type_info for socket_fd_ref
 	 */
@@ -39,6 +46,18 @@ namespace Pipe::client_ctl
 		static constexpr const char* name = "socket_fd";
 	};
 
+	/**
+	 * \brief Specialization of host_address_type_info for seqpacket_socket_fd_ref
+	 *
+	 * The socket type is not part of the serialized host_address. Instead, it is queried from the
+	 * socket itself.
+	 */
+	template<>
+	struct host_address_type_info<seqpacket_socket_fd_ref>
+	{
+		static constexpr const char* name = "socket_fd";
+	};
+
 	/**
 	 * \brief Converts a socket_fd_ref to jopp::number
 	 */
@@ -48,9 +67,26 @@ namespace Pipe::client_ctl
 	}
 
 	/**
-	 * \brief Converts a jopp::number to a socket_fd_ref
+	 * \brief Converts a seqpacket_socket_fd_ref to jopp::number
 	 */
-	inline socket_fd_ref make_socket_fd_ref(jopp::number value)
+	inline jopp::number to_jopp_value(seqpacket_socket_fd_ref value)
+	{
+		return static_cast<jopp::number>(value.native_handle());
+	}
+
+	/**
+	 * \brief Holds a validated socket_fd, together with its socket type
+	 */
+	struct socket_fd_info
+	{
+		int fd;
+		int type;
+	};
+
+	/**
+	 * \brief Checks that value refers to an open socket, and retrieves its socket type
+	 */
+	inline socket_fd_info validate_socket_fd(jopp::number value)
 	{
 		if(value < 0.0 || value > 2147483647.0)
 		{ throw std::runtime_error{"Invalid socket_fd"};}
@@ -66,13 +102,42 @@ namespace Pipe::client_ctl
 		if(!S_ISSOCK(statbuf.st_mode))
 		{ throw std::runtime_error{"socket_fd is not a socket"}; }
 
-		return socket_fd_ref{fd_val};
+		int type{};
+		socklen_t type_size = sizeof(type);
+		if(::getsockopt(fd_val, SOL_SOCKET, SO_TYPE, &type, &type_size) == -1)
+		{ throw os_services::error_handling::system_error{"Failed to query the type of socket_fd", errno}; }
+
+		return socket_fd_info{.fd = fd_val, .type = type};
+	}
+
+	/**
+	 * \brief Converts a jopp::number to a socket_fd_ref
+	 */
+	inline socket_fd_ref make_socket_fd_ref(jopp::number value)
+	{
+		auto const info = validate_socket_fd(value);
+		if(info.type != SOCK_STREAM)
+		{ throw std::runtime_error{"socket_fd is not a stream socket"}; }
+
+		return socket_fd_ref{info.fd};
+	}
+
+	/**
+	 * \brief Converts a jopp::number to a seqpacket_socket_fd_ref
+	 */
+	inline seqpacket_socket_fd_ref make_seqpacket_socket_fd_ref(jopp::number value)
+	{
+		auto const info = validate_socket_fd(value);
+		if(info.type != SOCK_SEQPACKET)
+		{ throw std::runtime_error{"socket_fd is not a seqpacket socket"}; }
+
+		return seqpacket_socket_fd_ref{info.fd};
 	}
 
 	/**
 	 * \brief The possible ways of specifying a host_address
 	 */
-	using host_address = std::variant<socket_fd_ref>;
+	using host_address = std::variant<socket_fd_ref, seqpacket_socket_fd_ref>;
 
 	/**
 	 * \brief Converts a host_address to a jopp::object
@@ -90,6 +155,22 @@ namespace Pipe::client_ctl
 		);
 	}
 
+	/**
+	 * \brief Converts a validated socket_fd to a host_address of the matching socket type
+	 */
+	inline host_address make_host_address(socket_fd_info info)
+	{
+		switch(info.type)
+		{
+			case SOCK_STREAM:
+				return socket_fd_ref{info.fd};
+			case SOCK_SEQPACKET:
+				return seqpacket_socket_fd_ref{info.fd};
+			default:
+				throw std::runtime_error{"socket_fd has an unsupported socket type"};
+		}
+	}
+
 	/**
 	 * \brief Converts a jopp::object to a host_address
 	 */
@@ -97,7 +178,7 @@ namespace Pipe::client_ctl
 	{
 		auto const& type = obj.get_field_as<jopp::string>("type");
 		if(type == host_address_type_info<socket_fd_ref>::name)
-		{ return make_socket_fd_ref(obj.get_field_as<jopp::number>("value")); }
+		{ return make_host_address(validate_socket_fd(obj.get_field_as<jopp::number>("value"))); }
 
 		throw std::runtime_error{"The given host address type is not supported"};
 	}
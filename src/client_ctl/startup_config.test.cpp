@@ -81,6 +81,22 @@ TESTCASE(Pipe_client_ctl_startup_config_make_socket_fd_ref_from_jopp_number)
 	EXPECT_EQ(result.native_handle(), sockets.socket_a());
 }
 
+TESTCASE(Pipe_client_ctl_startup_config_make_socket_fd_ref_from_jopp_number_wrong_socket_type)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET> sockets;
+	jopp::number val{static_cast<double>(sockets.socket_a().native_handle())};
+	try
+	{
+		std::ignore = Pipe::client_ctl::make_socket_fd_ref(val);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"socket_fd is not a stream socket"}); }
+
+	auto const result = Pipe::client_ctl::make_seqpacket_socket_fd_ref(val);
+	EXPECT_EQ(result.native_handle(), sockets.socket_a().native_handle());
+}
+
 TESTCASE(Pipe_client_ctl_startup_config_host_address_to_jopp_object)
 {
 	auto const result = Pipe::client_ctl::to_jopp_object(
@@ -122,6 +138,20 @@ TESTCASE(Pipe_client_ctl_startup_config_make_host_address_from_jopp_object_type_
 	);
 }
 
+TESTCASE(Pipe_client_ctl_startup_config_make_host_address_from_jopp_object_type_socket_fd_seqpacket)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET> sockets;
+	jopp::object obj;
+	obj.insert("type", "socket_fd");
+	obj.insert("value", static_cast<double>(sockets.socket_a().native_handle()));
+
+	auto const result = Pipe::client_ctl::make_host_address(obj);
+	EXPECT_EQ(
+		std::get<Pipe::client_ctl::seqpacket_socket_fd_ref>(result).native_handle(),
+		sockets.socket_a().native_handle()
+	);
+}
+
 TESTCASE(Pipe_client_ctl_startup_config_host_info_to_jopp_object)
 {
 	auto const result = Pipe::client_ctl::to_jopp_object(
@@ -410,7 +440,7 @@ TESTCASE(Pipe_client_ctl_startup_config_startup_config_hostinfo_to_jopp_object)
 	auto const result = to_jopp_object(
 		Pipe::client_ctl::startup_config{
 			Pipe::client_ctl::host_info{
-				.address = Pipe::client_ctl::host_address{324}
+				.address = Pipe::client_ctl::host_address{Pipe::client_ctl::socket_fd_ref{324}}
 			}
 		}
 	);
@@ -0,0 +1,320 @@
+//@	{"target":{"name":"client_info_cache.o"}}
+
+#include "./client_info_cache.hpp"
+
+#include "src/os_services/fs/file.hpp"
+#include "src/os_services/io/io.hpp"
+#include "src/os_services/ipc/pipe.hpp"
+#include "src/os_services/memory/mapped_region.hpp"
+#include "src/os_services/proc_mgmt/proc_mgmt.hpp"
+
+#include <jopp/parser.hpp>
+#include <jopp/serializer.hpp>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <format>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace
+{
+	template<class T>
+	std::optional<T> read_struct(std::span<std::byte const> data, size_t offset)
+	{
+		if(offset > std::size(data) || std::size(data) - offset < sizeof(T))
+		{ return std::nullopt; }
+
+		T ret;
+		memcpy(&ret, std::data(data) + offset, sizeof(T));
+		return ret;
+	}
+
+	constexpr size_t note_padding(size_t size)
+	{ return (size + 3) & ~static_cast<size_t>(3); }
+
+	std::optional<std::string> find_build_id_note(std::span<std::byte const> notes)
+	{
+		size_t offset = 0;
+		while(auto const header = read_struct<Elf64_Nhdr>(notes, offset))
+		{
+			auto const name_offset = offset + sizeof(Elf64_Nhdr);
+			auto const desc_offset = name_offset + note_padding(header->n_namesz);
+			if(desc_offset + header->n_descsz > std::size(notes))
+			{ return std::nullopt; }
+
+			constexpr std::string_view gnu_name{"GNU", 4};
+			if(header->n_type == NT_GNU_BUILD_ID
+				&& header->n_namesz == std::size(gnu_name)
+				&& memcmp(std::data(notes) + name_offset, std::data(gnu_name), std::size(gnu_name)) == 0)
+			{
+				constexpr std::string_view hex_digits{"0123456789abcdef"};
+				std::string ret;
+				ret.reserve(2*header->n_descsz);
+				for(auto const byte : notes.subspan(desc_offset, header->n_descsz))
+				{
+					ret.push_back(hex_digits[static_cast<size_t>(byte >> 4)]);
+					ret.push_back(hex_digits[static_cast<size_t>(byte & std::byte{0xf})]);
+				}
+				return ret;
+			}
+
+			offset = desc_offset + note_padding(header->n_descsz);
+		}
+		return std::nullopt;
+	}
+
+	template<class T>
+	T parse_integer(jopp::object const& obj, std::string_view field)
+	{
+		// Integers are stored as strings, since a jopp::number cannot represent all 64-bit values
+		auto const& str = obj.get_field_as<jopp::string>(field);
+		T ret{};
+		auto const res = std::from_chars(std::data(str), std::data(str) + std::size(str), ret);
+		if(res.ec != std::errc{} || res.ptr != std::data(str) + std::size(str))
+		{ throw std::runtime_error{std::format("Invalid value in field `{}`", field)}; }
+		return ret;
+	}
+
+	Pipe::host::binary_identity load_binary_identity(jopp::object const& obj)
+	{
+		return Pipe::host::binary_identity{
+			.path = obj.get_field_as<jopp::string>("path"),
+			.inode = parse_integer<uint64_t>(obj, "inode"),
+			.device = parse_integer<uint64_t>(obj, "device"),
+			.mtime_ns = parse_integer<int64_t>(obj, "mtime_ns"),
+			.build_id = obj.get_field_as<jopp::string>("build_id")
+		};
+	}
+
+	void write_all(Pipe::os_services::fs::file_ref fd, std::span<std::byte const> data)
+	{
+		while(!data.empty())
+		{ data = data.subspan(Pipe::os_services::io::write(fd, data).bytes_transferred()); }
+	}
+}
+
+std::optional<std::string> Pipe::host::read_elf_build_id(std::span<std::byte const> data)
+{
+	auto const header = read_struct<Elf64_Ehdr>(data, 0);
+	if(!header.has_value()
+		|| memcmp(header->e_ident, ELFMAG, SELFMAG) != 0
+		|| header->e_ident[EI_CLASS] != ELFCLASS64
+		|| header->e_ident[EI_DATA] != (std::endian::native == std::endian::little? ELFDATA2LSB : ELFDATA2MSB)
+		|| header->e_phentsize < sizeof(Elf64_Phdr)
+		|| header->e_phoff > std::size(data))
+	{ return std::nullopt; }
+
+	for(size_t k = 0; k != header->e_phnum; ++k)
+	{
+		auto const phdr = read_struct<Elf64_Phdr>(data, header->e_phoff + k*header->e_phentsize);
+		if(!phdr.has_value())
+		{ return std::nullopt; }
+
+		if(phdr->p_type != PT_NOTE
+			|| phdr->p_offset > std::size(data)
+			|| std::size(data) - phdr->p_offset < phdr->p_filesz)
+		{ continue; }
+
+		if(auto ret = find_build_id_note(data.subspan(phdr->p_offset, phdr->p_filesz)); ret.has_value())
+		{ return ret; }
+	}
+	return std::nullopt;
+}
+
+Pipe::host::binary_identity Pipe::host::make_binary_identity(std::filesystem::path const& path)
+{
+	auto const file = os_services::fs::open(path, os_services::fs::open_mode::read_only);
+	struct stat statbuf{};
+	if(::fstat(file.get().native_handle(), &statbuf) == -1)
+	{ throw os_services::error_handling::system_error{"Failed to get file status", errno}; }
+
+	os_services::memory::mapped_region const image{
+		file.get(),
+		static_cast<size_t>(statbuf.st_size),
+		os_services::memory::access_mode::read_only
+	};
+
+	return binary_identity{
+		.path = std::filesystem::canonical(path),
+		.inode = statbuf.st_ino,
+		.device = statbuf.st_dev,
+		.mtime_ns = static_cast<int64_t>(statbuf.st_mtim.tv_sec)*1'000'000'000 + statbuf.st_mtim.tv_nsec,
+		.build_id = read_elf_build_id(image.bytes()).value_or(std::string{})
+	};
+}
+
+Pipe::client_ctl::client_application_info
+Pipe::host::discover_client_application_info(std::filesystem::path const& path)
+{
+	os_services::ipc::pipe stdout_pipe;
+	std::array args{std::data(client_ctl::discovery_option)};
+	auto const process = os_services::proc_mgmt::spawn(
+		path.c_str(),
+		std::span{args},
+		std::span<char const*>{},
+		os_services::proc_mgmt::io_redirection{
+			.sysin = {},
+			.sysout = stdout_pipe.take_write_end(),
+			.syserr = {}
+		}
+	);
+
+	std::string output;
+	std::array<std::byte, 4096> buffer;
+	while(true)
+	{
+		auto const res = os_services::io::read(stdout_pipe.read_end(), buffer);
+		if(res.bytes_transferred() == 0)
+		{ break; }
+		output.append(reinterpret_cast<char const*>(std::data(buffer)), res.bytes_transferred());
+	}
+
+	auto const status = os_services::proc_mgmt::wait(process.second.get());
+	if(auto const killed = std::get_if<os_services::proc_mgmt::process_killed>(&status); killed != nullptr)
+	{
+		throw std::runtime_error{
+			std::format("{} was killed by signal {} during discovery", path.string(), killed->signo)
+		};
+	}
+
+	if(auto const exit_status = std::get<os_services::proc_mgmt::process_exited>(status).return_value; exit_status != 0)
+	{
+		throw std::runtime_error{
+			std::format("{} exited with status {} during discovery", path.string(), exit_status)
+		};
+	}
+
+	return client_ctl::make_client_application_info(jopp::parse(output).get<jopp::object>());
+}
+
+Pipe::host::client_info_cache::client_info_cache(std::filesystem::path storage):
+	m_storage{std::move(storage)}
+{
+	if(!std::filesystem::exists(m_storage))
+	{ return; }
+
+	try
+	{
+		auto const file = os_services::fs::open(m_storage, os_services::fs::open_mode::read_only);
+		os_services::memory::mapped_region const contents{
+			file.get(),
+			os_services::fs::get_size(file.get()),
+			os_services::memory::access_mode::read_only
+		};
+
+		auto const root = jopp::parse(
+			std::string_view{reinterpret_cast<char const*>(contents.data()), contents.size()}
+		);
+		for(auto const& item : root.get<jopp::object>().get_field_as<jopp::array>("entries"))
+		{
+			auto const& obj = item.get<jopp::object>();
+			insert(
+				load_binary_identity(obj),
+				client_ctl::make_client_application_info(obj.get_field_as<jopp::object>("info"))
+			);
+		}
+	}
+	catch(std::exception const&)
+	{
+		// The cache can always be rebuilt, so a damaged file is treated as an empty cache
+		m_entries.clear();
+	}
+	m_dirty = false;
+}
+
+Pipe::client_ctl::client_application_info const*
+Pipe::host::client_info_cache::find(binary_identity const& binary) const
+{
+	auto const i = m_entries.find(binary.path);
+	if(i == std::end(m_entries) || i->second.binary != binary)
+	{ return nullptr; }
+	return &i->second.info;
+}
+
+void Pipe::host::client_info_cache::insert(binary_identity const& binary, client_ctl::client_application_info info)
+{
+	m_entries.insert_or_assign(binary.path, entry{.binary = binary, .info = std::move(info)});
+	m_dirty = true;
+}
+
+void Pipe::host::client_info_cache::save()
+{
+	jopp::array entries;
+	for(auto const& item : m_entries)
+	{
+		auto const& binary = item.second.binary;
+		jopp::object obj;
+		obj.insert("path", binary.path.string());
+		obj.insert("inode", std::to_string(binary.inode));
+		obj.insert("device", std::to_string(binary.device));
+		obj.insert("mtime_ns", std::to_string(binary.mtime_ns));
+		obj.insert("build_id", binary.build_id);
+		obj.insert("info", to_jopp_object(item.second.info));
+		entries.push_back(std::move(obj));
+	}
+
+	jopp::object root;
+	root.insert("entries", std::move(entries));
+	auto const str = to_string(root);
+
+	if(m_storage.has_parent_path())
+	{ std::filesystem::create_directories(m_storage.parent_path()); }
+
+	// Write to a temporary file first, so the cache is never left partially written
+	auto tmp_path = m_storage;
+	tmp_path += ".tmp";
+	{
+		auto const file = os_services::fs::replace(tmp_path);
+		write_all(file.get(), std::as_bytes(std::span{str}));
+	}
+	std::filesystem::rename(tmp_path, m_storage);
+	m_dirty = false;
+}
+
+std::filesystem::path Pipe::host::default_client_info_cache_path()
+{
+	if(auto const cache_home = ::getenv("XDG_CACHE_HOME"); cache_home != nullptr && *cache_home != '\0')
+	{ return std::filesystem::path{cache_home}/"pipe"/"client_info.json"; }
+
+	if(auto const home = ::getenv("HOME"); home != nullptr && *home != '\0')
+	{ return std::filesystem::path{home}/".cache"/"pipe"/"client_info.json"; }
+
+	throw std::runtime_error{"Cannot locate the client info cache: neither XDG_CACHE_HOME nor HOME is set"};
+}
+
+Pipe::client_ctl::client_application_info Pipe::host::get_client_application_info(
+	client_info_cache& cache,
+	std::filesystem::path const& binary
+)
+{
+	auto const identity = make_binary_identity(binary);
+	if(auto const cached = cache.find(identity); cached != nullptr)
+	{ return *cached; }
+
+	auto info = discover_client_application_info(identity.path);
+	cache.insert(identity, info);
+	return info;
+}
+
+Pipe::host::client_info_map
+Pipe::host::get_client_info(pipeline_graph const& graph, client_info_cache& cache)
+{
+	std::map<std::filesystem::path, client_ctl::client_application_info> by_binary;
+	client_info_map ret;
+	for(auto const& node : graph.nodes)
+	{
+		auto i = by_binary.find(node.second.binary);
+		if(i == std::end(by_binary))
+		{
+			i = by_binary.insert(
+				std::pair{node.second.binary, get_client_application_info(cache, node.second.binary)}
+			).first;
+		}
+		ret.insert(std::pair{node.first, i->second});
+	}
+	return ret;
+}
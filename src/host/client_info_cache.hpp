@@ -0,0 +1,162 @@
+//@	{"dependencies_extra":[{"ref":"./client_info_cache.o", "rel":"implementation"}]}
+
+#ifndef PIPE_HOST_CLIENT_INFO_CACHE_HPP
+#define PIPE_HOST_CLIENT_INFO_CACHE_HPP
+
+#include "./pipeline_graph.hpp"
+
+#include "src/client_ctl/client_application_info.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace Pipe::host
+{
+	/**
+	 * \brief Identifies a particular build of a client binary
+	 *
+	 * If any of the fields changes, the binary may advertise different ports, and must be
+	 * discovered again.
+	 */
+	struct binary_identity
+	{
+		/**
+		 * \brief The canonical path to the binary
+		 */
+		std::filesystem::path path;
+
+		/**
+		 * \brief The inode number of the binary
+		 */
+		uint64_t inode;
+
+		/**
+		 * \brief The device that contains the binary
+		 */
+		uint64_t device;
+
+		/**
+		 * \brief The last modification time of the binary, in nanoseconds since the epoch
+		 */
+		int64_t mtime_ns;
+
+		/**
+		 * \brief The GNU build id of the binary, as a hex string, or an empty string if the
+		 *        binary has no build id
+		 */
+		std::string build_id;
+
+		bool operator==(binary_identity const&) const = default;
+	};
+
+	/**
+	 * \brief Computes the binary_identity of the binary at path
+	 */
+	binary_identity make_binary_identity(std::filesystem::path const& path);
+
+	/**
+	 * \brief Extracts the GNU build id from the ELF image in data
+	 *
+	 * \return The build id as a hex string, or nullopt if data is not a 64-bit ELF image of the
+	 *         native byte order, or if it has no build id note
+	 */
+	std::optional<std::string> read_elf_build_id(std::span<std::byte const> data);
+
+	/**
+	 * \brief Runs the binary at path with client_ctl::discovery_option, and parses the
+	 *        client_application_info it writes to stdout
+	 *
+	 * \throw std::runtime_error if the client does not exit normally with status 0
+	 */
+	client_ctl::client_application_info discover_client_application_info(std::filesystem::path const& path);
+
+	/**
+	 * \brief A persistent cache of the client_application_info of client binaries
+	 *
+	 * Entries are keyed by binary path, and are only returned while the binary_identity still
+	 * matches, so rebuilding or replacing a client invalidates its entry. The cache is stored as
+	 * a JSON file, which is read when the cache is constructed, and written by save.
+	 */
+	class client_info_cache
+	{
+	public:
+		/**
+		 * \brief Constructs a client_info_cache backed by the file storage
+		 *
+		 * If storage does not exist, or cannot be parsed, the cache starts out empty.
+		 */
+		explicit client_info_cache(std::filesystem::path storage);
+
+		/**
+		 * \brief Returns the cached info for binary, or nullptr if there is no up-to-date entry
+		 */
+		client_ctl::client_application_info const* find(binary_identity const& binary) const;
+
+		/**
+		 * \brief Inserts or replaces the entry for binary
+		 */
+		void insert(binary_identity const& binary, client_ctl::client_application_info info);
+
+		/**
+		 * \brief Returns the number of entries in the cache
+		 */
+		size_t size() const noexcept
+		{ return std::size(m_entries); }
+
+		/**
+		 * \brief Checks whether or not the cache has been modified since it was loaded or saved
+		 */
+		bool dirty() const noexcept
+		{ return m_dirty; }
+
+		/**
+		 * \brief Writes the cache to its storage file
+		 *
+		 * The file is replaced atomically, so concurrent readers never see a partially written
+		 * cache.
+		 */
+		void save();
+
+	private:
+		struct entry
+		{
+			binary_identity binary;
+			client_ctl::client_application_info info;
+		};
+
+		std::filesystem::path m_storage;
+		std::map<std::filesystem::path, entry> m_entries;
+		bool m_dirty{false};
+	};
+
+	/**
+	 * \brief Returns the default location of the client_info_cache file
+	 *
+	 * The file is placed in `$XDG_CACHE_HOME/pipe`, falling back to `$HOME/.cache/pipe`.
+	 *
+	 * \throw std::runtime_error if neither variable is set
+	 */
+	std::filesystem::path default_client_info_cache_path();
+
+	/**
+	 * \brief Returns the client_application_info of binary, from cache if it has an up-to-date
+	 *        entry, and otherwise by discovering it, and adding the result to cache
+	 */
+	client_ctl::client_application_info get_client_application_info(
+		client_info_cache& cache,
+		std::filesystem::path const& binary
+	);
+
+	/**
+	 * \brief Collects the client_application_info of every node in graph, as needed by validate
+	 *
+	 * Each distinct binary is looked up, or discovered, once.
+	 */
+	client_info_map get_client_info(pipeline_graph const& graph, client_info_cache& cache);
+}
+
+#endif
@@ -0,0 +1,160 @@
+//@	{"target":{"name":"client_info_cache.test"}}
+
+#include "./client_info_cache.hpp"
+
+#include "src/os_services/fs/file.hpp"
+#include "src/test_utils/temp_dir.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <cstring>
+#include <elf.h>
+#include <vector>
+
+namespace
+{
+	template<class T>
+	void append(std::vector<std::byte>& buffer, T const& value)
+	{
+		auto const bytes = std::as_bytes(std::span{&value, 1});
+		buffer.insert(std::end(buffer), std::begin(bytes), std::end(bytes));
+	}
+
+	std::vector<std::byte> make_elf_image(std::span<uint8_t const> build_id)
+	{
+		Elf64_Ehdr header{};
+		memcpy(header.e_ident, ELFMAG, SELFMAG);
+		header.e_ident[EI_CLASS] = ELFCLASS64;
+		header.e_ident[EI_DATA] = std::endian::native == std::endian::little? ELFDATA2LSB : ELFDATA2MSB;
+		header.e_phoff = sizeof(Elf64_Ehdr);
+		header.e_phentsize = sizeof(Elf64_Phdr);
+		header.e_phnum = 2;
+
+		// An unrelated note comes first, to check that notes are skipped properly
+		std::vector<std::byte> notes;
+		Elf64_Nhdr note{};
+		note.n_namesz = 6;
+		note.n_descsz = 3;
+		note.n_type = 1;
+		append(notes, note);
+		append(notes, std::array<char, 8>{"Other"});
+		append(notes, std::array<char, 4>{});
+
+		note.n_namesz = 4;
+		note.n_descsz = static_cast<Elf64_Word>(std::size(build_id));
+		note.n_type = NT_GNU_BUILD_ID;
+		append(notes, note);
+		append(notes, std::array<char, 4>{"GNU"});
+		auto const desc = std::as_bytes(build_id);
+		notes.insert(std::end(notes), std::begin(desc), std::end(desc));
+
+		std::vector<std::byte> ret;
+		append(ret, header);
+		Elf64_Phdr phdr{};
+		phdr.p_type = PT_LOAD;
+		append(ret, phdr);
+		phdr.p_type = PT_NOTE;
+		phdr.p_offset = sizeof(Elf64_Ehdr) + 2*sizeof(Elf64_Phdr);
+		phdr.p_filesz = std::size(notes);
+		append(ret, phdr);
+		ret.insert(std::end(ret), std::begin(notes), std::end(notes));
+		return ret;
+	}
+}
+
+TESTCASE(Pipe_host_client_info_cache_read_elf_build_id)
+{
+	std::array<uint8_t const, 5> const build_id{0xde, 0xad, 0xbe, 0xef, 0x01};
+	auto const image = make_elf_image(build_id);
+	EXPECT_EQ(Pipe::host::read_elf_build_id(image), std::optional<std::string>{"deadbeef01"});
+
+	// A truncated note section must not be read past its end
+	EXPECT_EQ(
+		Pipe::host::read_elf_build_id(std::span{image}.first(std::size(image) - 1)).has_value(),
+		false
+	);
+
+	EXPECT_EQ(
+		Pipe::host::read_elf_build_id(std::as_bytes(std::span{std::string_view{"#!/bin/sh\n"}})).has_value(),
+		false
+	);
+}
+
+TESTCASE(Pipe_host_client_info_cache_binary_identity)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_client_info_cache"};
+	auto const path = dir.path()/"client";
+	{
+		auto const file = Pipe::os_services::fs::create(path);
+		auto const image = make_elf_image(std::array<uint8_t const, 2>{0x12, 0x34});
+		std::ignore = Pipe::os_services::io::write(file.get(), image);
+	}
+
+	auto const identity = Pipe::host::make_binary_identity(dir.path()/"."/"client");
+	EXPECT_EQ(identity.path, std::filesystem::canonical(path));
+	EXPECT_EQ(identity.build_id, "1234");
+	EXPECT_EQ((Pipe::host::make_binary_identity(path) == identity), true);
+
+	// Replacing the binary gives it a new identity
+	{
+		auto const file = Pipe::os_services::fs::replace(path);
+		auto const image = make_elf_image(std::array<uint8_t const, 2>{0x56, 0x78});
+		std::ignore = Pipe::os_services::io::write(file.get(), image);
+	}
+	EXPECT_EQ(Pipe::host::make_binary_identity(path).build_id, "5678");
+}
+
+TESTCASE(Pipe_host_client_info_cache_save_and_load)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_client_info_cache"};
+	auto const storage = dir.path()/"cache"/"client_info.json";
+
+	Pipe::host::binary_identity const binary{
+		.path = "/usr/bin/client",
+		.inode = 0xffff'ffff'ffff'fff0,
+		.device = 2049,
+		.mtime_ns = 1'700'000'000'123'456'789,
+		.build_id = "deadbeef"
+	};
+
+	Pipe::client_ctl::client_application_info info{.display_name = "Client", .inputs = {}, .outputs = {}};
+	info.inputs.insert(std::pair{"stdin", Pipe::client_ctl::port_info{.stream_content_type = "text/plain"}});
+	info.outputs.insert(std::pair{"stdout", Pipe::client_ctl::port_info{.stream_content_type = "text/plain"}});
+
+	{
+		Pipe::host::client_info_cache cache{storage};
+		EXPECT_EQ(cache.size(), 0);
+		EXPECT_EQ(cache.find(binary), nullptr);
+		cache.insert(binary, info);
+		EXPECT_EQ(cache.dirty(), true);
+		cache.save();
+		EXPECT_EQ(cache.dirty(), false);
+	}
+
+	Pipe::host::client_info_cache cache{storage};
+	EXPECT_EQ(cache.dirty(), false);
+	REQUIRE_EQ(cache.size(), 1);
+	auto const cached = cache.find(binary);
+	REQUIRE_NE(cached, nullptr);
+	EXPECT_EQ(cached->display_name, "Client");
+	EXPECT_EQ(cached->inputs.at("stdin").stream_content_type, "text/plain");
+	EXPECT_EQ(cached->outputs.at("stdout").stream_content_type, "text/plain");
+
+	// An entry for a binary that has been modified is not used
+	auto modified = binary;
+	++modified.mtime_ns;
+	EXPECT_EQ(cache.find(modified), nullptr);
+}
+
+TESTCASE(Pipe_host_client_info_cache_damaged_file)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_client_info_cache"};
+	auto const storage = dir.path()/"client_info.json";
+	{
+		auto const file = Pipe::os_services::fs::create(storage);
+		std::ignore = Pipe::os_services::io::write(file.get(), std::as_bytes(std::span{std::string_view{"{\"entries\": ["}}));
+	}
+
+	Pipe::host::client_info_cache cache{storage};
+	EXPECT_EQ(cache.size(), 0);
+	EXPECT_EQ(cache.dirty(), false);
+}
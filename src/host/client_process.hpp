@@ -1,21 +1,439 @@
+#ifndef PIPE_HOST_CLIENT_PROCESS_HPP
+#define PIPE_HOST_CLIENT_PROCESS_HPP
+
+#include "src/client_ctl/message.hpp"
+#include "src/client_ctl/message_buffer.hpp"
+#include "src/client_ctl/flow_control.hpp"
+#include "src/host/startup_latency.hpp"
+#include "src/json_log/rate_limiter.hpp"
 #include "src/os_services/ipc/socket.hpp"
 #include "src/os_services/ipc/unix_domain_socket.hpp"
 #include "src/os_services/fd/activity_monitor.hpp"
+#include "src/os_services/io_multiplexer/epoll_instance.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Pipe::host
 {
-	class client_process
+	/**
+	 * \brief Information about a port announced by a client
+	 */
+	struct announced_port
+	{
+		client_ctl::port_direction direction;
+		std::string name;
+		std::string content_type;
+	};
+
+	/**
+	 * \brief Host side of the client_ctl connection to a client process
+	 *
+	 * Requests are queued by start, pause, drain, shutdown, and request_stats. Each request is
+	 * given a correlation id, so a request does not have to wait for the response to a previous
+	 * one. Queued requests are sent when the socket becomes writable, and responses are matched
+	 * with their requests when they arrive.
+	 *
+	 * \tparam SocketType The type of the control socket. With SOCK_SEQPACKET, message boundaries
+	 *         are kept by the kernel, and messages are received in batches.
+	 *
+	 * \note To send requests, the connection must have been registered with the epoll_instance
+	 *       passed to set_event_handler.
+	 */
+	template<auto SocketType>
+	class basic_client_process
 	{
 	public:
-		void handle_event(
-			os_services::fd::activity_event const& event,
-			os_services::ipc::connected_socket_ref<SOCK_STREAM, sockaddr_un>
-		)
+		using socket_ref = os_services::ipc::connected_socket_ref<SocketType, sockaddr_un>;
+		using clock = std::chrono::steady_clock;
+
+		/**
+		 * \brief Sets the event handler to wake up when there are requests to send
+		 *
+		 * \param event_loop The epoll_instance where the event handler has been registered
+		 * \param id The id of the event handler
+		 */
+		void set_event_handler(os_services::io_multiplexer::epoll_instance& event_loop, os_services::fd::event_handler_id id)
+		{
+			m_event_loop = &event_loop;
+			m_event_handler = id;
+			if(!m_output.empty())
+			{ start_writing(); }
+		}
+
+		/**
+		 * \brief Sets the histograms to record the startup latency of the client in
+		 *
+		 * \note tracker must outlive this object
+		 */
+		void set_startup_tracker(startup_latency& tracker) noexcept
+		{ m_startup_tracker = &tracker; }
+
+		/**
+		 * \brief Sets the counters of the log items from the client that have been suppressed by
+		 *        its rate limiter
+		 */
+		void set_log_suppression_metrics(std::shared_ptr<json_log::suppression_metrics const> metrics) noexcept
+		{ m_log_suppression_metrics = std::move(metrics); }
+
+		/**
+		 * \brief Returns the counters of the log items from the client that have been suppressed
+		 *        by its rate limiter, or nullptr if the client does not have any rate limiter
+		 */
+		json_log::suppression_metrics const* log_suppression_metrics() const noexcept
+		{ return m_log_suppression_metrics.get(); }
+
+		/**
+		 * \brief Records when the client was forked, and when it was known that execve succeeded
+		 */
+		void on_spawned(startup_clock::time_point fork, startup_clock::time_point exec)
+		{
+			m_startup.fork = fork;
+			m_startup.exec = exec;
+			if(m_startup_tracker != nullptr)
+			{ record(m_startup_tracker->fork_to_exec, m_startup.fork, m_startup.exec); }
+		}
+
+		/**
+		 * \brief Records when the client wrote its first byte to stderr
+		 *
+		 * \note Only the first call has any effect
+		 */
+		void on_first_output(startup_clock::time_point when)
+		{
+			if(m_startup.first_output.has_value())
+			{ return; }
+
+			m_startup.first_output = when;
+			if(m_startup_tracker != nullptr)
+			{ record(m_startup_tracker->exec_to_first_output, m_startup.exec, m_startup.first_output); }
+		}
+
+		/**
+		 * \brief Returns the startup events recorded so far
+		 */
+		startup_timeline const& startup() const noexcept
+		{ return m_startup; }
+
+		/**
+		 * \brief Checks whether or not the client has reported that it is ready
+		 */
+		bool is_ready() const noexcept
+		{ return m_startup.ready.has_value(); }
+
+		/**
+		 * \brief Sets the function to call when the client grants credit for one of its input ports
+		 *
+		 * \param handler The function to call. It is called with the name of the port, and the
+		 *        amount of credit.
+		 */
+		void set_credit_grant_handler(std::move_only_function<void(std::string_view, client_ctl::credit)> handler)
+		{ m_credit_grant_handler = std::move(handler); }
+
+		/**
+		 * \brief Grants credit to the client, for sending data through one of its output ports
+		 *
+		 * \note A credit grant is not a request, so the client does not respond to it
+		 */
+		void grant_credit(std::string_view port, client_ctl::credit amount)
 		{
-			if(can_read(event.get_activity_status()))
+			auto const was_empty = m_output.empty();
+			m_output.push(client_ctl::make_credit_grant(port, amount), 0);
+			if(was_empty)
+			{ start_writing(); }
+		}
+
+		/**
+		 * \brief Requests the client to start processing data
+		 * \return The correlation id of the request
+		 */
+		uint64_t start()
+		{ return send_request(client_ctl::start{}); }
+
+		/**
+		 * \brief Requests the client to stop processing data
+		 * \return The correlation id of the request
+		 */
+		uint64_t pause()
+		{ return send_request(client_ctl::pause{}); }
+
+		/**
+		 * \brief Requests the client to process all buffered data, and then pause
+		 * \return The correlation id of the request
+		 */
+		uint64_t drain()
+		{ return send_request(client_ctl::drain{}); }
+
+		/**
+		 * \brief Requests the client to exit
+		 * \return The correlation id of the request
+		 */
+		uint64_t shutdown()
+		{ return send_request(client_ctl::shutdown{}); }
+
+		/**
+		 * \brief Requests statistics from the client. The result is available through last_stats.
+		 * \return The correlation id of the request
+		 */
+		uint64_t request_stats()
+		{ return send_request(client_ctl::stats_request{}); }
+
+		/**
+		 * \brief Returns the number of requests that have not yet been responded to
+		 */
+		size_t pending_request_count() const noexcept
+		{ return std::size(m_pending_requests); }
+
+		/**
+		 * \brief Checks whether or not the client has sent its hello message
+		 */
+		bool has_said_hello() const noexcept
+		{ return m_pid.has_value(); }
+
+		/**
+		 * \brief Returns the pid reported by the client
+		 */
+		std::optional<pid_t> pid() const noexcept
+		{ return m_pid; }
+
+		/**
+		 * \brief Returns the display name reported by the client
+		 */
+		std::string const& display_name() const noexcept
+		{ return m_display_name; }
+
+		/**
+		 * \brief Returns the ports announced by the client
+		 */
+		std::vector<announced_port> const& ports() const noexcept
+		{ return m_ports; }
+
+		/**
+		 * \brief Returns the most recent statistics reported by the client
+		 */
+		std::optional<client_ctl::stats_report> const& last_stats() const noexcept
+		{ return m_last_stats; }
+
+		/**
+		 * \brief Returns the most recent error reported by the client, or by the protocol layer
+		 */
+		std::string const& last_error() const noexcept
+		{ return m_last_error; }
+
+		/**
+		 * \brief Returns the time between sending the most recently completed request, and
+		 *        receiving its response
+		 */
+		clock::duration last_round_trip_time() const noexcept
+		{ return m_last_round_trip_time; }
+
+		/**
+		 * \brief Checks whether or not the connection to the client is still open
+		 */
+		bool is_connected() const noexcept
+		{ return m_connected; }
+
+		void handle_event(os_services::fd::activity_event const& event, socket_ref fd)
+		{
+			try
 			{
-				// TODO: Decode log entries and dispatch to listener
+				if(can_read(event.get_activity_status()))
+				{
+					auto const still_open = receive_messages(
+						m_input,
+						fd,
+						[this](auto const& msg) { handle_message(msg); },
+						[&event](size_t num_bytes) { return event.consume_budget(num_bytes); }
+					);
+
+					if(!still_open)
+					{
+						close(event, "Client closed the control connection");
+						return;
+					}
+				}
+
+				if(can_write(event.get_activity_status()) && send_messages(m_output, fd))
+				{ event.update_listening_status(os_services::fd::activity_status::read); }
 			}
+			catch(std::exception const& err)
+			{ close(event, err.what()); }
 		}
+
+	private:
+		template<class Payload>
+		uint64_t send_request(Payload const& payload)
+		{
+			auto const correlation_id = m_next_correlation_id++;
+			auto const was_empty = m_output.empty();
+			m_output.push(payload, correlation_id);
+			m_pending_requests.insert(
+				std::pair{
+					correlation_id,
+					pending_request{
+						.type = Payload::type,
+						.sent_at = clock::now()
+					}
+				}
+			);
+
+			if(was_empty)
+			{ start_writing(); }
+			return correlation_id;
+		}
+
+		void start_writing()
+		{
+			if(m_event_loop != nullptr)
+			{
+				m_event_loop->update_listening_status(
+					m_event_handler,
+					os_services::fd::activity_status::read_or_write
+				);
+			}
+		}
+
+		void handle_message(client_ctl::message_view const& msg)
+		{
+			if(has_flag(msg.header.flags, client_ctl::message_flags::response))
+			{
+				handle_response(msg);
+				return;
+			}
+
+			switch(msg.header.type)
+			{
+				case client_ctl::message_type::hello:
+				{
+					auto const hello = get_payload<client_ctl::hello>(msg);
+					if(hello.protocol_version != client_ctl::protocol_version)
+					{ throw std::runtime_error{"Client uses an unsupported protocol version"}; }
+					m_pid = static_cast<pid_t>(hello.pid);
+					m_display_name = hello.display_name;
+					break;
+				}
+
+				case client_ctl::message_type::ready:
+				{
+					(void)get_payload<client_ctl::ready>(msg);
+					if(m_startup.ready.has_value())
+					{ throw std::runtime_error{"Client reported that it is ready more than once"}; }
+
+					m_startup.ready = startup_clock::now();
+					if(m_startup_tracker != nullptr)
+					{
+						record(m_startup_tracker->exec_to_ready, m_startup.exec, m_startup.ready);
+						record(m_startup_tracker->fork_to_ready, m_startup.fork, m_startup.ready);
+					}
+					break;
+				}
+
+				case client_ctl::message_type::credit_grant:
+				{
+					auto const grant = get_payload<client_ctl::credit_grant>(msg);
+					if(m_credit_grant_handler)
+					{
+						m_credit_grant_handler(
+							grant.port,
+							client_ctl::credit{.bytes = grant.bytes, .messages = grant.messages}
+						);
+					}
+					break;
+				}
+
+				case client_ctl::message_type::port_announce:
+				{
+					auto const port = get_payload<client_ctl::port_announce>(msg);
+					m_ports.push_back(
+						announced_port{
+							.direction = port.direction,
+							.name = std::string{port.name},
+							.content_type = std::string{port.content_type}
+						}
+					);
+					break;
+				}
+
+				default:
+					throw std::runtime_error{"Client sent an unexpected request"};
+			}
+		}
+
+		void handle_response(client_ctl::message_view const& msg)
+		{
+			auto const i = m_pending_requests.find(msg.header.correlation_id);
+			if(i == std::end(m_pending_requests) || i->second.type != msg.header.type)
+			{ throw std::runtime_error{"Client sent a response to an unknown request"}; }
+
+			m_last_round_trip_time = clock::now() - i->second.sent_at;
+			m_pending_requests.erase(i);
+
+			if(has_flag(msg.header.flags, client_ctl::message_flags::error))
+			{
+				m_last_error = get_payload<client_ctl::error_info>(msg).message;
+				return;
+			}
+
+			if(msg.header.type == client_ctl::message_type::stats)
+			{ m_last_stats = get_payload<client_ctl::stats_report>(msg); }
+			else
+			{ (void)get_payload<client_ctl::acknowledgement>(msg); }
+		}
+
+		template<class Payload>
+		static Payload get_payload(client_ctl::message_view const& msg)
+		{
+			auto ret = client_ctl::decode<Payload>(msg);
+			if(!ret.has_value())
+			{ throw std::runtime_error{ret.error()}; }
+			return *ret;
+		}
+
+		void close(os_services::fd::activity_event const& event, std::string_view reason)
+		{
+			m_connected = false;
+			m_last_error = reason;
+			m_pending_requests.clear();
+			event.stop_listening();
+		}
+
+		struct pending_request
+		{
+			client_ctl::message_type type;
+			clock::time_point sent_at;
+		};
+
+		client_ctl::message_reader_for<SocketType> m_input;
+		client_ctl::message_writer m_output;
+		uint64_t m_next_correlation_id{1};
+		std::unordered_map<uint64_t, pending_request> m_pending_requests;
+		clock::duration m_last_round_trip_time{};
+
+		std::optional<pid_t> m_pid;
+		std::string m_display_name;
+		std::vector<announced_port> m_ports;
+		std::optional<client_ctl::stats_report> m_last_stats;
+		std::string m_last_error;
+		bool m_connected{true};
+
+		startup_timeline m_startup;
+		startup_latency* m_startup_tracker{nullptr};
+		std::shared_ptr<json_log::suppression_metrics const> m_log_suppression_metrics;
+		std::move_only_function<void(std::string_view, client_ctl::credit)> m_credit_grant_handler;
+
+		os_services::io_multiplexer::epoll_instance* m_event_loop{nullptr};
+		os_services::fd::event_handler_id m_event_handler;
 	};
-}
\ No newline at end of file
+
+	/**
+	 * \brief The client_process used by the host
+	 */
+	using client_process = basic_client_process<SOCK_SEQPACKET>;
+}
+
+#endif
@@ -2,4 +2,277 @@
 
 #include "./client_process.hpp"
 
-#include <testfwk/testfwk.hpp>
\ No newline at end of file
+#include "src/os_services/ipc/socket_pair.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <vector>
+
+namespace
+{
+	// The host end of the control connection is registered with an epoll_instance
+	template<auto SocketType>
+	using control_sockets = Pipe::os_services::ipc::socket_pair<
+		SocketType,
+		Pipe::os_services::fd::io_mode::nonblocking
+	>;
+
+	template<auto SocketType>
+	struct client_side
+	{
+		explicit client_side(control_sockets<SocketType>& sockets_in):
+			sockets{sockets_in}
+		{}
+
+		control_sockets<SocketType>& sockets;
+		Pipe::client_ctl::message_reader_for<SocketType> reader;
+		Pipe::client_ctl::message_writer writer;
+
+		std::vector<Pipe::client_ctl::message_header> receive()
+		{
+			std::vector<Pipe::client_ctl::message_header> ret;
+			auto const still_open = receive_messages(reader, sockets.socket_b(), [&ret](auto const& msg){
+				ret.push_back(msg.header);
+			});
+			REQUIRE_EQ(still_open, true);
+			return ret;
+		}
+
+		void send()
+		{ REQUIRE_EQ(send_messages(writer, sockets.socket_b()), true); }
+	};
+
+	template<auto SocketType>
+	void test_hello_and_requests()
+	{
+		Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+		control_sockets<SocketType> sockets;
+		client_side client{sockets};
+
+		auto const proc = std::make_shared<Pipe::host::basic_client_process<SocketType>>();
+		auto const id = event_loop.add(
+			sockets.take_socket_a(),
+			Pipe::os_services::fd::activity_status::read,
+			proc
+		);
+		proc->set_event_handler(event_loop, id);
+
+		client.writer.push(
+			Pipe::client_ctl::hello{
+				.protocol_version = Pipe::client_ctl::protocol_version,
+				.pid = 1234,
+				.display_name = "My client"
+			},
+			0
+		);
+		client.writer.push(
+			Pipe::client_ctl::port_announce{
+				.direction = Pipe::client_ctl::port_direction::input,
+				.name = "stdin",
+				.content_type = "text/plain"
+			},
+			0
+		);
+		client.send();
+		event_loop.wait_for_and_distpatch_events();
+		EXPECT_EQ(proc->has_said_hello(), true);
+		EXPECT_EQ(proc->pid(), 1234);
+		EXPECT_EQ(proc->display_name(), "My client");
+		REQUIRE_EQ(std::size(proc->ports()), 1);
+		EXPECT_EQ(proc->ports()[0].name, "stdin");
+		EXPECT_EQ(proc->ports()[0].content_type, "text/plain");
+
+		// Pipeline two requests without waiting for the first response
+		auto const start_id = proc->start();
+		auto const stats_id = proc->request_stats();
+		EXPECT_NE(start_id, stats_id);
+		EXPECT_EQ(proc->pending_request_count(), 2);
+		event_loop.wait_for_and_distpatch_events();
+
+		auto const requests = client.receive();
+		REQUIRE_EQ(std::size(requests), 2);
+		EXPECT_EQ(requests[0].type, Pipe::client_ctl::message_type::start);
+		EXPECT_EQ(requests[0].correlation_id, start_id);
+		EXPECT_EQ(requests[1].type, Pipe::client_ctl::message_type::stats);
+		EXPECT_EQ(requests[1].correlation_id, stats_id);
+
+		// Respond in reverse order
+		client.writer.push(
+			Pipe::client_ctl::message_header{
+				.payload_size = 0,
+				.type = Pipe::client_ctl::message_type::stats,
+				.flags = Pipe::client_ctl::message_flags::response,
+				.correlation_id = stats_id
+			},
+			Pipe::client_ctl::stats_report{
+				.bytes_read = 10,
+				.bytes_written = 20,
+				.items_processed = 3
+			}
+		);
+		client.writer.push(
+			Pipe::client_ctl::message_header{
+				.payload_size = 0,
+				.type = Pipe::client_ctl::message_type::start,
+				.flags = Pipe::client_ctl::message_flags::response,
+				.correlation_id = start_id
+			},
+			Pipe::client_ctl::acknowledgement{}
+		);
+		client.send();
+		event_loop.wait_for_and_distpatch_events();
+		EXPECT_EQ(proc->pending_request_count(), 0);
+		REQUIRE_EQ(proc->last_stats().has_value(), true);
+		EXPECT_EQ(proc->last_stats()->bytes_written, 20);
+		EXPECT_EQ(proc->is_connected(), true);
+		EXPECT_EQ(proc->last_error(), "");
+	}
+}
+
+TESTCASE(Pipe_host_client_process_hello_and_requests_stream)
+{ test_hello_and_requests<SOCK_STREAM>(); }
+
+TESTCASE(Pipe_host_client_process_hello_and_requests_seqpacket)
+{ test_hello_and_requests<SOCK_SEQPACKET>(); }
+
+TESTCASE(Pipe_host_client_process_error_response)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	control_sockets<SOCK_SEQPACKET> sockets;
+	client_side client{sockets};
+
+	auto const proc = std::make_shared<Pipe::host::client_process>();
+	auto const drain_id = proc->drain();
+	auto const id = event_loop.add(
+		sockets.take_socket_a(),
+		Pipe::os_services::fd::activity_status::read,
+		proc
+	);
+	proc->set_event_handler(event_loop, id);
+	event_loop.wait_for_and_distpatch_events();
+	REQUIRE_EQ(std::size(client.receive()), 1);
+
+	client.writer.push(
+		Pipe::client_ctl::message_header{
+			.payload_size = 0,
+			.type = Pipe::client_ctl::message_type::drain,
+			.flags = Pipe::client_ctl::message_flags::response | Pipe::client_ctl::message_flags::error,
+			.correlation_id = drain_id
+		},
+		Pipe::client_ctl::error_info{.message = "Not supported"}
+	);
+	client.send();
+	event_loop.wait_for_and_distpatch_events();
+	EXPECT_EQ(proc->pending_request_count(), 0);
+	EXPECT_EQ(proc->last_error(), "Not supported");
+	EXPECT_EQ(proc->is_connected(), true);
+}
+
+TESTCASE(Pipe_host_client_process_unknown_response)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	control_sockets<SOCK_SEQPACKET> sockets;
+	client_side client{sockets};
+
+	auto const proc = std::make_shared<Pipe::host::client_process>();
+	auto const id = event_loop.add(
+		sockets.take_socket_a(),
+		Pipe::os_services::fd::activity_status::read,
+		proc
+	);
+	proc->set_event_handler(event_loop, id);
+
+	client.writer.push(
+		Pipe::client_ctl::message_header{
+			.payload_size = 0,
+			.type = Pipe::client_ctl::message_type::start,
+			.flags = Pipe::client_ctl::message_flags::response,
+			.correlation_id = 99
+		},
+		Pipe::client_ctl::acknowledgement{}
+	);
+	client.send();
+	event_loop.wait_for_and_distpatch_events();
+	EXPECT_EQ(proc->is_connected(), false);
+	EXPECT_EQ(proc->last_error(), "Client sent a response to an unknown request");
+}
+
+TESTCASE(Pipe_host_client_process_startup_latency)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	control_sockets<SOCK_SEQPACKET> sockets;
+	client_side client{sockets};
+	Pipe::host::startup_latency latency;
+
+	auto const proc = std::make_shared<Pipe::host::client_process>();
+	proc->set_startup_tracker(latency);
+	auto const fork_time = Pipe::host::startup_clock::now();
+	proc->on_spawned(fork_time, fork_time + std::chrono::microseconds{500});
+	EXPECT_EQ(latency.fork_to_exec.count(), 1);
+	EXPECT_EQ(latency.fork_to_exec.min(), 500'000);
+
+	proc->on_first_output(fork_time + std::chrono::milliseconds{1});
+	proc->on_first_output(fork_time + std::chrono::milliseconds{2});
+	EXPECT_EQ(latency.exec_to_first_output.count(), 1);
+	EXPECT_EQ(latency.exec_to_first_output.min(), 500'000);
+
+	auto const id = event_loop.add(
+		sockets.take_socket_a(),
+		Pipe::os_services::fd::activity_status::read,
+		proc
+	);
+	proc->set_event_handler(event_loop, id);
+	EXPECT_EQ(proc->is_ready(), false);
+
+	client.writer.push(Pipe::client_ctl::ready{}, 0);
+	client.send();
+	event_loop.wait_for_and_distpatch_events();
+	EXPECT_EQ(proc->is_ready(), true);
+	EXPECT_EQ(latency.exec_to_ready.count(), 1);
+	EXPECT_EQ(latency.fork_to_ready.count(), 1);
+	EXPECT_GE(latency.fork_to_ready.max(), latency.exec_to_ready.max());
+
+	// Saying ready twice is a protocol violation
+	client.writer.push(Pipe::client_ctl::ready{}, 0);
+	client.send();
+	event_loop.wait_for_and_distpatch_events();
+	EXPECT_EQ(proc->is_connected(), false);
+	EXPECT_EQ(proc->last_error(), "Client reported that it is ready more than once");
+}
+
+TESTCASE(Pipe_host_client_process_credit_grants)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	control_sockets<SOCK_SEQPACKET> sockets;
+	client_side client{sockets};
+
+	auto const proc = std::make_shared<Pipe::host::client_process>();
+	std::vector<std::pair<std::string, Pipe::client_ctl::credit>> grants;
+	proc->set_credit_grant_handler([&grants](std::string_view port, Pipe::client_ctl::credit amount) {
+		grants.push_back(std::pair{std::string{port}, amount});
+	});
+	auto const id = event_loop.add(
+		sockets.take_socket_a(),
+		Pipe::os_services::fd::activity_status::read,
+		proc
+	);
+	proc->set_event_handler(event_loop, id);
+
+	client.writer.push(
+		Pipe::client_ctl::make_credit_grant("stdin", Pipe::client_ctl::credit{.bytes = 4096, .messages = 16}),
+		0
+	);
+	client.send();
+	event_loop.wait_for_and_distpatch_events();
+	REQUIRE_EQ(std::size(grants), 1);
+	EXPECT_EQ(grants[0].first, "stdin");
+	EXPECT_EQ(grants[0].second.bytes, 4096);
+	EXPECT_EQ(grants[0].second.messages, 16);
+
+	proc->grant_credit("stdout", Pipe::client_ctl::credit{.bytes = 100, .messages = 1});
+	EXPECT_EQ(proc->pending_request_count(), 0);
+	event_loop.wait_for_and_distpatch_events();
+	auto const received = client.receive();
+	REQUIRE_EQ(std::size(received), 1);
+	EXPECT_EQ(received[0].type, Pipe::client_ctl::message_type::credit_grant);
+	EXPECT_EQ(proc->is_connected(), true);
+}
@@ -0,0 +1,184 @@
+#ifndef PIPE_HOST_CREDIT_BROKER_HPP
+#define PIPE_HOST_CREDIT_BROKER_HPP
+
+#include "src/client_ctl/flow_control.hpp"
+
+#include <algorithm>
+#include <compare>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace Pipe::host
+{
+	/**
+	 * \brief Identifies a port of a client process
+	 */
+	struct client_port
+	{
+		pid_t client;
+		std::string port;
+
+		auto operator<=>(client_port const&) const = default;
+	};
+
+	/**
+	 * \brief A grant that should be forwarded to a producer
+	 */
+	struct forwarded_credit
+	{
+		client_port producer;
+		client_ctl::credit amount;
+	};
+
+	/**
+	 * \brief Mediates credit grants for edges where data is relayed through the host
+	 *
+	 * Credit granted by the consumer of a relayed edge is forwarded to its producer, and the
+	 * data relayed from the producer is charged against that credit. If the output port of the
+	 * producer is relayed to more than one consumer, every message is delivered to all of
+	 * them, so the producer only gets as much credit as the slowest consumer has granted. Since
+	 * the producer can never have more credit than any consumer has granted, the host never has
+	 * to buffer more data than a consumer is willing to accept.
+	 *
+	 * \note All consumers of an output port should be connected before any credit is granted.
+	 */
+	class credit_broker
+	{
+		template<class Self>
+		static auto& find_consumers(Self& self, client_port const& producer)
+		{
+			auto const i = self.m_producers.find(producer);
+			if(i == std::end(self.m_producers))
+			{ throw std::runtime_error{"Port is not connected"}; }
+			return i->second;
+		}
+
+	public:
+		/**
+		 * \brief Registers an edge from producer to consumer, where data is relayed by the host
+		 * \throw std::runtime_error if consumer is already connected
+		 */
+		void connect(client_port producer, client_port consumer)
+		{
+			if(m_edges.contains(consumer))
+			{ throw std::runtime_error{"Port is already connected"}; }
+
+			m_producers[producer].push_back(consumer);
+			m_edges.insert(std::pair{std::move(consumer), edge{.producer = std::move(producer)}});
+		}
+
+		/**
+		 * \brief Removes all edges where client is either the producer or the consumer
+		 */
+		void disconnect(pid_t client)
+		{
+			std::erase_if(m_edges, [client](auto const& item) {
+				return item.first.client == client || item.second.producer.client == client;
+			});
+
+			for(auto i = std::begin(m_producers); i != std::end(m_producers);)
+			{
+				if(i->first.client != client)
+				{
+					std::erase_if(i->second, [client](auto const& consumer) {
+						return consumer.client == client;
+					});
+				}
+
+				if(i->first.client == client || i->second.empty())
+				{ i = m_producers.erase(i); }
+				else
+				{ ++i; }
+			}
+		}
+
+		/**
+		 * \brief Records credit granted by the consumer of an edge
+		 * \return The grant to forward to the producer, or nullopt if consumer is not the end of a
+		 *         relayed edge, or if the grant does not give the producer any more credit
+		 */
+		std::optional<forwarded_credit> on_credit_granted(client_port const& consumer, client_ctl::credit amount)
+		{
+			auto const i = m_edges.find(consumer);
+			if(i == std::end(m_edges))
+			{ return std::nullopt; }
+
+			auto const& producer = i->second.producer;
+			auto const before = outstanding_credit(producer);
+			i->second.outstanding = client_ctl::saturating_add(i->second.outstanding, amount);
+			auto const after = outstanding_credit(producer);
+			if(after == before)
+			{ return std::nullopt; }
+
+			return forwarded_credit{
+				.producer = producer,
+				.amount = client_ctl::credit{
+					.bytes = after.bytes - before.bytes,
+					.messages = after.messages - before.messages
+				}
+			};
+		}
+
+		/**
+		 * \brief Charges a message of size bytes, relayed from producer, against the credit of
+		 *        all edges starting at producer
+		 *
+		 * \throw std::runtime_error if the producer does not have enough credit left, or if
+		 *        producer is not the start of a relayed edge
+		 */
+		void on_data_relayed(client_port const& producer, uint64_t size)
+		{
+			auto const credit = outstanding_credit(producer);
+			if(credit.messages == 0 || credit.bytes < size)
+			{ throw std::runtime_error{"Producer has exceeded its credit"}; }
+
+			for(auto const& consumer : find_consumers(*this, producer))
+			{
+				auto& outstanding = m_edges.find(consumer)->second.outstanding;
+				outstanding.bytes -= size;
+				--outstanding.messages;
+			}
+		}
+
+		/**
+		 * \brief Returns the credit that the producer has not yet used
+		 */
+		client_ctl::credit outstanding_credit(client_port const& producer) const
+		{
+			client_ctl::credit ret{
+				.bytes = std::numeric_limits<uint64_t>::max(),
+				.messages = std::numeric_limits<uint64_t>::max()
+			};
+			for(auto const& consumer : find_consumers(*this, producer))
+			{
+				auto const& outstanding = m_edges.find(consumer)->second.outstanding;
+				ret.bytes = std::min(ret.bytes, outstanding.bytes);
+				ret.messages = std::min(ret.messages, outstanding.messages);
+			}
+			return ret;
+		}
+
+		/**
+		 * \brief Returns the number of registered edges
+		 */
+		size_t edge_count() const noexcept
+		{ return std::size(m_edges); }
+
+	private:
+		struct edge
+		{
+			client_port producer;
+			client_ctl::credit outstanding{};
+		};
+
+		std::map<client_port, edge> m_edges;
+		std::map<client_port, std::vector<client_port>> m_producers;
+	};
+}
+
+#endif
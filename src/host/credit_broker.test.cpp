@@ -0,0 +1,101 @@
+//@	{"target":{"name": "credit_broker.test"}}
+
+#include "./credit_broker.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+TESTCASE(Pipe_host_credit_broker_forward_and_charge)
+{
+	Pipe::host::credit_broker broker;
+	Pipe::host::client_port const producer{.client = 10, .port = "stdout"};
+	Pipe::host::client_port const consumer{.client = 20, .port = "stdin"};
+	broker.connect(producer, consumer);
+	EXPECT_EQ(broker.edge_count(), 1);
+
+	// Grants for ports that are not relayed are not forwarded
+	EXPECT_EQ(
+		broker.on_credit_granted(
+			Pipe::host::client_port{.client = 20, .port = "other"},
+			Pipe::client_ctl::credit{.bytes = 1, .messages = 1}
+		).has_value(),
+		false
+	);
+
+	auto const forwarded = broker.on_credit_granted(consumer, Pipe::client_ctl::credit{.bytes = 100, .messages = 2});
+	REQUIRE_EQ(forwarded.has_value(), true);
+	EXPECT_EQ((forwarded->producer == producer), true);
+	EXPECT_EQ(forwarded->amount.bytes, 100);
+
+	broker.on_data_relayed(producer, 70);
+	EXPECT_EQ(broker.outstanding_credit(producer).bytes, 30);
+	EXPECT_EQ(broker.outstanding_credit(producer).messages, 1);
+
+	try
+	{
+		broker.on_data_relayed(producer, 31);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Producer has exceeded its credit"}); }
+}
+
+TESTCASE(Pipe_host_credit_broker_connect_and_disconnect)
+{
+	Pipe::host::credit_broker broker;
+	broker.connect(
+		Pipe::host::client_port{.client = 10, .port = "stdout"},
+		Pipe::host::client_port{.client = 20, .port = "stdin"}
+	);
+	broker.connect(
+		Pipe::host::client_port{.client = 20, .port = "stdout"},
+		Pipe::host::client_port{.client = 30, .port = "stdin"}
+	);
+
+	try
+	{
+		broker.connect(
+			Pipe::host::client_port{.client = 30, .port = "stdout"},
+			Pipe::host::client_port{.client = 20, .port = "stdin"}
+		);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Port is already connected"}); }
+
+	broker.disconnect(20);
+	EXPECT_EQ(broker.edge_count(), 0);
+
+	// Ports are free again after the client has been disconnected
+	broker.connect(
+		Pipe::host::client_port{.client = 10, .port = "stdout"},
+		Pipe::host::client_port{.client = 30, .port = "stdin"}
+	);
+	EXPECT_EQ(broker.edge_count(), 1);
+}
+
+TESTCASE(Pipe_host_credit_broker_fan_out)
+{
+	Pipe::host::credit_broker broker;
+	Pipe::host::client_port const producer{.client = 10, .port = "stdout"};
+	Pipe::host::client_port const fast{.client = 20, .port = "stdin"};
+	Pipe::host::client_port const slow{.client = 30, .port = "stdin"};
+	broker.connect(producer, fast);
+	broker.connect(producer, slow);
+
+	// The producer only gets the credit granted by the slowest consumer
+	EXPECT_EQ(broker.on_credit_granted(fast, Pipe::client_ctl::credit{.bytes = 100, .messages = 10}).has_value(), false);
+	auto const forwarded = broker.on_credit_granted(slow, Pipe::client_ctl::credit{.bytes = 40, .messages = 20});
+	REQUIRE_EQ(forwarded.has_value(), true);
+	EXPECT_EQ((forwarded->amount == Pipe::client_ctl::credit{.bytes = 40, .messages = 10}), true);
+
+	broker.on_data_relayed(producer, 30);
+	EXPECT_EQ((broker.outstanding_credit(producer) == Pipe::client_ctl::credit{.bytes = 10, .messages = 9}), true);
+
+	auto const more = broker.on_credit_granted(slow, Pipe::client_ctl::credit{.bytes = 100, .messages = 0});
+	REQUIRE_EQ(more.has_value(), true);
+	EXPECT_EQ((more->amount == Pipe::client_ctl::credit{.bytes = 60, .messages = 0}), true);
+
+	broker.disconnect(30);
+	EXPECT_EQ(broker.edge_count(), 1);
+	EXPECT_EQ((broker.outstanding_credit(producer) == Pipe::client_ctl::credit{.bytes = 70, .messages = 9}), true);
+}
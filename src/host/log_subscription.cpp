@@ -0,0 +1,279 @@
+//@	{"target":{"name":"log_subscription.o"}}
+
+#include "./log_subscription.hpp"
+#include "src/json_log/item_converter.hpp"
+
+#include <algorithm>
+
+std::expected<Pipe::host::log_filter, char const*>
+Pipe::host::make_log_filter(jopp::object const& obj)
+{
+	log_filter ret{};
+
+	if(auto const client = obj.try_get_field_as<jopp::string>("client"); client != nullptr)
+	{ ret.client = *client; }
+
+	if(auto const severity = obj.try_get_field_as<jopp::string>("min_severity"); severity != nullptr)
+	{
+		if(*severity == "info")
+		{ ret.min_severity = log::item::severity::info; }
+		else
+		if(*severity == "warning")
+		{ ret.min_severity = log::item::severity::warning; }
+		else
+		if(*severity == "error")
+		{ ret.min_severity = log::item::severity::error; }
+		else
+		{ return std::unexpected{"Unknown severity in field `min_severity`"}; }
+	}
+
+	if(auto const substring = obj.try_get_field_as<jopp::string>("contains"); substring != nullptr)
+	{ ret.substring = *substring; }
+
+	if(auto const pattern = obj.try_get_field_as<jopp::string>("matches"); pattern != nullptr)
+	{
+		try
+		{ ret.pattern = std::regex{*pattern, std::regex::ECMAScript | std::regex::optimize}; }
+		catch(std::regex_error const&)
+		{ return std::unexpected{"Invalid regular expression in field `matches`"}; }
+	}
+
+	return ret;
+}
+
+jopp::object Pipe::host::to_jopp_object(log_subscription_event const& event)
+{
+	if(auto const item = std::get_if<subscribed_log_item>(&event); item != nullptr)
+	{
+		auto ret = json_log::to_jopp_object(item->item);
+		ret.insert("client", item->client);
+		return ret;
+	}
+
+	jopp::object ret;
+	ret.insert("dropped", static_cast<jopp::number>(std::get<dropped_log_items>(event).count));
+	return ret;
+}
+
+void Pipe::host::log_subscriber::push(std::string_view who, log::item const& item)
+{
+	auto const was_empty = m_events.empty();
+	if(m_item_count == m_max_queue_length)
+	{
+		++m_total_dropped;
+		if(auto const last = std::get_if<dropped_log_items>(&m_events.back()); last != nullptr)
+		{ ++last->count; }
+		else
+		{ m_events.push_back(dropped_log_items{.count = 1}); }
+		return;
+	}
+
+	m_events.push_back(
+		subscribed_log_item{
+			.client = std::string{who},
+			.item = item
+		}
+	);
+	++m_item_count;
+
+	if(was_empty && m_event_loop != nullptr)
+	{
+		m_event_loop->update_listening_status(
+			m_event_handler,
+			os_services::fd::activity_status::read_or_write
+		);
+	}
+}
+
+std::optional<Pipe::host::log_subscription_event> Pipe::host::log_subscriber::pop()
+{
+	if(m_events.empty())
+	{ return std::nullopt; }
+
+	auto ret = std::move(m_events.front());
+	m_events.pop_front();
+	if(std::holds_alternative<subscribed_log_item>(ret))
+	{ --m_item_count; }
+	return ret;
+}
+
+void Pipe::host::log_subscription_hub::subscribe(
+	std::shared_ptr<log_subscriber> subscriber,
+	log_filter&& filter
+)
+{
+	auto const i = std::ranges::find(m_subscriptions, subscriber, &subscription::subscriber);
+	if(i != std::end(m_subscriptions))
+	{
+		i->filter = std::move(filter);
+		return;
+	}
+
+	m_subscriptions.push_back(
+		subscription{
+			.filter = std::move(filter),
+			.subscriber = std::move(subscriber)
+		}
+	);
+}
+
+void Pipe::host::log_subscription_hub::unsubscribe(log_subscriber const& subscriber)
+{
+	std::erase_if(m_subscriptions, [&subscriber](auto const& item) {
+		return item.subscriber.get() == &subscriber;
+	});
+}
+
+void Pipe::host::log_subscription_hub::on_parse_error(char const* who, jopp::parser_error_code ec)
+{
+	publish(
+		who,
+		log::item{
+			.when = m_clock.now(),
+			.severity = log::item::severity::error,
+			.message = std::format("Failed to parse log data: {}", to_string(ec))
+		}
+	);
+}
+
+void Pipe::host::log_subscription_hub::on_invalid_log_item(char const* who, char const* errmsg)
+{
+	publish(
+		who,
+		log::item{
+			.when = m_clock.now(),
+			.severity = log::item::severity::error,
+			.message = std::format("Invalid log item: {}", errmsg)
+		}
+	);
+}
+
+void Pipe::host::log_subscription_hub::on_sequence_discontinuity(
+	char const* who,
+	json_log::sequence_discontinuity const& discontinuity
+)
+{
+	publish(
+		who,
+		log::item{
+			.when = m_clock.now(),
+			.severity = discontinuity.is_duplicate()? log::item::severity::warning : log::item::severity::error,
+			.message = to_string(discontinuity)
+		}
+	);
+}
+
+void Pipe::host::log_subscription_hub::publish(std::string_view who, log::item const& item)
+{
+	for(auto const& current : m_subscriptions)
+	{
+		if(current.filter.matches(who, item))
+		{ current.subscriber->push(who, item); }
+	}
+}
+
+void Pipe::host::log_subscriber_connection::handle_event(
+	os_services::fd::activity_event const& event,
+	socket_ref fd
+)
+{
+	try
+	{
+		if(can_read(event.get_activity_status()) && !handle_input(event, fd))
+		{
+			close(event);
+			return;
+		}
+
+		if(can_write(event.get_activity_status()) && !handle_output(event, fd))
+		{ close(event); }
+	}
+	catch(os_services::error_handling::system_error const&)
+	{ close(event); }
+}
+
+bool Pipe::host::log_subscriber_connection::handle_input(
+	os_services::fd::activity_event const& event,
+	socket_ref fd
+)
+{
+	std::array<char, 4096> buffer{};
+	while(true)
+	{
+		auto const read_result = receive_nonblocking(fd, std::as_writable_bytes(std::span{buffer}));
+		if(read_result.operation_would_have_blocked())
+		{ return true; }
+
+		if(read_result.bytes_transferred() == 0)
+		{ return false; }
+
+		std::span<char const> input_span{std::data(buffer), read_result.bytes_transferred()};
+		while(std::size(input_span) != 0)
+		{
+			auto const parse_result = m_state->parser.parse(input_span);
+			input_span = std::span{parse_result.ptr, std::end(input_span)};
+
+			if(parse_result.ec == jopp::parser_error_code::more_data_needed)
+			{ break; }
+
+			if(parse_result.ec != jopp::parser_error_code::completed)
+			{ return false; }
+
+			auto const obj = m_state->container.get_if<jopp::object>();
+			if(obj == nullptr)
+			{ return false; }
+
+			auto filter = make_log_filter(*obj);
+			if(!filter.has_value())
+			{ return false; }
+
+			m_hub.get().subscribe(m_subscriber, std::move(*filter));
+			m_state = std::make_unique<state>();
+		}
+
+		if(!event.consume_budget(read_result.bytes_transferred()))
+		{ return true; }
+	}
+}
+
+bool Pipe::host::log_subscriber_connection::handle_output(
+	os_services::fd::activity_event const& event,
+	socket_ref fd
+)
+{
+	while(true)
+	{
+		if(m_output_offset == std::size(m_output))
+		{
+			auto const next_event = m_subscriber->pop();
+			if(!next_event.has_value())
+			{
+				m_output.clear();
+				m_output_offset = 0;
+				event.update_listening_status(os_services::fd::activity_status::read);
+				return true;
+			}
+
+			m_output = to_string(to_jopp_object(*next_event));
+			m_output.push_back('\n');
+			m_output_offset = 0;
+		}
+
+		auto const data_to_write = std::as_bytes(
+			std::span{std::data(m_output) + m_output_offset, std::size(m_output) - m_output_offset}
+		);
+		auto const write_result = send_nonblocking(fd, data_to_write);
+		if(write_result.operation_would_have_blocked())
+		{ return true; }
+
+		m_output_offset += write_result.bytes_transferred();
+		if(!event.consume_budget(write_result.bytes_transferred()))
+		{ return true; }
+	}
+}
+
+void Pipe::host::log_subscriber_connection::close(os_services::fd::activity_event const& event)
+{
+	m_hub.get().unsubscribe(*m_subscriber);
+	event.stop_listening();
+}
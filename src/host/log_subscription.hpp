@@ -0,0 +1,294 @@
+//@	{"dependencies_extra":[{"ref":"./log_subscription.o", "rel":"implementation"}]}
+
+#ifndef PIPE_HOST_LOG_SUBSCRIPTION_HPP
+#define PIPE_HOST_LOG_SUBSCRIPTION_HPP
+
+#include "src/json_log/sequence_tracker.hpp"
+#include "src/log/log.hpp"
+#include "src/os_services/fd/activity_monitor.hpp"
+#include "src/os_services/io_multiplexer/epoll_instance.hpp"
+#include "src/os_services/ipc/socket.hpp"
+#include "src/os_services/ipc/unix_domain_socket.hpp"
+
+#include <jopp/types.hpp>
+#include <jopp/parser.hpp>
+#include <deque>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace Pipe::host
+{
+	/**
+	 * \brief Selects the log items a subscriber is interested in
+	 */
+	struct log_filter
+	{
+		/**
+		 * \brief If set, only items from this client are selected
+		 */
+		std::optional<std::string> client{};
+
+		/**
+		 * \brief The lowest severity to select
+		 */
+		enum log::item::severity min_severity{log::item::severity::info};
+
+		/**
+		 * \brief If set, only items whose message contains this string are selected
+		 */
+		std::optional<std::string> substring{};
+
+		/**
+		 * \brief If set, only items whose message matches this regular expression are selected
+		 */
+		std::optional<std::regex> pattern{};
+
+		/**
+		 * \brief Checks whether or not the item from who is selected by this filter
+		 */
+		bool matches(std::string_view who, log::item const& item) const
+		{
+			return item.severity >= min_severity
+				&& (!client.has_value() || *client == who)
+				&& (!substring.has_value() || item.message.find(*substring) != std::string::npos)
+				&& (!pattern.has_value() || std::regex_search(item.message, *pattern));
+		}
+	};
+
+	/**
+	 * \brief Converts a jopp::object into a log_filter
+	 *
+	 * The object may contain the fields `client`, `min_severity`, `contains`, and `matches`. Any
+	 * field that is not present does not restrict the selection.
+	 *
+	 * \note If conversion fails, a message wrapped in an std::unexpected is returned
+	 */
+	std::expected<log_filter, char const*> make_log_filter(jopp::object const& obj);
+
+	/**
+	 * \brief A log item delivered to a subscriber
+	 */
+	struct subscribed_log_item
+	{
+		std::string client;
+		log::item item;
+
+		bool operator==(subscribed_log_item const&) const = default;
+		bool operator!=(subscribed_log_item const&) const = default;
+	};
+
+	/**
+	 * \brief Notifies a subscriber that log items were dropped, because it did not keep up
+	 */
+	struct dropped_log_items
+	{
+		size_t count;
+
+		bool operator==(dropped_log_items const&) const = default;
+		bool operator!=(dropped_log_items const&) const = default;
+	};
+
+	/**
+	 * \brief An event delivered to a subscriber
+	 */
+	using log_subscription_event = std::variant<subscribed_log_item, dropped_log_items>;
+
+	/**
+	 * \brief Converts event into a jopp::object
+	 *
+	 * A subscribed_log_item is converted in the same way as a log::item, with an additional
+	 * `client` field. A dropped_log_items is converted to an object with a `dropped` field.
+	 */
+	jopp::object to_jopp_object(log_subscription_event const& event);
+
+	/**
+	 * \brief A bounded queue of events for a single subscriber
+	 *
+	 * If the queue is full, new items are dropped. The number of dropped items is recorded in a
+	 * dropped_log_items event, placed after the items that were queued before, so the subscriber
+	 * learns where items went missing. Thus, a slow subscriber never blocks the producer.
+	 */
+	class log_subscriber
+	{
+	public:
+		/**
+		 * \brief Constructs a log_subscriber
+		 * \param max_queue_length The max number of items to keep in the queue
+		 */
+		explicit log_subscriber(size_t max_queue_length):
+			m_max_queue_length{std::max(max_queue_length, static_cast<size_t>(1))}
+		{}
+
+		/**
+		 * \brief Sets the event handler to wake up when the queue becomes non-empty
+		 *
+		 * \param event_loop The epoll_instance where the event handler has been registered
+		 * \param id The id of the event handler
+		 */
+		void set_event_handler(os_services::io_multiplexer::epoll_instance& event_loop, os_services::fd::event_handler_id id)
+		{
+			m_event_loop = &event_loop;
+			m_event_handler = id;
+		}
+
+		/**
+		 * \brief Adds an item to the queue, or records that it was dropped if the queue is full
+		 *
+		 * If the queue was empty, the event handler set by set_event_handler starts listening for
+		 * write activity.
+		 */
+		void push(std::string_view who, log::item const& item);
+
+		/**
+		 * \brief Removes the first event from the queue
+		 * \return The removed event, or an empty optional if the queue is empty
+		 */
+		std::optional<log_subscription_event> pop();
+
+		/**
+		 * \brief Checks whether or not the queue is empty
+		 */
+		bool empty() const noexcept
+		{ return m_events.empty(); }
+
+		/**
+		 * \brief Returns the number of items in the queue
+		 */
+		size_t queue_length() const noexcept
+		{ return m_item_count; }
+
+		/**
+		 * \brief Returns the total number of items dropped so far
+		 */
+		size_t total_dropped() const noexcept
+		{ return m_total_dropped; }
+
+	private:
+		size_t m_max_queue_length;
+		size_t m_item_count{0};
+		size_t m_total_dropped{0};
+		std::deque<log_subscription_event> m_events;
+		os_services::io_multiplexer::epoll_instance* m_event_loop{nullptr};
+		os_services::fd::event_handler_id m_event_handler;
+	};
+
+	/**
+	 * \brief Fans out log items to all subscribers
+	 *
+	 * The hub is an item_receiver, so it can be used as a sink for json_log::reader. For each
+	 * item, the filter of each subscriber is evaluated once, before the item is pushed to the
+	 * queue of that subscriber.
+	 */
+	class log_subscription_hub
+	{
+	public:
+		/**
+		 * \brief Constructs a log_subscription_hub
+		 * \param clock The timestamp_generator used to timestamp parse errors
+		 */
+		explicit log_subscription_hub(
+			log::type_erased_timestamp_generator clock = std::ref(s_system_clock)
+		):
+			m_clock{clock}
+		{}
+
+		/**
+		 * \brief Adds subscriber, or replaces its filter if it has already been added
+		 */
+		void subscribe(std::shared_ptr<log_subscriber> subscriber, log_filter&& filter);
+
+		/**
+		 * \brief Removes subscriber
+		 */
+		void unsubscribe(log_subscriber const& subscriber);
+
+		/**
+		 * \brief Returns the number of subscribers
+		 */
+		size_t subscriber_count() const noexcept
+		{ return std::size(m_subscriptions); }
+
+		void consume(char const* who, log::item&& item)
+		{ publish(who, item); }
+
+		void on_parse_error(char const* who, jopp::parser_error_code ec);
+
+		void on_invalid_log_item(char const* who, char const* errmsg);
+
+		void on_sequence_discontinuity(char const* who, json_log::sequence_discontinuity const& discontinuity);
+
+	private:
+		static constinit inline log::clock s_system_clock{};
+
+		void publish(std::string_view who, log::item const& item);
+
+		struct subscription
+		{
+			log_filter filter;
+			std::shared_ptr<log_subscriber> subscriber;
+		};
+
+		log::type_erased_timestamp_generator m_clock;
+		std::vector<subscription> m_subscriptions;
+	};
+
+	/**
+	 * \brief Serves a log subscriber connected to the host
+	 *
+	 * The subscriber selects items by sending a JSON object, accepted by make_log_filter. A new
+	 * object replaces the previous filter. Selected items are sent back as a stream of JSON
+	 * objects, as produced by to_jopp_object. If the subscriber sends invalid data, or closes the
+	 * connection, it is unsubscribed.
+	 *
+	 * \note The connection must have been registered with the epoll_instance passed to
+	 *       log_subscriber::set_event_handler.
+	 */
+	class log_subscriber_connection
+	{
+	public:
+		using socket_ref = os_services::ipc::connected_socket_ref<SOCK_STREAM, sockaddr_un>;
+
+		/**
+		 * \brief Constructs a log_subscriber_connection
+		 * \param hub The hub to subscribe to
+		 * \param subscriber The queue holding events for this connection
+		 */
+		explicit log_subscriber_connection(
+			log_subscription_hub& hub,
+			std::shared_ptr<log_subscriber> subscriber
+		):
+			m_hub{hub},
+			m_subscriber{std::move(subscriber)},
+			m_state{std::make_unique<state>()}
+		{}
+
+		void handle_event(os_services::fd::activity_event const& event, socket_ref fd);
+
+	private:
+		bool handle_input(os_services::fd::activity_event const& event, socket_ref fd);
+		bool handle_output(os_services::fd::activity_event const& event, socket_ref fd);
+		void close(os_services::fd::activity_event const& event);
+
+		std::reference_wrapper<log_subscription_hub> m_hub;
+		std::shared_ptr<log_subscriber> m_subscriber;
+		std::string m_output;
+		size_t m_output_offset{0};
+
+		struct state
+		{
+			state():parser{container}{}
+
+			jopp::container container;
+			jopp::parser parser;
+		};
+
+		std::unique_ptr<state> m_state;
+	};
+}
+
+#endif
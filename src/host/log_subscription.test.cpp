@@ -0,0 +1,216 @@
+//@	{"target":{"name":"log_subscription.test"}}
+
+#include "./log_subscription.hpp"
+#include "src/os_services/ipc/socket_pair.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	struct my_clock
+	{
+		Pipe::log::clock::time_point now() const
+		{ return Pipe::log::clock::time_point{} + std::chrono::seconds{123}; }
+	};
+
+	Pipe::log::item make_item(enum Pipe::log::item::severity severity, std::string&& message)
+	{
+		return Pipe::log::item{
+			.when = Pipe::log::clock::time_point{} + std::chrono::seconds{1},
+			.severity = severity,
+			.message = std::move(message)
+		};
+	}
+
+	std::vector<Pipe::host::log_subscription_event> drain(Pipe::host::log_subscriber& subscriber)
+	{
+		std::vector<Pipe::host::log_subscription_event> ret;
+		while(auto event = subscriber.pop())
+		{ ret.push_back(std::move(*event)); }
+		return ret;
+	}
+}
+
+TESTCASE(Pipe_host_log_filter_matches)
+{
+	auto const item = make_item(Pipe::log::item::severity::warning, "Disk is almost full (93%)");
+
+	EXPECT_EQ(Pipe::host::log_filter{}.matches("foo", item), true);
+	EXPECT_EQ(Pipe::host::log_filter{.client = "foo"}.matches("foo", item), true);
+	EXPECT_EQ(Pipe::host::log_filter{.client = "foo"}.matches("bar", item), false);
+	EXPECT_EQ(
+		Pipe::host::log_filter{.min_severity = Pipe::log::item::severity::warning}.matches("foo", item),
+		true
+	);
+	EXPECT_EQ(
+		Pipe::host::log_filter{.min_severity = Pipe::log::item::severity::error}.matches("foo", item),
+		false
+	);
+	EXPECT_EQ(Pipe::host::log_filter{.substring = "almost"}.matches("foo", item), true);
+	EXPECT_EQ(Pipe::host::log_filter{.substring = "empty"}.matches("foo", item), false);
+	EXPECT_EQ(Pipe::host::log_filter{.pattern = std::regex{"\\(9[0-9]%\\)"}}.matches("foo", item), true);
+	EXPECT_EQ(Pipe::host::log_filter{.pattern = std::regex{"^Disk is full"}}.matches("foo", item), false);
+}
+
+TESTCASE(Pipe_host_log_subscriber_push_and_pop)
+{
+	Pipe::host::log_subscriber subscriber{4};
+	EXPECT_EQ(subscriber.empty(), true);
+	EXPECT_EQ(subscriber.pop().has_value(), false);
+
+	subscriber.push("foo", make_item(Pipe::log::item::severity::info, "Item 1"));
+	subscriber.push("bar", make_item(Pipe::log::item::severity::info, "Item 2"));
+	EXPECT_EQ(subscriber.queue_length(), 2);
+
+	auto const events = drain(subscriber);
+	REQUIRE_EQ(std::size(events), 2);
+	EXPECT_EQ(
+		events[1],
+		(Pipe::host::log_subscription_event{
+			Pipe::host::subscribed_log_item{
+				.client = "bar",
+				.item = make_item(Pipe::log::item::severity::info, "Item 2")
+			}
+		})
+	);
+	EXPECT_EQ(subscriber.queue_length(), 0);
+	EXPECT_EQ(subscriber.total_dropped(), 0);
+}
+
+TESTCASE(Pipe_host_log_subscriber_drops_when_full)
+{
+	Pipe::host::log_subscriber subscriber{2};
+	for(size_t k = 0; k != 5; ++k)
+	{ subscriber.push("foo", make_item(Pipe::log::item::severity::info, std::format("Item {}", k))); }
+	EXPECT_EQ(subscriber.queue_length(), 2);
+	EXPECT_EQ(subscriber.total_dropped(), 3);
+
+	// Popping one item makes room for another one, after the drop notification
+	REQUIRE_EQ(subscriber.pop().has_value(), true);
+	subscriber.push("foo", make_item(Pipe::log::item::severity::info, "Item 5"));
+	subscriber.push("foo", make_item(Pipe::log::item::severity::info, "Item 6"));
+
+	auto const events = drain(subscriber);
+	REQUIRE_EQ(std::size(events), 4);
+	EXPECT_EQ(std::get<Pipe::host::subscribed_log_item>(events[0]).item.message, "Item 1");
+	EXPECT_EQ(std::get<Pipe::host::dropped_log_items>(events[1]).count, 3);
+	EXPECT_EQ(std::get<Pipe::host::subscribed_log_item>(events[2]).item.message, "Item 5");
+	EXPECT_EQ(std::get<Pipe::host::dropped_log_items>(events[3]).count, 1);
+	EXPECT_EQ(subscriber.total_dropped(), 4);
+}
+
+TESTCASE(Pipe_host_log_subscription_hub_fan_out)
+{
+	my_clock clock;
+	Pipe::host::log_subscription_hub hub{std::ref(clock)};
+	auto const all = std::make_shared<Pipe::host::log_subscriber>(16);
+	auto const errors = std::make_shared<Pipe::host::log_subscriber>(16);
+	auto const from_foo = std::make_shared<Pipe::host::log_subscriber>(16);
+
+	hub.subscribe(all, Pipe::host::log_filter{});
+	hub.subscribe(errors, Pipe::host::log_filter{.min_severity = Pipe::log::item::severity::error});
+	hub.subscribe(from_foo, Pipe::host::log_filter{.client = "bar"});
+	hub.subscribe(from_foo, Pipe::host::log_filter{.client = "foo"});
+	EXPECT_EQ(hub.subscriber_count(), 3);
+
+	hub.consume("foo", make_item(Pipe::log::item::severity::info, "Item 1"));
+	hub.consume("bar", make_item(Pipe::log::item::severity::error, "Item 2"));
+	hub.on_invalid_log_item("foo", "Bad item");
+	hub.on_sequence_discontinuity("bar", Pipe::json_log::sequence_discontinuity{.expected = 5, .received = 2});
+
+	EXPECT_EQ(std::size(drain(*all)), 4);
+
+	// A duplicate is only a warning
+	auto const error_events = drain(*errors);
+	REQUIRE_EQ(std::size(error_events), 2);
+	EXPECT_EQ(
+		error_events[1],
+		(Pipe::host::log_subscription_event{
+			Pipe::host::subscribed_log_item{
+				.client = "foo",
+				.item = Pipe::log::item{
+					.when = clock.now(),
+					.severity = Pipe::log::item::severity::error,
+					.message = "Invalid log item: Bad item"
+				}
+			}
+		})
+	);
+
+	auto const foo_events = drain(*from_foo);
+	REQUIRE_EQ(std::size(foo_events), 2);
+	EXPECT_EQ(std::get<Pipe::host::subscribed_log_item>(foo_events[0]).item.message, "Item 1");
+
+	hub.unsubscribe(*errors);
+	EXPECT_EQ(hub.subscriber_count(), 2);
+	hub.consume("bar", make_item(Pipe::log::item::severity::error, "Item 3"));
+	EXPECT_EQ(errors->empty(), true);
+	EXPECT_EQ(std::size(drain(*all)), 1);
+}
+
+TESTCASE(Pipe_host_log_subscriber_connection_serve_subscriber)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	Pipe::host::log_subscription_hub hub;
+	Pipe::os_services::ipc::socket_pair<SOCK_STREAM, Pipe::os_services::fd::io_mode::nonblocking> sockets;
+
+	auto const subscriber = std::make_shared<Pipe::host::log_subscriber>(16);
+	auto const id = event_loop.add(
+		sockets.take_socket_a(),
+		Pipe::os_services::fd::activity_status::read,
+		Pipe::host::log_subscriber_connection{hub, subscriber}
+	);
+	subscriber->set_event_handler(event_loop, id);
+
+	std::string_view const filter{R"({"client": "foo", "min_severity": "warning", "contains": "disk"})"};
+	Pipe::os_services::io::write(sockets.socket_b(), std::as_bytes(std::span{filter}));
+	event_loop.wait_for_and_distpatch_events();
+	EXPECT_EQ(hub.subscriber_count(), 1);
+
+	hub.consume("foo", make_item(Pipe::log::item::severity::info, "disk is ok"));
+	hub.consume("bar", make_item(Pipe::log::item::severity::warning, "disk is almost full"));
+	hub.consume("foo", make_item(Pipe::log::item::severity::warning, "disk is almost full"));
+	EXPECT_EQ(subscriber->queue_length(), 1);
+	event_loop.wait_for_and_distpatch_events();
+	EXPECT_EQ(subscriber->queue_length(), 0);
+
+	std::array<char, 1024> buffer{};
+	auto const read_result = Pipe::os_services::io::read(sockets.socket_b(), std::as_writable_bytes(std::span{buffer}));
+	std::string_view const received{std::data(buffer), read_result.bytes_transferred()};
+	REQUIRE_EQ(received.back(), '\n');
+
+	auto const parsed = jopp::parse(received);
+	auto const obj = parsed.get_if<jopp::object>();
+	REQUIRE_NE(obj, nullptr);
+	EXPECT_EQ(obj->get_field_as<jopp::string>("client"), "foo");
+	EXPECT_EQ(obj->get_field_as<jopp::string>("message"), "disk is almost full");
+
+	sockets.close_socket_b();
+	event_loop.wait_for_and_distpatch_events();
+	EXPECT_EQ(hub.subscriber_count(), 0);
+}
+
+TESTCASE(Pipe_host_log_subscriber_connection_invalid_filter)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	Pipe::host::log_subscription_hub hub;
+	Pipe::os_services::ipc::socket_pair<SOCK_STREAM, Pipe::os_services::fd::io_mode::nonblocking> sockets;
+
+	auto const subscriber = std::make_shared<Pipe::host::log_subscriber>(16);
+	auto const id = event_loop.add(
+		sockets.take_socket_a(),
+		Pipe::os_services::fd::activity_status::read,
+		Pipe::host::log_subscriber_connection{hub, subscriber}
+	);
+	subscriber->set_event_handler(event_loop, id);
+
+	std::string_view const filter{R"({"matches": "("})"};
+	Pipe::os_services::io::write(sockets.socket_b(), std::as_bytes(std::span{filter}));
+	event_loop.wait_for_and_distpatch_events();
+	EXPECT_EQ(hub.subscriber_count(), 0);
+
+	// The connection should have been closed
+	std::array<char, 16> buffer{};
+	auto const read_result = Pipe::os_services::io::read(sockets.socket_b(), std::as_writable_bytes(std::span{buffer}));
+	EXPECT_EQ(read_result.bytes_transferred(), 0);
+}
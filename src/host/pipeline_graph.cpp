@@ -0,0 +1,213 @@
+//@	{"target":{"name":"pipeline_graph.o"}}
+
+#include "./pipeline_graph.hpp"
+
+#include <format>
+#include <set>
+#include <stdexcept>
+
+std::expected<Pipe::host::edge_transport, char const*>
+Pipe::host::make_edge_transport(std::string_view str)
+{
+	if(str == "pipe")
+	{ return edge_transport::pipe; }
+
+	if(str == "relayed")
+	{ return edge_transport::relayed; }
+
+	return std::unexpected{"Unknown edge transport"};
+}
+
+std::expected<Pipe::host::port_endpoint, char const*>
+Pipe::host::make_port_endpoint(std::string_view str)
+{
+	auto const dot = str.find('.');
+	if(dot == std::string_view::npos)
+	{ return std::unexpected{"A port endpoint must be written as node.port"}; }
+
+	auto const node = str.substr(0, dot);
+	auto const port = str.substr(dot + 1);
+	if(node.empty() || port.empty())
+	{ return std::unexpected{"A port endpoint must be written as node.port"}; }
+
+	return port_endpoint{.node = std::string{node}, .port = std::string{port}};
+}
+
+Pipe::host::pipeline_graph Pipe::host::make_pipeline_graph(jopp::object const& obj)
+{
+	pipeline_graph ret;
+	for(auto const& item : obj.get_field_as<jopp::object>("nodes"))
+	{
+		auto const& node = item.second.get<jopp::object>();
+		auto const config = node.try_get_field_as<jopp::object>("config");
+		ret.nodes.insert(
+			std::pair{
+				std::string{item.first},
+				graph_node{
+					.binary = std::string{node.get_field_as<jopp::string>("binary")},
+					.config = config != nullptr? *config : jopp::object{}
+				}
+			}
+		);
+	}
+
+	auto const get_endpoint = [](jopp::object const& edge, std::string_view field) {
+		auto ret = make_port_endpoint(edge.get_field_as<jopp::string>(field));
+		if(!ret.has_value())
+		{ throw std::runtime_error{std::format("Invalid value in field `{}`: {}", field, ret.error())}; }
+		return std::move(*ret);
+	};
+
+	for(auto const& item : obj.get_field_as<jopp::array>("edges"))
+	{
+		auto const& edge = item.get<jopp::object>();
+		graph_edge new_edge{
+			.from = get_endpoint(edge, "from"),
+			.to = get_endpoint(edge, "to"),
+			.transport = edge_transport::pipe,
+			.buffer_size = 0
+		};
+
+		if(auto const transport = edge.try_get_field_as<jopp::string>("transport"); transport != nullptr)
+		{
+			auto const value = make_edge_transport(*transport);
+			if(!value.has_value())
+			{ throw std::runtime_error{std::format("Invalid value in field `transport`: {}", value.error())}; }
+			new_edge.transport = *value;
+		}
+
+		if(auto const buffer_size = edge.try_get_field_as<jopp::number>("buffer_size"); buffer_size != nullptr)
+		{
+			if(*buffer_size < 0 || *buffer_size != static_cast<jopp::number>(static_cast<size_t>(*buffer_size)))
+			{ throw std::runtime_error{"Invalid value in field `buffer_size`"}; }
+			new_edge.buffer_size = static_cast<size_t>(*buffer_size);
+		}
+
+		ret.edges.push_back(std::move(new_edge));
+	}
+
+	return ret;
+}
+
+namespace
+{
+	void check_all_ports_connected(
+		std::string_view node,
+		Pipe::client_ctl::port_info_map const& ports,
+		std::set<Pipe::host::port_endpoint> const& connected,
+		std::string_view direction
+	)
+	{
+		for(auto const& port : ports)
+		{
+			Pipe::host::port_endpoint endpoint{.node = std::string{node}, .port = port.first};
+			if(!connected.contains(endpoint))
+			{ throw std::runtime_error{std::format("{} port {} is not connected", direction, to_string(endpoint))}; }
+		}
+	}
+}
+
+Pipe::host::pipeline_plan Pipe::host::validate(pipeline_graph const& graph, client_info_map const& clients)
+{
+	std::map<std::string_view, size_t> node_index;
+	std::vector<std::string_view> node_names;
+	for(auto const& node : graph.nodes)
+	{
+		if(!clients.contains(node.first))
+		{ throw std::runtime_error{std::format("There is no client information for node {}", node.first)}; }
+		node_index.insert(std::pair{std::string_view{node.first}, std::size(node_names)});
+		node_names.push_back(node.first);
+	}
+
+	auto const get_node = [&node_index](port_endpoint const& endpoint) {
+		auto const i = node_index.find(endpoint.node);
+		if(i == std::end(node_index))
+		{ throw std::runtime_error{std::format("Edge refers to unknown node {}", endpoint.node)}; }
+		return i->second;
+	};
+
+	pipeline_plan ret;
+	ret.edge_content_types.reserve(std::size(graph.edges));
+	std::set<port_endpoint> connected_inputs;
+	std::set<port_endpoint> connected_outputs;
+	std::set<port_endpoint> piped_outputs;
+	std::vector<std::vector<size_t>> producers(std::size(node_names));
+	std::vector<size_t> consumer_count(std::size(node_names));
+	for(auto const& edge : graph.edges)
+	{
+		auto const producer = get_node(edge.from);
+		auto const consumer = get_node(edge.to);
+
+		ret.edge_content_types.push_back(
+			client_ctl::negotiate(
+				clients.find(edge.from.node)->second,
+				edge.from.port,
+				clients.find(edge.to.node)->second,
+				edge.to.port
+			)
+		);
+
+		if(!connected_inputs.insert(edge.to).second)
+		{ throw std::runtime_error{std::format("Input port {} has more than one incoming edge", to_string(edge.to))}; }
+
+		// A pipe has a single reader, so only relayed edges can share an output port
+		auto const fan_out = !connected_outputs.insert(edge.from).second;
+		if(edge.transport == edge_transport::pipe)
+		{ piped_outputs.insert(edge.from); }
+
+		if(fan_out && piped_outputs.contains(edge.from))
+		{
+			throw std::runtime_error{
+				std::format("Output port {} is connected to more than one input port by a pipe", to_string(edge.from))
+			};
+		}
+
+		producers[consumer].push_back(producer);
+		++consumer_count[producer];
+	}
+
+	for(auto const& node : graph.nodes)
+	{
+		auto const& info = clients.find(node.first)->second;
+		check_all_ports_connected(node.first, info.inputs, connected_inputs, "Input");
+		check_all_ports_connected(node.first, info.outputs, connected_outputs, "Output");
+	}
+
+	// Start with the nodes that do not feed any other node, and then add a node once all of its
+	// consumers have been added
+	std::vector<size_t> current_stage;
+	for(size_t k = 0; k != std::size(node_names); ++k)
+	{
+		if(consumer_count[k] == 0)
+		{ current_stage.push_back(k); }
+	}
+
+	size_t launched = 0;
+	while(!current_stage.empty())
+	{
+		std::vector<size_t> next_stage;
+		auto& stage = ret.launch_stages.emplace_back();
+		for(auto const node : current_stage)
+		{
+			stage.push_back(std::string{node_names[node]});
+			for(auto const producer : producers[node])
+			{
+				if(--consumer_count[producer] == 0)
+				{ next_stage.push_back(producer); }
+			}
+		}
+		launched += std::size(current_stage);
+		current_stage = std::move(next_stage);
+	}
+
+	if(launched != std::size(node_names))
+	{
+		for(size_t k = 0; k != std::size(node_names); ++k)
+		{
+			if(consumer_count[k] != 0)
+			{ throw std::runtime_error{std::format("Pipeline graph contains a cycle through node {}", node_names[k])}; }
+		}
+	}
+
+	return ret;
+}
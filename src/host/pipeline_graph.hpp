@@ -0,0 +1,188 @@
+//@	{"dependencies_extra":[{"ref":"./pipeline_graph.o", "rel":"implementation"}]}
+
+#ifndef PIPE_HOST_PIPELINE_GRAPH_HPP
+#define PIPE_HOST_PIPELINE_GRAPH_HPP
+
+#include "src/client_ctl/client_application_info.hpp"
+#include "src/client_ctl/content_type.hpp"
+
+#include <jopp/types.hpp>
+#include <compare>
+#include <expected>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Pipe::host
+{
+	/**
+	 * \brief Controls how data is moved along an edge
+	 */
+	enum class edge_transport
+	{
+		/**
+		 * \brief The producer writes directly to a pipe that the consumer reads from
+		 */
+		pipe,
+
+		/**
+		 * \brief Data is relayed by the host, which also mediates credit grants. This allows an
+		 *        output port to be connected to more than one input port.
+		 */
+		relayed
+	};
+
+	/**
+	 * \brief Converts an edge_transport to a string
+	 */
+	constexpr char const* to_string(edge_transport value) noexcept
+	{
+		switch(value)
+		{
+			case edge_transport::pipe:
+				return "pipe";
+			case edge_transport::relayed:
+				return "relayed";
+		}
+		return "unknown";
+	}
+
+	/**
+	 * \brief Converts a string to an edge_transport
+	 */
+	std::expected<edge_transport, char const*> make_edge_transport(std::string_view str);
+
+	/**
+	 * \brief Identifies a port of a node in a pipeline_graph
+	 */
+	struct port_endpoint
+	{
+		std::string node;
+		std::string port;
+
+		auto operator<=>(port_endpoint const&) const = default;
+	};
+
+	/**
+	 * \brief Converts a string in the form `node.port` to a port_endpoint
+	 */
+	std::expected<port_endpoint, char const*> make_port_endpoint(std::string_view str);
+
+	/**
+	 * \brief Converts a port_endpoint to a string in the form `node.port`
+	 */
+	inline std::string to_string(port_endpoint const& endpoint)
+	{ return endpoint.node + "." + endpoint.port; }
+
+	/**
+	 * \brief A connection from an output port to an input port
+	 */
+	struct graph_edge
+	{
+		/**
+		 * \brief The output port that produces the data
+		 */
+		port_endpoint from;
+
+		/**
+		 * \brief The input port that consumes the data
+		 */
+		port_endpoint to;
+
+		/**
+		 * \brief How data is moved from the producer to the consumer
+		 */
+		edge_transport transport{edge_transport::pipe};
+
+		/**
+		 * \brief The amount of data that may be in flight on this edge, or 0 to use the default
+		 */
+		size_t buffer_size{0};
+	};
+
+	/**
+	 * \brief A client process in a pipeline_graph
+	 */
+	struct graph_node
+	{
+		/**
+		 * \brief The client binary to run
+		 */
+		std::filesystem::path binary;
+
+		/**
+		 * \brief Client-specific configuration
+		 */
+		jopp::object config;
+	};
+
+	/**
+	 * \brief Describes a pipeline, as a set of named nodes, and the edges connecting them
+	 */
+	struct pipeline_graph
+	{
+		std::map<std::string, graph_node, std::less<>> nodes;
+		std::vector<graph_edge> edges;
+	};
+
+	/**
+	 * \brief Converts a jopp::object to a pipeline_graph
+	 *
+	 * The object has the form
+	 *
+	 * \code
+	 * {
+	 *   "nodes": {"source": {"binary": "/usr/bin/foo", "config": {}}, ...},
+	 *   "edges": [{"from": "source.stdout", "to": "sink.stdin", "transport": "pipe", "buffer_size": 65536}, ...]
+	 * }
+	 * \endcode
+	 *
+	 * The fields `config`, `transport`, and `buffer_size` are optional.
+	 *
+	 * \throw std::runtime_error if the object is not a valid pipeline graph
+	 */
+	pipeline_graph make_pipeline_graph(jopp::object const& obj);
+
+	/**
+	 * \brief The information about each client needed to validate a pipeline_graph, indexed by node
+	 */
+	using client_info_map = std::map<std::string, client_ctl::client_application_info, std::less<>>;
+
+	/**
+	 * \brief The result of validating a pipeline_graph
+	 */
+	struct pipeline_plan
+	{
+		/**
+		 * \brief The order to start the nodes in
+		 *
+		 * All nodes within a stage may be started together. The consumers of a node are always in
+		 * an earlier stage than the node itself, so no client starts producing data before
+		 * whatever it is connected to is running.
+		 */
+		std::vector<std::vector<std::string>> launch_stages;
+
+		/**
+		 * \brief The negotiated content type of each edge, in the same order as the edges of the
+		 *        graph
+		 */
+		std::vector<client_ctl::content_type> edge_content_types;
+	};
+
+	/**
+	 * \brief Validates graph against the information advertised by each client, and computes the
+	 *        launch order
+	 *
+	 * The graph is rejected if any node lacks client information, if an edge refers to a port
+	 * that does not exist, if the content types of an edge cannot be negotiated, if any port is
+	 * unconnected, if an input port has more than one incoming edge, if an output port is
+	 * connected to more than one input port by a pipe, or if the graph has a cycle.
+	 *
+	 * \throw std::runtime_error if the graph is rejected
+	 */
+	pipeline_plan validate(pipeline_graph const& graph, client_info_map const& clients);
+}
+
+#endif
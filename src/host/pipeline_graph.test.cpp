@@ -0,0 +1,165 @@
+//@	{"target":{"name":"pipeline_graph.test"}}
+
+#include "./pipeline_graph.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	Pipe::client_ctl::client_application_info make_client(
+		std::string const& display_name,
+		std::vector<std::string> const& inputs,
+		std::vector<std::string> const& outputs,
+		std::string const& content_type = "text/plain"
+	)
+	{
+		Pipe::client_ctl::client_application_info ret{.display_name = display_name, .inputs = {}, .outputs = {}};
+		for(auto const& item : inputs)
+		{ ret.inputs.insert(std::pair{item, Pipe::client_ctl::port_info{.stream_content_type = content_type}}); }
+		for(auto const& item : outputs)
+		{ ret.outputs.insert(std::pair{item, Pipe::client_ctl::port_info{.stream_content_type = content_type}}); }
+		return ret;
+	}
+
+	Pipe::host::graph_edge make_edge(
+		std::string_view from,
+		std::string_view to,
+		Pipe::host::edge_transport transport = Pipe::host::edge_transport::pipe
+	)
+	{
+		return Pipe::host::graph_edge{
+			.from = Pipe::host::make_port_endpoint(from).value(),
+			.to = Pipe::host::make_port_endpoint(to).value(),
+			.transport = transport,
+			.buffer_size = 0
+		};
+	}
+
+	Pipe::host::pipeline_graph make_graph(
+		std::vector<std::string> const& nodes,
+		std::vector<Pipe::host::graph_edge> edges
+	)
+	{
+		Pipe::host::pipeline_graph ret;
+		for(auto const& item : nodes)
+		{ ret.nodes.insert(std::pair{item, Pipe::host::graph_node{.binary = item, .config = {}}}); }
+		ret.edges = std::move(edges);
+		return ret;
+	}
+
+	void expect_rejected(
+		Pipe::host::pipeline_graph const& graph,
+		Pipe::host::client_info_map const& clients,
+		std::string_view expected_message
+	)
+	{
+		try
+		{
+			std::ignore = Pipe::host::validate(graph, clients);
+			abort();
+		}
+		catch(std::runtime_error const& err)
+		{ EXPECT_EQ(err.what(), expected_message); }
+	}
+}
+
+TESTCASE(Pipe_host_pipeline_graph_make_port_endpoint)
+{
+	auto const res = Pipe::host::make_port_endpoint("source.stdout");
+	REQUIRE_EQ(res.has_value(), true);
+	EXPECT_EQ(res->node, "source");
+	EXPECT_EQ(res->port, "stdout");
+	EXPECT_EQ(to_string(*res), "source.stdout");
+
+	EXPECT_EQ(Pipe::host::make_port_endpoint("source").has_value(), false);
+	EXPECT_EQ(Pipe::host::make_port_endpoint(".stdout").has_value(), false);
+	EXPECT_EQ(Pipe::host::make_port_endpoint("source.").has_value(), false);
+
+	EXPECT_EQ(Pipe::host::make_edge_transport("relayed").value(), Pipe::host::edge_transport::relayed);
+	EXPECT_EQ(Pipe::host::make_edge_transport("carrier pigeon").has_value(), false);
+}
+
+TESTCASE(Pipe_host_pipeline_graph_launch_order)
+{
+	// source -> filter -> sink, and source -> monitor through the host
+	auto const graph = make_graph(
+		{"source", "filter", "sink", "monitor"},
+		{
+			make_edge("source.out", "filter.in", Pipe::host::edge_transport::relayed),
+			make_edge("source.out", "monitor.in", Pipe::host::edge_transport::relayed),
+			make_edge("filter.out", "sink.in")
+		}
+	);
+
+	Pipe::host::client_info_map const clients{
+		{"source", make_client("source", {}, {"out"})},
+		{"filter", make_client("filter", {"in"}, {"out"})},
+		{"sink", make_client("sink", {"in"}, {})},
+		{"monitor", make_client("monitor", {"in"}, {}, "")}
+	};
+
+	auto const plan = Pipe::host::validate(graph, clients);
+	REQUIRE_EQ(std::size(plan.launch_stages), 3);
+	REQUIRE_EQ(std::size(plan.launch_stages[0]), 2);
+	EXPECT_EQ(plan.launch_stages[0][0], "monitor");
+	EXPECT_EQ(plan.launch_stages[0][1], "sink");
+	REQUIRE_EQ(std::size(plan.launch_stages[1]), 1);
+	EXPECT_EQ(plan.launch_stages[1][0], "filter");
+	REQUIRE_EQ(std::size(plan.launch_stages[2]), 1);
+	EXPECT_EQ(plan.launch_stages[2][0], "source");
+
+	REQUIRE_EQ(std::size(plan.edge_content_types), 3);
+	EXPECT_EQ(plan.edge_content_types[1].media_type, "text/plain");
+}
+
+TESTCASE(Pipe_host_pipeline_graph_rejected)
+{
+	Pipe::host::client_info_map const clients{
+		{"a", make_client("a", {"in"}, {"out"})},
+		{"b", make_client("b", {"in"}, {"out"})},
+		{"c", make_client("c", {"in"}, {}, "application/x-pipe-records; fields=u8")}
+	};
+
+	expect_rejected(
+		make_graph({"a", "x"}, {}),
+		clients,
+		"There is no client information for node x"
+	);
+
+	expect_rejected(
+		make_graph({"a"}, {make_edge("a.out", "b.in")}),
+		clients,
+		"Edge refers to unknown node b"
+	);
+
+	expect_rejected(
+		make_graph({"a", "b"}, {make_edge("a.out", "b.in"), make_edge("b.out", "a.in")}),
+		clients,
+		"Pipeline graph contains a cycle through node a"
+	);
+
+	expect_rejected(
+		make_graph({"a", "b"}, {make_edge("a.out", "b.in")}),
+		clients,
+		"Input port a.in is not connected"
+	);
+
+	expect_rejected(
+		make_graph({"a", "c"}, {make_edge("a.out", "c.in")}),
+		clients,
+		"Cannot connect a.out (text/plain) to c.in (application/x-pipe-records; fields=u8): Media types do not match"
+	);
+
+	expect_rejected(
+		make_graph(
+			{"a", "b", "c"},
+			{make_edge("a.out", "b.in", Pipe::host::edge_transport::relayed), make_edge("a.out", "a.in")}
+		),
+		Pipe::host::client_info_map{
+			{"a", make_client("a", {"in"}, {"out"})},
+			{"b", make_client("b", {"in"}, {})},
+			{"c", make_client("c", {}, {})}
+		},
+		"Output port a.out is connected to more than one input port by a pipe"
+	);
+}
@@ -1,4 +1,7 @@
 #include "./client_process.hpp"
+#include "./credit_broker.hpp"
+#include "./pipeline_graph.hpp"
+#include "./log_subscription.hpp"
 
 #include "src/os_services/fd/activity_monitor.hpp"
 #include "src/os_services/fd/file_descriptor.hpp"
@@ -8,32 +11,25 @@
 #include "src/os_services/ipc/unix_domain_socket.hpp"
 #include "src/os_services/ipc/socket_pair.hpp"
 #include "src/os_services/io_multiplexer/epoll_instance.hpp"
+#include "src/os_services/memory/buffer_pool.hpp"
 #include "src/os_services/proc_mgmt/proc_mgmt.hpp"
-#include "src/client_ctl/startup_config.hpp"
+#include "src/client_ctl/flat_startup_config.hpp"
+#include "src/json_log/rate_limiter.hpp"
+#include "src/json_log/reader.hpp"
+#include "src/log/log.hpp"
+#include "src/log_store/store.hpp"
 #include "src/utils/utils.hpp"
 
 #include <ctime>
+#include <functional>
+#include <map>
+#include <optional>
 #include <random>
+#include <type_traits>
 #include <unordered_map>
-#include <jopp/serializer.hpp>
 
 namespace Pipe::host
 {
-	class log_reader
-	{
-	public:
-		void handle_event(
-			os_services::fd::activity_event const& event,
-			os_services::io::input_file_descriptor_ref
-		)
-		{
-			if(can_read(event.get_activity_status()))
-			{
-				// TODO: Decode log entries and dispatch to listener
-			}
-		}
-	};
-
 	class client_process_repository:std::unordered_map<pid_t, std::shared_ptr<client_process>>
 	{
 	public:
@@ -44,36 +40,84 @@ namespace Pipe::host
 		using base::end;
 		using base::size;
 
+		/**
+		 * \brief Constructs a client_process_repository
+		 * \param log_items Receives the log items written by loaded clients
+		 */
+		explicit client_process_repository(log_subscription_hub& log_items):
+			m_log_items{log_items}
+		{}
+
+		/**
+		 * \brief Constructs a client_process_repository, that also stores log items
+		 * \param log_items Receives the log items written by loaded clients
+		 * \param stored_log_items The store where log items are appended, before they are passed
+		 *        to log_items
+		 */
+		explicit client_process_repository(log_subscription_hub& log_items, log_store::store& stored_log_items):
+			m_log_items{log_items},
+			m_stored_log_items{&stored_log_items}
+		{}
+
+		/**
+		 * \brief Reaps the client referred to by fd, and forgets about it
+		 *
+		 * The pidfd of a client becomes readable when the client has terminated. The client is
+		 * then removed from the repository, and from any relayed edge in the credit_broker.
+		 */
 		void handle_event(
 			os_services::fd::activity_event const& event,
-			os_services::proc_mgmt::pidfd_ref
+			os_services::proc_mgmt::pidfd_ref fd,
+			pid_t pid
 		)
 		{
-			if(can_read(event.get_activity_status()))
-			{
-				// TODO: Decode log entries and dispatch to listener
-			}
+			if(!can_read(event.get_activity_status()))
+			{ return; }
+
+			event.stop_listening();
+			std::ignore = os_services::proc_mgmt::wait(fd);
+			erase(pid);
+			m_credit_broker.disconnect(pid);
 		}
 
-		void load(
+		/**
+		 * \brief Starts client_binary, and registers it with activity_monitor
+		 *
+		 * If numa is set, the client runs on, and allocates memory from, that NUMA node. The
+		 * buffers used for reading the log pipe of the client are then borrowed from a pool whose
+		 * memory is placed on the same node. That pool is shared by all clients on the node. To
+		 * keep data local, the thread that runs activity_monitor should also be placed on that
+		 * node.
+		 *
+		 * Log items written by the client pass through a rate_limited_item_receiver configured by
+		 * log_rate_limit, before they reach the log store, if any, and the log_subscription_hub.
+		 * Its counters are available through client_process::log_suppression_metrics.
+		 *
+		 * \return The pid of the new client process
+		 */
+		pid_t load(
 			std::filesystem::path const& client_binary,
-			os_services::io_multiplexer::epoll_instance& activity_monitor
+			os_services::io_multiplexer::epoll_instance& activity_monitor,
+			std::optional<os_services::memory::numa_node> numa = std::nullopt,
+			json_log::rate_limiter_config const& log_rate_limit = json_log::rate_limiter_config{}
 		)
 		{
-			os_services::ipc::pipe logpipe;
-			os_services::ipc::socket_pair<SOCK_STREAM> ctl_sockets;
-			auto const startup_config = to_string(
-				client_ctl::to_jopp_object(
-					client_ctl::startup_config{
-						client_ctl::host_info{
-							.address = ctl_sockets.socket_b()
-						}
-					}
-				)
+			// The ends used by the client stay blocking
+			os_services::ipc::pipe<os_services::fd::io_mode::nonblocking> logpipe;
+			os_services::ipc::socket_pair<SOCK_SEQPACKET, os_services::fd::io_mode::nonblocking> ctl_sockets;
+			auto startup_config = client_ctl::make_startup_config_memfd(
+				client_ctl::host_info{
+					.address = ctl_sockets.socket_b()
+				}
 			);
-			std::array args_cstr{startup_config.c_str()};
-			std::array fds_to_keep{Pipe::os_services::fd::make_generic_file_descriptor(ctl_sockets.take_socket_b())};
+			auto const startup_config_arg = client_ctl::make_startup_config_fd_argument(startup_config.get());
+			std::array args_cstr{startup_config_arg.c_str()};
+			std::array fds_to_keep{
+				Pipe::os_services::fd::make_generic_file_descriptor(ctl_sockets.take_socket_b()),
+				Pipe::os_services::fd::make_generic_file_descriptor(std::move(startup_config))
+			};
 
+			auto const fork_time = startup_clock::now();
 			auto process = os_services::proc_mgmt::spawn(
 				client_binary.c_str(),
 				std::span{std::data(args_cstr), 1},
@@ -83,51 +127,374 @@ namespace Pipe::host
 					.sysout = {},
 					.syserr = logpipe.take_write_end()
 				},
-				std::span{fds_to_keep}
+				std::span{fds_to_keep},
+				numa.has_value()?
+					std::optional{os_services::memory::numa_binding{*numa}} : std::nullopt
 			);
 
+			// spawn returns when execve has succeeded in the child
+			auto const exec_time = startup_clock::now();
+
 			auto client_proc = std::make_shared<client_process>();
-			activity_monitor.make_config_transaction()
+			client_proc->set_startup_tracker(m_startup_latency);
+			client_proc->on_spawned(fork_time, exec_time);
+			client_proc->set_credit_grant_handler(
+				[this, consumer = process.first](std::string_view port, client_ctl::credit amount) {
+					forward_credit(client_port{.client = consumer, .port = std::string{port}}, amount);
+				}
+			);
+			// The rate limiter is shared with client_proc, so its metrics can be inspected for as
+			// long as either the client or its log pipe is around
+			auto log_filter = std::make_shared<json_log::rate_limited_item_receiver<log_item_sink>>(
+				log_item_sink{m_log_items, m_stored_log_items},
+				log_rate_limit
+			);
+			client_proc->set_log_suppression_metrics(
+				std::shared_ptr<json_log::suppression_metrics const>{log_filter, &log_filter->metrics()}
+			);
+
+			auto transaction = activity_monitor.make_config_transaction();
+			transaction.add(
+				ctl_sockets.take_socket_a(),
+				os_services::fd::activity_status::read,
+				client_proc
+			);
+			client_proc->set_event_handler(activity_monitor, transaction.last_added_id());
+
+			transaction
 				.add(
 					logpipe.take_read_end(),
 					os_services::fd::activity_status::read,
-					log_reader{}
-				)
-				.add(
-					ctl_sockets.take_socket_a(),
-					os_services::fd::activity_status::write,
-					client_proc
+					first_output_probe{
+						json_log::reader{
+							client_binary.filename().string(),
+							std::move(log_filter),
+							json_log::reader::default_buffer_size,
+							get_log_buffer_pool(numa)
+						},
+						client_proc
+					}
 				)
 				.add(
 					std::move(process.second),
 					os_services::fd::activity_status::read,
-					std::ref(*this)
+					exit_monitor{*this, process.first}
 				)
 			.commit();
+
+			insert(std::pair{process.first, std::move(client_proc)});
+			return process.first;
+		}
+
+		/**
+		 * \brief Starts the binary of each node of graph, in the order given by plan
+		 *
+		 * Relayed edges are registered with the credit_broker once all nodes have been started.
+		 * No events are dispatched before this function returns, so no credit grant is lost.
+		 *
+		 * \note Pipe edges cannot be set up yet, and there is no way to pass the config of a node
+		 *       to its client. Rather than running a partially connected pipeline, graphs that
+		 *       use any of these features are rejected before any node is started.
+		 *
+		 * \param graph The graph to start
+		 * \param plan The result of validating graph
+		 * \param activity_monitor The epoll_instance to register the clients with
+		 * \return The pid of each node
+		 * \throw std::runtime_error if graph has a pipe edge, or a node with a non-empty config
+		 */
+		std::map<std::string, pid_t, std::less<>> load(
+			pipeline_graph const& graph,
+			pipeline_plan const& plan,
+			os_services::io_multiplexer::epoll_instance& activity_monitor
+		)
+		{
+			for(auto const& edge : graph.edges)
+			{
+				if(edge.transport == edge_transport::pipe)
+				{
+					throw std::runtime_error{
+						std::format(
+							"The edge from {} to {} uses a pipe, which is not supported yet",
+							to_string(edge.from),
+							to_string(edge.to)
+						)
+					};
+				}
+			}
+
+			for(auto const& node : graph.nodes)
+			{
+				if(std::size(node.second.config) != 0)
+				{
+					throw std::runtime_error{
+						std::format("Node {} has a config, which is not supported yet", node.first)
+					};
+				}
+			}
+
+			std::map<std::string, pid_t, std::less<>> ret;
+			for(auto const& stage : plan.launch_stages)
+			{
+				for(auto const& node : stage)
+				{ ret.insert(std::pair{node, load(graph.nodes.find(node)->second.binary, activity_monitor)}); }
+			}
+
+			for(auto const& edge : graph.edges)
+			{
+				connect_relayed(
+					client_port{.client = ret.find(edge.from.node)->second, .port = edge.from.port},
+					client_port{.client = ret.find(edge.to.node)->second, .port = edge.to.port}
+				);
+			}
+
+			return ret;
+		}
+
+		/**
+		 * \brief Sends the same request to all clients, by calling request on each client_process
+		 *
+		 * Requests are queued, and sent when the control socket of each client becomes writable.
+		 * Thus, all requests queued for a client during one iteration of the event loop are sent
+		 * by a single syscall.
+		 *
+		 * \param request A member function of client_process, such as client_process::drain,
+		 *                or any other callable that returns the correlation id of the request
+		 * \return The correlation id of the request sent to each client
+		 */
+		template<class Request>
+		requires(std::is_invocable_r_v<uint64_t, Request, client_process&>)
+		std::unordered_map<pid_t, uint64_t> broadcast(Request&& request)
+		{
+			std::unordered_map<pid_t, uint64_t> ret;
+			ret.reserve(size());
+			for(auto const& item : *this)
+			{ ret.insert(std::pair{item.first, std::invoke(request, *item.second)}); }
+			return ret;
 		}
+
+		/**
+		 * \brief Returns the startup latency of all clients loaded so far
+		 */
+		startup_latency const& get_startup_latency() const noexcept
+		{ return m_startup_latency; }
+
+		/**
+		 * \brief Registers an edge from producer to consumer, where data is relayed by the host
+		 *
+		 * Credit granted by the consumer for its input port will be forwarded to the producer.
+		 */
+		void connect_relayed(client_port producer, client_port consumer)
+		{ m_credit_broker.connect(std::move(producer), std::move(consumer)); }
+
+		/**
+		 * \brief Returns the credit_broker that mediates credit grants for relayed edges
+		 */
+		credit_broker& get_credit_broker() noexcept
+		{ return m_credit_broker; }
+
+	private:
+		/**
+		 * \brief Event handler for the pidfd of a client, that knows the pid of that client
+		 */
+		struct exit_monitor
+		{
+			std::reference_wrapper<client_process_repository> repository;
+			pid_t pid;
+
+			void handle_event(
+				os_services::fd::activity_event const& event,
+				os_services::proc_mgmt::pidfd_ref fd
+			)
+			{ repository.get().handle_event(event, fd, pid); }
+		};
+
+		/**
+		 * \brief Passes the log items of a client to the log store, if any, and to the hub
+		 */
+		struct log_item_sink
+		{
+			std::reference_wrapper<log_subscription_hub> hub;
+			log_store::store* store;
+
+			void consume(char const* who, log::item&& item)
+			{
+				if(store != nullptr)
+				{ store->append(who, item); }
+				hub.get().consume(who, std::move(item));
+			}
+
+			void on_parse_error(char const* who, jopp::parser_error_code ec)
+			{
+				if(store != nullptr)
+				{ store->on_parse_error(who, ec); }
+				hub.get().on_parse_error(who, ec);
+			}
+
+			void on_invalid_log_item(char const* who, char const* errmsg)
+			{
+				if(store != nullptr)
+				{ store->on_invalid_log_item(who, errmsg); }
+				hub.get().on_invalid_log_item(who, errmsg);
+			}
+
+			void on_sequence_discontinuity(char const* who, json_log::sequence_discontinuity const& discontinuity)
+			{
+				if(store != nullptr)
+				{ store->on_sequence_discontinuity(who, discontinuity); }
+				hub.get().on_sequence_discontinuity(who, discontinuity);
+			}
+		};
+
+		/**
+		 * \brief Returns the pool to borrow log pipe buffers from, for clients running on numa
+		 */
+		os_services::memory::buffer_pool& get_log_buffer_pool(std::optional<os_services::memory::numa_node> numa)
+		{
+			if(!numa.has_value())
+			{ return os_services::memory::default_buffer_pool(); }
+
+			return m_log_buffer_pools.try_emplace(
+				numa->value(),
+				os_services::memory::buffer_pool_config{
+					.placement = os_services::memory::memory_placement{.node = *numa}
+				}
+			).first->second;
+		}
+
+		void forward_credit(client_port const& consumer, client_ctl::credit amount)
+		{
+			auto const forwarded = m_credit_broker.on_credit_granted(consumer, amount);
+			if(!forwarded.has_value())
+			{ return; }
+
+			auto const i = find(forwarded->producer.client);
+			if(i == end())
+			{ return; }
+
+			i->second->grant_credit(forwarded->producer.port, forwarded->amount);
+		}
+
+		std::reference_wrapper<log_subscription_hub> m_log_items;
+		log_store::store* m_stored_log_items{nullptr};
+		startup_latency m_startup_latency;
+		credit_broker m_credit_broker;
+		std::map<unsigned int, os_services::memory::buffer_pool> m_log_buffer_pools;
 	};
 
+	/**
+	 * \brief Accepts connections to the host server socket
+	 *
+	 * Each accepted connection is served by a log_subscriber_connection, that is registered with
+	 * the same epoll_instance as the server socket. Only peers running as allowed_uid are
+	 * accepted. Other connections are closed directly.
+	 *
+	 * Pending connections are accepted until the accept queue is empty, or the dispatch budget is
+	 * exhausted.
+	 */
 	class server_activity_handler
 	{
 	public:
-		explicit server_activity_handler(std::string_view server_name):
-			m_server_name{server_name}
+		using socket_ref = os_services::ipc::nonblocking_server_socket_ref<SOCK_STREAM, sockaddr_un>;
+
+		/**
+		 * \brief Constructs a server_activity_handler
+		 * \param server_name The name of the server
+		 * \param event_loop The epoll_instance used to serve accepted connections
+		 * \param log_items The hub that accepted connections subscribe to
+		 * \param max_queue_length The max number of log items queued for each subscriber
+		 * \param allowed_uid The user id that peers must run as
+		 */
+		explicit server_activity_handler(
+			std::string_view server_name,
+			os_services::io_multiplexer::epoll_instance& event_loop,
+			log_subscription_hub& log_items,
+			size_t max_queue_length = 1024,
+			uid_t allowed_uid = ::geteuid()
+		):
+			m_server_name{server_name},
+			m_event_loop{event_loop},
+			m_log_items{log_items},
+			m_max_queue_length{max_queue_length},
+			m_allowed_uid{allowed_uid}
 		{}
 
-		void handle_event(
-			os_services::fd::activity_event const& event,
-			os_services::ipc::server_socket_ref<SOCK_STREAM, sockaddr_un> fd
-		)
+		void handle_event(os_services::fd::activity_event const& event, socket_ref fd)
 		{
-			if(can_read(event.get_activity_status()))
+			if(!can_read(event.get_activity_status()))
+			{ return; }
+
+			while(true)
 			{
-				m_clients.emplace(m_client_id, accept(fd));
+				auto connection = accept_nonblocking(fd);
+				if(connection == nullptr)
+				{ return; }
+
+				if(auto const peer = get_peer_credentials(
+					os_services::ipc::connected_socket_ref<SOCK_STREAM, sockaddr_un>{connection.get()}
+				); peer.uid != m_allowed_uid)
+				{
+					log::write_message(
+						log::item::severity::warning,
+						"{}: Rejected connection from process {} running as user {}",
+						m_server_name,
+						peer.pid,
+						peer.uid
+					);
+				}
+				else
+				{
+					auto subscriber = std::make_shared<log_subscriber>(m_max_queue_length);
+					auto const id = m_event_loop.get().add(
+						std::move(connection),
+						os_services::fd::activity_status::read,
+						log_subscriber_connection{m_log_items.get(), subscriber}
+					);
+					subscriber->set_event_handler(m_event_loop.get(), id);
+				}
+
+				// Let other file descriptors be serviced when many clients connect at once
+				if(!event.consume_budget(0))
+				{ return; }
 			}
 		}
 
 	private:
 		std::string m_server_name;
-		std::unordered_map<uint64_t, os_services::ipc::connected_socket<SOCK_STREAM, sockaddr_un>> m_clients;
-		uint64_t m_client_id{0};
+		std::reference_wrapper<os_services::io_multiplexer::epoll_instance> m_event_loop;
+		std::reference_wrapper<log_subscription_hub> m_log_items;
+		size_t m_max_queue_length;
+		uid_t m_allowed_uid;
 	};
+
+	/**
+	 * \brief Creates a non-blocking server socket bound to the abstract unix socket address
+	 *        server_name
+	 */
+	inline auto make_host_server_socket(std::string_view server_name)
+	{
+		return os_services::ipc::make_server_socket<SOCK_STREAM, os_services::fd::io_mode::nonblocking>(
+			os_services::ipc::make_abstract_sockaddr_un(server_name),
+			SOMAXCONN
+		);
+	}
+
+	/**
+	 * \brief Binds the host server to the abstract unix socket address server_name, and registers
+	 *        it with event_loop
+	 *
+	 * \return The id of the event handler that accepts new connections
+	 */
+	inline os_services::fd::event_handler_id start_host_server(
+		std::string_view server_name,
+		os_services::io_multiplexer::epoll_instance& event_loop,
+		log_subscription_hub& log_items,
+		size_t max_queue_length = 1024
+	)
+	{
+		return event_loop.add(
+			make_host_server_socket(server_name),
+			os_services::fd::activity_status::read,
+			server_activity_handler{server_name, event_loop, log_items, max_queue_length}
+		);
+	}
 }
\ No newline at end of file
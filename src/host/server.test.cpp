@@ -1,5 +1,131 @@
-//@	{"target":{"name":"./server.test"}}
+//@	{
+//@		"target":{
+//@			"name":"./server.test",
+//@			"dependencies":[{"ref":"src/client/test/client", "origin":"generated"}]
+//@		}
+//@	}
 
 #include "./server.hpp"
 
-#include <testfwk/testfwk.hpp>
\ No newline at end of file
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	std::string make_server_name(std::string_view test)
+	{ return std::format("pipe_host_server_test_{}_{}", test, ::getpid()); }
+
+	std::filesystem::path testclient_exe()
+	{ return std::filesystem::path{MAIKE_BUILDINFO_TARGETDIR}/"src/client/test/client"; }
+}
+
+TESTCASE(Pipe_host_server_accept_many_connections)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	Pipe::host::log_subscription_hub hub;
+	auto const server_name = make_server_name("accept");
+	std::ignore = Pipe::host::start_host_server(server_name, event_loop, hub);
+
+	// More connections than the dispatch budget allows to be accepted at once
+	constexpr size_t connection_count = 100;
+	std::vector<Pipe::os_services::ipc::connected_socket<SOCK_STREAM, sockaddr_un>> connections;
+	std::string_view const filter{R"({"min_severity": "error"})"};
+	for(size_t k = 0; k != connection_count; ++k)
+	{
+		connections.push_back(
+			Pipe::os_services::ipc::make_connection<SOCK_STREAM>(
+				Pipe::os_services::ipc::make_abstract_sockaddr_un(server_name)
+			)
+		);
+		Pipe::os_services::io::write(connections.back().get(), std::as_bytes(std::span{filter}));
+	}
+
+	while(hub.subscriber_count() != connection_count)
+	{ event_loop.wait_for_and_distpatch_events(); }
+
+	connections.clear();
+	while(hub.subscriber_count() != 0)
+	{ event_loop.wait_for_and_distpatch_events(); }
+}
+
+TESTCASE(Pipe_host_server_reject_other_user)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	Pipe::host::log_subscription_hub hub;
+	auto const server_name = make_server_name("reject");
+	std::ignore = event_loop.add(
+		Pipe::host::make_host_server_socket(server_name),
+		Pipe::os_services::fd::activity_status::read,
+		Pipe::host::server_activity_handler{server_name, event_loop, hub, 16, ::geteuid() + 1}
+	);
+
+	auto const connection = Pipe::os_services::ipc::make_connection<SOCK_STREAM>(
+		Pipe::os_services::ipc::make_abstract_sockaddr_un(server_name)
+	);
+	event_loop.wait_for_and_distpatch_events();
+
+	// The server closes the connection without reading anything
+	std::array<std::byte, 16> buffer{};
+	EXPECT_EQ(Pipe::os_services::io::read(connection.get(), buffer).bytes_transferred(), 0);
+	EXPECT_EQ(hub.subscriber_count(), 0);
+}
+
+TESTCASE(Pipe_host_client_process_repository_reap_exited_client)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	Pipe::host::log_subscription_hub hub;
+	Pipe::host::client_process_repository clients{hub};
+
+	auto const pid = clients.load(testclient_exe(), event_loop);
+	REQUIRE_EQ(clients.contains(pid), true);
+	EXPECT_NE(clients.find(pid)->second->log_suppression_metrics(), nullptr);
+
+	auto const requests = clients.broadcast(&Pipe::host::client_process::shutdown);
+	EXPECT_EQ(requests.size(), 1);
+
+	// The client exits after acknowledging the request, and is then removed
+	while(clients.size() != 0)
+	{ event_loop.wait_for_and_distpatch_events(); }
+
+	EXPECT_EQ(clients.contains(pid), false);
+}
+
+TESTCASE(Pipe_host_client_process_repository_load_graph_with_pipe_edge)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+	Pipe::host::log_subscription_hub hub;
+	Pipe::host::client_process_repository clients{hub};
+
+	Pipe::host::pipeline_graph const graph{
+		.nodes = {
+			{"source", Pipe::host::graph_node{.binary = testclient_exe(), .config = {}}},
+			{"sink", Pipe::host::graph_node{.binary = testclient_exe(), .config = {}}}
+		},
+		.edges = {
+			Pipe::host::graph_edge{
+				.from = Pipe::host::port_endpoint{.node = "source", .port = "stdout"},
+				.to = Pipe::host::port_endpoint{.node = "sink", .port = "stdin"},
+				.transport = Pipe::host::edge_transport::pipe
+			}
+		}
+	};
+
+	try
+	{
+		std::ignore = clients.load(
+			graph,
+			Pipe::host::pipeline_plan{.launch_stages = {{"sink"}, {"source"}}, .edge_content_types = {}},
+			event_loop
+		);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{
+		EXPECT_EQ(
+			err.what(),
+			std::string_view{"The edge from source.stdout to sink.stdin uses a pipe, which is not supported yet"}
+		);
+	}
+
+	// Nothing was started
+	EXPECT_EQ(clients.size(), 0);
+}
@@ -0,0 +1,107 @@
+#ifndef PIPE_HOST_STARTUP_LATENCY_HPP
+#define PIPE_HOST_STARTUP_LATENCY_HPP
+
+#include "src/utils/histogram.hpp"
+#include "src/os_services/fd/activity_monitor.hpp"
+
+#include <chrono>
+#include <memory>
+#include <optional>
+
+namespace Pipe::host
+{
+	/**
+	 * \brief The clock used to timestamp startup events
+	 */
+	using startup_clock = std::chrono::steady_clock;
+
+	/**
+	 * \brief Records when a client passed each step of its startup
+	 */
+	struct startup_timeline
+	{
+		/**
+		 * \brief When the host forked the client process
+		 */
+		std::optional<startup_clock::time_point> fork{};
+
+		/**
+		 * \brief When the host knew that execve had succeeded
+		 */
+		std::optional<startup_clock::time_point> exec{};
+
+		/**
+		 * \brief When the first byte appeared on the stderr of the client
+		 */
+		std::optional<startup_clock::time_point> first_output{};
+
+		/**
+		 * \brief When the client reported that it was ready
+		 */
+		std::optional<startup_clock::time_point> ready{};
+	};
+
+	/**
+	 * \brief Histograms of the time spent in each step of client startup, across all clients
+	 * \note All values are recorded in nanoseconds
+	 */
+	struct startup_latency
+	{
+		utils::log_histogram fork_to_exec;
+		utils::log_histogram exec_to_first_output;
+		utils::log_histogram exec_to_ready;
+		utils::log_histogram fork_to_ready;
+	};
+
+	/**
+	 * \brief Records the time between from and to in hist, if both are known
+	 */
+	inline void record(
+		utils::log_histogram& hist,
+		std::optional<startup_clock::time_point> from,
+		std::optional<startup_clock::time_point> to
+	)
+	{
+		if(!from.has_value() || !to.has_value())
+		{ return; }
+
+		auto const duration = std::chrono::duration_cast<std::chrono::nanoseconds>(*to - *from);
+		hist.record(static_cast<uint64_t>(std::max(duration.count(), int64_t{0})));
+	}
+
+	/**
+	 * \brief Wraps an event handler, and reports the first activity on its file descriptor
+	 *
+	 * This is used on the stderr pipe of a client, to timestamp its first output, without
+	 * changing the reader that processes that output.
+	 *
+	 * \tparam EventHandler The wrapped event handler
+	 * \tparam Listener A type with an on_first_output(startup_clock::time_point) member function
+	 */
+	template<class EventHandler, class Listener>
+	class first_output_probe
+	{
+	public:
+		explicit first_output_probe(EventHandler&& handler, std::shared_ptr<Listener> listener):
+			m_handler{std::move(handler)},
+			m_listener{std::move(listener)}
+		{}
+
+		template<class FileDescriptorRef>
+		void handle_event(os_services::fd::activity_event const& event, FileDescriptorRef fd)
+		{
+			if(m_listener != nullptr)
+			{
+				m_listener->on_first_output(startup_clock::now());
+				m_listener.reset();
+			}
+			m_handler.handle_event(event, fd);
+		}
+
+	private:
+		EventHandler m_handler;
+		std::shared_ptr<Listener> m_listener;
+	};
+}
+
+#endif
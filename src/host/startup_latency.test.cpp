@@ -0,0 +1,66 @@
+//@	{"target":{"name": "startup_latency.test"}}
+
+#include "./startup_latency.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <vector>
+
+namespace
+{
+	struct event_counter
+	{
+		size_t event_count{0};
+
+		void handle_event(Pipe::os_services::fd::activity_event const&, int)
+		{ ++event_count; }
+	};
+
+	struct my_activity_event:public Pipe::os_services::fd::activity_event
+	{
+		Pipe::os_services::fd::activity_status get_activity_status() const noexcept override
+		{ return Pipe::os_services::fd::activity_status::read; }
+
+		void update_listening_status(Pipe::os_services::fd::activity_status) const noexcept override
+		{}
+
+		void stop_listening() const noexcept override
+		{}
+	};
+
+	struct first_output_listener
+	{
+		std::vector<Pipe::host::startup_clock::time_point> calls;
+
+		void on_first_output(Pipe::host::startup_clock::time_point when)
+		{ calls.push_back(when); }
+	};
+}
+
+TESTCASE(Pipe_host_startup_latency_record)
+{
+	Pipe::utils::log_histogram hist;
+	auto const t0 = Pipe::host::startup_clock::now();
+
+	Pipe::host::record(hist, t0, std::nullopt);
+	EXPECT_EQ(hist.count(), 0);
+
+	Pipe::host::record(hist, t0, t0 + std::chrono::nanoseconds{5});
+	EXPECT_EQ(hist.count(), 1);
+	EXPECT_EQ(hist.max(), 5);
+
+	// Clamp negative durations rather than wrapping around
+	Pipe::host::record(hist, t0 + std::chrono::nanoseconds{5}, t0);
+	EXPECT_EQ(hist.count(), 2);
+	EXPECT_EQ(hist.min(), 0);
+}
+
+TESTCASE(Pipe_host_startup_latency_first_output_probe)
+{
+	auto const listener = std::make_shared<first_output_listener>();
+	Pipe::host::first_output_probe probe{event_counter{}, listener};
+
+	my_activity_event const event;
+	probe.handle_event(event, 0);
+	probe.handle_event(event, 0);
+	EXPECT_EQ(std::size(listener->calls), 1);
+}
@@ -4,14 +4,71 @@
 #include "src/log/log.hpp"
 
 #include <jopp/types.hpp>
+#include <algorithm>
 #include <expected>
+#include <format>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace Pipe::json_log
 {
 	/**
-	 * \brief Converts item into a jopp::object
+	 * \brief Assigns small integer ids to field keys
+	 *
+	 * A writer uses one field_key_encoder per connection, so the name of a key is normally only
+	 * sent the first time it is used. After that, only its id is sent. To let a reader recover
+	 * after it has lost a definition, the name is sent again every redefinition_interval:th
+	 * time the key is used.
 	 */
-	inline jopp::object to_jopp_object(log::item const& item)
+	class field_key_encoder
+	{
+	public:
+		/**
+		 * \brief Constructs a field_key_encoder
+		 * \param redefinition_interval The number of uses of a key between two definitions of it
+		 */
+		explicit field_key_encoder(uint32_t redefinition_interval = 256):
+			m_redefinition_interval{std::max(redefinition_interval, uint32_t{1})}
+		{}
+
+		/**
+		 * \brief Returns the id of key, and whether or not the name of key should be sent together
+		 *        with the id
+		 */
+		std::pair<uint32_t, bool> get_id(std::string const& key)
+		{
+			auto const res = m_ids.try_emplace(key, key_state{.id = static_cast<uint32_t>(std::size(m_ids)), .uses = 0});
+			auto& state = res.first->second;
+			auto const define = state.uses == 0;
+			state.uses = (state.uses + 1) % m_redefinition_interval;
+			return std::pair{state.id, define};
+		}
+
+	private:
+		struct key_state
+		{
+			uint32_t id;
+			uint32_t uses;
+		};
+
+		uint32_t m_redefinition_interval;
+		std::unordered_map<std::string, key_state> m_ids;
+	};
+
+	/**
+	 * \brief Maps field key ids back to key names, on the receiving side of a connection
+	 */
+	using field_key_table = std::unordered_map<uint32_t, std::string>;
+
+	/**
+	 * \brief Converts the timestamp, the message, and the severity of item into a jopp::object
+	 *
+	 * This is the part of the conversion that does not depend on how fields are encoded.
+	 */
+	inline jopp::object to_jopp_object_without_fields(log::item const& item)
 	{
 		jopp::object ret;
 		ret.insert(
@@ -23,12 +80,64 @@ namespace Pipe::json_log
 		return ret;
 	}
 
+	/**
+	 * \brief Converts item into a jopp::object
+	 *
+	 * Fields are stored by key name, in the object `fields`. The order of fields is not
+	 * preserved.
+	 */
+	inline jopp::object to_jopp_object(log::item const& item)
+	{
+		auto ret = to_jopp_object_without_fields(item);
+		if(!item.fields.empty())
+		{
+			jopp::object fields;
+			for(auto const& field : item.fields)
+			{ fields.insert(jopp::string{field.key}, field.value); }
+			ret.insert("fields", std::move(fields));
+		}
+		return ret;
+	}
+
+	/**
+	 * \brief Converts item into a jopp::object, using keys to intern field keys
+	 *
+	 * Fields are stored in the array `fields`. Each entry is an array holding the id of the key,
+	 * and the value. If keys decides that the key should be defined, the name of the key follows.
+	 */
+	inline jopp::object to_jopp_object(log::item const& item, field_key_encoder& keys)
+	{
+		auto ret = to_jopp_object_without_fields(item);
+		if(!item.fields.empty())
+		{
+			jopp::array fields;
+			for(auto const& field : item.fields)
+			{
+				auto const id = keys.get_id(field.key);
+				jopp::array entry;
+				entry.push_back(static_cast<jopp::number>(id.first));
+				entry.push_back(field.value);
+				if(id.second)
+				{ entry.push_back(field.key); }
+				fields.push_back(std::move(entry));
+			}
+			ret.insert("fields", std::move(fields));
+		}
+		return ret;
+	}
+
 	/**
 	 * \brief Converts a jopp::object into an item
+	 *
+	 * Fields may either be stored by key name, or by key id, as written by the interning version
+	 * of to_jopp_object. New key ids are added to keys. A field that refers to a key id that has
+	 * not been defined, because the definition was lost, is given the key `#<id>`. The key is
+	 * resolved once the writer defines it again.
+	 *
 	 * \note If conversion fails, a message wrapped in an std::unexpected is returned
 	 * \note If the severity conveyed by obj is unknown, it is mapped to log::item::severity::info
 	 */
-	inline std::expected<log::item, char const*> make_log_item(jopp::object const& obj)
+	inline std::expected<log::item, char const*> make_log_item(jopp::object const& obj, field_key_table& keys)
 	{
 		auto const when = obj.try_get_field_as<double>("when");
 		if(when == nullptr)
@@ -42,13 +151,84 @@ namespace Pipe::json_log
 		if(message == nullptr)
 		{ return std::unexpected{"Failed to extract mandatory field `severity` from received log item"}; }
 
+		std::vector<log::field> fields;
+		if(auto const named_fields = obj.try_get_field_as<jopp::object>("fields"); named_fields != nullptr)
+		{
+			for(auto const& item : *named_fields)
+			{
+				auto const value = item.second.get_if<jopp::string>();
+				if(value == nullptr)
+				{ return std::unexpected{"The value of a field must be a string"}; }
+				fields.push_back(log::field{.key = item.first, .value = *value});
+			}
+		}
+		else
+		if(auto const interned_fields = obj.try_get_field_as<jopp::array>("fields"); interned_fields != nullptr)
+		{
+			for(auto const& item : *interned_fields)
+			{
+				auto const entry = item.get_if<jopp::array>();
+				if(entry == nullptr || (std::size(*entry) != 2 && std::size(*entry) != 3))
+				{ return std::unexpected{"A field must be an array of a key id, a value, and optionally a key"}; }
+
+				auto const id = (*entry)[0].get_if<jopp::number>();
+				if(id == nullptr || !(*id >= 0.0 && *id <= static_cast<jopp::number>(std::numeric_limits<uint32_t>::max()))
+					|| static_cast<jopp::number>(static_cast<uint32_t>(*id)) != *id)
+				{ return std::unexpected{"A field key id must be a non-negative integer"}; }
+
+				auto const value = (*entry)[1].get_if<jopp::string>();
+				if(value == nullptr)
+				{ return std::unexpected{"The value of a field must be a string"}; }
+
+				if(std::size(*entry) == 3)
+				{
+					auto const key = (*entry)[2].get_if<jopp::string>();
+					if(key == nullptr)
+					{ return std::unexpected{"A field key must be a string"}; }
+					keys.insert_or_assign(static_cast<uint32_t>(*id), *key);
+				}
+
+				auto const i = keys.find(static_cast<uint32_t>(*id));
+				fields.push_back(
+					log::field{
+						.key = i != std::end(keys)? i->second : std::format("#{}", static_cast<uint32_t>(*id)),
+						.value = *value
+					}
+				);
+			}
+		}
+
 		return log::item{
 			.when = log::clock::time_point{}
 				+ duration_cast<log::clock::duration>(std::chrono::duration<double>{*when}),
 			.severity = log::make_severity_with_fallback(*severity, log::item::severity::info),
-			.message = std::move(*message)
+			.message = std::move(*message),
+			.fields = std::move(fields)
 		};
 	}
+
+	/**
+	 * \brief Extracts the sequence number assigned by the writer of obj
+	 * \return The sequence number, or an empty optional if obj does not carry a valid sequence
+	 *         number
+	 */
+	inline std::optional<uint64_t> get_sequence_number(jopp::object const& obj)
+	{
+		auto const seq = obj.try_get_field_as<jopp::number>("seq");
+		if(seq == nullptr || !(*seq >= 0.0 && *seq < 0x1p64)
+			|| static_cast<jopp::number>(static_cast<uint64_t>(*seq)) != *seq)
+		{ return std::nullopt; }
+		return static_cast<uint64_t>(*seq);
+	}
+
+	/**
+	 * \brief Converts a jopp::object into an item, without any previously defined field keys
+	 */
+	inline std::expected<log::item, char const*> make_log_item(jopp::object const& obj)
+	{
+		field_key_table keys;
+		return make_log_item(obj, keys);
+	}
 }
 
 #endif
\ No newline at end of file
@@ -87,4 +87,88 @@ TESTCASE(Pipe_json_log_item_converter_make_log_item_missing_message)
 		std::string_view{item.error()},
 		"Failed to extract mandatory field `severity` from received log item"
 	);
-}
\ No newline at end of file
+}
+
+TESTCASE(Pipe_json_log_item_converter_named_fields)
+{
+	Pipe::log::item const src{
+		.when = Pipe::log::clock::time_point{} + std::chrono::seconds{1},
+		.severity = Pipe::log::item::severity::info,
+		.message = "This is a test",
+		.fields = {Pipe::log::field{.key = "request_id", .value = "1234"}}
+	};
+
+	auto const obj = Pipe::json_log::to_jopp_object(src);
+	EXPECT_EQ(obj.get_field_as<jopp::object>("fields").get_field_as<std::string>("request_id"), "1234");
+
+	auto const item = Pipe::json_log::make_log_item(obj);
+	REQUIRE_EQ(item.has_value(), true);
+	EXPECT_EQ(*item, src);
+}
+
+TESTCASE(Pipe_json_log_item_converter_interned_fields)
+{
+	Pipe::json_log::field_key_encoder encoder;
+	Pipe::log::item const first{
+		.when = Pipe::log::clock::time_point{} + std::chrono::seconds{1},
+		.severity = Pipe::log::item::severity::info,
+		.message = "Request started",
+		.fields = {
+			Pipe::log::field{.key = "request_id", .value = "1234"},
+			Pipe::log::field{.key = "user", .value = "alice"}
+		}
+	};
+	Pipe::log::item const second{
+		.when = Pipe::log::clock::time_point{} + std::chrono::seconds{2},
+		.severity = Pipe::log::item::severity::info,
+		.message = "Request completed",
+		.fields = {
+			Pipe::log::field{.key = "request_id", .value = "1234"},
+			Pipe::log::field{.key = "status", .value = "200"}
+		}
+	};
+
+	auto const first_obj = Pipe::json_log::to_jopp_object(first, encoder);
+	auto const second_obj = Pipe::json_log::to_jopp_object(second, encoder);
+
+	// The name of a key is only sent the first time it is used
+	auto const& first_fields = first_obj.get_field_as<jopp::array>("fields");
+	REQUIRE_EQ(std::size(first_fields), 2);
+	EXPECT_EQ(std::size(first_fields[0].get<jopp::array>()), 3);
+	EXPECT_EQ(std::size(first_fields[1].get<jopp::array>()), 3);
+
+	auto const& second_fields = second_obj.get_field_as<jopp::array>("fields");
+	REQUIRE_EQ(std::size(second_fields), 2);
+	EXPECT_EQ(std::size(second_fields[0].get<jopp::array>()), 2);
+	EXPECT_EQ(std::size(second_fields[1].get<jopp::array>()), 3);
+
+	Pipe::json_log::field_key_table keys;
+	auto const first_item = Pipe::json_log::make_log_item(first_obj, keys);
+	REQUIRE_EQ(first_item.has_value(), true);
+	EXPECT_EQ(*first_item, first);
+
+	auto const second_item = Pipe::json_log::make_log_item(second_obj, keys);
+	REQUIRE_EQ(second_item.has_value(), true);
+	EXPECT_EQ(*second_item, second);
+	EXPECT_EQ(std::size(keys), 3);
+
+	// Without the first item, the key of the first field is unknown, but the value is kept
+	auto const item = Pipe::json_log::make_log_item(second_obj);
+	REQUIRE_EQ(item.has_value(), true);
+	REQUIRE_EQ(std::size(item->fields), 2);
+	EXPECT_EQ(item->fields[0].key, "#0");
+	EXPECT_EQ(item->fields[0].value, "1234");
+	EXPECT_EQ(item->fields[1].key, "status");
+}
+
+TESTCASE(Pipe_json_log_item_converter_redefine_field_keys)
+{
+	Pipe::json_log::field_key_encoder encoder{3};
+	std::vector<bool> defined;
+	for(size_t k = 0; k != 7; ++k)
+	{ defined.push_back(encoder.get_id("request_id").second); }
+
+	EXPECT_EQ(defined, (std::vector<bool>{true, false, false, true, false, false, true}));
+	EXPECT_EQ(encoder.get_id("request_id").first, 0);
+	EXPECT_EQ(encoder.get_id("status"), (std::pair{uint32_t{1}, true}));
+}
@@ -0,0 +1,80 @@
+//@	{"target":{"name":"json_log.bench"}}
+
+#include "./reader.hpp"
+#include "./writer.hpp"
+#include "src/bench/bench.hpp"
+#include "src/log/log.hpp"
+#include "src/os_services/io_multiplexer/epoll_instance.hpp"
+#include "src/os_services/ipc/pipe.hpp"
+
+#include <array>
+#include <string>
+#include <thread>
+
+namespace
+{
+	struct counting_receiver
+	{
+		std::reference_wrapper<uint64_t> count;
+		std::reference_wrapper<uint64_t> bytes;
+
+		void consume(char const*, Pipe::log::item&& item)
+		{
+			++count.get();
+			bytes.get() += std::size(item.message);
+		}
+
+		void on_parse_error(char const*, jopp::parser_error_code)
+		{ abort(); }
+
+		void on_invalid_log_item(char const*, char const*)
+		{ abort(); }
+
+		void on_sequence_discontinuity(char const*, Pipe::json_log::sequence_discontinuity const&)
+		{ abort(); }
+	};
+}
+
+BENCHMARK(Pipe_json_log_round_trip, context)
+{
+	constexpr std::array<size_t, 4> message_sizes{16, 128, 1024, 8192};
+	for(auto const message_size : message_sizes)
+	{
+		context.measure(
+			"json_log_round_trip",
+			{{"message_size", static_cast<int64_t>(message_size)}},
+			[message_size](uint64_t iterations) {
+				Pipe::os_services::ipc::pipe<
+					Pipe::os_services::fd::io_mode::nonblocking,
+					Pipe::os_services::fd::io_mode::blocking
+				> logpipe;
+
+				// The writer runs in its own thread, like a client writing to its stderr
+				std::jthread producer{[write_end = logpipe.take_write_end(), message_size, iterations]() {
+					Pipe::json_log::writer writer{65536, write_end.get()};
+					Pipe::log::item const item{
+						.when = Pipe::log::clock::now(),
+						.severity = Pipe::log::item::severity::info,
+						.message = std::string(message_size, 'x')
+					};
+					for(uint64_t k = 0; k != iterations; ++k)
+					{ writer.write(item); }
+				}};
+
+				uint64_t count = 0;
+				uint64_t bytes = 0;
+				Pipe::os_services::io_multiplexer::epoll_instance event_loop;
+				std::ignore = event_loop.add(
+					logpipe.take_read_end(),
+					Pipe::os_services::fd::activity_status::read,
+					Pipe::json_log::reader{"bench", counting_receiver{count, bytes}}
+				);
+
+				while(count != iterations)
+				{ event_loop.wait_for_and_distpatch_events(); }
+
+				return Pipe::bench::work_done{.items = count, .bytes = bytes};
+			}
+		);
+	}
+}
@@ -0,0 +1,312 @@
+#ifndef PIPE_JSON_LOG_RATE_LIMITER_HPP
+#define PIPE_JSON_LOG_RATE_LIMITER_HPP
+
+#include "./reader.hpp"
+#include "src/log/log.hpp"
+#include "src/utils/utils.hpp"
+
+#include <jopp/parser.hpp>
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <string>
+#include <vector>
+
+namespace Pipe::json_log
+{
+	/**
+	 * \brief A token bucket, used to limit the rate of incoming log items
+	 *
+	 * The bucket holds up to `capacity` tokens, and is refilled with `fill_rate` tokens per second.
+	 * Each accepted item costs one token.
+	 */
+	template<class Clock = std::chrono::steady_clock>
+	class token_bucket
+	{
+	public:
+		/**
+		 * \brief Constructs a token_bucket
+		 * \param fill_rate The number of tokens to add per second
+		 * \param capacity The max number of tokens that can be stored in the bucket. This is also
+		 *                 the largest burst of items that will be accepted. Since each item costs
+		 *                 one token, a capacity less than one is treated as one.
+		 * \param now The current time
+		 */
+		explicit token_bucket(double fill_rate, double capacity, typename Clock::time_point now):
+			m_fill_rate{fill_rate},
+			m_capacity{std::max(capacity, 1.0)},
+			m_tokens{m_capacity},
+			m_last_refill{now}
+		{}
+
+		/**
+		 * \brief Tries to take one token from the bucket
+		 * \return true if a token was available, otherwise false
+		 */
+		bool try_take(typename Clock::time_point now) noexcept
+		{
+			refill(now);
+			if(m_tokens < 1.0)
+			{ return false; }
+
+			m_tokens -= 1.0;
+			return true;
+		}
+
+		/**
+		 * \brief Returns the number of tokens currently in the bucket
+		 */
+		double tokens() const noexcept
+		{ return m_tokens; }
+
+	private:
+		void refill(typename Clock::time_point now) noexcept
+		{
+			if(now <= m_last_refill)
+			{ return; }
+
+			auto const dt = std::chrono::duration<double>(now - m_last_refill).count();
+			m_tokens = std::min(m_capacity, m_tokens + dt*m_fill_rate);
+			m_last_refill = now;
+		}
+
+		double m_fill_rate;
+		double m_capacity;
+		double m_tokens;
+		typename Clock::time_point m_last_refill;
+	};
+
+	/**
+	 * \brief Per-client configuration of a rate_limited_item_receiver
+	 */
+	struct rate_limiter_config
+	{
+		/**
+		 * \brief The sustained number of items per second that should be accepted. If set to zero,
+		 *        rate limiting is disabled.
+		 */
+		double items_per_second{0.0};
+
+		/**
+		 * \brief The max number of items that can be accepted in a burst. At least one item is
+		 *        always accepted, so the default allows items to pass at items_per_second.
+		 */
+		double burst_size{0.0};
+
+		/**
+		 * \brief Whether or not consecutive identical messages should be collapsed into a single
+		 *        "last message repeated N times" item
+		 */
+		bool collapse_repeated_items{true};
+	};
+
+	/**
+	 * \brief Counters for items suppressed by a rate_limited_item_receiver
+	 */
+	struct suppression_metrics
+	{
+		/**
+		 * \brief The number of items that were forwarded unmodified
+		 */
+		size_t items_forwarded{0};
+
+		/**
+		 * \brief The number of items dropped because the token bucket was empty
+		 */
+		size_t items_rate_limited{0};
+
+		/**
+		 * \brief The number of items that were collapsed into a "last message repeated" item
+		 */
+		size_t items_collapsed{0};
+
+		bool operator==(suppression_metrics const&) const = default;
+		bool operator!=(suppression_metrics const&) const = default;
+	};
+
+	/**
+	 * \brief An item_receiver that sits between a reader and another item_receiver, and suppresses
+	 *        log storms
+	 *
+	 * Items are first compared against the previously forwarded item. If both have the same
+	 * severity, message, and fields, the new item is not forwarded. Instead, a single "Last
+	 * message repeated N times" item, carrying the same fields, is forwarded as soon as a different item arrives, when the stream
+	 * ends, or when flush is called. Items that are not collapsed are checked against a token
+	 * bucket, so only items that would actually be forwarded are charged. Items arriving when the
+	 * bucket is empty are dropped, at the cost of a counter increment.
+	 *
+	 * \note An instance should be used per client, so one misbehaving client cannot consume the
+	 *       budget of another one
+	 */
+	template<item_receiver ItemReceiver, class Clock = std::chrono::steady_clock>
+	class rate_limited_item_receiver
+	{
+	public:
+		/**
+		 * \brief Constructs a rate_limited_item_receiver
+		 * \param downstream The item_receiver that should receive items that pass through
+		 * \param cfg The configuration to use
+		 * \param clock The clock used to refill the token bucket
+		 */
+		explicit rate_limited_item_receiver(
+			ItemReceiver downstream,
+			rate_limiter_config const& cfg,
+			Clock clock = Clock{}
+		):
+			m_downstream{std::move(downstream)},
+			m_clock{std::move(clock)},
+			m_bucket{cfg.items_per_second, cfg.burst_size, m_clock.now()},
+			m_rate_limit_enabled{cfg.items_per_second > 0.0},
+			m_collapse_repeated_items{cfg.collapse_repeated_items}
+		{}
+
+		void consume(char const* who, log::item&& item)
+		{
+			if(m_last_item.matches(item))
+			{
+				++m_metrics.items_collapsed;
+				++m_repeat_count;
+				m_last_item.when = item.when;
+				return;
+			}
+
+			// A different item ends any run of repeated items, even if it is dropped
+			flush(who);
+			m_last_item.valid = false;
+
+			if(m_rate_limit_enabled && !m_bucket.try_take(m_clock.now()))
+			{
+				++m_metrics.items_rate_limited;
+				++m_pending_rate_limited;
+				m_last_rate_limited = item.when;
+				return;
+			}
+
+			report_rate_limited(who);
+			++m_metrics.items_forwarded;
+			if(m_collapse_repeated_items)
+			{ m_last_item.assign(item); }
+			utils::unwrap(m_downstream).consume(who, std::move(item));
+		}
+
+		void on_parse_error(char const* who, jopp::parser_error_code ec)
+		{
+			flush(who);
+			utils::unwrap(m_downstream).on_parse_error(who, ec);
+		}
+
+		void on_invalid_log_item(char const* who, char const* errmsg)
+		{
+			flush(who);
+			utils::unwrap(m_downstream).on_invalid_log_item(who, errmsg);
+		}
+
+		void on_sequence_discontinuity(char const* who, sequence_discontinuity const& discontinuity)
+		{
+			flush(who);
+			if constexpr(requires(){ utils::unwrap(m_downstream).on_sequence_discontinuity(who, discontinuity); })
+			{ utils::unwrap(m_downstream).on_sequence_discontinuity(who, discontinuity); }
+		}
+
+		/**
+		 * \brief Forwards any pending summary items, since no more items will arrive
+		 */
+		void on_end_of_stream(char const* who)
+		{
+			flush(who);
+			m_last_item.valid = false;
+			report_rate_limited(who);
+			if constexpr(requires(){ utils::unwrap(m_downstream).on_end_of_stream(who); })
+			{ utils::unwrap(m_downstream).on_end_of_stream(who); }
+		}
+
+		/**
+		 * \brief Forwards any pending "last message repeated" item
+		 */
+		void flush(char const* who)
+		{
+			if(m_repeat_count == 0)
+			{ return; }
+
+			utils::unwrap(m_downstream).consume(
+				who,
+				log::item{
+					.when = m_last_item.when,
+					.severity = m_last_item.severity,
+					.message = std::format("Last message repeated {} times", m_repeat_count),
+					.fields = m_last_item.fields
+				}
+			);
+			m_repeat_count = 0;
+		}
+
+		/**
+		 * \brief Returns the current suppression_metrics
+		 */
+		suppression_metrics const& metrics() const noexcept
+		{ return m_metrics; }
+
+	private:
+		void report_rate_limited(char const* who)
+		{
+			if(m_pending_rate_limited == 0)
+			{ return; }
+
+			utils::unwrap(m_downstream).consume(
+				who,
+				log::item{
+					.when = m_last_rate_limited,
+					.severity = log::item::severity::warning,
+					.message = std::format("{} log items were dropped due to rate limiting", m_pending_rate_limited)
+				}
+			);
+			m_pending_rate_limited = 0;
+		}
+
+		/**
+		 * \brief The parts of the last forwarded item needed to detect and summarize repeats
+		 *
+		 * Items only repeat if their fields are equal too, so no field value is lost by
+		 * collapsing them. The buffers are reused between items, so remembering an item does not
+		 * allocate unless it is larger than any previous one.
+		 */
+		struct repeated_item
+		{
+			bool valid{false};
+			log::clock::time_point when{};
+			enum log::item::severity severity{};
+			std::string message;
+			std::vector<log::field> fields;
+
+			bool matches(log::item const& item) const noexcept
+			{
+				return valid
+					&& severity == item.severity
+					&& message == item.message
+					&& fields == item.fields;
+			}
+
+			void assign(log::item const& item)
+			{
+				valid = true;
+				when = item.when;
+				severity = item.severity;
+				message.assign(item.message);
+				fields.assign(std::begin(item.fields), std::end(item.fields));
+			}
+		};
+
+		ItemReceiver m_downstream;
+		Clock m_clock;
+		token_bucket<Clock> m_bucket;
+		bool m_rate_limit_enabled;
+		bool m_collapse_repeated_items;
+		repeated_item m_last_item;
+		size_t m_repeat_count{0};
+		size_t m_pending_rate_limited{0};
+		log::clock::time_point m_last_rate_limited{};
+		suppression_metrics m_metrics;
+	};
+}
+
+#endif
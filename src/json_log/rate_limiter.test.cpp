@@ -0,0 +1,290 @@
+//@	{"target":{"name": "rate_limiter.test"}}
+
+#include "./rate_limiter.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	struct my_clock
+	{
+		using time_point = std::chrono::steady_clock::time_point;
+		time_point* current_time;
+
+		time_point now() const
+		{ return *current_time; }
+	};
+
+	struct my_receiver
+	{
+		std::vector<Pipe::log::item> items;
+		size_t parse_error_count{0};
+
+		void consume(char const*, Pipe::log::item&& item)
+		{ items.push_back(std::move(item)); }
+
+		void on_parse_error(char const*, jopp::parser_error_code)
+		{ ++parse_error_count; }
+
+		void on_invalid_log_item(char const*, char const*)
+		{}
+	};
+}
+
+TESTCASE(Pipe_json_log_token_bucket_take_and_refill)
+{
+	std::chrono::steady_clock::time_point now{};
+	Pipe::json_log::token_bucket<my_clock> bucket{2.0, 3.0, now};
+
+	EXPECT_EQ(bucket.try_take(now), true);
+	EXPECT_EQ(bucket.try_take(now), true);
+	EXPECT_EQ(bucket.try_take(now), true);
+	EXPECT_EQ(bucket.try_take(now), false);
+
+	now += std::chrono::milliseconds{500};
+	EXPECT_EQ(bucket.try_take(now), true);
+	EXPECT_EQ(bucket.try_take(now), false);
+
+	now += std::chrono::seconds{10};
+	EXPECT_EQ(bucket.tokens(), 0.0);
+	EXPECT_EQ(bucket.try_take(now), true);
+	EXPECT_EQ(bucket.tokens(), 2.0);
+}
+
+TESTCASE(Pipe_json_log_rate_limited_item_receiver_default_burst_size)
+{
+	std::chrono::steady_clock::time_point now{};
+	my_receiver receiver;
+	Pipe::json_log::rate_limited_item_receiver limiter{
+		std::ref(receiver),
+		Pipe::json_log::rate_limiter_config{.items_per_second = 1.0},
+		my_clock{&now}
+	};
+
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Item 0"});
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Item 1"});
+	now += std::chrono::seconds{1};
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Item 2"});
+
+	REQUIRE_EQ(std::size(receiver.items), 3);
+	EXPECT_EQ(receiver.items[0].message, "Item 0");
+	EXPECT_EQ(receiver.items[1].message, "1 log items were dropped due to rate limiting");
+	EXPECT_EQ(receiver.items[2].message, "Item 2");
+}
+
+TESTCASE(Pipe_json_log_rate_limited_item_receiver_collapse_repeated)
+{
+	std::chrono::steady_clock::time_point now{};
+	my_receiver receiver;
+	Pipe::json_log::rate_limited_item_receiver limiter{
+		std::ref(receiver),
+		Pipe::json_log::rate_limiter_config{},
+		my_clock{&now}
+	};
+
+	for(size_t k = 0; k != 4; ++k)
+	{
+		limiter.consume(
+			"foo",
+			Pipe::log::item{
+				.when = {},
+				.severity = Pipe::log::item::severity::error,
+				.message = "Something failed"
+			}
+		);
+	}
+
+	REQUIRE_EQ(std::size(receiver.items), 1);
+	EXPECT_EQ(receiver.items[0].message, "Something failed");
+
+	limiter.consume(
+		"foo",
+		Pipe::log::item{
+			.when = {},
+			.severity = Pipe::log::item::severity::info,
+			.message = "Something else"
+		}
+	);
+
+	REQUIRE_EQ(std::size(receiver.items), 3);
+	EXPECT_EQ(receiver.items[1].message, "Last message repeated 3 times");
+	EXPECT_EQ(receiver.items[1].severity, Pipe::log::item::severity::error);
+	EXPECT_EQ(receiver.items[2].message, "Something else");
+
+	EXPECT_EQ(
+		limiter.metrics(),
+		(Pipe::json_log::suppression_metrics{
+			.items_forwarded = 2,
+			.items_rate_limited = 0,
+			.items_collapsed = 3
+		})
+	);
+}
+
+TESTCASE(Pipe_json_log_rate_limited_item_receiver_collapse_only_equal_fields)
+{
+	std::chrono::steady_clock::time_point now{};
+	my_receiver receiver;
+	Pipe::json_log::rate_limited_item_receiver limiter{
+		std::ref(receiver),
+		Pipe::json_log::rate_limiter_config{},
+		my_clock{&now}
+	};
+
+	auto const make_item = [](char const* status) {
+		return Pipe::log::item{
+			.when = {},
+			.severity = Pipe::log::item::severity::error,
+			.message = "Request failed",
+			.fields = {Pipe::log::field{.key = "status", .value = status}}
+		};
+	};
+
+	limiter.consume("foo", make_item("404"));
+	limiter.consume("foo", make_item("500"));
+	limiter.consume("foo", make_item("500"));
+	limiter.on_end_of_stream("foo");
+
+	REQUIRE_EQ(std::size(receiver.items), 3);
+	EXPECT_EQ(receiver.items[0].fields[0].value, "404");
+	EXPECT_EQ(receiver.items[1].message, "Request failed");
+	EXPECT_EQ(receiver.items[1].fields[0].value, "500");
+	EXPECT_EQ(receiver.items[2].message, "Last message repeated 1 times");
+	REQUIRE_EQ(std::size(receiver.items[2].fields), 1);
+	EXPECT_EQ(receiver.items[2].fields[0].value, "500");
+}
+
+TESTCASE(Pipe_json_log_rate_limited_item_receiver_flush_on_parse_error)
+{
+	std::chrono::steady_clock::time_point now{};
+	my_receiver receiver;
+	Pipe::json_log::rate_limited_item_receiver limiter{
+		std::ref(receiver),
+		Pipe::json_log::rate_limiter_config{},
+		my_clock{&now}
+	};
+
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Hello"});
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Hello"});
+	limiter.on_parse_error("foo", jopp::parser_error_code::more_data_needed);
+
+	REQUIRE_EQ(std::size(receiver.items), 2);
+	EXPECT_EQ(receiver.items[1].message, "Last message repeated 1 times");
+	EXPECT_EQ(receiver.parse_error_count, 1);
+}
+
+TESTCASE(Pipe_json_log_rate_limited_item_receiver_drop_items)
+{
+	std::chrono::steady_clock::time_point now{};
+	my_receiver receiver;
+	Pipe::json_log::rate_limited_item_receiver limiter{
+		std::ref(receiver),
+		Pipe::json_log::rate_limiter_config{
+			.items_per_second = 1.0,
+			.burst_size = 2.0,
+			.collapse_repeated_items = false
+		},
+		my_clock{&now}
+	};
+
+	for(size_t k = 0; k != 10; ++k)
+	{
+		limiter.consume(
+			"foo",
+			Pipe::log::item{.when = {}, .severity = {}, .message = std::format("Item {}", k)}
+		);
+	}
+
+	REQUIRE_EQ(std::size(receiver.items), 2);
+	EXPECT_EQ(receiver.items[0].message, "Item 0");
+	EXPECT_EQ(receiver.items[1].message, "Item 1");
+
+	now += std::chrono::seconds{1};
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Item 10"});
+
+	REQUIRE_EQ(std::size(receiver.items), 4);
+	EXPECT_EQ(receiver.items[2].message, "8 log items were dropped due to rate limiting");
+	EXPECT_EQ(receiver.items[2].severity, Pipe::log::item::severity::warning);
+	EXPECT_EQ(receiver.items[3].message, "Item 10");
+
+	EXPECT_EQ(
+		limiter.metrics(),
+		(Pipe::json_log::suppression_metrics{
+			.items_forwarded = 3,
+			.items_rate_limited = 8,
+			.items_collapsed = 0
+		})
+	);
+}
+
+TESTCASE(Pipe_json_log_rate_limited_item_receiver_repeats_do_not_consume_tokens)
+{
+	std::chrono::steady_clock::time_point now{};
+	my_receiver receiver;
+	Pipe::json_log::rate_limited_item_receiver limiter{
+		std::ref(receiver),
+		Pipe::json_log::rate_limiter_config{
+			.items_per_second = 1.0,
+			.burst_size = 2.0,
+			.collapse_repeated_items = true
+		},
+		my_clock{&now}
+	};
+
+	for(size_t k = 0; k != 10; ++k)
+	{ limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Hello"}); }
+
+	// Only the first item was charged, so there is still a token left
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "World"});
+
+	REQUIRE_EQ(std::size(receiver.items), 3);
+	EXPECT_EQ(receiver.items[0].message, "Hello");
+	EXPECT_EQ(receiver.items[1].message, "Last message repeated 9 times");
+	EXPECT_EQ(receiver.items[2].message, "World");
+
+	EXPECT_EQ(
+		limiter.metrics(),
+		(Pipe::json_log::suppression_metrics{
+			.items_forwarded = 2,
+			.items_rate_limited = 0,
+			.items_collapsed = 9
+		})
+	);
+}
+
+TESTCASE(Pipe_json_log_rate_limited_item_receiver_flush_on_end_of_stream)
+{
+	std::chrono::steady_clock::time_point now{};
+	my_receiver receiver;
+	Pipe::json_log::rate_limited_item_receiver limiter{
+		std::ref(receiver),
+		Pipe::json_log::rate_limiter_config{
+			.items_per_second = 1.0,
+			.burst_size = 2.0,
+			.collapse_repeated_items = true
+		},
+		my_clock{&now}
+	};
+
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Item 0"});
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Item 1"});
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Item 2"});
+	limiter.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Item 3"});
+	REQUIRE_EQ(std::size(receiver.items), 2);
+
+	limiter.on_end_of_stream("foo");
+	REQUIRE_EQ(std::size(receiver.items), 3);
+	EXPECT_EQ(receiver.items[2].message, "2 log items were dropped due to rate limiting");
+
+	// Repeats of the last forwarded item are also reported
+	Pipe::json_log::rate_limited_item_receiver repeats{
+		std::ref(receiver),
+		Pipe::json_log::rate_limiter_config{},
+		my_clock{&now}
+	};
+	repeats.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Hello"});
+	repeats.consume("foo", Pipe::log::item{.when = {}, .severity = {}, .message = "Hello"});
+	repeats.on_end_of_stream("foo");
+	REQUIRE_EQ(std::size(receiver.items), 5);
+	EXPECT_EQ(receiver.items[4].message, "Last message repeated 1 times");
+}
@@ -14,7 +14,9 @@ namespace
 		std::span<char const> input_span,
 		std::unique_ptr<State>& state,
 		Receiver& item_receiver,
-		char const* who
+		char const* who,
+		Pipe::json_log::field_key_table& field_keys,
+		Pipe::json_log::sequence_tracker& sequence
 	)
 	{
 		while(true)
@@ -35,7 +37,14 @@ namespace
 						break;
 					}
 
-					auto result = Pipe::json_log::make_log_item(std::move(*log_item));
+					// The item was received even if it turns out to be invalid
+					if(auto const seq = Pipe::json_log::get_sequence_number(*log_item); seq.has_value())
+					{
+						if(auto const discontinuity = sequence.update(*seq); discontinuity.has_value())
+						{ item_receiver.on_sequence_discontinuity(who, *discontinuity); }
+					}
+
+					auto result = Pipe::json_log::make_log_item(*log_item, field_keys);
 					if(result.has_value())
 					{ item_receiver.consume(who, std::move(*result)); }
 					else
@@ -64,9 +73,11 @@ void Pipe::json_log::reader::handle_event(
 	if(!can_read(event.get_activity_status()))
 	{ return; }
 
+	// The parser keeps its own state, so the buffer can be returned as soon as it has been parsed
+	auto const buffer = m_buffer_pool.get().allocate(m_buffer_size);
 	while(true)
 	{
-		std::span input_span{m_input_buffer.get(), m_buffer_size};
+		std::span input_span{reinterpret_cast<char*>(buffer.data()), m_buffer_size};
 		auto const read_result = read(fd, std::as_writable_bytes(input_span));
 
 		if(read_result.operation_would_have_blocked())
@@ -77,6 +88,7 @@ void Pipe::json_log::reader::handle_event(
 			if(m_state->parser.current_depth() != 0)
 			{ m_item_receiver->on_parse_error(m_name.c_str(), jopp::parser_error_code::more_data_needed); }
 
+			m_item_receiver->on_end_of_stream(m_name.c_str());
 			event.stop_listening();
 			return;
 		}
@@ -86,15 +98,21 @@ void Pipe::json_log::reader::handle_event(
 				std::span{std::begin(input_span), read_result.bytes_transferred()},
 				m_state,
 				*m_item_receiver,
-				m_name.c_str()
+				m_name.c_str(),
+				m_field_keys,
+				m_sequence
 			)
 		)
 		{
 			case parser_state::good:
 				break;
 			case parser_state::jammed:
+				m_item_receiver->on_end_of_stream(m_name.c_str());
 				event.stop_listening();
 				return;
 		}
+
+		if(!event.consume_budget(read_result.bytes_transferred()))
+		{ return; }
 	}
 }
\ No newline at end of file
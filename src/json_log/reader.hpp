@@ -3,13 +3,17 @@
 #ifndef PIPE_JSON_LOG_READER_HPP
 #define PIPE_JSON_LOG_READER_HPP
 
+#include "./item_converter.hpp"
+#include "./sequence_tracker.hpp"
 #include "src/log/log.hpp"
 #include "src/os_services/io/io.hpp"
 #include "src/os_services/fd/activity_monitor.hpp"
+#include "src/os_services/memory/buffer_pool.hpp"
 #include "src/utils/utils.hpp"
 
 #include <jopp/types.hpp>
 #include <jopp/parser.hpp>
+#include <functional>
 #include <memory>
 
 namespace Pipe::json_log
@@ -22,6 +26,14 @@ namespace Pipe::json_log
 	 * \param item The decoded log item
 	 * \param ec An error code issued by the JSON parser
 	 * \param errmsg A message explaining why a log item was invalid
+	 *
+	 * \note An item_receiver may also have an on_sequence_discontinuity(char const* who,
+	 *       sequence_discontinuity const& discontinuity) member function. If it has, it is called
+	 *       when items have been lost or duplicated. Otherwise, discontinuities are ignored.
+	 *
+	 * \note An item_receiver may also have an on_end_of_stream(char const* who) member function.
+	 *       If it has, it is called when the reader stops listening, so any state held back
+	 *       for the stream can be flushed.
 	 */
 	template<class T>
 	concept item_receiver = requires(
@@ -48,6 +60,8 @@ namespace Pipe::json_log
 		virtual void consume(char const* who, log::item&& item) = 0;
 		virtual void on_parse_error(char const* who, jopp::parser_error_code ec) = 0;
 		virtual void on_invalid_log_item(char const* who, char const* message) = 0;
+		virtual void on_sequence_discontinuity(char const* who, sequence_discontinuity const& discontinuity) = 0;
+		virtual void on_end_of_stream(char const* who) = 0;
 	};
 
 	/**
@@ -70,27 +84,59 @@ namespace Pipe::json_log
 		void on_invalid_log_item(char const* who, char const* message) override
 		{ utils::unwrap(m_object).on_invalid_log_item(who, message); }
 
+		void on_sequence_discontinuity(char const* who, sequence_discontinuity const& discontinuity) override
+		{
+			if constexpr(requires(){ utils::unwrap(m_object).on_sequence_discontinuity(who, discontinuity); })
+			{ utils::unwrap(m_object).on_sequence_discontinuity(who, discontinuity); }
+		}
+
+		void on_end_of_stream(char const* who) override
+		{
+			if constexpr(requires(){ utils::unwrap(m_object).on_end_of_stream(who); })
+			{ utils::unwrap(m_object).on_end_of_stream(who); }
+		}
+
 	private:
 		ItemReceiver m_object;
 	};
 
 	/**
 	 * \brief A reader that decodes log items from a stream of JSON objects
+	 *
+	 * The input buffer is borrowed from a buffer_pool for the duration of handle_event only, so
+	 * an idle reader does not hold any buffer memory. Field keys defined by the writer are
+	 * remembered for the lifetime of the reader.
+	 *
+	 * If log items carry sequence numbers, lost and duplicated items are reported to the
+	 * receiver through on_sequence_discontinuity, before the item that revealed them is
+	 * delivered. Duplicated items are still delivered.
+	 *
 	 * \note A reader can be used as a listener in os_services::fd::activity_monitor
 	 */
 	class reader
 	{
 	public:
+		/**
+		 * \brief The default size of the input buffer
+		 */
+		static constexpr size_t default_buffer_size = 65536;
+
 		/**
 		 * \brief Constructs a reader
 		 * \param name The name of this reader. Used for identifying the events passed to receiver
 		 * \param receiver The item_receiver that will receive log items
-		 * \param buffer_size The size of the internal buffer
+		 * \param buffer_size The size of the input buffer
+		 * \param buffer_pool The pool to borrow the input buffer from. It must outlive the reader.
 		 */
 		template<item_receiver ItemReceiver>
-		explicit reader(std::string&& name, ItemReceiver receiver, size_t buffer_size = 65536):
+		explicit reader(
+			std::string&& name,
+			ItemReceiver receiver,
+			size_t buffer_size = default_buffer_size,
+			os_services::memory::buffer_pool& buffer_pool = os_services::memory::default_buffer_pool()
+		):
 			m_buffer_size{buffer_size},
-			m_input_buffer{std::make_unique<char[]>(buffer_size)},
+			m_buffer_pool{buffer_pool},
 			m_item_receiver{new item_receiver_impl(std::forward<ItemReceiver>(receiver))},
 			m_name{std::move(name)},
 			m_state{std::make_unique<state>()}
@@ -98,6 +144,10 @@ namespace Pipe::json_log
 
 		/**
 		 * \brief Handles file activity events
+		 *
+		 * Data is read until the read operation would block, or until the dispatch budget of event
+		 * has been exhausted.
+		 *
 		 * \param event The event to handle
 		 * \param fd The file descriptor that has activity
 		 */
@@ -108,9 +158,11 @@ namespace Pipe::json_log
 
 	private:
 		size_t m_buffer_size;
-		std::unique_ptr<char[]> m_input_buffer;
+		std::reference_wrapper<os_services::memory::buffer_pool> m_buffer_pool;
 		std::unique_ptr<type_erased_item_receiver>  m_item_receiver;
 		std::string m_name;
+		field_key_table m_field_keys;
+		sequence_tracker m_sequence;
 
 		struct state
 		{
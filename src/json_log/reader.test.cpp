@@ -17,6 +17,7 @@ namespace
 		Pipe::log::item recv_item{};
 		jopp::parser_error_code parser_error = jopp::parser_error_code::completed;
 		std::vector<std::string> errmesg{};
+		std::vector<Pipe::json_log::sequence_discontinuity> discontinuities{};
 
 		void consume(char const*, Pipe::log::item&& item)
 		{
@@ -29,6 +30,9 @@ namespace
 
 		void on_invalid_log_item(char const*, char const* msg)
 		{ errmesg.push_back(msg);}
+
+		void on_sequence_discontinuity(char const*, Pipe::json_log::sequence_discontinuity const& discontinuity)
+		{ discontinuities.push_back(discontinuity); }
 	};
 
 	struct my_fd_activity_event:public Pipe::os_services::fd::activity_event
@@ -422,4 +426,42 @@ TESTCASE(Pipe_json_log_reader_read_jammed_parser)
 	EXPECT_EQ(receiver.errmesg.size(), 0);
 	EXPECT_EQ(receiver.parser_error, jopp::parser_error_code::no_top_level_node);
 	EXPECT_EQ(receiver.recv_item, Pipe::log::item{});
+}
+
+TESTCASE(Pipe_json_log_reader_read_sequence_discontinuity)
+{
+	my_receiver receiver;
+	Pipe::json_log::reader reader{"foo", std::ref(receiver)};
+	Pipe::os_services::ipc::pipe logpipe;
+
+	std::string const str{
+		R"({"when":0,"severity":"info","message":"First","seq":0})"
+		R"({"when":0,"severity":"info","message":"Second","seq":3})"
+		R"({"when":0,"severity":"info","message":"Third","seq":1})"
+		R"({"when":0,"severity":"info","message":"Fourth","seq":4})"
+	};
+
+	fcntl(logpipe.read_end().native_handle(), F_SETFL, O_NONBLOCK);
+	write(logpipe.write_end(), std::as_bytes(std::span{str}));
+
+	auto listening_status = Pipe::os_services::fd::activity_status::read;
+	bool stop_listening = false;
+
+	reader.handle_event(
+		my_fd_activity_event{
+			Pipe::os_services::fd::activity_status::read,
+			&listening_status,
+			&stop_listening
+		},
+		logpipe.read_end()
+	);
+
+	EXPECT_EQ(stop_listening, false);
+	EXPECT_EQ(receiver.errmesg.empty(), true);
+	REQUIRE_EQ(receiver.discontinuities.size(), 2);
+	EXPECT_EQ(receiver.discontinuities[0], (Pipe::json_log::sequence_discontinuity{.expected = 1, .received = 3}));
+	EXPECT_EQ(receiver.discontinuities[0].lost_items(), 2);
+	EXPECT_EQ(receiver.discontinuities[1], (Pipe::json_log::sequence_discontinuity{.expected = 4, .received = 1}));
+	EXPECT_EQ(receiver.discontinuities[1].is_duplicate(), true);
+	EXPECT_EQ(receiver.recv_item.message, "Fourth");
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef PIPE_JSON_LOG_SEQUENCE_TRACKER_HPP
+#define PIPE_JSON_LOG_SEQUENCE_TRACKER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string>
+
+namespace Pipe::json_log
+{
+	/**
+	 * \brief Describes a log item whose sequence number was not the expected one
+	 */
+	struct sequence_discontinuity
+	{
+		/**
+		 * \brief The sequence number of the next item, had no items been lost or repeated
+		 */
+		uint64_t expected;
+
+		/**
+		 * \brief The sequence number of the received item
+		 */
+		uint64_t received;
+
+		/**
+		 * \brief Checks whether or not the item had already been received
+		 */
+		constexpr bool is_duplicate() const noexcept
+		{ return received < expected; }
+
+		/**
+		 * \brief Returns the number of items that were lost before the received item
+		 */
+		constexpr uint64_t lost_items() const noexcept
+		{ return is_duplicate()? 0 : received - expected; }
+
+		bool operator==(sequence_discontinuity const&) const = default;
+		bool operator!=(sequence_discontinuity const&) const = default;
+	};
+
+	/**
+	 * \brief Describes discontinuity in a human-readable way
+	 */
+	inline std::string to_string(sequence_discontinuity const& discontinuity)
+	{
+		if(discontinuity.is_duplicate())
+		{
+			return std::format(
+				"Received duplicate log item {} (expected {})",
+				discontinuity.received,
+				discontinuity.expected
+			);
+		}
+
+		return std::format(
+			"{} log items were lost (expected {}, received {})",
+			discontinuity.lost_items(),
+			discontinuity.expected,
+			discontinuity.received
+		);
+	}
+
+	/**
+	 * \brief Keeps track of the sequence numbers received from a single writer
+	 *
+	 * A writer numbers its items from zero, so the first item is expected to have sequence
+	 * number zero.
+	 */
+	class sequence_tracker
+	{
+	public:
+		/**
+		 * \brief Registers the sequence number of a received item
+		 * \return A sequence_discontinuity if sequence_number was not the expected one
+		 */
+		std::optional<sequence_discontinuity> update(uint64_t sequence_number) noexcept
+		{
+			auto const expected = m_next;
+			m_next = std::max(m_next, sequence_number + 1);
+			if(sequence_number == expected)
+			{ return std::nullopt; }
+
+			return sequence_discontinuity{
+				.expected = expected,
+				.received = sequence_number
+			};
+		}
+
+	private:
+		uint64_t m_next{0};
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+//@	{"target": {"name": "sequence_tracker.test"}}
+
+#include "./sequence_tracker.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+TESTCASE(Pipe_json_log_sequence_tracker_update)
+{
+	Pipe::json_log::sequence_tracker tracker;
+	EXPECT_EQ(tracker.update(0).has_value(), false);
+	EXPECT_EQ(tracker.update(1).has_value(), false);
+
+	auto const gap = tracker.update(5);
+	REQUIRE_EQ(gap.has_value(), true);
+	EXPECT_EQ(gap->expected, 2);
+	EXPECT_EQ(gap->received, 5);
+	EXPECT_EQ(gap->is_duplicate(), false);
+	EXPECT_EQ(gap->lost_items(), 3);
+	EXPECT_EQ(tracker.update(6).has_value(), false);
+
+	auto const duplicate = tracker.update(3);
+	REQUIRE_EQ(duplicate.has_value(), true);
+	EXPECT_EQ(duplicate->expected, 7);
+	EXPECT_EQ(duplicate->received, 3);
+	EXPECT_EQ(duplicate->is_duplicate(), true);
+	EXPECT_EQ(duplicate->lost_items(), 0);
+
+	// A duplicate does not move the expected sequence number backwards
+	EXPECT_EQ(tracker.update(7).has_value(), false);
+}
+
+TESTCASE(Pipe_json_log_sequence_tracker_first_item_lost)
+{
+	Pipe::json_log::sequence_tracker tracker;
+	auto const gap = tracker.update(2);
+	REQUIRE_EQ(gap.has_value(), true);
+	EXPECT_EQ(gap->lost_items(), 2);
+}
+
+TESTCASE(Pipe_json_log_sequence_discontinuity_to_string)
+{
+	EXPECT_EQ(
+		to_string(Pipe::json_log::sequence_discontinuity{.expected = 10, .received = 40010}),
+		"40000 log items were lost (expected 10, received 40010)"
+	);
+	EXPECT_EQ(
+		to_string(Pipe::json_log::sequence_discontinuity{.expected = 10, .received = 4}),
+		"Received duplicate log item 4 (expected 10)"
+	);
+}
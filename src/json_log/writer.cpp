@@ -7,9 +7,12 @@
 
 void Pipe::json_log::writer::write(log::item const& item)
 {
-	auto const object = to_jopp_object(item);
+	auto object = to_jopp_object(item, m_field_keys);
+	object.insert("seq", static_cast<jopp::number>(m_sequence_number));
+	++m_sequence_number;
 	jopp::serializer serializer{object};
-	std::span current_range{m_output_buffer.get(), m_buffer_size};
+	auto const buffer = m_buffer_pool.get().allocate(m_buffer_size);
+	std::span current_range{reinterpret_cast<char*>(buffer.data()), m_buffer_size};
 	while(true)
 	{
 		auto const serialize_result = serializer.serialize(current_range);
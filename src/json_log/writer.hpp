@@ -3,23 +3,38 @@
 #ifndef PIPE_JSON_LOG_WRITER_HPP
 #define PIPE_JSON_LOG_WRITER_HPP
 
+#include "./item_converter.hpp"
 #include "src/log/log.hpp"
 #include "src/os_services/io/io.hpp"
+#include "src/os_services/memory/buffer_pool.hpp"
 
 #include <jopp/types.hpp>
+#include <functional>
 
 namespace Pipe::json_log
 {
+	/**
+	 * \brief Writes log items as JSON objects
+	 *
+	 * The output buffer is borrowed from a buffer_pool for the duration of write only. Field keys
+	 * are interned, so a key name is normally only written the first time it is used by this
+	 * writer. The name is written again periodically, so a reader that has lost its definition
+	 * can recover.
+	 *
+	 * Each item is given a sequence number, starting from zero, so a reader can detect lost
+	 * items.
+	 */
 	class writer
 	{
 	public:
 		explicit writer(
 			size_t buffer_size = 65536,
-			os_services::io::output_file_descriptor_ref output_fd = os_services::io::output_file_descriptor_ref{STDERR_FILENO}
+			os_services::io::output_file_descriptor_ref output_fd = os_services::io::output_file_descriptor_ref{STDERR_FILENO},
+			os_services::memory::buffer_pool& buffer_pool = os_services::memory::default_buffer_pool()
 		):
 			m_output_fd{output_fd},
 			m_buffer_size{buffer_size},
-			m_output_buffer{std::make_unique<char[]>(buffer_size)}
+			m_buffer_pool{buffer_pool}
 		{}
 
 		void write(log::item const& item);
@@ -27,7 +42,9 @@ namespace Pipe::json_log
 	private:
 		os_services::io::output_file_descriptor_ref m_output_fd;
 		size_t m_buffer_size;
-		std::unique_ptr<char[]> m_output_buffer;
+		std::reference_wrapper<os_services::memory::buffer_pool> m_buffer_pool;
+		field_key_encoder m_field_keys;
+		uint64_t m_sequence_number{0};
 	};
 }
 
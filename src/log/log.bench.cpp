@@ -0,0 +1,69 @@
+//@	{"target":{"name":"log.bench"}}
+
+#include "./log.hpp"
+#include "src/bench/bench.hpp"
+
+#include <array>
+#include <latch>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct counting_writer
+	{
+		// Only accessed while the log is locked
+		uint64_t count{0};
+		uint64_t bytes{0};
+
+		void write(Pipe::log::item&& item)
+		{
+			++count;
+			bytes += std::size(item.message);
+		}
+	};
+
+	struct system_clock_timestamp_generator
+	{
+		Pipe::log::clock::time_point now() const
+		{ return Pipe::log::clock::now(); }
+	};
+}
+
+BENCHMARK(Pipe_log_write_message_contention, context)
+{
+	counting_writer writer;
+	system_clock_timestamp_generator timestamp_generator;
+	Pipe::log::context log_ctxt{
+		Pipe::log::configuration{
+			.writer = std::ref(writer),
+			.timestamp_generator = std::ref(timestamp_generator)
+		}
+	};
+
+	constexpr std::array<size_t, 7> thread_counts{1, 2, 4, 8, 16, 32, 64};
+	for(auto const thread_count : thread_counts)
+	{
+		context.measure(
+			"log_write_message_contention",
+			{{"thread_count", static_cast<int64_t>(thread_count)}},
+			[thread_count, &writer](uint64_t iterations) {
+				writer = counting_writer{};
+				std::latch start{static_cast<ptrdiff_t>(thread_count)};
+				{
+					std::vector<std::jthread> threads;
+					threads.reserve(thread_count);
+					for(size_t k = 0; k != thread_count; ++k)
+					{
+						threads.emplace_back([&start, iterations, k]() {
+							start.arrive_and_wait();
+							for(uint64_t n = 0; n != iterations; ++n)
+							{ Pipe::log::write_message(Pipe::log::item::severity::info, "Message {} from thread {}", n, k); }
+						});
+					}
+				}
+				return Pipe::bench::work_done{.items = writer.count, .bytes = writer.bytes};
+			}
+		);
+	}
+}
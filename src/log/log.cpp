@@ -18,13 +18,21 @@ Pipe::log::configuration Pipe::log::configure(configuration const& cfg) noexcept
 }
 
 void Pipe::log::write_message(enum item::severity severity, std::string&& message)
+{ write_message(severity, std::move(message), std::vector<field>{}); }
+
+void Pipe::log::write_message(
+	enum item::severity severity,
+	std::string&& message,
+	std::vector<field>&& fields
+)
 {
 	std::lock_guard lock{log_mutex};
 	write_message(
 		item{
 			.when = log_cfg.timestamp_generator.now(),
 			.severity = severity,
-			.message = std::move(message)
+			.message = std::move(message),
+			.fields = std::move(fields)
 		},
 		log_cfg.writer
 	);
@@ -9,6 +9,7 @@
 #include <functional>
 #include <string_view>
 #include <stdexcept>
+#include <vector>
 
 /**
  * \brief Logging facilities
@@ -20,6 +21,20 @@ namespace Pipe::log
 	 */
 	using clock = std::chrono::system_clock;
 
+	/**
+	 * \brief A key/value pair attached to a log item
+	 *
+	 * Fields make it possible to select log items without parsing the message.
+	 */
+	struct field
+	{
+		std::string key;
+		std::string value;
+
+		bool operator==(field const&) const = default;
+		bool operator!=(field const&) const = default;
+	};
+
 	/**
 	 * An item in a log
 	 */
@@ -33,6 +48,7 @@ namespace Pipe::log
 		clock::time_point when;
 		enum severity severity;
 		std::string message;
+		std::vector<field> fields{};
 
 		bool operator==(item const&) const = default;
 		bool operator!=(item const&) const = default;
@@ -177,6 +193,11 @@ namespace Pipe::log
 	 */
 	void write_message(enum item::severity severity, std::string&& message);
 
+	/**
+	 * \brief Writes a pre-formatted log message, together with fields, using the current writer
+	 */
+	void write_message(enum item::severity severity, std::string&& message, std::vector<field>&& fields);
+
 	/**
 	 * \brief Formats a log message and writes it using the current writer
 	 */
@@ -85,6 +85,34 @@ TESTCASE(Pipe_log_configure_and_write_message)
 	EXPECT_EQ(writer.written_items, written_items);
 }
 
+TESTCASE(Pipe_log_write_message_with_fields)
+{
+	my_timestamp_generator generator;
+	my_writer writer;
+	Pipe::log::context ctxt{
+		Pipe::log::configuration{
+			.writer = std::ref(writer),
+			.timestamp_generator = std::ref(generator)
+		}
+	};
+
+	write_message(
+		Pipe::log::item::severity::info,
+		"Request completed",
+		std::vector{
+			Pipe::log::field{.key = "request_id", .value = "1234"},
+			Pipe::log::field{.key = "status", .value = "200"}
+		}
+	);
+
+	REQUIRE_EQ(writer.written_items.size(), 1);
+	auto const& item = writer.written_items[0];
+	EXPECT_EQ(item.message, "Request completed");
+	REQUIRE_EQ(item.fields.size(), 2);
+	EXPECT_EQ(item.fields[0], (Pipe::log::field{.key = "request_id", .value = "1234"}));
+	EXPECT_EQ(item.fields[1], (Pipe::log::field{.key = "status", .value = "200"}));
+}
+
 TESTCASE(Pipe_log_severity_to_string)
 {
 	EXPECT_EQ(to_string(Pipe::log::item::severity::info), std::string_view{"info"});
@@ -0,0 +1,274 @@
+//@	{"target":{"name":"archived_segment.o"}}
+
+#include "./archived_segment.hpp"
+
+namespace
+{
+	struct pending_block
+	{
+		Pipe::log_store::block_index_entry entry;
+		std::vector<std::byte> compressed_data;
+	};
+
+	class block_builder
+	{
+	public:
+		explicit block_builder(size_t block_size, std::span<std::byte const> dictionary):
+			m_block_size{block_size},
+			m_dictionary{dictionary}
+		{ reset_entry(); }
+
+		void append(Pipe::log_store::record_view const& record)
+		{
+			if(m_current_entry.item_count != 0
+				&& std::size(m_current_fields) + std::size(m_current_messages) + std::size(record.payload) > m_block_size)
+			{ flush(); }
+
+			auto const delta = static_cast<uint64_t>(record.header.when)
+				- static_cast<uint64_t>(m_previous_time);
+			auto const payload = std::as_bytes(std::span{record.payload});
+			Pipe::log_store::write_varint(
+				m_current_fields,
+				(delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63)
+			);
+			m_current_fields.push_back(
+				static_cast<std::byte>((record.header.severity & 0xf) | (record.header.flags << 4))
+			);
+			Pipe::log_store::write_varint(m_current_fields, record.header.client_id);
+			Pipe::log_store::write_varint(m_current_fields, std::size(payload));
+			m_current_messages.insert(std::end(m_current_messages), std::begin(payload), std::end(payload));
+			m_previous_time = record.header.when;
+
+			m_current_entry.min_time = std::min(m_current_entry.min_time, record.header.when);
+			m_current_entry.max_time = std::max(m_current_entry.max_time, record.header.when);
+			m_current_entry.client_mask |= Pipe::log_store::client_mask_bit(record.header.client_id);
+			++m_current_entry.item_count;
+		}
+
+		void flush()
+		{
+			if(m_current_entry.item_count == 0)
+			{ return; }
+
+			std::vector<std::byte> block;
+			block.reserve(std::size(m_current_fields) + std::size(m_current_messages) + 8);
+			Pipe::log_store::write_varint(block, std::size(m_current_fields));
+			block.insert(std::end(block), std::begin(m_current_fields), std::end(m_current_fields));
+			block.insert(std::end(block), std::begin(m_current_messages), std::end(m_current_messages));
+
+			m_current_entry.uncompressed_size = static_cast<uint32_t>(std::size(block));
+			auto compressed_data = Pipe::log_store::lz_compress(block, m_dictionary);
+			m_current_entry.compressed_size = static_cast<uint32_t>(std::size(compressed_data));
+			m_blocks.push_back(
+				pending_block{
+					.entry = m_current_entry,
+					.compressed_data = std::move(compressed_data)
+				}
+			);
+			m_current_fields.clear();
+			m_current_messages.clear();
+			m_previous_time = 0;
+			reset_entry();
+		}
+
+		auto& blocks() noexcept
+		{ return m_blocks; }
+
+	private:
+		void reset_entry()
+		{
+			m_current_entry = Pipe::log_store::block_index_entry{
+				.min_time = std::numeric_limits<int64_t>::max(),
+				.max_time = std::numeric_limits<int64_t>::min(),
+				.offset = 0,
+				.compressed_size = 0,
+				.uncompressed_size = 0,
+				.item_count = 0,
+				.client_mask = 0,
+				.reserved = 0
+			};
+		}
+
+		size_t m_block_size;
+		std::span<std::byte const> m_dictionary;
+		std::vector<std::byte> m_current_fields;
+		std::vector<std::byte> m_current_messages;
+		Pipe::log_store::block_index_entry m_current_entry;
+		int64_t m_previous_time{0};
+		std::vector<pending_block> m_blocks;
+	};
+
+	template<class Callable>
+	void for_each_raw_record(std::span<std::byte const> data, Callable&& func)
+	{
+		size_t offset = 0;
+		while(offset < std::size(data))
+		{
+			auto const record = Pipe::log_store::read_record(data.subspan(offset));
+			if(!record.has_value())
+			{ return; }
+
+			func(*record, data.subspan(offset, record->header.size));
+			offset += record->header.size;
+		}
+	}
+}
+
+void Pipe::log_store::write_archive(
+	std::filesystem::path const& path,
+	segment const& src,
+	archive_config const& cfg
+)
+{
+	auto const records = src.records();
+
+	std::vector<std::string_view> samples;
+	std::vector<std::byte> client_table;
+	for_each_raw_record(records, [&samples, &client_table](auto const& record, auto raw_data) {
+		switch(record.header.type)
+		{
+			case record_type::client_name:
+			case record_type::field_key:
+				client_table.insert(std::end(client_table), std::begin(raw_data), std::end(raw_data));
+				break;
+
+			case record_type::log_item:
+				samples.push_back(record.payload);
+				break;
+		}
+	});
+
+	auto const dictionary = cfg.dictionary_size != 0?
+		train_lz_dictionary(samples, cfg.dictionary_size):
+		std::vector<std::byte>{};
+
+	block_builder builder{std::max(cfg.block_size, static_cast<size_t>(1)), dictionary};
+	for_each_raw_record(records, [&builder](auto const& record, auto) {
+		if(record.header.type == record_type::log_item)
+		{ builder.append(record); }
+	});
+	builder.flush();
+
+	auto& blocks = builder.blocks();
+	auto offset = sizeof(archive_header)
+		+ std::size(blocks)*sizeof(block_index_entry)
+		+ std::size(dictionary)
+		+ std::size(client_table);
+	for(auto& item : blocks)
+	{
+		item.entry.offset = static_cast<uint32_t>(offset);
+		offset += std::size(item.compressed_data);
+	}
+
+	if(offset > std::numeric_limits<uint32_t>::max())
+	{ throw std::runtime_error{"Archived segment is too large"}; }
+
+	auto const file = os_services::fs::create(path);
+	os_services::fs::truncate(file.get(), offset);
+	os_services::memory::mapped_region mapping{
+		file.get(),
+		offset,
+		os_services::memory::access_mode::read_write
+	};
+
+	archive_header const header{
+		.magic = archive_magic,
+		.version = archive_version,
+		.block_count = static_cast<uint32_t>(std::size(blocks)),
+		.sequence_number = src.sequence_number(),
+		.created = to_record_time(src.created()),
+		.dictionary_size = static_cast<uint32_t>(std::size(dictionary)),
+		.client_table_size = static_cast<uint32_t>(std::size(client_table))
+	};
+
+	auto write_ptr = mapping.data();
+	auto const write = [&write_ptr](void const* data, size_t size) {
+		memcpy(write_ptr, data, size);
+		write_ptr += size;
+	};
+
+	write(&header, sizeof(header));
+	for(auto const& item : blocks)
+	{ write(&item.entry, sizeof(item.entry)); }
+	write(std::data(dictionary), std::size(dictionary));
+	write(std::data(client_table), std::size(client_table));
+	for(auto const& item : blocks)
+	{ write(std::data(item.compressed_data), std::size(item.compressed_data)); }
+
+	mapping.sync();
+}
+
+Pipe::log_store::archived_segment::archived_segment(std::filesystem::path const& path):
+	m_path{path},
+	m_file{os_services::fs::open(path, os_services::fs::open_mode::read_only)},
+	m_sequence_number{0},
+	m_created{0},
+	m_dictionary_offset{0},
+	m_dictionary_size{0}
+{
+	auto const file_size = os_services::fs::get_size(m_file.get());
+	auto const invalid_file = [&path]() {
+		return std::runtime_error{std::format("{} is not a valid archived segment file", path.string())};
+	};
+
+	if(file_size < sizeof(archive_header) || file_size > std::numeric_limits<uint32_t>::max())
+	{ throw invalid_file(); }
+
+	m_mapping = os_services::memory::mapped_region{
+		m_file.get(),
+		file_size,
+		os_services::memory::access_mode::read_only
+	};
+
+	archive_header header{};
+	memcpy(&header, m_mapping.data(), sizeof(header));
+	if(header.magic != archive_magic || header.version == 0 || header.version > archive_version)
+	{ throw invalid_file(); }
+
+	auto const index_size = static_cast<size_t>(header.block_count)*sizeof(block_index_entry);
+	auto const data_offset = sizeof(archive_header) + index_size
+		+ header.dictionary_size + header.client_table_size;
+	if(data_offset > file_size)
+	{ throw invalid_file(); }
+
+	m_sequence_number = header.sequence_number;
+	m_created = header.created;
+	m_dictionary_offset = sizeof(archive_header) + index_size;
+	m_dictionary_size = header.dictionary_size;
+
+	m_block_index.resize(header.block_count);
+	memcpy(std::data(m_block_index), m_mapping.data() + sizeof(archive_header), index_size);
+	for(auto const& entry : m_block_index)
+	{
+		if(entry.offset < data_offset || entry.compressed_size > file_size - entry.offset)
+		{ throw invalid_file(); }
+
+		m_item_count += entry.item_count;
+		m_uncompressed_size += entry.uncompressed_size;
+		if(entry.item_count != 0)
+		{
+			m_min_time = std::min(m_min_time, entry.min_time);
+			m_max_time = std::max(m_max_time, entry.max_time);
+		}
+	}
+
+	for_each_raw_record(
+		m_mapping.bytes().subspan(m_dictionary_offset + m_dictionary_size, header.client_table_size),
+		[this](auto const& record, auto) {
+			switch(record.header.type)
+			{
+				case record_type::client_name:
+					m_client_names.insert_or_assign(record.header.client_id, std::string{record.payload});
+					break;
+
+				case record_type::field_key:
+					if(auto const key = read_field_key_payload(record.payload); key.has_value())
+					{ m_field_keys.insert_or_assign(key->first, std::string{key->second}); }
+					break;
+
+				case record_type::log_item:
+					break;
+			}
+		}
+	);
+}
@@ -0,0 +1,338 @@
+//@	{"dependencies_extra":[{"ref":"./archived_segment.o", "rel":"implementation"}]}
+
+#ifndef PIPE_LOG_STORE_ARCHIVED_SEGMENT_HPP
+#define PIPE_LOG_STORE_ARCHIVED_SEGMENT_HPP
+
+#include "./segment.hpp"
+#include "./lz_codec.hpp"
+
+namespace Pipe::log_store
+{
+	/**
+	 * \brief The header at the start of each archived segment file
+	 *
+	 * The header is followed by block_count entries of the block index, the dictionary, the
+	 * client_name and field_key records of the segment, and finally the compressed blocks.
+	 */
+	struct archive_header
+	{
+		std::array<char, 8> magic;
+		uint32_t version;
+		uint32_t block_count;
+		uint64_t sequence_number;
+		int64_t created;
+		uint32_t dictionary_size;
+		uint32_t client_table_size;
+	};
+
+	static_assert(sizeof(archive_header) == 40);
+
+	/**
+	 * \brief The magic number that identifies an archived segment file
+	 */
+	constexpr std::array<char, 8> archive_magic{'P', 'I', 'P', 'E', 'L', 'O', 'G', 'Z'};
+
+	/**
+	 * \brief The current version of the archived segment file format
+	 *
+	 * Version 2 added record flags and field_key records. Files of version 1 can still be read.
+	 */
+	constexpr uint32_t archive_version = 2;
+
+	/**
+	 * \brief Describes a compressed block within an archived segment
+	 */
+	struct block_index_entry
+	{
+		/**
+		 * \brief The earliest timestamp of all log items within the block
+		 */
+		int64_t min_time;
+
+		/**
+		 * \brief The latest timestamp of all log items within the block
+		 */
+		int64_t max_time;
+
+		/**
+		 * \brief The offset of the compressed block within the file
+		 */
+		uint32_t offset;
+
+		/**
+		 * \brief The size of the compressed block
+		 */
+		uint32_t compressed_size;
+
+		/**
+		 * \brief The size of the block after decompression
+		 */
+		uint32_t uncompressed_size;
+
+		/**
+		 * \brief The number of log items within the block
+		 */
+		uint32_t item_count;
+
+		/**
+		 * \brief A bit mask of client ids within the block. Bit client_id % 32 is set for each
+		 *        client with log items in the block.
+		 */
+		uint32_t client_mask;
+
+		uint32_t reserved;
+	};
+
+	static_assert(sizeof(block_index_entry) == 40);
+
+	/**
+	 * \brief Calls func with a record_view for each log item within a decompressed block
+	 *
+	 * A block starts with the size of its field section. For each log item, the field section
+	 * holds the difference between its timestamp and the timestamp of the previous item (zigzag
+	 * encoded), its severity and flags (in the low and high four bits of a single byte), its client
+	 * id, and the size of its message. The field section is
+	 * followed by all messages. Compared to storing complete records, this removes most of the
+	 * redundancy before the block is compressed, and it keeps similar data together.
+	 *
+	 * \return false if block is corrupt
+	 */
+	template<class Func>
+	bool for_each_block_entry(std::span<std::byte const> block, Func&& func)
+	{
+		size_t offset = 0;
+		auto const fields_size = read_varint(block, offset);
+		if(!fields_size.has_value() || *fields_size > std::size(block) - offset)
+		{ return false; }
+
+		auto const fields = block.subspan(offset, *fields_size);
+		auto const messages = block.subspan(offset + *fields_size);
+		size_t field_offset = 0;
+		size_t message_offset = 0;
+		int64_t when = 0;
+		while(field_offset != std::size(fields))
+		{
+			auto const delta = read_varint(fields, field_offset);
+			if(!delta.has_value() || field_offset == std::size(fields))
+			{ return false; }
+
+			auto const severity_and_flags = std::to_integer<uint8_t>(fields[field_offset]);
+			++field_offset;
+
+			auto const client_id = read_varint(fields, field_offset);
+			auto const payload_size = read_varint(fields, field_offset);
+			if(!client_id.has_value() || !payload_size.has_value()
+				|| *payload_size > std::size(messages) - message_offset)
+			{ return false; }
+
+			when += static_cast<int64_t>((*delta >> 1) ^ (~(*delta & 1) + 1));
+			func(
+				record_view{
+					.header = record_header{
+						.size = static_cast<uint32_t>(record_size(*payload_size)),
+						.type = record_type::log_item,
+						.severity = static_cast<uint8_t>(severity_and_flags & 0xf),
+						.flags = static_cast<uint8_t>(severity_and_flags >> 4),
+						.client_id = static_cast<uint32_t>(*client_id),
+						.payload_size = static_cast<uint32_t>(*payload_size),
+						.when = when
+					},
+					.payload = std::string_view{
+						reinterpret_cast<char const*>(std::data(messages) + message_offset),
+						*payload_size
+					}
+				}
+			);
+			message_offset += *payload_size;
+		}
+		return message_offset == std::size(messages);
+	}
+
+	/**
+	 * \brief Returns the bit used to represent client_id in block_index_entry::client_mask
+	 */
+	constexpr uint32_t client_mask_bit(uint32_t client_id)
+	{ return uint32_t{1} << (client_id % 32); }
+
+	/**
+	 * \brief Controls how a segment is archived
+	 */
+	struct archive_config
+	{
+		/**
+		 * \brief The max uncompressed size of a block. A block always contains at least one record.
+		 */
+		size_t block_size{64*1024};
+
+		/**
+		 * \brief The max size of the dictionary shared by all blocks. Set to zero to disable the
+		 *        dictionary.
+		 */
+		size_t dictionary_size{16*1024};
+	};
+
+	/**
+	 * \brief Writes the content of src to a new archived segment file
+	 *
+	 * The log items of src are split into blocks, that are compressed independently, using a
+	 * dictionary trained from the messages within src. Thus, a query only needs to decompress
+	 * the blocks that overlaps the requested time range.
+	 *
+	 * \param path The path of the file to create
+	 * \param src The segment to archive
+	 * \param cfg Controls block and dictionary sizes
+	 */
+	void write_archive(std::filesystem::path const& path, segment const& src, archive_config const& cfg);
+
+	/**
+	 * \brief A read-only, memory-mapped segment file, whose log items are stored in compressed blocks
+	 */
+	class archived_segment
+	{
+	public:
+		/**
+		 * \brief Opens an archived segment file
+		 * \param path The path of the file to open
+		 */
+		explicit archived_segment(std::filesystem::path const& path);
+
+		/**
+		 * \brief An archived segment is always sealed
+		 */
+		constexpr bool is_sealed() const noexcept
+		{ return true; }
+
+		/**
+		 * \brief Returns all client names defined in this segment
+		 */
+		auto const& client_names() const noexcept
+		{ return m_client_names; }
+
+		/**
+		 * \brief Returns all field keys defined in this segment
+		 */
+		auto const& field_keys() const noexcept
+		{ return m_field_keys; }
+
+		/**
+		 * \brief Returns the path of the segment file
+		 */
+		std::filesystem::path const& path() const noexcept
+		{ return m_path; }
+
+		/**
+		 * \brief Returns the sequence number of the segment
+		 */
+		uint64_t sequence_number() const noexcept
+		{ return m_sequence_number; }
+
+		/**
+		 * \brief Returns the time the original segment was created
+		 */
+		log::clock::time_point created() const noexcept
+		{ return from_record_time(m_created); }
+
+		/**
+		 * \brief Returns the latest timestamp of all log items within the segment
+		 */
+		int64_t max_time() const noexcept
+		{ return m_max_time; }
+
+		/**
+		 * \brief Returns the earliest timestamp of all log items within the segment
+		 */
+		int64_t min_time() const noexcept
+		{ return m_min_time; }
+
+		/**
+		 * \brief Returns the size of the segment file
+		 */
+		size_t size() const noexcept
+		{ return m_mapping.size(); }
+
+		/**
+		 * \brief Returns the total size of all blocks after decompression
+		 */
+		size_t uncompressed_size() const noexcept
+		{ return m_uncompressed_size; }
+
+		/**
+		 * \brief Returns the number of log items in the segment
+		 */
+		size_t item_count() const noexcept
+		{ return m_item_count; }
+
+		/**
+		 * \brief Returns the block index
+		 */
+		std::span<block_index_entry const> block_index() const noexcept
+		{ return m_block_index; }
+
+		/**
+		 * \brief Returns the dictionary shared by all blocks
+		 */
+		std::span<std::byte const> dictionary() const noexcept
+		{ return m_mapping.bytes().subspan(m_dictionary_offset, m_dictionary_size); }
+
+		/**
+		 * \brief Decompresses the block described by entry
+		 */
+		std::vector<std::byte> decompress_block(block_index_entry const& entry) const
+		{
+			return lz_decompress(
+				m_mapping.bytes().subspan(entry.offset, entry.compressed_size),
+				entry.uncompressed_size,
+				dictionary()
+			);
+		}
+
+		/**
+		 * \brief Calls func for each log item record that matches filter, in storage order
+		 *
+		 * Only blocks that may contain matching records are decompressed.
+		 */
+		template<class Func>
+		void for_each_record(record_filter const& filter, Func&& func) const
+		{
+			if(m_item_count == 0 || filter.since > m_max_time || filter.until < m_min_time)
+			{ return; }
+
+			for(auto const& entry : m_block_index)
+			{
+				if(entry.item_count == 0
+					|| filter.since > entry.max_time
+					|| filter.until < entry.min_time
+					|| (filter.client_id.has_value() && (entry.client_mask & client_mask_bit(*filter.client_id)) == 0))
+				{ continue; }
+
+				auto const block = decompress_block(entry);
+				auto const res = for_each_block_entry(block, [&filter, &func](record_view const& record) {
+					if(matches(filter, record))
+					{ func(record); }
+				});
+
+				if(!res)
+				{ throw std::runtime_error{std::format("{} contains a corrupt block", m_path.string())}; }
+			}
+		}
+
+	private:
+		std::filesystem::path m_path;
+		os_services::fs::file m_file;
+		os_services::memory::mapped_region m_mapping;
+		uint64_t m_sequence_number;
+		int64_t m_created;
+		size_t m_dictionary_offset;
+		size_t m_dictionary_size;
+
+		size_t m_item_count{0};
+		size_t m_uncompressed_size{0};
+		int64_t m_min_time{std::numeric_limits<int64_t>::max()};
+		int64_t m_max_time{std::numeric_limits<int64_t>::min()};
+		std::vector<block_index_entry> m_block_index;
+		std::unordered_map<uint32_t, std::string> m_client_names;
+		std::unordered_map<uint32_t, std::string> m_field_keys;
+	};
+}
+
+#endif
@@ -0,0 +1,154 @@
+//@	{"target":{"name":"archived_segment.test"}}
+
+#include "./archived_segment.hpp"
+
+#include "src/test_utils/temp_dir.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	Pipe::log_store::record_header make_header(
+		Pipe::log_store::record_type type,
+		uint32_t client_id,
+		int64_t when
+	)
+	{
+		return Pipe::log_store::record_header{
+			.size = 0,
+			.type = type,
+			.severity = static_cast<uint8_t>(
+				when % 3 == 0? Pipe::log::item::severity::error : Pipe::log::item::severity::info
+			),
+			.flags = 0,
+			.client_id = client_id,
+			.payload_size = 0,
+			.when = when
+		};
+	}
+
+	Pipe::log_store::segment make_segment(std::filesystem::path const& path, size_t item_count)
+	{
+		Pipe::log_store::segment ret{path, 7, 1024*1024, 64, Pipe::log::clock::time_point{}};
+		ret.try_append(make_header(Pipe::log_store::record_type::client_name, 0, 0), "foo");
+		ret.try_append(make_header(Pipe::log_store::record_type::client_name, 1, 0), "bar");
+		for(size_t k = 0; k != item_count; ++k)
+		{
+			auto const message = std::format("Processed request {} in {} ms", k % 128, k % 17);
+			ret.try_append(
+				make_header(Pipe::log_store::record_type::log_item, static_cast<uint32_t>(k % 2), static_cast<int64_t>(k)),
+				message
+			);
+		}
+		ret.seal();
+		return ret;
+	}
+
+	std::vector<int64_t> get_timestamps(auto const& segment, Pipe::log_store::record_filter const& filter)
+	{
+		std::vector<int64_t> ret;
+		segment.for_each_record(filter, [&ret](auto const& record) {
+			ret.push_back(record.header.when);
+		});
+		return ret;
+	}
+}
+
+TESTCASE(Pipe_log_store_archived_segment_write_and_open)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	auto const src = make_segment(dir.path()/"0.pipelog", 4096);
+	auto const path = dir.path()/"0.pipelogz";
+	Pipe::log_store::write_archive(
+		path,
+		src,
+		Pipe::log_store::archive_config{
+			.block_size = 4096,
+			.dictionary_size = 4096
+		}
+	);
+
+	Pipe::log_store::archived_segment archive{path};
+	EXPECT_EQ(archive.sequence_number(), 7);
+	EXPECT_EQ(archive.item_count(), 4096);
+	EXPECT_EQ(archive.min_time(), 0);
+	EXPECT_EQ(archive.max_time(), 4095);
+	EXPECT_EQ(std::size(archive.client_names()), 2);
+	EXPECT_EQ(archive.client_names().at(1), "bar");
+	EXPECT_GT(std::size(archive.block_index()), 1);
+	EXPECT_EQ(std::filesystem::file_size(path), archive.size());
+	EXPECT_LT(archive.size()*5, src.size());
+
+	Pipe::log_store::record_filter const all_items{};
+	EXPECT_EQ(get_timestamps(archive, all_items), get_timestamps(src, all_items));
+
+	Pipe::log_store::record_filter const errors_from_bar{
+		.client_id = 1,
+		.min_severity = Pipe::log::item::severity::error,
+		.since = 100,
+		.until = 120
+	};
+	EXPECT_EQ(get_timestamps(archive, errors_from_bar), (std::vector<int64_t>{105, 111, 117}));
+	EXPECT_EQ(get_timestamps(archive, errors_from_bar), get_timestamps(src, errors_from_bar));
+
+	std::vector<std::string> messages;
+	archive.for_each_record(
+		Pipe::log_store::record_filter{.client_id = 0, .since = 4094},
+		[&messages](auto const& record) {
+			messages.push_back(std::string{record.payload});
+		}
+	);
+	EXPECT_EQ(messages, (std::vector<std::string>{"Processed request 126 in 14 ms"}));
+}
+
+TESTCASE(Pipe_log_store_archived_segment_without_dictionary)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	auto const src = make_segment(dir.path()/"0.pipelog", 256);
+	auto const path = dir.path()/"0.pipelogz";
+	Pipe::log_store::write_archive(
+		path,
+		src,
+		Pipe::log_store::archive_config{
+			.block_size = 1024,
+			.dictionary_size = 0
+		}
+	);
+
+	Pipe::log_store::archived_segment archive{path};
+	EXPECT_EQ(std::size(archive.dictionary()), 0);
+	EXPECT_EQ(get_timestamps(archive, {}), get_timestamps(src, {}));
+}
+
+TESTCASE(Pipe_log_store_archived_segment_empty)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	auto const src = make_segment(dir.path()/"0.pipelog", 0);
+	auto const path = dir.path()/"0.pipelogz";
+	Pipe::log_store::write_archive(path, src, Pipe::log_store::archive_config{});
+
+	Pipe::log_store::archived_segment archive{path};
+	EXPECT_EQ(archive.item_count(), 0);
+	EXPECT_EQ(std::size(archive.block_index()), 0);
+	EXPECT_EQ(std::size(archive.client_names()), 2);
+	EXPECT_EQ(std::size(get_timestamps(archive, {})), 0);
+}
+
+TESTCASE(Pipe_log_store_archived_segment_bad_file)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	auto const src = make_segment(dir.path()/"0.pipelog", 16);
+
+	try
+	{
+		Pipe::log_store::archived_segment archive{src.path()};
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{
+		EXPECT_EQ(
+			err.what(),
+			std::format("{} is not a valid archived segment file", src.path().string())
+		);
+	}
+}
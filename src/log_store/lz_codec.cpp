@@ -0,0 +1,241 @@
+//@	{"target":{"name":"lz_codec.o"}}
+
+#include "./lz_codec.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+	constexpr size_t min_match_length = 4;
+	constexpr size_t max_match_offset = 65535;
+	constexpr size_t hash_bits = 14;
+	constexpr auto no_position = std::numeric_limits<uint32_t>::max();
+
+	uint32_t load_u32(std::byte const* ptr)
+	{
+		uint32_t ret{};
+		memcpy(&ret, ptr, sizeof(ret));
+		return ret;
+	}
+
+	size_t get_hash(std::byte const* ptr)
+	{ return static_cast<size_t>((load_u32(ptr)*2654435761u) >> (32 - hash_bits)); }
+
+	void write_length(std::vector<std::byte>& output, size_t length)
+	{
+		while(length >= 255)
+		{
+			output.push_back(std::byte{255});
+			length -= 255;
+		}
+		output.push_back(static_cast<std::byte>(length));
+	}
+
+	void write_sequence(
+		std::vector<std::byte>& output,
+		std::span<std::byte const> literals,
+		size_t match_length,
+		size_t match_offset
+	)
+	{
+		auto const literal_length = std::size(literals);
+		auto const match_code = match_length != 0? match_length - min_match_length : 0;
+		output.push_back(
+			static_cast<std::byte>((std::min(literal_length, size_t{15}) << 4) | std::min(match_code, size_t{15}))
+		);
+		if(literal_length >= 15)
+		{ write_length(output, literal_length - 15); }
+		output.insert(std::end(output), std::begin(literals), std::end(literals));
+
+		if(match_length == 0)
+		{ return; }
+
+		output.push_back(static_cast<std::byte>(match_offset & 0xff));
+		output.push_back(static_cast<std::byte>(match_offset >> 8));
+		if(match_code >= 15)
+		{ write_length(output, match_code - 15); }
+	}
+
+	size_t read_length(std::span<std::byte const> input, size_t& read_offset, size_t length)
+	{
+		if(length != 15)
+		{ return length; }
+
+		while(true)
+		{
+			if(read_offset == std::size(input))
+			{ throw std::runtime_error{"Compressed data is truncated"}; }
+
+			auto const val = std::to_integer<size_t>(input[read_offset]);
+			++read_offset;
+			length += val;
+			if(val != 255)
+			{ return length; }
+		}
+	}
+}
+
+std::vector<std::byte> Pipe::log_store::lz_compress(
+	std::span<std::byte const> input,
+	std::span<std::byte const> dictionary
+)
+{
+	// Work on a contiguous window, so back references into the dictionary are handled the same way
+	// as back references into input
+	std::vector<std::byte> window;
+	window.reserve(std::size(dictionary) + std::size(input));
+	window.insert(std::end(window), std::begin(dictionary), std::end(dictionary));
+	window.insert(std::end(window), std::begin(input), std::end(input));
+	if(std::size(window) > no_position)
+	{ throw std::runtime_error{"Input is too large to be compressed"}; }
+
+	std::vector<uint32_t> positions(size_t{1} << hash_bits, no_position);
+	auto const dict_size = std::size(dictionary);
+	for(size_t k = 0; k + min_match_length <= dict_size; ++k)
+	{ positions[get_hash(std::data(window) + k)] = static_cast<uint32_t>(k); }
+
+	std::vector<std::byte> ret;
+	ret.reserve(std::size(input)/2 + 16);
+	auto const end = std::size(window);
+	auto literal_start = dict_size;
+	auto pos = dict_size;
+	while(pos + min_match_length <= end)
+	{
+		auto const hash = get_hash(std::data(window) + pos);
+		auto const candidate = positions[hash];
+		positions[hash] = static_cast<uint32_t>(pos);
+
+		if(candidate == no_position
+			|| pos - candidate > max_match_offset
+			|| load_u32(std::data(window) + candidate) != load_u32(std::data(window) + pos))
+		{
+			++pos;
+			continue;
+		}
+
+		auto length = min_match_length;
+		while(pos + length != end && window[candidate + length] == window[pos + length])
+		{ ++length; }
+
+		write_sequence(
+			ret,
+			std::span{std::data(window) + literal_start, pos - literal_start},
+			length,
+			pos - candidate
+		);
+
+		// Make the end of the match available for later matches
+		auto const match_end = pos + length;
+		for(auto k = std::max(pos + 1, match_end - std::min(length, size_t{8})); k + min_match_length <= match_end; ++k)
+		{ positions[get_hash(std::data(window) + k)] = static_cast<uint32_t>(k); }
+
+		pos = match_end;
+		literal_start = pos;
+	}
+
+	write_sequence(ret, std::span{std::data(window) + literal_start, end - literal_start}, 0, 0);
+	return ret;
+}
+
+std::vector<std::byte> Pipe::log_store::lz_decompress(
+	std::span<std::byte const> input,
+	size_t decompressed_size,
+	std::span<std::byte const> dictionary
+)
+{
+	std::vector<std::byte> ret;
+	ret.reserve(decompressed_size);
+
+	auto const dict_size = std::size(dictionary);
+	size_t read_offset = 0;
+	while(read_offset != std::size(input))
+	{
+		auto const token = std::to_integer<size_t>(input[read_offset]);
+		++read_offset;
+
+		auto const literal_length = read_length(input, read_offset, token >> 4);
+		if(literal_length > std::size(input) - read_offset
+			|| literal_length > decompressed_size - std::size(ret))
+		{ throw std::runtime_error{"Compressed data is corrupt"}; }
+
+		ret.insert(
+			std::end(ret),
+			std::begin(input) + read_offset,
+			std::begin(input) + read_offset + literal_length
+		);
+		read_offset += literal_length;
+
+		// The last sequence does not have any back reference
+		if(read_offset == std::size(input))
+		{ break; }
+
+		if(std::size(input) - read_offset < 2)
+		{ throw std::runtime_error{"Compressed data is truncated"}; }
+
+		auto const match_offset = std::to_integer<size_t>(input[read_offset])
+			| (std::to_integer<size_t>(input[read_offset + 1]) << 8);
+		read_offset += 2;
+
+		auto const match_length = read_length(input, read_offset, token & 0xf) + min_match_length;
+		if(match_offset == 0
+			|| match_offset > std::size(ret) + dict_size
+			|| match_length > decompressed_size - std::size(ret))
+		{ throw std::runtime_error{"Compressed data is corrupt"}; }
+
+		// Copy byte by byte, since source and destination may overlap
+		for(size_t k = 0; k != match_length; ++k)
+		{
+			auto const src = std::size(ret) + dict_size - match_offset;
+			ret.push_back(src < dict_size? dictionary[src] : ret[src - dict_size]);
+		}
+	}
+
+	if(std::size(ret) != decompressed_size)
+	{ throw std::runtime_error{"Compressed data has an unexpected size"}; }
+
+	return ret;
+}
+
+std::vector<std::byte> Pipe::log_store::train_lz_dictionary(
+	std::span<std::string_view const> samples,
+	size_t max_size
+)
+{
+	std::unordered_map<std::string_view, size_t> counts;
+	for(auto const item : samples)
+	{
+		if(std::size(item) >= min_match_length)
+		{ ++counts[item]; }
+	}
+
+	std::vector<std::pair<std::string_view, size_t>> candidates{std::begin(counts), std::end(counts)};
+	std::ranges::sort(candidates, [](auto const& a, auto const& b) {
+		auto const a_score = a.second*std::size(a.first);
+		auto const b_score = b.second*std::size(b.first);
+		return a_score != b_score? a_score > b_score : a.first < b.first;
+	});
+
+	std::vector<std::string_view> selected;
+	size_t size = 0;
+	for(auto const& item : candidates)
+	{
+		if(size + std::size(item.first) > max_size)
+		{ continue; }
+		selected.push_back(item.first);
+		size += std::size(item.first);
+	}
+
+	std::vector<std::byte> ret;
+	ret.reserve(size);
+	for(auto k = std::rbegin(selected); k != std::rend(selected); ++k)
+	{
+		auto const bytes = std::as_bytes(std::span{*k});
+		ret.insert(std::end(ret), std::begin(bytes), std::end(bytes));
+	}
+	return ret;
+}
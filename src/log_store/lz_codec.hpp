@@ -0,0 +1,57 @@
+//@	{"dependencies_extra":[{"ref":"./lz_codec.o", "rel":"implementation"}]}
+
+#ifndef PIPE_LOG_STORE_LZ_CODEC_HPP
+#define PIPE_LOG_STORE_LZ_CODEC_HPP
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Pipe::log_store
+{
+	/**
+	 * \brief Compresses input using a byte-oriented LZ77 codec
+	 *
+	 * The output is a sequence of tokens, each holding a run of literals followed by a back
+	 * reference of at least four bytes. A back reference may point into dictionary, which makes it
+	 * possible to compress small blocks efficiently, as long as the same dictionary is used when
+	 * decompressing.
+	 *
+	 * \param input The data to compress
+	 * \param dictionary Data that is treated as if it preceded input
+	 */
+	std::vector<std::byte> lz_compress(
+		std::span<std::byte const> input,
+		std::span<std::byte const> dictionary = std::span<std::byte const>{}
+	);
+
+	/**
+	 * \brief Decompresses data produced by lz_compress
+	 *
+	 * \param input The compressed data
+	 * \param decompressed_size The size of the original data
+	 * \param dictionary The dictionary that was used when input was compressed
+	 *
+	 * \throw std::runtime_error if input is corrupt, or does not decompress to decompressed_size
+	 *        bytes
+	 */
+	std::vector<std::byte> lz_decompress(
+		std::span<std::byte const> input,
+		size_t decompressed_size,
+		std::span<std::byte const> dictionary = std::span<std::byte const>{}
+	);
+
+	/**
+	 * \brief Builds a dictionary for lz_compress from a set of samples
+	 *
+	 * Samples that occur often are considered more valuable than rare samples. The most valuable
+	 * samples are placed at the end of the dictionary.
+	 *
+	 * \param samples Typical data, such as log messages
+	 * \param max_size The max size of the dictionary
+	 */
+	std::vector<std::byte> train_lz_dictionary(std::span<std::string_view const> samples, size_t max_size);
+}
+
+#endif
@@ -0,0 +1,136 @@
+//@	{"target":{"name":"lz_codec.test"}}
+
+#include "./lz_codec.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <format>
+#include <random>
+#include <string>
+
+namespace
+{
+	std::span<std::byte const> as_bytes(std::string_view str)
+	{ return std::as_bytes(std::span{str}); }
+
+	std::string make_log_text(size_t count)
+	{
+		std::string ret;
+		for(size_t k = 0; k != count; ++k)
+		{ ret += std::format("Processed request {} from worker {} in {} ms\n", 1000 + k, k % 4, k % 17); }
+		return ret;
+	}
+}
+
+TESTCASE(Pipe_log_store_lz_codec_empty)
+{
+	auto const compressed = Pipe::log_store::lz_compress(std::span<std::byte const>{});
+	EXPECT_EQ(std::size(compressed), 1);
+	EXPECT_EQ(std::size(Pipe::log_store::lz_decompress(compressed, 0)), 0);
+}
+
+TESTCASE(Pipe_log_store_lz_codec_roundtrip_repetitive)
+{
+	auto const text = make_log_text(1000);
+	auto const compressed = Pipe::log_store::lz_compress(as_bytes(text));
+	EXPECT_LT(std::size(compressed)*5, std::size(text));
+
+	auto const decompressed = Pipe::log_store::lz_decompress(compressed, std::size(text));
+	EXPECT_EQ(
+		(std::string_view{reinterpret_cast<char const*>(std::data(decompressed)), std::size(decompressed)}),
+		text
+	);
+}
+
+TESTCASE(Pipe_log_store_lz_codec_roundtrip_random)
+{
+	std::mt19937 rng;
+	std::vector<std::byte> data(100000);
+	for(auto& item : data)
+	{ item = static_cast<std::byte>(rng()); }
+
+	auto const compressed = Pipe::log_store::lz_compress(data);
+	EXPECT_EQ(Pipe::log_store::lz_decompress(compressed, std::size(data)), data);
+}
+
+TESTCASE(Pipe_log_store_lz_codec_roundtrip_long_runs)
+{
+	std::vector<std::byte> data(70000, std::byte{'A'});
+	data.push_back(std::byte{'B'});
+	data.insert(std::end(data), 300, std::byte{'C'});
+
+	auto const compressed = Pipe::log_store::lz_compress(data);
+	EXPECT_LT(std::size(compressed), 1024);
+	EXPECT_EQ(Pipe::log_store::lz_decompress(compressed, std::size(data)), data);
+}
+
+TESTCASE(Pipe_log_store_lz_codec_dictionary)
+{
+	auto const text = make_log_text(8);
+	std::array const samples{std::string_view{text}};
+	auto const dictionary = Pipe::log_store::train_lz_dictionary(samples, 4096);
+	EXPECT_EQ(std::size(dictionary), std::size(text));
+
+	auto const block = make_log_text(4);
+	auto const with_dictionary = Pipe::log_store::lz_compress(as_bytes(block), dictionary);
+	auto const without_dictionary = Pipe::log_store::lz_compress(as_bytes(block));
+	EXPECT_LT(std::size(with_dictionary), std::size(without_dictionary));
+
+	auto const decompressed = Pipe::log_store::lz_decompress(with_dictionary, std::size(block), dictionary);
+	EXPECT_EQ(
+		(std::string_view{reinterpret_cast<char const*>(std::data(decompressed)), std::size(decompressed)}),
+		block
+	);
+
+	try
+	{
+		std::ignore = Pipe::log_store::lz_decompress(with_dictionary, std::size(block));
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Compressed data is corrupt"}); }
+}
+
+TESTCASE(Pipe_log_store_lz_codec_train_dictionary_prefers_frequent_samples)
+{
+	std::array const samples{
+		std::string_view{"Rare message"},
+		std::string_view{"Frequent"},
+		std::string_view{"Frequent"},
+		std::string_view{"Frequent"},
+		std::string_view{"x"}
+	};
+
+	auto const dictionary = Pipe::log_store::train_lz_dictionary(samples, 20);
+	EXPECT_EQ(
+		(std::string_view{reinterpret_cast<char const*>(std::data(dictionary)), std::size(dictionary)}),
+		"Rare messageFrequent"
+	);
+
+	auto const small_dictionary = Pipe::log_store::train_lz_dictionary(samples, 10);
+	EXPECT_EQ(
+		(std::string_view{reinterpret_cast<char const*>(std::data(small_dictionary)), std::size(small_dictionary)}),
+		"Frequent"
+	);
+}
+
+TESTCASE(Pipe_log_store_lz_codec_wrong_size)
+{
+	auto const text = make_log_text(10);
+	auto const compressed = Pipe::log_store::lz_compress(as_bytes(text));
+
+	try
+	{
+		std::ignore = Pipe::log_store::lz_decompress(compressed, std::size(text) + 1);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Compressed data has an unexpected size"}); }
+
+	try
+	{
+		std::ignore = Pipe::log_store::lz_decompress(compressed, std::size(text) - 1);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Compressed data is corrupt"}); }
+}
@@ -0,0 +1,308 @@
+#ifndef PIPE_LOG_STORE_RECORD_HPP
+#define PIPE_LOG_STORE_RECORD_HPP
+
+#include "src/log/log.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief An indexed on-disk store for decoded log items
+ */
+namespace Pipe::log_store
+{
+	/**
+	 * \brief Identifies the kind of data stored in a record
+	 */
+	enum class record_type:uint16_t
+	{
+		/**
+		 * \brief The record holds a log item
+		 */
+		log_item = 1,
+
+		/**
+		 * \brief The record defines the name of a client. Each segment defines the names of all
+		 *        clients it refers to, before they are used, so a segment can be decoded on its own.
+		 */
+		client_name = 2,
+
+		/**
+		 * \brief The record defines the name of a field key. Like client names, each segment
+		 *        defines all field keys it refers to, before they are used.
+		 */
+		field_key = 3
+	};
+
+	/**
+	 * \brief Set in record_header::flags if the payload of a log_item record starts with a field
+	 *        section
+	 */
+	constexpr uint8_t has_fields_flag = 0x1;
+
+	/**
+	 * \brief The fixed part of a record
+	 *
+	 * The header is followed by payload_size bytes of payload (the log message, the client name, or
+	 * the field key definition), and padding up to the next multiple of record_alignment. A header
+	 * with size set to zero marks the end of a segment.
+	 */
+	struct record_header
+	{
+		uint32_t size;
+		record_type type;
+		uint8_t severity;
+		uint8_t flags;
+		uint32_t client_id;
+		uint32_t payload_size;
+		int64_t when;
+	};
+
+	static_assert(sizeof(record_header) == 24);
+	static_assert(std::is_trivially_copyable_v<record_header>);
+
+	/**
+	 * \brief The alignment of each record within a segment
+	 */
+	constexpr size_t record_alignment = alignof(record_header);
+
+	/**
+	 * \brief Computes the total size of a record with payload_size bytes of payload
+	 */
+	constexpr size_t record_size(size_t payload_size)
+	{
+		auto const size = sizeof(record_header) + payload_size;
+		return (size + record_alignment - 1)/record_alignment*record_alignment;
+	}
+
+	/**
+	 * \brief Converts a log::clock::time_point to the representation used in a record_header
+	 */
+	constexpr int64_t to_record_time(log::clock::time_point t)
+	{ return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count(); }
+
+	/**
+	 * \brief Converts the representation used in a record_header to a log::clock::time_point
+	 */
+	constexpr log::clock::time_point from_record_time(int64_t t)
+	{
+		return log::clock::time_point{}
+			+ std::chrono::duration_cast<log::clock::duration>(std::chrono::nanoseconds{t});
+	}
+
+	/**
+	 * \brief A decoded record, referring to the memory it was decoded from
+	 */
+	struct record_view
+	{
+		record_header header;
+		std::string_view payload;
+	};
+
+	/**
+	 * \brief Appends value to output, using 7 bits per byte
+	 */
+	inline void write_varint(std::vector<std::byte>& output, uint64_t value)
+	{
+		while(value >= 0x80)
+		{
+			output.push_back(static_cast<std::byte>((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
+		output.push_back(static_cast<std::byte>(value));
+	}
+
+	/**
+	 * \brief Reads a value written by write_varint from input, starting at offset
+	 * \return The decoded value, or an empty optional if input is truncated
+	 */
+	inline std::optional<uint64_t> read_varint(std::span<std::byte const> input, size_t& offset)
+	{
+		uint64_t ret = 0;
+		for(unsigned int shift = 0; shift < 64 && offset != std::size(input); shift += 7)
+		{
+			auto const val = std::to_integer<uint64_t>(input[offset]);
+			++offset;
+			ret |= (val & 0x7f) << shift;
+			if((val & 0x80) == 0)
+			{ return ret; }
+		}
+		return std::nullopt;
+	}
+
+	/**
+	 * \brief Writes a record to output
+	 * \pre std::size(output) >= record_size(std::size(payload))
+	 * \return The number of bytes written
+	 */
+	inline size_t write_record(std::span<std::byte> output, record_header header, std::string_view payload)
+	{
+		auto const size = record_size(std::size(payload));
+		header.size = static_cast<uint32_t>(size);
+		header.payload_size = static_cast<uint32_t>(std::size(payload));
+		memcpy(std::data(output), &header, sizeof(header));
+		memcpy(std::data(output) + sizeof(header), std::data(payload), std::size(payload));
+		memset(
+			std::data(output) + sizeof(header) + std::size(payload),
+			0,
+			size - sizeof(header) - std::size(payload)
+		);
+		return size;
+	}
+
+	/**
+	 * \brief Reads a record from input
+	 * \return The decoded record, or an empty optional if input does not start with a complete
+	 *         record
+	 */
+	inline std::optional<record_view> read_record(std::span<std::byte const> input)
+	{
+		if(std::size(input) < sizeof(record_header))
+		{ return std::nullopt; }
+
+		record_header header{};
+		memcpy(&header, std::data(input), sizeof(header));
+		if(header.size == 0 || header.size > std::size(input)
+			|| record_size(header.payload_size) != header.size)
+		{ return std::nullopt; }
+
+		return record_view{
+			.header = header,
+			.payload = std::string_view{
+				reinterpret_cast<char const*>(std::data(input) + sizeof(header)),
+				header.payload_size
+			}
+		};
+	}
+
+	/**
+	 * \brief A field of a log item, with its key replaced by a key id
+	 */
+	struct encoded_field
+	{
+		uint32_t key_id;
+		std::string_view value;
+	};
+
+	/**
+	 * \brief Creates the payload of a log_item record
+	 *
+	 * If there are any fields, the payload starts with the size of the field section. For each
+	 * field, the field section holds the key id, the size of the value, and the value. The
+	 * message follows the field section. Since key ids are small, a key typically occupies one
+	 * byte.
+	 *
+	 * \note The has_fields_flag must be set in the header of the record if fields is non-empty
+	 */
+	inline std::string make_log_item_payload(std::span<encoded_field const> fields, std::string_view message)
+	{
+		if(fields.empty())
+		{ return std::string{message}; }
+
+		std::vector<std::byte> field_section;
+		for(auto const& field : fields)
+		{
+			write_varint(field_section, field.key_id);
+			write_varint(field_section, std::size(field.value));
+			auto const value = std::as_bytes(std::span{field.value});
+			field_section.insert(std::end(field_section), std::begin(value), std::end(value));
+		}
+
+		std::vector<std::byte> ret;
+		ret.reserve(std::size(field_section) + std::size(message) + 4);
+		write_varint(ret, std::size(field_section));
+		ret.insert(std::end(ret), std::begin(field_section), std::end(field_section));
+		auto const message_bytes = std::as_bytes(std::span{message});
+		ret.insert(std::end(ret), std::begin(message_bytes), std::end(message_bytes));
+		return std::string{reinterpret_cast<char const*>(std::data(ret)), std::size(ret)};
+	}
+
+	/**
+	 * \brief The payload of a log_item record, split into its field section and its message
+	 */
+	struct log_item_payload
+	{
+		std::span<std::byte const> fields;
+		std::string_view message;
+	};
+
+	/**
+	 * \brief Splits the payload of the log_item record into its field section and its message
+	 * \return The split payload, or an empty optional if the field section is corrupt
+	 */
+	inline std::optional<log_item_payload> split_log_item_payload(record_view const& record)
+	{
+		if((record.header.flags & has_fields_flag) == 0)
+		{ return log_item_payload{.fields = {}, .message = record.payload}; }
+
+		auto const payload = std::as_bytes(std::span{record.payload});
+		size_t offset = 0;
+		auto const fields_size = read_varint(payload, offset);
+		if(!fields_size.has_value() || *fields_size > std::size(payload) - offset)
+		{ return std::nullopt; }
+
+		return log_item_payload{
+			.fields = payload.subspan(offset, *fields_size),
+			.message = record.payload.substr(offset + *fields_size)
+		};
+	}
+
+	/**
+	 * \brief Calls func with the key id and the value of each field in a field section
+	 * \return false if the field section is corrupt
+	 */
+	template<class Func>
+	bool for_each_field(std::span<std::byte const> fields, Func&& func)
+	{
+		size_t offset = 0;
+		while(offset != std::size(fields))
+		{
+			auto const key_id = read_varint(fields, offset);
+			auto const value_size = read_varint(fields, offset);
+			if(!key_id.has_value() || !value_size.has_value() || *value_size > std::size(fields) - offset)
+			{ return false; }
+
+			func(
+				static_cast<uint32_t>(*key_id),
+				std::string_view{reinterpret_cast<char const*>(std::data(fields) + offset), *value_size}
+			);
+			offset += *value_size;
+		}
+		return true;
+	}
+
+	/**
+	 * \brief Creates the payload of a field_key record
+	 *
+	 * The payload holds the key id, followed by the name of the key.
+	 */
+	inline std::string make_field_key_payload(uint32_t key_id, std::string_view key)
+	{
+		std::vector<std::byte> ret;
+		write_varint(ret, key_id);
+		auto const key_bytes = std::as_bytes(std::span{key});
+		ret.insert(std::end(ret), std::begin(key_bytes), std::end(key_bytes));
+		return std::string{reinterpret_cast<char const*>(std::data(ret)), std::size(ret)};
+	}
+
+	/**
+	 * \brief Decodes the payload of a field_key record
+	 * \return The key id and the name of the key, or an empty optional if the payload is corrupt
+	 */
+	inline std::optional<std::pair<uint32_t, std::string_view>> read_field_key_payload(std::string_view payload)
+	{
+		size_t offset = 0;
+		auto const key_id = read_varint(std::as_bytes(std::span{payload}), offset);
+		if(!key_id.has_value())
+		{ return std::nullopt; }
+		return std::pair{static_cast<uint32_t>(*key_id), payload.substr(offset)};
+	}
+}
+
+#endif
@@ -0,0 +1,165 @@
+//@	{"target":{"name":"segment.o"}}
+
+#include "./segment.hpp"
+
+Pipe::log_store::segment::segment(
+	std::filesystem::path const& path,
+	uint64_t sequence_number,
+	size_t capacity,
+	size_t time_index_interval,
+	log::clock::time_point now
+):
+	m_path{path},
+	m_file{os_services::fs::create(path)},
+	m_capacity{std::max(capacity, sizeof(segment_header))},
+	m_used{sizeof(segment_header)},
+	m_time_index_interval{std::max(time_index_interval, static_cast<size_t>(1))},
+	m_sequence_number{sequence_number},
+	m_created{to_record_time(now)},
+	m_sealed{false}
+{
+	if(m_capacity > std::numeric_limits<uint32_t>::max())
+	{ throw std::runtime_error{"Segment capacity is too large"}; }
+
+	os_services::fs::truncate(m_file.get(), m_capacity);
+	m_mapping = os_services::memory::mapped_region{
+		m_file.get(),
+		m_capacity,
+		os_services::memory::access_mode::read_write
+	};
+
+	segment_header const header{
+		.magic = segment_magic,
+		.version = segment_version,
+		.reserved = 0,
+		.sequence_number = m_sequence_number,
+		.created = m_created
+	};
+	memcpy(m_mapping.data(), &header, sizeof(header));
+}
+
+Pipe::log_store::segment::segment(std::filesystem::path const& path, size_t time_index_interval):
+	m_path{path},
+	m_file{os_services::fs::open(path, os_services::fs::open_mode::read_only)},
+	m_capacity{os_services::fs::get_size(m_file.get())},
+	m_used{sizeof(segment_header)},
+	m_time_index_interval{std::max(time_index_interval, static_cast<size_t>(1))},
+	m_sequence_number{0},
+	m_created{0},
+	m_sealed{true}
+{
+	if(m_capacity < sizeof(segment_header) || m_capacity > std::numeric_limits<uint32_t>::max())
+	{ throw std::runtime_error{std::format("{} is not a valid segment file", path.string())}; }
+
+	m_mapping = os_services::memory::mapped_region{
+		m_file.get(),
+		m_capacity,
+		os_services::memory::access_mode::read_only
+	};
+
+	segment_header header{};
+	memcpy(&header, m_mapping.data(), sizeof(header));
+	if(header.magic != segment_magic || header.version == 0 || header.version > segment_version)
+	{ throw std::runtime_error{std::format("{} is not a valid segment file", path.string())}; }
+
+	m_sequence_number = header.sequence_number;
+	m_created = header.created;
+	rebuild_index();
+}
+
+bool Pipe::log_store::segment::try_append(record_header const& header, std::string_view payload)
+{
+	if(record_size(std::size(payload)) > free_space())
+	{ return false; }
+
+	auto const offset = static_cast<uint32_t>(m_used);
+	m_used += write_record(m_mapping.bytes().subspan(m_used), header, payload);
+	index_record(
+		record_view{
+			.header = header,
+			.payload = payload
+		},
+		offset
+	);
+	return true;
+}
+
+void Pipe::log_store::segment::seal()
+{
+	if(m_sealed)
+	{ return; }
+
+	// Sealing happens on the thread that appends items, so do not wait for the disk
+	m_mapping.sync(os_services::memory::sync_mode::schedule);
+	m_mapping.reset();
+	os_services::fs::truncate(m_file.get(), m_used);
+	m_capacity = m_used;
+	m_mapping = os_services::memory::mapped_region{
+		m_file.get(),
+		m_capacity,
+		os_services::memory::access_mode::read_only
+	};
+	m_sealed = true;
+}
+
+void Pipe::log_store::segment::index_record(record_view const& record, uint32_t offset)
+{
+	if(m_record_count % m_time_index_interval == 0)
+	{
+		m_time_index.push_back(
+			time_index_entry{
+				.max_time_before = m_max_time,
+				.offset = offset
+			}
+		);
+	}
+	++m_record_count;
+
+	switch(record.header.type)
+	{
+		case record_type::client_name:
+			m_client_names.insert_or_assign(record.header.client_id, std::string{record.payload});
+			break;
+
+		case record_type::field_key:
+			if(auto const key = read_field_key_payload(record.payload); key.has_value())
+			{ m_field_keys.insert_or_assign(key->first, std::string{key->second}); }
+			break;
+
+		case record_type::log_item:
+			m_client_index[record.header.client_id].push_back(offset);
+			m_min_time = std::min(m_min_time, record.header.when);
+			m_max_time = std::max(m_max_time, record.header.when);
+			++m_item_count;
+			break;
+	}
+}
+
+void Pipe::log_store::segment::rebuild_index()
+{
+	auto const data = m_mapping.bytes();
+	while(m_used < m_capacity)
+	{
+		auto const record = read_record(data.subspan(m_used));
+		if(!record.has_value())
+		{ break; }
+
+		index_record(*record, static_cast<uint32_t>(m_used));
+		m_used += record->header.size;
+	}
+}
+
+uint32_t Pipe::log_store::segment::find_start_offset(int64_t since) const
+{
+	auto const i = std::ranges::partition_point(
+		m_time_index,
+		[since](auto const& item) {
+			return item.max_time_before < since;
+		}
+	);
+
+	if(i == std::begin(m_time_index))
+	{ return static_cast<uint32_t>(sizeof(segment_header)); }
+
+	return (i - 1)->offset;
+}
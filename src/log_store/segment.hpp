@@ -0,0 +1,341 @@
+//@	{"dependencies_extra":[{"ref":"./segment.o", "rel":"implementation"}]}
+
+#ifndef PIPE_LOG_STORE_SEGMENT_HPP
+#define PIPE_LOG_STORE_SEGMENT_HPP
+
+#include "./record.hpp"
+#include "src/os_services/fs/file.hpp"
+#include "src/os_services/memory/mapped_region.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace Pipe::log_store
+{
+	/**
+	 * \brief The header at the start of each segment file
+	 */
+	struct segment_header
+	{
+		std::array<char, 8> magic;
+		uint32_t version;
+		uint32_t reserved;
+		uint64_t sequence_number;
+		int64_t created;
+	};
+
+	static_assert(sizeof(segment_header) == 32);
+
+	/**
+	 * \brief The magic number that identifies a segment file
+	 */
+	constexpr std::array<char, 8> segment_magic{'P', 'I', 'P', 'E', 'L', 'O', 'G', 'S'};
+
+	/**
+	 * \brief The current version of the segment file format
+	 *
+	 * Version 2 added record flags and field_key records. Files of version 1 can still be read.
+	 */
+	constexpr uint32_t segment_version = 2;
+
+	/**
+	 * \brief An entry in the sparse time index of a segment
+	 */
+	struct time_index_entry
+	{
+		/**
+		 * \brief The latest timestamp of all records before offset. Since timestamps are provided
+		 *        by clients, they are not guaranteed to be monotonic, but this value is.
+		 */
+		int64_t max_time_before;
+
+		/**
+		 * \brief The offset of a record within the segment
+		 */
+		uint32_t offset;
+	};
+
+	/**
+	 * \brief Selects log item records within a segment
+	 */
+	struct record_filter
+	{
+		/**
+		 * \brief If set, only records from this client are selected
+		 */
+		std::optional<uint32_t> client_id{};
+
+		/**
+		 * \brief The lowest severity to select
+		 */
+		enum log::item::severity min_severity{log::item::severity::info};
+
+		/**
+		 * \brief The earliest timestamp to select, in the representation used by record_header
+		 */
+		int64_t since{std::numeric_limits<int64_t>::min()};
+
+		/**
+		 * \brief The latest timestamp to select, in the representation used by record_header
+		 */
+		int64_t until{std::numeric_limits<int64_t>::max()};
+
+		/**
+		 * \brief If set, only records with a field with this key id, and the value field_value,
+		 *        are selected
+		 */
+		std::optional<uint32_t> field_key{};
+
+		/**
+		 * \brief The field value to select, if field_key is set
+		 */
+		std::string_view field_value{};
+	};
+
+	/**
+	 * \brief Checks whether or not the record described by header is selected by filter
+	 */
+	constexpr bool matches(record_filter const& filter, record_header const& header)
+	{
+		return header.type == record_type::log_item
+			&& (!filter.client_id.has_value() || header.client_id == *filter.client_id)
+			&& header.when >= filter.since
+			&& header.when <= filter.until
+			&& header.severity >= static_cast<uint8_t>(filter.min_severity);
+	}
+
+	/**
+	 * \brief Checks whether or not record is selected by filter
+	 *
+	 * Fields are compared by key id, so the message does not have to be inspected.
+	 */
+	inline bool matches(record_filter const& filter, record_view const& record)
+	{
+		if(!matches(filter, record.header))
+		{ return false; }
+
+		if(!filter.field_key.has_value())
+		{ return true; }
+
+		auto const payload = split_log_item_payload(record);
+		if(!payload.has_value())
+		{ return false; }
+
+		auto found = false;
+		for_each_field(payload->fields, [&filter, &found](uint32_t key_id, std::string_view value) {
+			found = found || (key_id == *filter.field_key && value == filter.field_value);
+		});
+		return found;
+	}
+
+	/**
+	 * \brief A memory-mapped segment file, containing a sequence of records
+	 *
+	 * A segment is either active or sealed. An active segment has a fixed capacity, and records are
+	 * appended directly into the mapped file. When a segment is sealed, the file is truncated to the
+	 * space actually used, and it is mapped read-only.
+	 */
+	class segment
+	{
+	public:
+		/**
+		 * \brief Creates a new active segment
+		 * \param path The path of the file to create
+		 * \param sequence_number A number used to order segments
+		 * \param capacity The max size of the segment file
+		 * \param time_index_interval The number of records between two entries in the time index
+		 * \param now The current time
+		 */
+		explicit segment(
+			std::filesystem::path const& path,
+			uint64_t sequence_number,
+			size_t capacity,
+			size_t time_index_interval,
+			log::clock::time_point now
+		);
+
+		/**
+		 * \brief Opens an existing segment file as a sealed segment, and rebuilds its indices
+		 * \param path The path of the file to open
+		 * \param time_index_interval The number of records between two entries in the time index
+		 */
+		explicit segment(std::filesystem::path const& path, size_t time_index_interval);
+
+		/**
+		 * \brief Tries to append a record
+		 * \return false if the segment has been sealed, or if the record does not fit
+		 */
+		bool try_append(record_header const& header, std::string_view payload);
+
+		/**
+		 * \brief Returns the number of bytes that can be appended to the segment
+		 */
+		size_t free_space() const noexcept
+		{ return m_sealed? 0 : m_capacity - m_used; }
+
+		/**
+		 * \brief Seals the segment, so no more records can be appended
+		 *
+		 * Writeback of the segment file is started, but not waited for.
+		 */
+		void seal();
+
+		/**
+		 * \brief Checks whether or not the segment has been sealed
+		 */
+		bool is_sealed() const noexcept
+		{ return m_sealed; }
+
+		/**
+		 * \brief Checks whether or not the segment contains a client_name record for client_id
+		 */
+		bool defines_client(uint32_t client_id) const
+		{ return m_client_names.contains(client_id); }
+
+		/**
+		 * \brief Returns all client names defined in this segment
+		 */
+		auto const& client_names() const noexcept
+		{ return m_client_names; }
+
+		/**
+		 * \brief Checks whether or not the segment contains a field_key record for key_id
+		 */
+		bool defines_field_key(uint32_t key_id) const
+		{ return m_field_keys.contains(key_id); }
+
+		/**
+		 * \brief Returns all field keys defined in this segment
+		 */
+		auto const& field_keys() const noexcept
+		{ return m_field_keys; }
+
+		/**
+		 * \brief Returns the path of the segment file
+		 */
+		std::filesystem::path const& path() const noexcept
+		{ return m_path; }
+
+		/**
+		 * \brief Returns the sequence number of the segment
+		 */
+		uint64_t sequence_number() const noexcept
+		{ return m_sequence_number; }
+
+		/**
+		 * \brief Returns the time the segment was created
+		 */
+		log::clock::time_point created() const noexcept
+		{ return from_record_time(m_created); }
+
+		/**
+		 * \brief Returns the latest timestamp of all log items within the segment
+		 */
+		int64_t max_time() const noexcept
+		{ return m_max_time; }
+
+		/**
+		 * \brief Returns the earliest timestamp of all log items within the segment
+		 */
+		int64_t min_time() const noexcept
+		{ return m_min_time; }
+
+		/**
+		 * \brief Returns the number of bytes used by the segment
+		 */
+		size_t size() const noexcept
+		{ return m_used; }
+
+		/**
+		 * \brief Returns the number of log items in the segment
+		 */
+		size_t item_count() const noexcept
+		{ return m_item_count; }
+
+		/**
+		 * \brief Returns the raw content of the segment, excluding the segment header
+		 */
+		std::span<std::byte const> records() const noexcept
+		{ return m_mapping.bytes().subspan(sizeof(segment_header), m_used - sizeof(segment_header)); }
+
+		/**
+		 * \brief Returns the sparse time index
+		 */
+		std::span<time_index_entry const> time_index() const noexcept
+		{ return m_time_index; }
+
+		/**
+		 * \brief Calls func for each log item record that matches filter, in storage order
+		 */
+		template<class Func>
+		void for_each_record(record_filter const& filter, Func&& func) const
+		{
+			if(m_item_count == 0 || filter.since > m_max_time || filter.until < m_min_time)
+			{ return; }
+
+			auto const start_at = find_start_offset(filter.since);
+			auto const process = [&filter, &func](record_view const& record) {
+				if(matches(filter, record))
+				{ func(record); }
+			};
+
+			auto const data = m_mapping.bytes().first(m_used);
+			if(filter.client_id.has_value())
+			{
+				auto const i = m_client_index.find(*filter.client_id);
+				if(i == std::end(m_client_index))
+				{ return; }
+
+				auto const& offsets = i->second;
+				for(auto k = std::ranges::lower_bound(offsets, start_at); k != std::end(offsets); ++k)
+				{
+					auto const record = read_record(data.subspan(*k));
+					if(!record.has_value())
+					{ return; }
+
+					process(*record);
+				}
+				return;
+			}
+
+			auto offset = start_at;
+			while(offset < m_used)
+			{
+				auto const record = read_record(data.subspan(offset));
+				if(!record.has_value())
+				{ return; }
+				process(*record);
+				offset += record->header.size;
+			}
+		}
+
+	private:
+		void index_record(record_view const& record, uint32_t offset);
+		void rebuild_index();
+		uint32_t find_start_offset(int64_t since) const;
+
+		std::filesystem::path m_path;
+		os_services::fs::file m_file;
+		os_services::memory::mapped_region m_mapping;
+		size_t m_capacity;
+		size_t m_used;
+		size_t m_time_index_interval;
+		uint64_t m_sequence_number;
+		int64_t m_created;
+		bool m_sealed;
+
+		size_t m_item_count{0};
+		size_t m_record_count{0};
+		int64_t m_min_time{std::numeric_limits<int64_t>::max()};
+		int64_t m_max_time{std::numeric_limits<int64_t>::min()};
+		std::vector<time_index_entry> m_time_index;
+		std::unordered_map<uint32_t, std::vector<uint32_t>> m_client_index;
+		std::unordered_map<uint32_t, std::string> m_client_names;
+		std::unordered_map<uint32_t, std::string> m_field_keys;
+	};
+}
+
+#endif
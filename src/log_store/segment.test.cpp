@@ -0,0 +1,139 @@
+//@	{"target":{"name":"segment.test"}}
+
+#include "./segment.hpp"
+
+#include "src/test_utils/temp_dir.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	Pipe::log_store::record_header make_item_header(uint32_t client_id, int64_t when)
+	{
+		return Pipe::log_store::record_header{
+			.size = 0,
+			.type = Pipe::log_store::record_type::log_item,
+			.severity = static_cast<uint8_t>(Pipe::log::item::severity::info),
+			.flags = 0,
+			.client_id = client_id,
+			.payload_size = 0,
+			.when = when
+		};
+	}
+}
+
+TESTCASE(Pipe_log_store_record_write_and_read)
+{
+	std::array<std::byte, 64> buffer{};
+	auto const size = Pipe::log_store::write_record(buffer, make_item_header(3, 1234), "Hello");
+	EXPECT_EQ(size, 32);
+
+	auto const record = Pipe::log_store::read_record(std::span{buffer}.first(size));
+	REQUIRE_EQ(record.has_value(), true);
+	EXPECT_EQ(record->header.client_id, 3);
+	EXPECT_EQ(record->header.when, 1234);
+	EXPECT_EQ(record->header.size, 32);
+	EXPECT_EQ(record->payload, "Hello");
+
+	EXPECT_EQ(Pipe::log_store::read_record(std::span{buffer}.first(size - 1)).has_value(), false);
+	EXPECT_EQ(Pipe::log_store::read_record(std::span{buffer}.subspan(size)).has_value(), false);
+}
+
+TESTCASE(Pipe_log_store_record_log_item_payload_with_fields)
+{
+	std::array<Pipe::log_store::encoded_field, 2> const fields{
+		Pipe::log_store::encoded_field{.key_id = 0, .value = "1234"},
+		Pipe::log_store::encoded_field{.key_id = 300, .value = "200"}
+	};
+	auto const payload = Pipe::log_store::make_log_item_payload(fields, "Hello");
+
+	// One byte for the size of the field section, and one or two bytes per key id
+	EXPECT_EQ(std::size(payload), 1 + (1 + 1 + 4) + (2 + 1 + 3) + 5);
+
+	auto header = make_item_header(3, 1234);
+	header.flags = Pipe::log_store::has_fields_flag;
+	auto const split = Pipe::log_store::split_log_item_payload(
+		Pipe::log_store::record_view{.header = header, .payload = payload}
+	);
+	REQUIRE_EQ(split.has_value(), true);
+	EXPECT_EQ(split->message, "Hello");
+
+	std::vector<std::pair<uint32_t, std::string>> decoded_fields;
+	auto const res = Pipe::log_store::for_each_field(split->fields, [&decoded_fields](uint32_t key_id, std::string_view value) {
+		decoded_fields.push_back(std::pair{key_id, std::string{value}});
+	});
+	EXPECT_EQ(res, true);
+	REQUIRE_EQ(std::size(decoded_fields), 2);
+	EXPECT_EQ(decoded_fields[0].first, 0);
+	EXPECT_EQ(decoded_fields[0].second, "1234");
+	EXPECT_EQ(decoded_fields[1].first, 300);
+	EXPECT_EQ(decoded_fields[1].second, "200");
+
+	// Without the flag, the payload is the message
+	auto const plain = Pipe::log_store::split_log_item_payload(
+		Pipe::log_store::record_view{.header = make_item_header(3, 1234), .payload = "Hello"}
+	);
+	REQUIRE_EQ(plain.has_value(), true);
+	EXPECT_EQ(plain->message, "Hello");
+	EXPECT_EQ(std::size(plain->fields), 0);
+}
+
+TESTCASE(Pipe_log_store_segment_append_seal_and_reopen)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	auto const path = dir.path()/"0.pipelog";
+	{
+		Pipe::log_store::segment segment{path, 0, 4096, 4, Pipe::log::clock::time_point{}};
+		EXPECT_EQ(segment.is_sealed(), false);
+		EXPECT_EQ(segment.size(), sizeof(Pipe::log_store::segment_header));
+
+		for(int64_t k = 0; k != 16; ++k)
+		{ EXPECT_EQ(segment.try_append(make_item_header(static_cast<uint32_t>(k % 2), k), "Item"), true); }
+
+		EXPECT_EQ(segment.item_count(), 16);
+		EXPECT_EQ(segment.min_time(), 0);
+		EXPECT_EQ(segment.max_time(), 15);
+		EXPECT_EQ(std::size(segment.time_index()), 4);
+
+		segment.seal();
+		EXPECT_EQ(segment.is_sealed(), true);
+		EXPECT_EQ(segment.free_space(), 0);
+		EXPECT_EQ(segment.try_append(make_item_header(0, 16), "Item"), false);
+		EXPECT_EQ(std::filesystem::file_size(path), segment.size());
+	}
+
+	Pipe::log_store::segment segment{path, 4};
+	EXPECT_EQ(segment.is_sealed(), true);
+	EXPECT_EQ(segment.item_count(), 16);
+	EXPECT_EQ(std::size(segment.time_index()), 4);
+
+	std::vector<int64_t> timestamps;
+	segment.for_each_record(
+		Pipe::log_store::record_filter{
+			.client_id = 1,
+			.min_severity = Pipe::log::item::severity::info,
+			.since = 6,
+			.until = 11
+		},
+		[&timestamps](auto const& record) {
+			timestamps.push_back(record.header.when);
+		}
+	);
+	EXPECT_EQ(timestamps, (std::vector<int64_t>{7, 9, 11}));
+}
+
+TESTCASE(Pipe_log_store_segment_full)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	Pipe::log_store::segment segment{
+		dir.path()/"0.pipelog",
+		0,
+		sizeof(Pipe::log_store::segment_header) + Pipe::log_store::record_size(4),
+		4,
+		Pipe::log::clock::time_point{}
+	};
+
+	EXPECT_EQ(segment.try_append(make_item_header(0, 0), "Item"), true);
+	EXPECT_EQ(segment.free_space(), 0);
+	EXPECT_EQ(segment.try_append(make_item_header(0, 1), "Item"), false);
+}
@@ -0,0 +1,73 @@
+//@	{"target":{"name":"segment_archiver.o"}}
+
+#include "./segment_archiver.hpp"
+
+#include <limits>
+
+Pipe::log_store::segment_archiver::segment_archiver(archive_config const& cfg):
+	m_cfg{cfg},
+	m_worker{[this](std::stop_token stop){ run(stop); }}
+{}
+
+void Pipe::log_store::segment_archiver::submit(archive_job&& job)
+{
+	{
+		std::lock_guard lock{m_mtx};
+		m_jobs.push_back(std::move(job));
+		++m_jobs_in_progress;
+	}
+	m_job_added.notify_one();
+}
+
+std::vector<Pipe::log_store::archive_result> Pipe::log_store::segment_archiver::take_results()
+{
+	std::lock_guard lock{m_mtx};
+	return std::exchange(m_results, std::vector<archive_result>{});
+}
+
+void Pipe::log_store::segment_archiver::wait_until_idle()
+{
+	std::unique_lock lock{m_mtx};
+	m_job_completed.wait(lock, [this](){ return m_jobs_in_progress == 0; });
+}
+
+void Pipe::log_store::segment_archiver::run(std::stop_token stop)
+{
+	while(true)
+	{
+		archive_job job{};
+		{
+			std::unique_lock lock{m_mtx};
+			if(!m_job_added.wait(lock, stop, [this](){ return !m_jobs.empty(); }))
+			{ return; }
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		archive_result result{
+			.sequence_number = job.sequence_number,
+			.archive = job.archive,
+			.error = std::string{}
+		};
+
+		try
+		{
+			auto tmp_path = job.archive;
+			tmp_path += ".tmp";
+			std::filesystem::remove(tmp_path);
+			// The time index is not used when archiving, so make it as sparse as possible
+			write_archive(tmp_path, segment{job.segment, std::numeric_limits<size_t>::max()}, m_cfg);
+			std::filesystem::rename(tmp_path, job.archive);
+			std::filesystem::remove(job.segment);
+		}
+		catch(std::exception const& err)
+		{ result.error = err.what(); }
+
+		{
+			std::lock_guard lock{m_mtx};
+			m_results.push_back(std::move(result));
+			--m_jobs_in_progress;
+		}
+		m_job_completed.notify_all();
+	}
+}
@@ -0,0 +1,113 @@
+//@	{"dependencies_extra":[{"ref":"./segment_archiver.o", "rel":"implementation"}]}
+
+#ifndef PIPE_LOG_STORE_SEGMENT_ARCHIVER_HPP
+#define PIPE_LOG_STORE_SEGMENT_ARCHIVER_HPP
+
+#include "./archived_segment.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Pipe::log_store
+{
+	/**
+	 * \brief Describes a sealed segment to archive
+	 */
+	struct archive_job
+	{
+		/**
+		 * \brief The sequence number of the segment
+		 */
+		uint64_t sequence_number;
+
+		/**
+		 * \brief The path of the segment file
+		 */
+		std::filesystem::path segment;
+
+		/**
+		 * \brief The path of the archive to create
+		 */
+		std::filesystem::path archive;
+	};
+
+	/**
+	 * \brief The outcome of an archive_job
+	 */
+	struct archive_result
+	{
+		/**
+		 * \brief The sequence number of the segment
+		 */
+		uint64_t sequence_number;
+
+		/**
+		 * \brief The path of the archive. Only valid if error is empty.
+		 */
+		std::filesystem::path archive;
+
+		/**
+		 * \brief A description of why the segment could not be archived, or empty on success
+		 */
+		std::string error;
+	};
+
+	/**
+	 * \brief Archives sealed segments on a background thread
+	 *
+	 * Compressing a segment takes much longer than appending to one, so it should not be done
+	 * on the thread that dispatches events. Jobs are processed in the order they were
+	 * submitted. The segment file is reopened by the worker, so the caller may drop its own
+	 * segment while the job is running.
+	 *
+	 * The archive is first written to a temporary file, which is renamed into place when
+	 * complete. The segment file is removed after that.
+	 */
+	class segment_archiver
+	{
+	public:
+		/**
+		 * \brief Constructs a segment_archiver, and starts its worker thread
+		 * \param cfg Controls how segments are compressed
+		 */
+		explicit segment_archiver(archive_config const& cfg);
+
+		/**
+		 * \brief Queues job for archiving
+		 */
+		void submit(archive_job&& job);
+
+		/**
+		 * \brief Returns the results of all jobs that have completed since the last call
+		 *
+		 * \note This function does not block
+		 */
+		std::vector<archive_result> take_results();
+
+		/**
+		 * \brief Blocks until all submitted jobs have completed
+		 */
+		void wait_until_idle();
+
+	private:
+		void run(std::stop_token stop);
+
+		archive_config m_cfg;
+		std::mutex m_mtx;
+		std::condition_variable_any m_job_added;
+		std::condition_variable m_job_completed;
+		std::deque<archive_job> m_jobs;
+		std::vector<archive_result> m_results;
+		size_t m_jobs_in_progress{0};
+
+		// Must be last, so the thread is joined before the state it uses is destroyed
+		std::jthread m_worker;
+	};
+}
+
+#endif
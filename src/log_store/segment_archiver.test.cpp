@@ -0,0 +1,95 @@
+//@	{"target":{"name":"segment_archiver.test"}}
+
+#include "./segment_archiver.hpp"
+
+#include "src/test_utils/temp_dir.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	void make_segment(std::filesystem::path const& path, uint64_t sequence_number)
+	{
+		Pipe::log_store::segment segment{path, sequence_number, 64*1024, 64, Pipe::log::clock::time_point{}};
+		segment.try_append(
+			Pipe::log_store::record_header{
+				.size = 0,
+				.type = Pipe::log_store::record_type::client_name,
+				.severity = 0,
+				.flags = 0,
+				.client_id = 0,
+				.payload_size = 0,
+				.when = 0
+			},
+			"foo"
+		);
+		for(int64_t k = 0; k != 256; ++k)
+		{
+			segment.try_append(
+				Pipe::log_store::record_header{
+					.size = 0,
+					.type = Pipe::log_store::record_type::log_item,
+					.severity = 0,
+					.flags = 0,
+					.client_id = 0,
+					.payload_size = 0,
+					.when = k
+				},
+				std::format("Item {}", k)
+			);
+		}
+		segment.seal();
+	}
+}
+
+TESTCASE(Pipe_log_store_segment_archiver_archive_segments)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	make_segment(dir.path()/"0.pipelog", 0);
+	make_segment(dir.path()/"1.pipelog", 1);
+
+	Pipe::log_store::segment_archiver archiver{Pipe::log_store::archive_config{}};
+	for(uint64_t k = 0; k != 2; ++k)
+	{
+		archiver.submit(
+			Pipe::log_store::archive_job{
+				.sequence_number = k,
+				.segment = dir.path()/std::format("{}.pipelog", k),
+				.archive = dir.path()/std::format("{}.pipelogz", k)
+			}
+		);
+	}
+	archiver.wait_until_idle();
+
+	auto const results = archiver.take_results();
+	REQUIRE_EQ(std::size(results), 2);
+	for(uint64_t k = 0; k != 2; ++k)
+	{
+		EXPECT_EQ(results[k].sequence_number, k);
+		EXPECT_EQ(results[k].error, "");
+		EXPECT_EQ(std::filesystem::exists(dir.path()/std::format("{}.pipelog", k)), false);
+
+		Pipe::log_store::archived_segment const archive{results[k].archive};
+		EXPECT_EQ(archive.item_count(), 256);
+	}
+	EXPECT_EQ(archiver.take_results().empty(), true);
+}
+
+TESTCASE(Pipe_log_store_segment_archiver_missing_segment)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	Pipe::log_store::segment_archiver archiver{Pipe::log_store::archive_config{}};
+	archiver.submit(
+		Pipe::log_store::archive_job{
+			.sequence_number = 0,
+			.segment = dir.path()/"0.pipelog",
+			.archive = dir.path()/"0.pipelogz"
+		}
+	);
+	archiver.wait_until_idle();
+
+	auto const results = archiver.take_results();
+	REQUIRE_EQ(std::size(results), 1);
+	EXPECT_NE(results[0].error, "");
+	EXPECT_EQ(std::filesystem::exists(dir.path()/"0.pipelogz"), false);
+}
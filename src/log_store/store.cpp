@@ -0,0 +1,465 @@
+//@	{"target":{"name":"store.o"}}
+
+#include "./store.hpp"
+
+#include <jopp/parser.hpp>
+#include <algorithm>
+#include <charconv>
+#include <map>
+
+namespace
+{
+	constexpr std::string_view segment_file_extension{".pipelog"};
+	constexpr std::string_view archive_file_extension{".pipelogz"};
+
+	std::optional<uint64_t> get_sequence_number(std::filesystem::path const& path)
+	{
+		if(path.extension() != segment_file_extension && path.extension() != archive_file_extension)
+		{ return std::nullopt; }
+
+		auto const stem = path.stem().string();
+		uint64_t ret{};
+		auto const res = std::from_chars(std::data(stem), std::data(stem) + std::size(stem), ret, 16);
+		if(res.ec != std::errc{} || res.ptr != std::data(stem) + std::size(stem))
+		{ return std::nullopt; }
+		return ret;
+	}
+
+	struct segment_files
+	{
+		std::optional<std::filesystem::path> segment;
+		std::optional<std::filesystem::path> archive;
+	};
+}
+
+Pipe::log_store::store::store(store_config const& cfg, log::type_erased_timestamp_generator clock):
+	m_cfg{cfg},
+	m_clock{clock},
+	m_last_retention_check{m_clock.now()},
+	m_archiver{cfg.archive}
+{
+	std::filesystem::create_directories(m_cfg.directory);
+
+	std::map<uint64_t, segment_files> existing_segments;
+	for(auto const& item : std::filesystem::directory_iterator{m_cfg.directory})
+	{
+		auto const& path = item.path();
+		auto const seq = get_sequence_number(path);
+		if(!seq.has_value())
+		{ continue; }
+
+		auto& files = existing_segments[*seq];
+		if(path.extension() == archive_file_extension)
+		{ files.archive = path; }
+		else
+		{ files.segment = path; }
+	}
+
+	for(auto const& item : existing_segments)
+	{
+		auto const& files = item.second;
+		if(files.archive.has_value())
+		{
+			// The archive is only renamed into place after it has been completely written, so
+			// any remaining uncompressed segment is redundant
+			if(files.segment.has_value())
+			{ std::filesystem::remove(*files.segment); }
+			auto const& current = m_archived_segments.emplace_back(*files.archive);
+			add_client_names(current.client_names());
+			add_field_keys(current.field_keys());
+		}
+		else
+		{
+			segment current{*files.segment, m_cfg.time_index_interval};
+			add_client_names(current.client_names());
+			add_field_keys(current.field_keys());
+			if(m_cfg.compress_sealed_segments)
+			{ m_archived_segments.push_back(archive(current)); }
+			else
+			{ m_segments.push_back(std::move(current)); }
+		}
+		m_next_sequence_number = item.first + 1;
+	}
+}
+
+Pipe::log_store::store::~store()
+{
+	// Archives of segments removed by the retention policy must also be removed
+	m_archiver.wait_until_idle();
+	collect_archived_segments();
+}
+
+void Pipe::log_store::store::on_parse_error(char const* who, jopp::parser_error_code ec)
+{
+	append(
+		get_client_id(who),
+		log::item{
+			.when = m_clock.now(),
+			.severity = log::item::severity::error,
+			.message = std::format("Failed to parse log data: {}", to_string(ec))
+		}
+	);
+}
+
+void Pipe::log_store::store::on_invalid_log_item(char const* who, char const* errmsg)
+{
+	append(
+		get_client_id(who),
+		log::item{
+			.when = m_clock.now(),
+			.severity = log::item::severity::error,
+			.message = std::format("Invalid log item: {}", errmsg)
+		}
+	);
+}
+
+void Pipe::log_store::store::on_sequence_discontinuity(
+	char const* who,
+	json_log::sequence_discontinuity const& discontinuity
+)
+{
+	append(
+		get_client_id(who),
+		log::item{
+			.when = m_clock.now(),
+			.severity = discontinuity.is_duplicate()? log::item::severity::warning : log::item::severity::error,
+			.message = to_string(discontinuity)
+		}
+	);
+}
+
+std::vector<Pipe::log_store::stored_item>
+Pipe::log_store::store::find(query const& q) const
+{
+	record_filter filter{
+		.client_id = std::nullopt,
+		.min_severity = q.min_severity,
+		.since = to_record_time(std::max(q.since, log::clock::time_point{} + std::chrono::nanoseconds::min())),
+		.until = to_record_time(std::min(q.until, log::clock::time_point{} + std::chrono::nanoseconds::max()))
+	};
+
+	if(q.client.has_value())
+	{
+		auto const i = m_client_ids.find(*q.client);
+		if(i == std::end(m_client_ids))
+		{ return std::vector<stored_item>{}; }
+		filter.client_id = i->second;
+	}
+
+	if(q.field.has_value())
+	{
+		auto const i = m_field_key_ids.find(q.field->key);
+		if(i == std::end(m_field_key_ids))
+		{ return std::vector<stored_item>{}; }
+		filter.field_key = i->second;
+		filter.field_value = q.field->value;
+	}
+
+	std::vector<stored_item> ret;
+	auto const add_item = [&ret, this](record_view const& record) {
+		auto const payload = split_log_item_payload(record);
+		if(!payload.has_value())
+		{ return; }
+
+		std::vector<log::field> fields;
+		for_each_field(payload->fields, [&fields, this](uint32_t key_id, std::string_view value) {
+			auto const i = m_field_keys.find(key_id);
+			fields.push_back(
+				log::field{
+					.key = i != std::end(m_field_keys)? i->second : std::string{},
+					.value = std::string{value}
+				}
+			);
+		});
+
+		auto const i = m_client_names.find(record.header.client_id);
+		ret.push_back(
+			stored_item{
+				.client = i != std::end(m_client_names)? i->second : std::string{},
+				.item = log::item{
+					.when = from_record_time(record.header.when),
+					.severity = static_cast<enum log::item::severity>(record.header.severity),
+					.message = std::string{payload->message},
+					.fields = std::move(fields)
+				}
+			}
+		);
+	};
+
+	for(auto const& current : m_archived_segments)
+	{ current.for_each_record(filter, add_item); }
+
+	for(auto const& current : m_segments)
+	{ current.for_each_record(filter, add_item); }
+
+	return ret;
+}
+
+void Pipe::log_store::store::rotate()
+{
+	collect_archived_segments();
+	if(!m_segments.empty() && !m_segments.back().is_sealed())
+	{
+		auto& current = m_segments.back();
+		current.seal();
+		if(m_cfg.compress_sealed_segments)
+		{ start_archiving(current); }
+	}
+	enforce_retention();
+}
+
+void Pipe::log_store::store::wait_for_archiving()
+{
+	m_archiver.wait_until_idle();
+	collect_archived_segments();
+}
+
+size_t Pipe::log_store::store::total_size() const noexcept
+{
+	size_t ret = 0;
+	for(auto const& item : m_archived_segments)
+	{ ret += item.size(); }
+	for(auto const& item : m_segments)
+	{ ret += item.size(); }
+	return ret;
+}
+
+uint32_t Pipe::log_store::store::get_client_id(std::string_view name)
+{
+	auto const i = m_client_ids.find(std::string{name});
+	if(i != std::end(m_client_ids))
+	{ return i->second; }
+
+	auto const id = m_next_client_id;
+	++m_next_client_id;
+	m_client_ids.emplace(std::string{name}, id);
+	m_client_names.emplace(id, std::string{name});
+	return id;
+}
+
+uint32_t Pipe::log_store::store::get_field_key_id(std::string_view key)
+{
+	auto const i = m_field_key_ids.find(std::string{key});
+	if(i != std::end(m_field_key_ids))
+	{ return i->second; }
+
+	auto const id = m_next_field_key_id;
+	++m_next_field_key_id;
+	m_field_key_ids.emplace(std::string{key}, id);
+	m_field_keys.emplace(id, std::string{key});
+	return id;
+}
+
+Pipe::log_store::segment& Pipe::log_store::store::get_active_segment(size_t bytes_needed)
+{
+	collect_archived_segments();
+
+	auto const now = m_clock.now();
+	if(now - m_last_retention_check >= m_cfg.retention_check_interval)
+	{ enforce_retention(); }
+
+	if(!m_segments.empty())
+	{
+		auto& current = m_segments.back();
+		if(current.free_space() >= bytes_needed && now - current.created() < m_cfg.max_segment_age)
+		{ return current; }
+	}
+
+	rotate();
+
+	auto const seq = m_next_sequence_number;
+	auto& ret = m_segments.emplace_back(
+		m_cfg.directory/std::format("{:016x}{}", seq, segment_file_extension),
+		seq,
+		m_cfg.segment_size,
+		m_cfg.time_index_interval,
+		now
+	);
+	++m_next_sequence_number;
+
+	// append makes sure that bytes_needed never exceeds the capacity of an empty segment
+	return ret;
+}
+
+void Pipe::log_store::store::append(uint32_t client_id, log::item const& item)
+{
+	auto const& client_name = m_client_names.at(client_id);
+
+	std::vector<encoded_field> fields;
+	fields.reserve(std::size(item.fields));
+	for(auto const& field : item.fields)
+	{ fields.push_back(encoded_field{.key_id = get_field_key_id(field.key), .value = field.value}); }
+	auto const payload = make_log_item_payload(fields, item.message);
+
+	// Reserve space for the client name and the field keys, since they must be defined within the
+	// same segment as the item. A key id occupies at most five bytes.
+	auto bytes_needed = record_size(std::size(payload)) + record_size(std::size(client_name));
+	for(auto const& field : item.fields)
+	{ bytes_needed += record_size(5 + std::size(field.key)); }
+
+	// This is called from within an item_receiver callback, so an item that does not fit in an
+	// empty segment is stored without its fields, and with its message truncated
+	auto const max_bytes = m_cfg.segment_size - std::min(m_cfg.segment_size, sizeof(segment_header));
+	if(bytes_needed > max_bytes)
+	{
+		auto const bytes_for_item = (max_bytes - std::min(max_bytes, record_size(std::size(client_name))))
+			/record_alignment*record_alignment;
+		if(bytes_for_item < sizeof(record_header))
+		{ return; }
+
+		append(
+			client_id,
+			log::item{
+				.when = item.when,
+				.severity = item.severity,
+				.message = item.message.substr(
+					0,
+					std::min(std::size(item.message), bytes_for_item - sizeof(record_header))
+				)
+			}
+		);
+		return;
+	}
+
+	auto& current = get_active_segment(bytes_needed);
+
+	if(!current.defines_client(client_id))
+	{
+		current.try_append(
+			record_header{
+				.size = 0,
+				.type = record_type::client_name,
+				.severity = 0,
+				.flags = 0,
+				.client_id = client_id,
+				.payload_size = 0,
+				.when = 0
+			},
+			client_name
+		);
+	}
+
+	for(size_t k = 0; k != std::size(fields); ++k)
+	{
+		if(current.defines_field_key(fields[k].key_id))
+		{ continue; }
+
+		current.try_append(
+			record_header{
+				.size = 0,
+				.type = record_type::field_key,
+				.severity = 0,
+				.flags = 0,
+				.client_id = 0,
+				.payload_size = 0,
+				.when = 0
+			},
+			make_field_key_payload(fields[k].key_id, item.fields[k].key)
+		);
+	}
+
+	current.try_append(
+		record_header{
+			.size = 0,
+			.type = record_type::log_item,
+			.severity = static_cast<uint8_t>(item.severity),
+			.flags = fields.empty()? uint8_t{0} : has_fields_flag,
+			.client_id = client_id,
+			.payload_size = 0,
+			.when = to_record_time(item.when)
+		},
+		payload
+	);
+}
+
+void Pipe::log_store::store::enforce_retention()
+{
+	auto const now = m_clock.now();
+	m_last_retention_check = now;
+	auto const oldest_to_keep = to_record_time(now - m_cfg.max_retention_age);
+	auto const remove_front = [oldest_to_keep, this](auto& segments) {
+		while(!segments.empty() && segments.front().is_sealed())
+		{
+			auto const& front = segments.front();
+			auto const expired = front.item_count() == 0 || front.max_time() < oldest_to_keep;
+			if(!expired && total_size() <= m_cfg.max_total_size)
+			{ return false; }
+
+			std::filesystem::remove(front.path());
+			segments.pop_front();
+		}
+		return true;
+	};
+
+	// Archived segments are always older than uncompressed segments
+	if(remove_front(m_archived_segments))
+	{ remove_front(m_segments); }
+}
+
+void Pipe::log_store::store::add_client_names(std::unordered_map<uint32_t, std::string> const& names)
+{
+	for(auto const& client : names)
+	{
+		m_client_ids.insert_or_assign(client.second, client.first);
+		m_client_names.insert_or_assign(client.first, client.second);
+		m_next_client_id = std::max(m_next_client_id, client.first + 1);
+	}
+}
+
+void Pipe::log_store::store::add_field_keys(std::unordered_map<uint32_t, std::string> const& keys)
+{
+	for(auto const& key : keys)
+	{
+		m_field_key_ids.insert_or_assign(key.second, key.first);
+		m_field_keys.insert_or_assign(key.first, key.second);
+		m_next_field_key_id = std::max(m_next_field_key_id, key.first + 1);
+	}
+}
+
+Pipe::log_store::archived_segment Pipe::log_store::store::archive(segment const& src) const
+{
+	// Write to a temporary file first, so a crash never leaves a partially written archive behind
+	auto const path = m_cfg.directory/std::format("{:016x}{}", src.sequence_number(), archive_file_extension);
+	auto tmp_path = path;
+	tmp_path += ".tmp";
+	std::filesystem::remove(tmp_path);
+	write_archive(tmp_path, src, m_cfg.archive);
+	std::filesystem::rename(tmp_path, path);
+	std::filesystem::remove(src.path());
+	return archived_segment{path};
+}
+
+void Pipe::log_store::store::start_archiving(segment const& src)
+{
+	m_archiver.submit(
+		archive_job{
+			.sequence_number = src.sequence_number(),
+			.segment = src.path(),
+			.archive = m_cfg.directory/std::format("{:016x}{}", src.sequence_number(), archive_file_extension)
+		}
+	);
+}
+
+void Pipe::log_store::store::collect_archived_segments()
+{
+	for(auto const& result : m_archiver.take_results())
+	{
+		// If archiving failed, the segment is kept uncompressed
+		if(!result.error.empty())
+		{ continue; }
+
+		auto const i = std::ranges::find_if(m_segments, [seq = result.sequence_number](auto const& item) {
+			return item.sequence_number() == seq;
+		});
+
+		// The segment has been removed by the retention policy while it was being archived
+		if(i == std::end(m_segments))
+		{
+			std::filesystem::remove(result.archive);
+			continue;
+		}
+
+		m_archived_segments.emplace_back(result.archive);
+		m_segments.erase(i);
+	}
+}
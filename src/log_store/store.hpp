@@ -0,0 +1,245 @@
+//@	{"dependencies_extra":[{"ref":"./store.o", "rel":"implementation"}]}
+
+#ifndef PIPE_LOG_STORE_STORE_HPP
+#define PIPE_LOG_STORE_STORE_HPP
+
+#include "./segment.hpp"
+#include "./archived_segment.hpp"
+#include "./segment_archiver.hpp"
+#include "src/json_log/sequence_tracker.hpp"
+#include "src/log/log.hpp"
+
+#include <jopp/parser.hpp>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+namespace Pipe::log_store
+{
+	/**
+	 * \brief Configures a store
+	 */
+	struct store_config
+	{
+		/**
+		 * \brief The directory where segment files are stored
+		 */
+		std::filesystem::path directory;
+
+		/**
+		 * \brief The max size of a segment file
+		 */
+		size_t segment_size{16*1024*1024};
+
+		/**
+		 * \brief The max time a segment is active, before it is sealed and a new segment is created
+		 */
+		std::chrono::seconds max_segment_age{3600};
+
+		/**
+		 * \brief The max total size of all segments. When exceeded, the oldest segments are removed.
+		 */
+		size_t max_total_size{1024*1024*1024};
+
+		/**
+		 * \brief The max age of log items to keep. Segments that only contain older items are
+		 *        removed.
+		 */
+		std::chrono::seconds max_retention_age{7*24*3600};
+
+		/**
+		 * \brief The min time between two retention checks triggered by appending items
+		 */
+		std::chrono::seconds retention_check_interval{60};
+
+		/**
+		 * \brief The number of records between two entries in the time index
+		 */
+		size_t time_index_interval{64};
+
+		/**
+		 * \brief Whether or not sealed segments are compressed
+		 */
+		bool compress_sealed_segments{true};
+
+		/**
+		 * \brief Controls how sealed segments are compressed
+		 */
+		archive_config archive{};
+	};
+
+	/**
+	 * \brief Describes which items to retrieve from a store
+	 */
+	struct query
+	{
+		/**
+		 * \brief If set, only items from this client are retrieved
+		 */
+		std::optional<std::string> client{};
+
+		/**
+		 * \brief The lowest severity to retrieve
+		 */
+		enum log::item::severity min_severity{log::item::severity::info};
+
+		/**
+		 * \brief The earliest timestamp to retrieve
+		 */
+		log::clock::time_point since{log::clock::time_point::min()};
+
+		/**
+		 * \brief The latest timestamp to retrieve
+		 */
+		log::clock::time_point until{log::clock::time_point::max()};
+
+		/**
+		 * \brief If set, only items with a field matching both key and value are retrieved
+		 */
+		std::optional<log::field> field{};
+	};
+
+	/**
+	 * \brief A log item retrieved from a store
+	 */
+	struct stored_item
+	{
+		std::string client;
+		log::item item;
+
+		bool operator==(stored_item const&) const = default;
+		bool operator!=(stored_item const&) const = default;
+	};
+
+	/**
+	 * \brief An append-only store for decoded log items
+	 *
+	 * The store is an item_receiver, and can be used as a sink for json_log::reader. Items are
+	 * appended to memory-mapped segment files. Each segment keeps a sparse time index and a
+	 * per-client index, so a query only has to visit segments that overlap the requested time
+	 * range, and only records from the requested client. Field keys are interned, so a field
+	 * costs little more than its value, and queries can filter on fields without inspecting
+	 * messages.
+	 *
+	 * If enabled in the configuration, sealed segments are replaced by archived segments, where
+	 * log items are stored in independently compressed blocks. Compression runs on a background
+	 * thread. Until it has completed, the sealed segment is still used for queries.
+	 */
+	class store
+	{
+	public:
+		/**
+		 * \brief Constructs a store
+		 *
+		 * Existing segment files in cfg.directory are opened as sealed segments, so previously
+		 * stored items can be queried. If compression is enabled, uncompressed segments are
+		 * archived.
+		 *
+		 * \param cfg The configuration to use
+		 * \param clock The timestamp_generator used for rotation and retention
+		 */
+		explicit store(
+			store_config const& cfg,
+			log::type_erased_timestamp_generator clock = std::ref(s_system_clock)
+		);
+
+		store(store const&) = delete;
+		store& operator=(store const&) = delete;
+
+		/**
+		 * \brief Waits for any pending compression to complete, and closes the store
+		 */
+		~store();
+
+		void consume(char const* who, log::item&& item)
+		{ append(who, item); }
+
+		/**
+		 * \brief Appends item, as written by who
+		 *
+		 * This is the same as consume, but item is left untouched, so it can be passed on to
+		 * other receivers.
+		 */
+		void append(std::string_view who, log::item const& item)
+		{ append(get_client_id(who), item); }
+
+		void on_parse_error(char const* who, jopp::parser_error_code ec);
+
+		void on_invalid_log_item(char const* who, char const* errmsg);
+
+		void on_sequence_discontinuity(char const* who, json_log::sequence_discontinuity const& discontinuity);
+
+		/**
+		 * \brief Retrieves all items that match q
+		 */
+		std::vector<stored_item> find(query const& q) const;
+
+		/**
+		 * \brief Seals the active segment, and removes segments according to the retention policy
+		 *
+		 * If compression is enabled, the sealed segment is queued for archiving, and this function
+		 * returns without waiting for it.
+		 */
+		void rotate();
+
+		/**
+		 * \brief Blocks until all sealed segments queued for archiving have been archived
+		 */
+		void wait_for_archiving();
+
+		/**
+		 * \brief Removes segments according to the retention policy
+		 *
+		 * This is done by rotate, and when an item is appended, at most once per
+		 * retention_check_interval. A store that receives no items can call this from a timer.
+		 */
+		void enforce_retention();
+
+		/**
+		 * \brief Returns the number of segments, including the active one and archived segments
+		 */
+		size_t segment_count() const noexcept
+		{ return std::size(m_archived_segments) + std::size(m_segments); }
+
+		/**
+		 * \brief Returns the number of archived segments
+		 */
+		size_t archived_segment_count() const noexcept
+		{ return std::size(m_archived_segments); }
+
+		/**
+		 * \brief Returns the total number of bytes used by all segments
+		 */
+		size_t total_size() const noexcept;
+
+	private:
+		static constinit inline log::clock s_system_clock{};
+
+		uint32_t get_client_id(std::string_view name);
+		uint32_t get_field_key_id(std::string_view key);
+		segment& get_active_segment(size_t bytes_needed);
+		void append(uint32_t client_id, log::item const& item);
+		void add_client_names(std::unordered_map<uint32_t, std::string> const& names);
+		void add_field_keys(std::unordered_map<uint32_t, std::string> const& keys);
+		archived_segment archive(segment const& src) const;
+		void start_archiving(segment const& src);
+		void collect_archived_segments();
+
+		store_config m_cfg;
+		log::type_erased_timestamp_generator m_clock;
+		log::clock::time_point m_last_retention_check;
+		std::deque<archived_segment> m_archived_segments;
+		std::deque<segment> m_segments;
+		uint64_t m_next_sequence_number{0};
+		uint32_t m_next_client_id{0};
+		std::unordered_map<std::string, uint32_t> m_client_ids;
+		std::unordered_map<uint32_t, std::string> m_client_names;
+		uint32_t m_next_field_key_id{0};
+		std::unordered_map<std::string, uint32_t> m_field_key_ids;
+		std::unordered_map<uint32_t, std::string> m_field_keys;
+		segment_archiver m_archiver;
+	};
+}
+
+#endif
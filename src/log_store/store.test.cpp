@@ -0,0 +1,361 @@
+//@	{"target":{"name":"store.test"}}
+
+#include "./store.hpp"
+
+#include "src/test_utils/temp_dir.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	struct my_clock
+	{
+		Pipe::log::clock::time_point current_time{};
+
+		Pipe::log::clock::time_point now() const
+		{ return current_time; }
+	};
+
+	Pipe::log::item make_item(int64_t seconds, enum Pipe::log::item::severity severity, std::string&& message)
+	{
+		return Pipe::log::item{
+			.when = Pipe::log::clock::time_point{} + std::chrono::seconds{seconds},
+			.severity = severity,
+			.message = std::move(message)
+		};
+	}
+}
+
+TESTCASE(Pipe_log_store_store_consume_and_find)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store store{Pipe::log_store::store_config{.directory = dir.path()}, std::ref(clock)};
+
+	store.consume("foo", make_item(1, Pipe::log::item::severity::info, "foo 1"));
+	store.consume("bar", make_item(2, Pipe::log::item::severity::error, "bar 1"));
+	store.consume("foo", make_item(3, Pipe::log::item::severity::error, "foo 2"));
+	store.consume("foo", make_item(400, Pipe::log::item::severity::error, "foo 3"));
+	EXPECT_EQ(store.segment_count(), 1);
+
+	auto const all_items = store.find(Pipe::log_store::query{});
+	REQUIRE_EQ(std::size(all_items), 4);
+	EXPECT_EQ(all_items[1].client, "bar");
+	EXPECT_EQ(all_items[1].item, make_item(2, Pipe::log::item::severity::error, "bar 1"));
+
+	auto const errors_from_foo = store.find(
+		Pipe::log_store::query{
+			.client = "foo",
+			.min_severity = Pipe::log::item::severity::error,
+			.since = Pipe::log::clock::time_point{} + std::chrono::seconds{100},
+			.until = Pipe::log::clock::time_point::max()
+		}
+	);
+	REQUIRE_EQ(std::size(errors_from_foo), 1);
+	EXPECT_EQ(errors_from_foo[0].item.message, "foo 3");
+
+	EXPECT_EQ(std::size(store.find(Pipe::log_store::query{.client = "baz"})), 0);
+}
+
+TESTCASE(Pipe_log_store_store_parse_errors_are_stored)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store store{Pipe::log_store::store_config{.directory = dir.path()}, std::ref(clock)};
+
+	store.on_invalid_log_item("foo", "Bad item");
+	store.on_sequence_discontinuity("foo", Pipe::json_log::sequence_discontinuity{.expected = 2, .received = 12});
+
+	auto const items = store.find(Pipe::log_store::query{});
+	REQUIRE_EQ(std::size(items), 2);
+	EXPECT_EQ(items[0].client, "foo");
+	EXPECT_EQ(items[0].item.severity, Pipe::log::item::severity::error);
+	EXPECT_EQ(items[0].item.message, "Invalid log item: Bad item");
+	EXPECT_EQ(items[1].item.severity, Pipe::log::item::severity::error);
+	EXPECT_EQ(items[1].item.message, "10 log items were lost (expected 2, received 12)");
+}
+
+TESTCASE(Pipe_log_store_store_rotate_and_reopen)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store_config const cfg{
+		.directory = dir.path(),
+		.segment_size = 256,
+		.max_segment_age = std::chrono::seconds{3600},
+		.max_total_size = 1024*1024,
+		.max_retention_age = std::chrono::seconds{7*24*3600},
+		.time_index_interval = 2
+	};
+
+	{
+		Pipe::log_store::store store{cfg, std::ref(clock)};
+		for(int64_t k = 0; k != 16; ++k)
+		{
+			store.consume(
+				k % 2 == 0? "foo" : "bar",
+				make_item(k, Pipe::log::item::severity::info, std::format("Item {}", k))
+			);
+		}
+		EXPECT_GT(store.segment_count(), 1);
+		EXPECT_EQ(std::size(store.find(Pipe::log_store::query{})), 16);
+	}
+
+	Pipe::log_store::store store{cfg, std::ref(clock)};
+	auto const items = store.find(Pipe::log_store::query{.client = "bar"});
+	REQUIRE_EQ(std::size(items), 8);
+	for(size_t k = 0; k != std::size(items); ++k)
+	{
+		EXPECT_EQ(items[k].client, "bar");
+		EXPECT_EQ(items[k].item.message, std::format("Item {}", 2*k + 1));
+	}
+
+	store.consume("baz", make_item(16, Pipe::log::item::severity::info, "Item 16"));
+	EXPECT_EQ(std::size(store.find(Pipe::log_store::query{.client = "baz"})), 1);
+	EXPECT_EQ(std::size(store.find(Pipe::log_store::query{.client = "foo"})), 8);
+}
+
+TESTCASE(Pipe_log_store_store_rotate_by_age)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store store{
+		Pipe::log_store::store_config{
+			.directory = dir.path(),
+			.max_segment_age = std::chrono::seconds{10}
+		},
+		std::ref(clock)
+	};
+
+	store.consume("foo", make_item(0, Pipe::log::item::severity::info, "Item 0"));
+	clock.current_time += std::chrono::seconds{5};
+	store.consume("foo", make_item(5, Pipe::log::item::severity::info, "Item 1"));
+	EXPECT_EQ(store.segment_count(), 1);
+
+	clock.current_time += std::chrono::seconds{5};
+	store.consume("foo", make_item(10, Pipe::log::item::severity::info, "Item 2"));
+	EXPECT_EQ(store.segment_count(), 2);
+}
+
+TESTCASE(Pipe_log_store_store_retention)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store store{
+		Pipe::log_store::store_config{
+			.directory = dir.path(),
+			.segment_size = 256,
+			.max_segment_age = std::chrono::seconds{3600},
+			.max_total_size = 1024,
+			.max_retention_age = std::chrono::seconds{100},
+			.time_index_interval = 64
+		},
+		std::ref(clock)
+	};
+
+	for(int64_t k = 0; k != 64; ++k)
+	{ store.consume("foo", make_item(0, Pipe::log::item::severity::info, std::format("Item {}", k))); }
+
+	EXPECT_LE(store.total_size(), 1024 + 256);
+	auto const items = store.find(Pipe::log_store::query{});
+	REQUIRE_NE(std::size(items), 0);
+	EXPECT_EQ(items.back().item.message, "Item 63");
+
+	clock.current_time += std::chrono::seconds{200};
+	store.rotate();
+	EXPECT_EQ(store.segment_count(), 0);
+	EXPECT_EQ(std::size(store.find(Pipe::log_store::query{})), 0);
+}
+
+TESTCASE(Pipe_log_store_store_retention_on_append)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store store{
+		Pipe::log_store::store_config{
+			.directory = dir.path(),
+			.max_retention_age = std::chrono::seconds{100},
+			.retention_check_interval = std::chrono::seconds{60},
+			.compress_sealed_segments = false
+		},
+		std::ref(clock)
+	};
+
+	store.consume("foo", make_item(0, Pipe::log::item::severity::info, "Item 1"));
+	store.rotate();
+	store.consume("foo", make_item(0, Pipe::log::item::severity::info, "Item 2"));
+	EXPECT_EQ(store.segment_count(), 2);
+
+	// The active segment still has room, so only the periodic check removes the sealed segment
+	clock.current_time += std::chrono::seconds{200};
+	store.consume("foo", make_item(200, Pipe::log::item::severity::info, "Item 3"));
+	EXPECT_EQ(store.segment_count(), 1);
+
+	auto const items = store.find(Pipe::log_store::query{});
+	REQUIRE_EQ(std::size(items), 2);
+	EXPECT_EQ(items[0].item.message, "Item 2");
+}
+
+TESTCASE(Pipe_log_store_store_compress_sealed_segments)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store_config const cfg{
+		.directory = dir.path(),
+		.segment_size = 64*1024,
+		.max_segment_age = std::chrono::seconds{3600},
+		.max_total_size = 1024*1024*1024,
+		.max_retention_age = std::chrono::seconds{7*24*3600},
+		.time_index_interval = 64,
+		.compress_sealed_segments = true,
+		.archive = Pipe::log_store::archive_config{
+			.block_size = 4096,
+			.dictionary_size = 1024
+		}
+	};
+
+	size_t uncompressed_size = 0;
+	{
+		Pipe::log_store::store store{cfg, std::ref(clock)};
+		for(int64_t k = 0; k != 4096; ++k)
+		{
+			auto message = std::format("Processed request {} in {} ms", k % 128, k % 17);
+			uncompressed_size += Pipe::log_store::record_size(std::size(message));
+			store.consume(
+				k % 2 == 0? "foo" : "bar",
+				make_item(k, Pipe::log::item::severity::info, std::move(message))
+			);
+		}
+		store.rotate();
+		store.wait_for_archiving();
+		EXPECT_EQ(store.archived_segment_count(), store.segment_count());
+		EXPECT_LT(store.total_size()*4, uncompressed_size);
+	}
+
+	size_t archive_count = 0;
+	for(auto const& item : std::filesystem::directory_iterator{dir.path()})
+	{
+		EXPECT_EQ(item.path().extension(), ".pipelogz");
+		++archive_count;
+	}
+
+	Pipe::log_store::store store{cfg, std::ref(clock)};
+	EXPECT_EQ(store.archived_segment_count(), archive_count);
+
+	auto const items = store.find(
+		Pipe::log_store::query{
+			.client = "bar",
+			.min_severity = Pipe::log::item::severity::info,
+			.since = Pipe::log::clock::time_point{} + std::chrono::seconds{1001},
+			.until = Pipe::log::clock::time_point{} + std::chrono::seconds{1005}
+		}
+	);
+	REQUIRE_EQ(std::size(items), 3);
+	EXPECT_EQ(items[0].item, make_item(1001, Pipe::log::item::severity::info, "Processed request 105 in 15 ms"));
+	EXPECT_EQ(items[2].item.when, Pipe::log::clock::time_point{} + std::chrono::seconds{1005});
+
+	store.consume("baz", make_item(4096, Pipe::log::item::severity::info, "Item"));
+	EXPECT_EQ(std::size(store.find(Pipe::log_store::query{.client = "baz"})), 1);
+	EXPECT_EQ(std::size(store.find(Pipe::log_store::query{.client = "foo"})), 2048);
+}
+
+TESTCASE(Pipe_log_store_store_archive_on_reopen)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store_config cfg{
+		.directory = dir.path(),
+		.compress_sealed_segments = false
+	};
+
+	{
+		Pipe::log_store::store store{cfg, std::ref(clock)};
+		store.consume("foo", make_item(0, Pipe::log::item::severity::info, "Item 0"));
+		store.rotate();
+		EXPECT_EQ(store.archived_segment_count(), 0);
+	}
+
+	cfg.compress_sealed_segments = true;
+	Pipe::log_store::store store{cfg, std::ref(clock)};
+	EXPECT_EQ(store.archived_segment_count(), 1);
+	for(auto const& item : std::filesystem::directory_iterator{dir.path()})
+	{ EXPECT_EQ(item.path().extension(), ".pipelogz"); }
+
+	auto const items = store.find(Pipe::log_store::query{});
+	REQUIRE_EQ(std::size(items), 1);
+	EXPECT_EQ(items[0].client, "foo");
+	EXPECT_EQ(items[0].item.message, "Item 0");
+}
+
+TESTCASE(Pipe_log_store_store_fields)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store_config const cfg{
+		.directory = dir.path(),
+		.segment_size = 4096,
+		.compress_sealed_segments = true
+	};
+
+	auto const make_item_with_fields = [](int64_t k) {
+		auto ret = make_item(k, Pipe::log::item::severity::info, std::format("Request {} completed", k));
+		ret.fields.push_back(Pipe::log::field{.key = "request_id", .value = std::to_string(k)});
+		ret.fields.push_back(Pipe::log::field{.key = "status", .value = k % 10 == 0? "500" : "200"});
+		return ret;
+	};
+
+	auto const failed_requests = Pipe::log_store::query{
+		.field = Pipe::log::field{.key = "status", .value = "500"}
+	};
+
+	{
+		Pipe::log_store::store store{cfg, std::ref(clock)};
+		for(int64_t k = 0; k != 400; ++k)
+		{ store.consume("foo", make_item_with_fields(k)); }
+		store.consume("foo", make_item(400, Pipe::log::item::severity::info, "No fields"));
+
+		// Each segment must define the field keys it uses
+		EXPECT_GE(store.segment_count(), 2);
+		EXPECT_EQ(std::size(store.find(failed_requests)), 40);
+		store.rotate();
+		EXPECT_EQ(std::size(store.find(failed_requests)), 40);
+	}
+
+	Pipe::log_store::store store{cfg, std::ref(clock)};
+	auto const items = store.find(failed_requests);
+	REQUIRE_EQ(std::size(items), 40);
+	EXPECT_EQ(items[3].item, make_item_with_fields(30));
+
+	auto const all_items = store.find(Pipe::log_store::query{});
+	REQUIRE_EQ(std::size(all_items), 401);
+	EXPECT_EQ(all_items[400].item, make_item(400, Pipe::log::item::severity::info, "No fields"));
+
+	EXPECT_EQ(std::size(store.find(Pipe::log_store::query{.field = Pipe::log::field{.key = "user", .value = "bob"}})), 0);
+}
+
+TESTCASE(Pipe_log_store_store_truncate_oversized_item)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_log_store"};
+	my_clock clock;
+	Pipe::log_store::store store{
+		Pipe::log_store::store_config{
+			.directory = dir.path(),
+			.segment_size = 256,
+			.compress_sealed_segments = false
+		},
+		std::ref(clock)
+	};
+
+	auto item = make_item(1, Pipe::log::item::severity::error, std::string(1000, 'x'));
+	item.fields.push_back(Pipe::log::field{.key = "request_id", .value = "123"});
+	store.consume("foo", std::move(item));
+	store.consume("foo", make_item(2, Pipe::log::item::severity::info, "Small item"));
+
+	auto const items = store.find(Pipe::log_store::query{});
+	REQUIRE_EQ(std::size(items), 2);
+	EXPECT_EQ(items[0].item.severity, Pipe::log::item::severity::error);
+	EXPECT_EQ(items[0].item.fields.empty(), true);
+	EXPECT_LT(std::size(items[0].item.message), 256);
+	EXPECT_EQ(items[0].item.message, std::string(std::size(items[0].item.message), 'x'));
+	EXPECT_EQ(items[1].item, make_item(2, Pipe::log::item::severity::info, "Small item"));
+}
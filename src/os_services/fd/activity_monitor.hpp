@@ -202,6 +202,18 @@ namespace Pipe::os_services::fd
 		 * \brief Stops listening and cleans up resources associated with this event
 		 */
 		virtual void stop_listening() const noexcept = 0;
+
+		/**
+		 * \brief Charges one iteration that transferred num_bytes, to the dispatch budget of the
+		 *        event handler
+		 *
+		 * \return false if the budget is exhausted. In this case, the event handler should return, so
+		 *         other file descriptors can be serviced. The event source is then responsible for
+		 *         calling the event handler again, after other ready file descriptors have been
+		 *         serviced. By default, the budget is unlimited.
+		 */
+		virtual bool consume_budget(size_t) const noexcept
+		{ return true; }
 	};
 
 	/**
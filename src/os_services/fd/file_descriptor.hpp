@@ -4,6 +4,7 @@
 #include <unistd.h>
 #include <memory>
 #include <cassert>
+#include <type_traits>
 
 namespace Pipe::os_services::fd
 {
@@ -27,6 +28,13 @@ namespace Pipe::os_services::fd
 	struct enabled_fd_conversions
 	{};
 
+	/**
+	 * \brief Checks whether or not enabled_fd_conversions allows conversion from a file descriptor
+	 *        tagged with From to one tagged with To
+	 */
+	template<class From, class To>
+	concept fd_conversion_enabled = requires{{enabled_fd_conversions<From>::supports(std::declval<To>())};};
+
 	/**
 	 * \brief Class referring to a file descriptor
 	 * \tparam Tag An arbitrary type that can be used to identify the kind of file descriptor
@@ -100,7 +108,7 @@ namespace Pipe::os_services::fd
 		 * type of file descriptor
 		 */
 		template<class OtherTag>
-		requires requires{{enabled_fd_conversions<Tag>::supports(std::declval<OtherTag>())};}
+		requires(fd_conversion_enabled<Tag, OtherTag>)
 		operator tagged_file_descriptor_ref<OtherTag>() const noexcept
 		{ return tagged_file_descriptor_ref<OtherTag>{m_ref}; }
 
@@ -152,6 +160,82 @@ namespace Pipe::os_services::fd
 		file_descriptor_deleter<Tag>
 	>;
 
+	/**
+	 * \brief A tag type for a file descriptor of kind Tag, that has O_NONBLOCK set
+	 *
+	 * A reference to a non-blocking file descriptor converts to a reference of kind Tag, and to
+	 * anything that Tag converts to, also keeping the non-blocking property. The reverse is not
+	 * possible, so a function that requires a non-blocking file descriptor cannot be given a
+	 * blocking one by accident.
+	 */
+	template<class Tag>
+	struct nonblocking_tag
+	{};
+
+	template<class Tag>
+	struct enabled_fd_conversions<nonblocking_tag<Tag>>
+	{
+		static consteval void supports(Tag){}
+
+		template<class OtherTag>
+		requires(fd_conversion_enabled<Tag, OtherTag>)
+		static consteval void supports(OtherTag){}
+
+		template<class OtherTag>
+		requires(fd_conversion_enabled<Tag, OtherTag>)
+		static consteval void supports(nonblocking_tag<OtherTag>){}
+	};
+
+	/**
+	 * \brief Closes a non-blocking file descriptor the same way as a file descriptor of kind Tag
+	 */
+	template<class Tag>
+	struct file_descriptor_deleter<nonblocking_tag<Tag>>
+	{
+		/**
+		 * \brief The "pointer" type to "delete"
+		 */
+		using pointer = tagged_file_descriptor_ref<nonblocking_tag<Tag>>;
+
+		/**
+		 * \brief Function call operator that implements the delete operation
+		 */
+		static void operator()(tagged_file_descriptor_ref<nonblocking_tag<Tag>> fd) noexcept
+		{ file_descriptor_deleter<Tag>{}(tagged_file_descriptor_ref<Tag>{fd.native_handle()}); }
+	};
+
+	/**
+	 * \brief Trait to check whether or not operations on a file descriptor tagged with Tag never
+	 *        block
+	 *
+	 * Specialize this trait for tags whose file descriptors never block once they have been
+	 * reported ready, even though they do not have O_NONBLOCK set.
+	 */
+	template<class Tag>
+	struct is_nonblocking : std::false_type
+	{};
+
+	template<class Tag>
+	struct is_nonblocking<nonblocking_tag<Tag>> : std::true_type
+	{};
+
+	/**
+	 * \brief Satisfied by tags identifying file descriptors that never block
+	 */
+	template<class Tag>
+	concept nonblocking_fd_tag = is_nonblocking<Tag>::value;
+
+	/**
+	 * \brief Controls whether or not a factory function creates non-blocking file descriptors
+	 */
+	enum class io_mode{blocking, nonblocking};
+
+	/**
+	 * \brief Maps Tag to the tag of a file descriptor of kind Tag, created with mode Mode
+	 */
+	template<class Tag, io_mode Mode>
+	using tag_for_io_mode = std::conditional_t<Mode == io_mode::nonblocking, nonblocking_tag<Tag>, Tag>;
+
 	/**
 	 * \brief A tag type for an arbitrary file descriptor
 	 */
@@ -0,0 +1,181 @@
+#ifndef PIPE_OS_SERVICES_FS_FILE_HPP
+#define PIPE_OS_SERVICES_FS_FILE_HPP
+
+#include "src/os_services/io/io.hpp"
+#include "src/os_services/fd/file_descriptor.hpp"
+#include "src/os_services/error_handling/system_error.hpp"
+#include "src/os_services/error_handling/error_handling.hpp"
+
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+/**
+ * \brief File system support
+ */
+namespace Pipe::os_services::fs
+{
+	/**
+	 * \brief A tag type used to identify a file descriptor referring to a regular file
+	 */
+	struct file_tag
+	{};
+}
+
+template<>
+struct Pipe::os_services::fd::enabled_fd_conversions<Pipe::os_services::fs::file_tag>
+{
+	static consteval void supports(io::input_file_descriptor_tag){}
+	static consteval void supports(io::output_file_descriptor_tag){}
+	static consteval void supports(generic_fd_tag){}
+};
+
+namespace Pipe::os_services::fs
+{
+	/**
+	 * \brief A reference to a file
+	 */
+	using file_ref = fd::tagged_file_descriptor_ref<file_tag>;
+
+	/**
+	 * \brief An owner of a file
+	 */
+	using file = fd::tagged_file_descriptor<file_tag>;
+
+	/**
+	 * \brief Controls how a file is opened
+	 */
+	enum class open_mode{read_only = O_RDONLY, read_write = O_RDWR};
+
+	/**
+	 * \brief Opens an existing file
+	 */
+	inline file open(std::filesystem::path const& path, open_mode mode)
+	{
+		file ret{
+			error_handling::do_while_eintr(::open, path.c_str(), static_cast<int>(mode) | O_CLOEXEC)
+		};
+		if(ret == nullptr)
+		{ throw error_handling::system_error{std::format("Failed to open {}", path.string()), errno}; }
+		return ret;
+	}
+
+	/**
+	 * \brief Creates a new file, that is opened for reading and writing
+	 * \note If the file already exists, an exception is thrown
+	 */
+	inline file create(std::filesystem::path const& path, mode_t permissions = 0644)
+	{
+		file ret{
+			error_handling::do_while_eintr(
+				::open,
+				path.c_str(),
+				O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+				permissions
+			)
+		};
+		if(ret == nullptr)
+		{ throw error_handling::system_error{std::format("Failed to create {}", path.string()), errno}; }
+		return ret;
+	}
+
+	/**
+	 * \brief Creates a file, that is opened for reading and writing
+	 * \note If the file already exists, it is truncated
+	 */
+	inline file replace(std::filesystem::path const& path, mode_t permissions = 0644)
+	{
+		file ret{
+			error_handling::do_while_eintr(
+				::open,
+				path.c_str(),
+				O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+				permissions
+			)
+		};
+		if(ret == nullptr)
+		{ throw error_handling::system_error{std::format("Failed to create {}", path.string()), errno}; }
+		return ret;
+	}
+
+	/**
+	 * \brief Copies count bytes from src, starting at src_offset, to dest at dest_offset, using
+	 *        sendfile
+	 *
+	 * \note src_offset is updated to point past the copied data
+	 */
+	inline ssize_t sendfile_at(file_ref src, off_t& src_offset, file_ref dest, off_t dest_offset, size_t count) noexcept
+	{
+		if(::lseek(dest.native_handle(), dest_offset, SEEK_SET) == -1)
+		{ return -1; }
+		return ::sendfile(dest.native_handle(), src.native_handle(), &src_offset, count);
+	}
+
+	/**
+	 * \brief Copies count bytes from src, starting at src_offset, to dest, starting at dest_offset
+	 *
+	 * The data is copied by the kernel, without passing through user space. On file systems that
+	 * support it, the copy may share storage with the source. If copy_file_range cannot be used
+	 * between the two files, sendfile is used instead.
+	 *
+	 * \return The number of bytes copied. This is less than count only if src ends before
+	 *         src_offset + count.
+	 */
+	inline size_t copy_range(file_ref src, off_t src_offset, file_ref dest, off_t dest_offset, size_t count)
+	{
+		auto const total = count;
+		auto use_sendfile = false;
+		while(count != 0)
+		{
+			auto const res = use_sendfile?
+				sendfile_at(src, src_offset, dest, dest_offset, count):
+				::copy_file_range(src.native_handle(), &src_offset, dest.native_handle(), &dest_offset, count, 0);
+
+			if(res == -1)
+			{
+				if(errno == EINTR)
+				{ continue; }
+
+				if(!use_sendfile && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL))
+				{
+					use_sendfile = true;
+					continue;
+				}
+
+				throw error_handling::system_error{"Failed to copy data between files", errno};
+			}
+
+			if(res == 0)
+			{ break; }
+
+			// copy_file_range updates dest_offset, but sendfile does not
+			if(use_sendfile)
+			{ dest_offset += res; }
+			count -= static_cast<size_t>(res);
+		}
+		return total - count;
+	}
+
+	/**
+	 * \brief Sets the size of the file referred to by fd to new_size
+	 */
+	inline void truncate(file_ref fd, size_t new_size)
+	{
+		if(::ftruncate(fd.native_handle(), static_cast<off_t>(new_size)) == -1)
+		{ throw error_handling::system_error{"Failed to change the size of file", errno}; }
+	}
+
+	/**
+	 * \brief Returns the size of the file referred to by fd
+	 */
+	inline size_t get_size(file_ref fd)
+	{
+		struct stat statbuf{};
+		if(::fstat(fd.native_handle(), &statbuf) == -1)
+		{ throw error_handling::system_error{"Failed to get size of file", errno}; }
+		return static_cast<size_t>(statbuf.st_size);
+	}
+}
+
+#endif
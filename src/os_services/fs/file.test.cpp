@@ -0,0 +1,87 @@
+//@	{"target":{"name":"file.test"}}
+
+#include "./file.hpp"
+
+#include "src/test_utils/temp_dir.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+TESTCASE(Pipe_os_services_fs_file_create_truncate_and_open)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_fs"};
+	auto const path = dir.path()/"foo";
+
+	{
+		auto const file = Pipe::os_services::fs::create(path);
+		EXPECT_EQ(Pipe::os_services::fs::get_size(file.get()), 0);
+		Pipe::os_services::fs::truncate(file.get(), 1234);
+		EXPECT_EQ(Pipe::os_services::fs::get_size(file.get()), 1234);
+
+		auto const res = Pipe::os_services::io::write(
+			file.get(),
+			std::as_bytes(std::span{std::string_view{"Hello"}})
+		);
+		EXPECT_EQ(res.bytes_transferred(), 5);
+	}
+
+	try
+	{
+		std::ignore = Pipe::os_services::fs::create(path);
+		abort();
+	}
+	catch(std::runtime_error const&)
+	{}
+
+	{
+		auto const file = Pipe::os_services::fs::open(path, Pipe::os_services::fs::open_mode::read_only);
+		EXPECT_EQ(Pipe::os_services::fs::get_size(file.get()), 1234);
+
+		std::array<char, 5> buffer{};
+		auto const res = Pipe::os_services::io::read(file.get(), std::as_writable_bytes(std::span{buffer}));
+		EXPECT_EQ(res.bytes_transferred(), 5);
+		EXPECT_EQ((std::string_view{std::data(buffer), std::size(buffer)}), "Hello");
+	}
+}
+
+TESTCASE(Pipe_os_services_fs_file_open_nonexisting)
+{
+	try
+	{
+		std::ignore = Pipe::os_services::fs::open(
+			"/this/file/does/not/exist",
+			Pipe::os_services::fs::open_mode::read_only
+		);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{
+		EXPECT_EQ(
+			err.what(),
+			std::string_view{"Failed to open /this/file/does/not/exist: No such file or directory"}
+		);
+	}
+}
+
+TESTCASE(Pipe_os_services_fs_file_replace_and_copy_range)
+{
+	Pipe::test_utils::temp_dir const dir{"pipe_fs"};
+
+	auto const src = Pipe::os_services::fs::replace(dir.path()/"src");
+	auto const res = Pipe::os_services::io::write(
+		src.get(),
+		std::as_bytes(std::span{std::string_view{"Hello, World"}})
+	);
+	EXPECT_EQ(res.bytes_transferred(), 12);
+
+	auto const dest = Pipe::os_services::fs::replace(dir.path()/"dest");
+	EXPECT_EQ(Pipe::os_services::fs::copy_range(src.get(), 7, dest.get(), 0, 5), 5);
+	EXPECT_EQ(Pipe::os_services::fs::copy_range(src.get(), 0, dest.get(), 5, 100), 12);
+	EXPECT_EQ(Pipe::os_services::fs::get_size(dest.get()), 17);
+
+	std::array<char, 17> buffer{};
+	EXPECT_EQ(::pread(dest.get().native_handle(), std::data(buffer), std::size(buffer), 0), 17);
+	EXPECT_EQ((std::string_view{std::data(buffer), std::size(buffer)}), "WorldHello, World");
+
+	// Replacing an existing file truncates it
+	EXPECT_EQ(Pipe::os_services::fs::get_size(Pipe::os_services::fs::replace(dir.path()/"dest").get()), 0);
+}
@@ -5,9 +5,14 @@
 #include "src/os_services/error_handling/system_error.hpp"
 #include "src/os_services/error_handling/error_handling.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cerrno>
 #include <expected>
 #include <cassert>
+#include <span>
+#include <type_traits>
+#include <sys/uio.h>
 
 /**
  * \brief Contains basic I/O support functions
@@ -114,6 +119,149 @@ namespace Pipe::os_services::io
 			errno
 		};
 	}
+
+	/**
+	 * \brief The max number of buffers transferred by a single call to readv or writev
+	 */
+	constexpr size_t max_iovec_count = 64;
+
+	/**
+	 * \brief Tries to read data from fd into buffers, filling them in order
+	 *
+	 * At most max_iovec_count buffers are used. Use advance to resume after a short read.
+	 *
+	 * \return An io_result, containing the number of bytes transferred during the operation
+	 */
+	inline io_result readv(input_file_descriptor_ref fd, std::span<iovec const> buffers)
+	{
+		return io_result{
+			error_handling::do_while_eintr(
+				::readv,
+				fd.native_handle(),
+				std::data(buffers),
+				static_cast<int>(std::min(std::size(buffers), max_iovec_count))
+			),
+			errno
+		};
+	}
+
+	/**
+	 * \brief Tries to read data from fd into buffers, filling them in order
+	 *
+	 * At most max_iovec_count buffers are used. Use advance to resume after a short read.
+	 *
+	 * \return An io_result, containing the number of bytes transferred during the operation
+	 */
+	inline io_result readv(input_file_descriptor_ref fd, std::span<std::span<std::byte> const> buffers)
+	{
+		std::array<iovec, max_iovec_count> iovecs;
+		auto const count = std::min(std::size(buffers), max_iovec_count);
+		for(size_t k = 0; k != count; ++k)
+		{ iovecs[k] = iovec{.iov_base = std::data(buffers[k]), .iov_len = std::size(buffers[k])}; }
+		return readv(fd, std::span{std::data(iovecs), count});
+	}
+
+	/**
+	 * \brief Tries to write the data in buffers to fd, as if they were concatenated
+	 *
+	 * At most max_iovec_count buffers are used. Use advance to resume after a short write.
+	 *
+	 * \return An io_result, containing the number of bytes transferred during the operation
+	 */
+	inline io_result writev(output_file_descriptor_ref fd, std::span<iovec const> buffers)
+	{
+		return io_result{
+			error_handling::do_while_eintr(
+				::writev,
+				fd.native_handle(),
+				std::data(buffers),
+				static_cast<int>(std::min(std::size(buffers), max_iovec_count))
+			),
+			errno
+		};
+	}
+
+	/**
+	 * \brief Tries to write the data in buffers to fd, as if they were concatenated
+	 *
+	 * At most max_iovec_count buffers are used. Use advance to resume after a short write.
+	 *
+	 * \return An io_result, containing the number of bytes transferred during the operation
+	 */
+	inline io_result writev(output_file_descriptor_ref fd, std::span<std::span<std::byte const> const> buffers)
+	{
+		std::array<iovec, max_iovec_count> iovecs;
+		auto const count = std::min(std::size(buffers), max_iovec_count);
+		for(size_t k = 0; k != count; ++k)
+		{
+			iovecs[k] = iovec{
+				.iov_base = const_cast<std::byte*>(std::data(buffers[k])),
+				.iov_len = std::size(buffers[k])
+			};
+		}
+		return writev(fd, std::span{std::data(iovecs), count});
+	}
+
+	/**
+	 * \brief Skips the first bytes bytes of buffers, after a short readv or writev
+	 *
+	 * Buffers that have been transferred completely are removed, and the first remaining buffer
+	 * is adjusted in place, so the operation can be resumed without copying any data.
+	 *
+	 * \pre bytes is not greater than the total size of buffers
+	 *
+	 * \return The buffers that have not yet been transferred completely
+	 */
+	inline std::span<iovec> advance(std::span<iovec> buffers, size_t bytes) noexcept
+	{
+		while(!buffers.empty() && bytes >= buffers.front().iov_len)
+		{
+			bytes -= buffers.front().iov_len;
+			buffers = buffers.subspan(1);
+		}
+
+		if(buffers.empty())
+		{
+			assert(bytes == 0);
+			return buffers;
+		}
+
+		auto& first = buffers.front();
+		first.iov_base = static_cast<std::byte*>(first.iov_base) + bytes;
+		first.iov_len -= bytes;
+		return buffers;
+	}
+
+	/**
+	 * \brief Skips the first bytes bytes of buffers, after a short readv or writev
+	 *
+	 * Buffers that have been transferred completely are removed, and the first remaining buffer
+	 * is adjusted in place, so the operation can be resumed without copying any data.
+	 *
+	 * \pre bytes is not greater than the total size of buffers
+	 *
+	 * \return The buffers that have not yet been transferred completely
+	 */
+	template<class T, size_t Extent>
+	requires(std::is_same_v<std::remove_const_t<T>, std::byte>)
+	std::span<std::span<T>> advance(std::span<std::span<T>, Extent> span_of_buffers, size_t bytes) noexcept
+	{
+		std::span<std::span<T>> buffers{span_of_buffers};
+		while(!buffers.empty() && bytes >= std::size(buffers.front()))
+		{
+			bytes -= std::size(buffers.front());
+			buffers = buffers.subspan(1);
+		}
+
+		if(buffers.empty())
+		{
+			assert(bytes == 0);
+			return buffers;
+		}
+
+		buffers.front() = buffers.front().subspan(bytes);
+		return buffers;
+	}
 }
 
 #endif
\ No newline at end of file
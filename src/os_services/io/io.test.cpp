@@ -82,4 +82,69 @@ TESTCASE(Pipe_io_io_result_from_eagain)
 		EXPECT_EQ(res.operation_would_have_blocked(), true);
 		EXPECT_EQ(res.bytes_transferred(), 0);
 	}
-}
\ No newline at end of file
+}
+
+TESTCASE(Pipe_io_writev_and_readv)
+{
+	Pipe::os_services::fd::tagged_file_descriptor<memfd_tag> fd{memfd_create("foo", 0)};
+	REQUIRE_NE(fd, nullptr);
+
+	std::string_view const header{"Hello"};
+	std::string_view const body{", World"};
+	std::array const buffers_to_write{std::as_bytes(std::span{header}), std::as_bytes(std::span{body})};
+	auto const write_result = Pipe::os_services::io::writev(fd.get(), buffers_to_write);
+	EXPECT_EQ(write_result.operation_would_have_blocked(), false);
+	EXPECT_EQ(write_result.bytes_transferred(), std::size(header) + std::size(body));
+
+	REQUIRE_NE(::lseek(fd.get().native_handle(), 0, SEEK_SET), -1);
+
+	std::array<char, 3> first{};
+	std::array<char, 16> second{};
+	std::array<std::span<std::byte>, 2> const buffers_to_read{
+		std::as_writable_bytes(std::span{first}),
+		std::as_writable_bytes(std::span{second})
+	};
+	auto const read_result = Pipe::os_services::io::readv(fd.get(), buffers_to_read);
+	EXPECT_EQ(read_result.bytes_transferred(), std::size(header) + std::size(body));
+	EXPECT_EQ((std::string_view{std::data(first), std::size(first)}), "Hel");
+	EXPECT_EQ((std::string_view{std::data(second), 9}), "lo, World");
+}
+
+TESTCASE(Pipe_io_advance_iovecs)
+{
+	std::array<char, 4> first{};
+	std::array<char, 0> empty{};
+	std::array<char, 8> second{};
+	std::array buffers{
+		iovec{.iov_base = std::data(first), .iov_len = std::size(first)},
+		iovec{.iov_base = std::data(empty), .iov_len = std::size(empty)},
+		iovec{.iov_base = std::data(second), .iov_len = std::size(second)}
+	};
+
+	auto remaining = Pipe::os_services::io::advance(buffers, 1);
+	REQUIRE_EQ(std::size(remaining), 3);
+	EXPECT_EQ(remaining[0].iov_base, std::data(first) + 1);
+	EXPECT_EQ(remaining[0].iov_len, 3);
+
+	// Empty buffers are skipped together with the completed ones
+	remaining = Pipe::os_services::io::advance(remaining, 5);
+	REQUIRE_EQ(std::size(remaining), 1);
+	EXPECT_EQ(remaining[0].iov_base, std::data(second) + 2);
+	EXPECT_EQ(remaining[0].iov_len, 6);
+
+	remaining = Pipe::os_services::io::advance(remaining, 6);
+	EXPECT_EQ(std::size(remaining), 0);
+}
+
+TESTCASE(Pipe_io_advance_spans)
+{
+	std::string_view const data{"Hello, World"};
+	std::array buffers{std::as_bytes(std::span{data}).first(5), std::as_bytes(std::span{data}).subspan(5)};
+
+	auto remaining = Pipe::os_services::io::advance(std::span{buffers}, 7);
+	REQUIRE_EQ(std::size(remaining), 1);
+	EXPECT_EQ(std::size(remaining[0]), 5);
+	EXPECT_EQ(std::data(remaining[0]), std::as_bytes(std::span{data}).data() + 7);
+
+	EXPECT_EQ(std::size(Pipe::os_services::io::advance(remaining, 5)), 0);
+}
@@ -0,0 +1,98 @@
+//@	{"target":{"name":"epoll_instance.bench"}}
+
+#include "./epoll_instance.hpp"
+#include "src/bench/bench.hpp"
+#include "src/os_services/ipc/eventfd.hpp"
+#include "src/os_services/io/io.hpp"
+
+#include <array>
+#include <cstdio>
+#include <sys/resource.h>
+
+namespace
+{
+	struct dispatch_counter
+	{
+		std::reference_wrapper<uint64_t> count;
+
+		void handle_event(
+			Pipe::os_services::fd::activity_event const&,
+			Pipe::os_services::io::input_file_descriptor_ref
+		)
+		{ ++count.get(); }
+	};
+
+	/**
+	 * \brief Raises the soft limit on the number of open files to the hard limit
+	 * \return The new soft limit
+	 */
+	rlim_t raise_open_file_limit()
+	{
+		rlimit limit{};
+		if(::getrlimit(RLIMIT_NOFILE, &limit) == -1)
+		{ throw Pipe::os_services::error_handling::system_error{"Failed to get open file limit", errno}; }
+
+		limit.rlim_cur = limit.rlim_max;
+		if(::setrlimit(RLIMIT_NOFILE, &limit) == -1)
+		{ throw Pipe::os_services::error_handling::system_error{"Failed to raise open file limit", errno}; }
+
+		return limit.rlim_cur;
+	}
+
+	/**
+	 * \brief Measures the dispatch rate of fd_count event handlers, that are ready at every wakeup
+	 *
+	 * The stats parameter of the measurement makes it possible to compare the cost of collecting
+	 * statistics per dispatch.
+	 */
+	template<class StatsPolicy>
+	void measure_dispatch_rate(Pipe::bench::run_context& context, size_t fd_count)
+	{
+		// Every eventfd is kept readable, so all event handlers are ready at every wakeup
+		Pipe::os_services::io_multiplexer::basic_epoll_instance<StatsPolicy> event_loop;
+		uint64_t dispatch_count = 0;
+		for(size_t k = 0; k != fd_count; ++k)
+		{
+			auto fd = Pipe::os_services::ipc::make_eventfd<Pipe::os_services::fd::io_mode::nonblocking>();
+			uint64_t const value = 1;
+			Pipe::os_services::io::write(fd.get(), std::as_bytes(std::span{&value, 1}));
+			std::ignore = event_loop.add(
+				std::move(fd),
+				Pipe::os_services::fd::activity_status::read,
+				dispatch_counter{dispatch_count}
+			);
+		}
+
+		context.measure(
+			"epoll_dispatch_rate",
+			{
+				{"fd_count", static_cast<int64_t>(fd_count)},
+				{"stats", StatsPolicy::enabled? 1 : 0}
+			},
+			[&event_loop, &dispatch_count](uint64_t iterations) {
+				dispatch_count = 0;
+				for(uint64_t k = 0; k != iterations; ++k)
+				{ event_loop.wait_for_and_distpatch_events(); }
+				return Pipe::bench::work_done{.items = dispatch_count, .bytes = 0};
+			}
+		);
+	}
+}
+
+BENCHMARK(Pipe_os_services_io_multiplexer_epoll_instance_dispatch_rate, context)
+{
+	auto const max_fds = raise_open_file_limit();
+	constexpr std::array<size_t, 6> fd_counts{1, 10, 100, 1000, 10000, 100000};
+	for(auto const fd_count : fd_counts)
+	{
+		// Leave some room for the standard streams and the epoll instance itself
+		if(fd_count + 16 > max_fds)
+		{
+			fprintf(stderr, "Skipping %zu file descriptors, because the open file limit is %zu\n", fd_count, static_cast<size_t>(max_fds));
+			continue;
+		}
+
+		measure_dispatch_rate<Pipe::os_services::io_multiplexer::no_event_loop_stats>(context, fd_count);
+		measure_dispatch_rate<Pipe::os_services::io_multiplexer::record_event_loop_stats>(context, fd_count);
+	}
+}
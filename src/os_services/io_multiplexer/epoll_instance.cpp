@@ -2,31 +2,108 @@
 
 #include "./epoll_instance.hpp"
 
-void Pipe::os_services::io_multiplexer::epoll_instance::wait_for_and_distpatch_events()
+template<Pipe::os_services::io_multiplexer::event_loop_stats_policy StatsPolicy>
+void Pipe::os_services::io_multiplexer::basic_epoll_instance<StatsPolicy>::dispatch(
+	epoll_entry_data& data,
+	fd::activity_status status
+)
+{
+	auto const id = data.get_id();
+	[[maybe_unused]] event_handler_stats* stats = nullptr;
+	[[maybe_unused]] auto sampled = false;
+	[[maybe_unused]] auto sample_start = event_loop_clock::time_point{};
+	if constexpr(StatsPolicy::enabled)
+	{
+		// Reading the clock costs more than the rest of the bookkeeping, so only some dispatches
+		// are timed
+		stats = &data.get_or_create_stats();
+		sampled = stats->dispatch_count % StatsPolicy::time_sample_interval == 0;
+		if(sampled)
+		{ sample_start = event_loop_clock::now(); }
+	}
+
+	auto const activity = epoll_fd_activity{data, status, m_epoll_fd.get(), m_budget}.process();
+	if constexpr(StatsPolicy::enabled)
+	{
+		if(sampled)
+		{ stats->handle_event_time.record(to_nanoseconds(event_loop_clock::now() - sample_start)); }
+		++stats->dispatch_count;
+		stats->bytes_transferred += activity.bytes_transferred();
+	}
+
+	if(activity.item_should_be_removed())
+	{
+		m_listeners.erase(id);
+		return;
+	}
+
+	if(activity.budget_exhausted())
+	{ m_deferred_events.push_back(deferred_event{.id = id, .status = status}); }
+}
+
+template<Pipe::os_services::io_multiplexer::event_loop_stats_policy StatsPolicy>
+void Pipe::os_services::io_multiplexer::basic_epoll_instance<StatsPolicy>::wait_for_and_distpatch_events()
 {
 	std::array<::epoll_event, 1024> events{};
+	[[maybe_unused]] auto const wait_start = StatsPolicy::enabled?
+		event_loop_clock::now() : event_loop_clock::time_point{};
 	auto const res = error_handling::do_while_eintr(
 		::epoll_wait,
 		m_epoll_fd.get().native_handle(),
 		std::data(events),
 		static_cast<int>(std::size(events)),
-		-1
+		m_deferred_events.empty()? -1 : 0
 	);
 	if(res == -1)
 	{ throw error_handling::system_error{"Failed to wait for events", errno}; }
 
+	[[maybe_unused]] auto const dispatch_start = StatsPolicy::enabled?
+		event_loop_clock::now() : event_loop_clock::time_point{};
+	if constexpr(StatsPolicy::enabled)
+	{
+		++m_loop_stats.wakeup_count;
+		m_loop_stats.events_per_wakeup.record(static_cast<uint64_t>(res));
+		m_loop_stats.wait_time.record(to_nanoseconds(dispatch_start - wait_start));
+	}
+
+	// Handlers that exhausted their budget are serviced last, even if they are reported again
+	auto deferred_events = std::exchange(m_deferred_events, std::vector<deferred_event>{});
+	std::ranges::sort(deferred_events, [](auto const& a, auto const& b) {
+		return a.id.value() < b.id.value();
+	});
+	auto const find_deferred = [&deferred_events](fd::event_handler_id id) {
+		auto const i = std::ranges::lower_bound(
+			deferred_events,
+			id.value(),
+			std::less<>{},
+			[](auto const& item) { return item.id.value(); }
+		);
+		return (i != std::end(deferred_events) && i->id == id)? i : std::end(deferred_events);
+	};
+
 	for(auto const& item : std::span{std::data(events), static_cast<size_t>(res)})
 	{
 		auto const data = static_cast<epoll_entry_data*>(item.data.ptr);
-		if(
-			epoll_fd_activity{
-				*data,
-				epoll_event_to_activity_status(item.events),
-				m_epoll_fd.get()
-			}.process().item_should_be_removed()
-		)
+		auto const status = epoll_event_to_activity_status(item.events);
+		if(auto const i = find_deferred(data->get_id()); i != std::end(deferred_events))
 		{
-			m_listeners.erase(data->get_id());
+			i->status = status;
+			continue;
 		}
+
+		dispatch(*data, status);
 	}
-}
\ No newline at end of file
+
+	for(auto const& item : deferred_events)
+	{
+		auto const i = m_listeners.find(item.id);
+		if(i != std::end(m_listeners))
+		{ dispatch(*i->second, item.status); }
+	}
+
+	if constexpr(StatsPolicy::enabled)
+	{ m_loop_stats.dispatch_time.record(to_nanoseconds(event_loop_clock::now() - dispatch_start)); }
+}
+
+template class Pipe::os_services::io_multiplexer::basic_epoll_instance<Pipe::os_services::io_multiplexer::record_event_loop_stats>;
+template class Pipe::os_services::io_multiplexer::basic_epoll_instance<Pipe::os_services::io_multiplexer::no_event_loop_stats>;
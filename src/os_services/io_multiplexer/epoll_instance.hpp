@@ -3,13 +3,18 @@
 #ifndef PIPE_OS_SERVICES_IO_MULTIPLEXER_EPOLL_INSTANCE_HPP
 #define PIPE_OS_SERVICES_IO_MULTIPLEXER_EPOLL_INSTANCE_HPP
 
+#include "./event_loop_stats.hpp"
+
 #include "src/os_services/fd/activity_monitor.hpp"
 #include "src/os_services/fd/file_descriptor.hpp"
 #include "src/os_services/error_handling/error_handling.hpp"
 #include "src/os_services/error_handling/system_error.hpp"
 
 #include <sys/epoll.h>
+#include <algorithm>
+#include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace Pipe::os_services::io_multiplexer
@@ -74,9 +79,52 @@ namespace Pipe::os_services::io_multiplexer
 		 * \brief Add virtual destructor so objects can be destructed polymorphically
 		 */
 		virtual ~epoll_entry_data() noexcept = default;
+
+		/**
+		 * \brief Returns the statistics collected for the event handler, allocating them the
+		 *        first time the event handler is dispatched
+		 *
+		 * The statistics are kept out of line, so event handlers that are never dispatched only
+		 * pay for a pointer.
+		 */
+		event_handler_stats& get_or_create_stats()
+		{
+			if(m_stats == nullptr)
+			{ m_stats = std::make_unique<event_handler_stats>(); }
+			return *m_stats;
+		}
+
+		/**
+		 * \brief Returns the statistics collected for the event handler, or nullptr if it has not
+		 *        been dispatched yet
+		 */
+		event_handler_stats const* stats() const noexcept
+		{ return m_stats.get(); }
+
+	private:
+		std::unique_ptr<event_handler_stats> m_stats;
 	};
 
 
+	/**
+	 * \brief Limits the amount of work an event handler may perform during a single dispatch
+	 *
+	 * An event handler that exceeds its budget is re-queued, and is serviced again after all other
+	 * ready file descriptors.
+	 */
+	struct dispatch_budget
+	{
+		/**
+		 * \brief The max number of bytes an event handler may transfer per dispatch
+		 */
+		size_t max_bytes{262144};
+
+		/**
+		 * \brief The max number of iterations an event handler may perform per dispatch
+		 */
+		size_t max_iterations{16};
+	};
+
 	struct epoll_fd_tag
 	{};
 
@@ -95,15 +143,18 @@ namespace Pipe::os_services::io_multiplexer
 		 * \param epoll_event_data The epoll_entry_data read from epoll_wait
 		 * \param status The current file descriptor activity_status
 		 * \param epoll_fd The epoll instance that issued this activity
+		 * \param budget The dispatch_budget for the event handler
 		 */
 		explicit epoll_fd_activity(
 			epoll_entry_data& epoll_event_data,
 			fd::activity_status status,
-			epoll_file_descriptor_ref epoll_fd
+			epoll_file_descriptor_ref epoll_fd,
+			dispatch_budget budget = dispatch_budget{}
 		) noexcept:
 			m_epoll_event_data{epoll_event_data},
 			m_status{status},
-			m_epoll_fd{epoll_fd}
+			m_epoll_fd{epoll_fd},
+			m_remaining_budget{budget}
 		{}
 
 		void update_listening_status(fd::activity_status new_status) const override
@@ -130,12 +181,34 @@ namespace Pipe::os_services::io_multiplexer
 		fd::activity_status get_activity_status() const noexcept override
 		{ return m_status; }
 
+		bool consume_budget(size_t num_bytes) const noexcept override
+		{
+			m_bytes_transferred += num_bytes;
+			m_remaining_budget.max_bytes -= std::min(num_bytes, m_remaining_budget.max_bytes);
+			m_remaining_budget.max_iterations -= std::min(size_t{1}, m_remaining_budget.max_iterations);
+			m_budget_exhausted = m_remaining_budget.max_bytes == 0
+				|| m_remaining_budget.max_iterations == 0;
+			return !m_budget_exhausted;
+		}
+
 		/**
 		 * \brief Check whether or not the event_data_should_be_deleted should be deleted
 		 */
 		bool item_should_be_removed() const
 		{ return m_item_should_be_removed; }
 
+		/**
+		 * \brief Check whether or not the event handler returned because it exhausted its budget
+		 */
+		bool budget_exhausted() const
+		{ return m_budget_exhausted; }
+
+		/**
+		 * \brief Returns the number of bytes the event handler has reported through consume_budget
+		 */
+		size_t bytes_transferred() const
+		{ return m_bytes_transferred; }
+
 		/**
 		 * \brief Processes the associated event
 		 */
@@ -149,7 +222,10 @@ namespace Pipe::os_services::io_multiplexer
 		std::reference_wrapper<epoll_entry_data> m_epoll_event_data;
 		fd::activity_status m_status;
 		fd::file_descriptor_ref m_epoll_fd;
+		mutable dispatch_budget m_remaining_budget;
 		mutable bool m_item_should_be_removed{false};
+		mutable bool m_budget_exhausted{false};
+		mutable size_t m_bytes_transferred{0};
 	};
 
 	/**
@@ -204,14 +280,18 @@ namespace Pipe::os_services::io_multiplexer
 
 	/**
 	 * \brief Used to monitor activity on file descriptors
+	 *
+	 * \tparam StatsPolicy Controls whether or not statistics are collected. With
+	 *         no_event_loop_stats, the event loop does not read the clock at all.
 	 */
-	class epoll_instance
+	template<event_loop_stats_policy StatsPolicy = record_event_loop_stats>
+	class basic_epoll_instance
 	{
 	public:
 		class config_transaction
 		{
 		public:
-			explicit config_transaction(epoll_instance& monitor):
+			explicit config_transaction(basic_epoll_instance& monitor):
 				m_monitor{monitor}
 			{}
 
@@ -221,7 +301,7 @@ namespace Pipe::os_services::io_multiplexer
 				{ m_monitor.get().remove(item); }
 			}
 
-			template<class FileDescriptorTag, fd::activity_event_handler<FileDescriptorTag> EventHandler>
+			template<fd::nonblocking_fd_tag FileDescriptorTag, fd::activity_event_handler<FileDescriptorTag> EventHandler>
 			auto& add(
 				fd::tagged_file_descriptor<FileDescriptorTag> fd_to_watch,
 				fd::activity_status initial_listen_status,
@@ -237,19 +317,28 @@ namespace Pipe::os_services::io_multiplexer
 				return *this;
 			}
 
+			/**
+			 * \brief Returns the id of the event handler most recently added by this transaction
+			 * \pre At least one event handler has been added
+			 */
+			fd::event_handler_id last_added_id() const
+			{ return m_added_ids.back(); }
+
 			void commit()
 			{ m_added_ids.clear(); }
 
 		private:
-			std::reference_wrapper<epoll_instance> m_monitor;
+			std::reference_wrapper<basic_epoll_instance> m_monitor;
 			std::vector<fd::event_handler_id> m_added_ids;
 		};
 
 		/**
-		 * \brief Constructs an epoll_instance
+		 * \brief Constructs a basic_epoll_instance
+		 * \param budget The dispatch_budget to use for each event handler
 		 */
-		epoll_instance():
-			m_epoll_fd{::epoll_create1(0)}
+		explicit basic_epoll_instance(dispatch_budget budget = dispatch_budget{}):
+			m_epoll_fd{::epoll_create1(0)},
+			m_budget{budget}
 		{
 			if(m_epoll_fd == nullptr)
 			{ throw error_handling::system_error{"Failed to an fd activity monitor", errno}; }
@@ -263,8 +352,11 @@ namespace Pipe::os_services::io_multiplexer
 		/**
 		 * \brief Adds fd_to_watch to the epoll_instance, and starts listen for the activity_status
 		 * given by initial_listen_status
+		 *
+		 * \note fd_to_watch must be non-blocking, since a blocking read or write within an event
+		 *       handler would stall all other event handlers
 		 */
-		template<class FileDescriptorTag, fd::activity_event_handler<FileDescriptorTag> EventHandler>
+		template<fd::nonblocking_fd_tag FileDescriptorTag, fd::activity_event_handler<FileDescriptorTag> EventHandler>
 		[[nodiscard]] fd::event_handler_id add(
 			fd::tagged_file_descriptor<FileDescriptorTag> fd_to_watch,
 			fd::activity_status initial_listen_status,
@@ -309,6 +401,36 @@ namespace Pipe::os_services::io_multiplexer
 			}
 			return id;
 		}
+		/**
+		 * \brief Updates the activity_status to listen for, for the event handler identified by id
+		 *
+		 * This makes it possible to resume listening for write activity, when data for an event
+		 * handler becomes available from another event handler.
+		 *
+		 * \note If there is no event handler with the given id, this function does nothing
+		 */
+		void update_listening_status(fd::event_handler_id id, fd::activity_status new_status)
+		{
+			auto const i = m_listeners.find(id);
+			if(i == std::end(m_listeners))
+			{ return; }
+
+			::epoll_event event{
+				.events = to_epoll_event(new_status),
+				.data = ::epoll_data{
+					.ptr = i->second.get()
+				}
+			};
+			auto const result = ::epoll_ctl(
+				m_epoll_fd.get().native_handle(),
+				EPOLL_CTL_MOD,
+				i->second->get_fd_native_handle(),
+				&event
+			);
+			if(result == -1)
+			{ throw error_handling::system_error{"Failed to update epoll event", errno}; }
+		}
+
 		void remove(fd::event_handler_id id) noexcept
 		{
 			auto i = m_listeners.find(id);
@@ -320,14 +442,91 @@ namespace Pipe::os_services::io_multiplexer
 
 		/**
 		 * \brief Waits for incoming events
+		 *
+		 * Event handlers that exhausted their dispatch_budget during the previous call are serviced
+		 * after all other ready file descriptors. If there are such event handlers, this function
+		 * does not block.
 		 */
 		void wait_for_and_distpatch_events();
 
+		/**
+		 * \brief Returns the number of event handlers that are waiting to be serviced again, because
+		 *        they exhausted their budget
+		 */
+		size_t deferred_event_count() const noexcept
+		{ return std::size(m_deferred_events); }
+
+		/**
+		 * \brief Returns the statistics collected for the event loop
+		 * \note No statistics are collected with no_event_loop_stats
+		 */
+		event_loop_stats const& get_loop_stats() const noexcept
+		{ return m_loop_stats; }
+
+		/**
+		 * \brief Returns the statistics collected for the event handler identified by id
+		 *
+		 * Statistics are discarded when the event handler is removed.
+		 *
+		 * \return The statistics of the event handler, or nullptr if there is no such event
+		 *         handler, if it has not been dispatched yet, or if statistics are disabled by
+		 *         StatsPolicy
+		 */
+		event_handler_stats const* get_handler_stats([[maybe_unused]] fd::event_handler_id id) const noexcept
+		{
+			if constexpr(StatsPolicy::enabled)
+			{
+				auto const i = m_listeners.find(id);
+				return i != std::end(m_listeners)? i->second->stats() : nullptr;
+			}
+			else
+			{ return nullptr; }
+		}
+
+		/**
+		 * \brief Calls func with the id and the statistics of each event handler that has been
+		 *        dispatched
+		 *
+		 * This can be used to find the event handlers that take the most time.
+		 */
+		template<class Func>
+		void visit_handler_stats([[maybe_unused]] Func&& func) const
+		{
+			if constexpr(StatsPolicy::enabled)
+			{
+				for(auto const& item : m_listeners)
+				{
+					if(auto const stats = item.second->stats(); stats != nullptr)
+					{ func(item.first, *stats); }
+				}
+			}
+		}
+
 	private:
+		void dispatch(epoll_entry_data& data, fd::activity_status status);
+
 		epoll_file_descriptor m_epoll_fd;
 		std::unordered_map<fd::event_handler_id, std::unique_ptr<epoll_entry_data>, fd::event_handler_id_hash> m_listeners;
 		fd::event_handler_id m_current_id;
+		dispatch_budget m_budget;
+
+		struct deferred_event
+		{
+			fd::event_handler_id id;
+			fd::activity_status status;
+		};
+		std::vector<deferred_event> m_deferred_events;
+
+		event_loop_stats m_loop_stats;
 	};
+
+	extern template class basic_epoll_instance<record_event_loop_stats>;
+	extern template class basic_epoll_instance<no_event_loop_stats>;
+
+	/**
+	 * \brief The epoll_instance used by default, which collects statistics
+	 */
+	using epoll_instance = basic_epoll_instance<>;
 }
 
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "src/os_services/fd/activity_monitor.hpp"
 #include "src/os_services/fd/file_descriptor.hpp"
 #include "src/os_services/io/io.hpp"
+#include "src/os_services/ipc/pipe.hpp"
 #include "src/os_services/ipc/socket.hpp"
 #include "src/os_services/ipc/unix_domain_socket.hpp"
 #include "src/utils/utils.hpp"
@@ -190,13 +191,13 @@ namespace
 
 		void handle_event(
 			Pipe::os_services::fd::activity_event const& activity,
-			Pipe::os_services::ipc::server_socket_ref<SOCK_SEQPACKET, sockaddr_un> fd
+			Pipe::os_services::ipc::nonblocking_server_socket_ref<SOCK_SEQPACKET, sockaddr_un> fd
 		)
 		{
 			if(can_read(activity.get_activity_status()))
 			{
 				auto id = monitor.get().add(
-					accept(fd),
+					accept_nonblocking(fd),
 					Pipe::os_services::fd::activity_status::read,
 					my_client{}
 				);
@@ -241,7 +242,10 @@ TESTCASE(Pipe_os_services_io_multiplexer_epoll_instance)
 		Pipe::os_services::io_multiplexer::epoll_instance monitor;
 		EXPECT_EQ(
 			monitor.add(
-				Pipe::os_services::ipc::make_server_socket<SOCK_SEQPACKET>(address, 1024),
+				Pipe::os_services::ipc::make_server_socket<
+					SOCK_SEQPACKET,
+					Pipe::os_services::fd::io_mode::nonblocking
+				>(address, 1024),
 				Pipe::os_services::fd::activity_status::read,
 				my_server_event_handler{monitor}
 			),
@@ -276,3 +280,222 @@ TESTCASE(Pipe_os_services_io_multiplexer_epoll_instance)
 	);
 	EXPECT_EQ(read_result.bytes_transferred(), 12);
 }
+
+TESTCASE(Pipe_os_services_io_multiplexer_epoll_fd_activity_consume_budget)
+{
+	my_epoll_entry_data_status status;
+	my_epoll_entry_data my_data{status};
+
+	{
+		Pipe::os_services::io_multiplexer::epoll_fd_activity activity{
+			my_data,
+			Pipe::os_services::fd::activity_status::read,
+			Pipe::os_services::io_multiplexer::epoll_file_descriptor_ref{},
+			Pipe::os_services::io_multiplexer::dispatch_budget{.max_bytes = 10, .max_iterations = 100}
+		};
+
+		EXPECT_EQ(activity.consume_budget(4), true);
+		EXPECT_EQ(activity.budget_exhausted(), false);
+		EXPECT_EQ(activity.consume_budget(8), false);
+		EXPECT_EQ(activity.budget_exhausted(), true);
+	}
+
+	{
+		Pipe::os_services::io_multiplexer::epoll_fd_activity activity{
+			my_data,
+			Pipe::os_services::fd::activity_status::read,
+			Pipe::os_services::io_multiplexer::epoll_file_descriptor_ref{},
+			Pipe::os_services::io_multiplexer::dispatch_budget{.max_bytes = 100, .max_iterations = 2}
+		};
+
+		EXPECT_EQ(activity.consume_budget(0), true);
+		EXPECT_EQ(activity.consume_budget(0), false);
+		EXPECT_EQ(activity.budget_exhausted(), true);
+	}
+}
+
+namespace
+{
+	struct my_chunked_reader
+	{
+		char name;
+		std::reference_wrapper<std::string> reads;
+
+		void handle_event(
+			Pipe::os_services::fd::activity_event const& activity,
+			Pipe::os_services::io::input_file_descriptor_ref fd
+		)
+		{
+			while(true)
+			{
+				std::array<std::byte, 4> buffer;
+				auto res = Pipe::os_services::io::read(fd, buffer);
+				if(res.operation_would_have_blocked())
+				{ return; }
+
+				if(res.bytes_transferred() == 0)
+				{
+					activity.stop_listening();
+					return;
+				}
+
+				reads.get().push_back(name);
+				if(!activity.consume_budget(res.bytes_transferred()))
+				{ return; }
+			}
+		}
+	};
+}
+
+TESTCASE(Pipe_os_services_io_multiplexer_epoll_instance_budget_exhausted)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance monitor{
+		Pipe::os_services::io_multiplexer::dispatch_budget{.max_bytes = 8, .max_iterations = 16}
+	};
+
+	Pipe::os_services::ipc::pipe<Pipe::os_services::fd::io_mode::nonblocking> chatty;
+	Pipe::os_services::ipc::pipe<Pipe::os_services::fd::io_mode::nonblocking> quiet;
+
+	std::string reads;
+	std::ignore = monitor.add(
+		chatty.take_read_end(),
+		Pipe::os_services::fd::activity_status::read,
+		my_chunked_reader{'A', reads}
+	);
+	std::ignore = monitor.add(
+		quiet.take_read_end(),
+		Pipe::os_services::fd::activity_status::read,
+		my_chunked_reader{'B', reads}
+	);
+
+	std::string_view chatty_data{"0123456789abcdef"};
+	write(chatty.write_end(), std::as_bytes(std::span{chatty_data}));
+
+	monitor.wait_for_and_distpatch_events();
+	EXPECT_EQ(reads, "AA");
+	EXPECT_EQ(monitor.deferred_event_count(), 1);
+
+	// The chatty handler should be serviced after the quiet one, although it has data ready
+	write(quiet.write_end(), std::as_bytes(std::span{std::string_view{"x"}}));
+	monitor.wait_for_and_distpatch_events();
+	EXPECT_EQ(reads, "AABAA");
+	EXPECT_EQ(monitor.deferred_event_count(), 1);
+
+	// The pipe is now empty, so the handler should not be re-queued
+	monitor.wait_for_and_distpatch_events();
+	EXPECT_EQ(reads, "AABAA");
+	EXPECT_EQ(monitor.deferred_event_count(), 0);
+}
+
+namespace
+{
+	struct my_status_recorder
+	{
+		std::reference_wrapper<std::vector<Pipe::os_services::fd::activity_status>> events;
+
+		void handle_event(
+			Pipe::os_services::fd::activity_event const& activity,
+			Pipe::os_services::io::output_file_descriptor_ref
+		)
+		{
+			events.get().push_back(activity.get_activity_status());
+			activity.update_listening_status(Pipe::os_services::fd::activity_status::read);
+		}
+	};
+}
+
+TESTCASE(Pipe_os_services_io_multiplexer_epoll_instance_update_listening_status)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance monitor;
+	Pipe::os_services::ipc::pipe<
+		Pipe::os_services::fd::io_mode::blocking,
+		Pipe::os_services::fd::io_mode::nonblocking
+	> data_pipe;
+
+	std::vector<Pipe::os_services::fd::activity_status> events;
+	auto const id = monitor.add(
+		data_pipe.take_write_end(),
+		Pipe::os_services::fd::activity_status::read,
+		my_status_recorder{events}
+	);
+
+	monitor.update_listening_status(id, Pipe::os_services::fd::activity_status::write);
+	monitor.wait_for_and_distpatch_events();
+	REQUIRE_EQ(std::size(events), 1);
+	EXPECT_EQ(events[0], Pipe::os_services::fd::activity_status::write);
+
+	// Updating the status of a removed event handler should be a no-op
+	monitor.remove(id);
+	monitor.update_listening_status(id, Pipe::os_services::fd::activity_status::write);
+}
+
+TESTCASE(Pipe_os_services_io_multiplexer_epoll_instance_stats)
+{
+	Pipe::os_services::io_multiplexer::epoll_instance monitor;
+	Pipe::os_services::ipc::pipe<Pipe::os_services::fd::io_mode::nonblocking> data_pipe;
+
+	std::string reads;
+	auto const id = monitor.add(
+		data_pipe.take_read_end(),
+		Pipe::os_services::fd::activity_status::read,
+		my_chunked_reader{'A', reads}
+	);
+
+	write(data_pipe.write_end(), std::as_bytes(std::span{std::string_view{"0123456789"}}));
+	monitor.wait_for_and_distpatch_events();
+	EXPECT_EQ(reads, "AAA");
+
+	auto const handler_stats = monitor.get_handler_stats(id);
+	auto const& loop_stats = monitor.get_loop_stats();
+	REQUIRE_NE(handler_stats, nullptr);
+	EXPECT_EQ(handler_stats->dispatch_count, 1);
+	EXPECT_EQ(handler_stats->bytes_transferred, 10);
+	EXPECT_EQ(handler_stats->handle_event_time.count(), 1);
+
+	EXPECT_EQ(loop_stats.wakeup_count, 1);
+	EXPECT_EQ(loop_stats.events_per_wakeup.max(), 1);
+	EXPECT_EQ(loop_stats.wait_time.count(), 1);
+	EXPECT_EQ(loop_stats.dispatch_time.count(), 1);
+	EXPECT_GE(loop_stats.dispatch_time.max(), handler_stats->handle_event_time.max());
+
+	size_t visited = 0;
+	monitor.visit_handler_stats([&visited, id](auto handler_id, auto const& stats) {
+		EXPECT_EQ(handler_id, id);
+		EXPECT_EQ(stats.dispatch_count, 1);
+		++visited;
+	});
+	EXPECT_EQ(visited, 1);
+
+	// Closing the write end removes the event handler, together with its statistics
+	data_pipe.close_write_end();
+	monitor.wait_for_and_distpatch_events();
+	EXPECT_EQ(monitor.get_handler_stats(id), nullptr);
+}
+
+TESTCASE(Pipe_os_services_io_multiplexer_epoll_instance_no_stats)
+{
+	Pipe::os_services::io_multiplexer::basic_epoll_instance<
+		Pipe::os_services::io_multiplexer::no_event_loop_stats
+	> monitor;
+	Pipe::os_services::ipc::pipe<Pipe::os_services::fd::io_mode::nonblocking> data_pipe;
+
+	std::string reads;
+	auto const id = monitor.add(
+		data_pipe.take_read_end(),
+		Pipe::os_services::fd::activity_status::read,
+		my_chunked_reader{'A', reads}
+	);
+
+	write(data_pipe.write_end(), std::as_bytes(std::span{std::string_view{"0123456789"}}));
+	monitor.wait_for_and_distpatch_events();
+	EXPECT_EQ(reads, "AAA");
+
+	EXPECT_EQ(monitor.get_handler_stats(id), nullptr);
+	EXPECT_EQ(monitor.get_loop_stats().wakeup_count, 0);
+
+	size_t visited = 0;
+	monitor.visit_handler_stats([&visited](auto, auto const&) {
+		++visited;
+	});
+	EXPECT_EQ(visited, 0);
+}
@@ -0,0 +1,112 @@
+#ifndef PIPE_OS_SERVICES_IO_MULTIPLEXER_EVENT_LOOP_STATS_HPP
+#define PIPE_OS_SERVICES_IO_MULTIPLEXER_EVENT_LOOP_STATS_HPP
+
+#include "src/utils/histogram.hpp"
+
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+
+namespace Pipe::os_services::io_multiplexer
+{
+	/**
+	 * \brief Stats policy for basic_epoll_instance, that records event_loop_stats, and
+	 *        event_handler_stats for each event handler
+	 */
+	struct record_event_loop_stats
+	{
+		static constexpr bool enabled = true;
+
+		/**
+		 * \brief The time spent in handle_event is measured for every time_sample_interval:th
+		 *        dispatch of each event handler, starting with the first one
+		 */
+		static constexpr uint64_t time_sample_interval = 16;
+	};
+
+	/**
+	 * \brief Stats policy for basic_epoll_instance, that removes all instrumentation from the
+	 *        event loop at compile time
+	 */
+	struct no_event_loop_stats
+	{
+		static constexpr bool enabled = false;
+	};
+
+	/**
+	 * \brief Concept for a type that controls whether or not an event loop collects statistics
+	 */
+	template<class T>
+	concept event_loop_stats_policy = requires()
+	{
+		{ T::enabled } -> std::convertible_to<bool>;
+	};
+
+	/**
+	 * \brief The clock used to measure time spent in the event loop
+	 */
+	using event_loop_clock = std::chrono::steady_clock;
+
+	/**
+	 * \brief Converts a duration measured by event_loop_clock to nanoseconds, for recording in a
+	 *        histogram
+	 */
+	constexpr uint64_t to_nanoseconds(event_loop_clock::duration duration) noexcept
+	{
+		auto const ret = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		return ret < 0? 0 : static_cast<uint64_t>(ret);
+	}
+
+	/**
+	 * \brief Statistics collected for a single event handler
+	 * \note All times are recorded in nanoseconds
+	 */
+	struct event_handler_stats
+	{
+		/**
+		 * \brief The number of times the event handler has been dispatched
+		 */
+		uint64_t dispatch_count{0};
+
+		/**
+		 * \brief The time spent in handle_event, for the dispatches selected by the
+		 *        time_sample_interval of the stats policy
+		 */
+		utils::log_histogram handle_event_time;
+
+		/**
+		 * \brief The number of bytes the event handler has reported through
+		 *        activity_event::consume_budget
+		 */
+		uint64_t bytes_transferred{0};
+	};
+
+	/**
+	 * \brief Statistics collected for an event loop
+	 * \note All times are recorded in nanoseconds
+	 */
+	struct event_loop_stats
+	{
+		/**
+		 * \brief The number of times the event loop has returned from waiting for events
+		 */
+		uint64_t wakeup_count{0};
+
+		/**
+		 * \brief The number of ready file descriptors reported by each wakeup
+		 */
+		utils::log_histogram events_per_wakeup;
+
+		/**
+		 * \brief The time spent blocked waiting for events
+		 */
+		utils::log_histogram wait_time;
+
+		/**
+		 * \brief The time spent dispatching events, for each wakeup
+		 */
+		utils::log_histogram dispatch_time;
+	};
+}
+
+#endif
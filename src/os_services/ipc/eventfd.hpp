@@ -36,12 +36,29 @@ namespace Pipe::os_services::ipc
 	 */
 	using eventfd = fd::tagged_file_descriptor<eventfd_tag>;
 
+	/**
+	 * \brief A reference to a non-blocking event file descriptor
+	 */
+	using nonblocking_eventfd_ref = fd::tagged_file_descriptor_ref<fd::nonblocking_tag<eventfd_tag>>;
+
+	/**
+	 * \brief An owner of a non-blocking event file descriptor
+	 */
+	using nonblocking_eventfd = fd::tagged_file_descriptor<fd::nonblocking_tag<eventfd_tag>>;
+
 	/**
 	 * \brief Creates an event file descriptor, to be used for synchronization between processes
+	 *
+	 * The file descriptor is closed on exec.
+	 *
+	 * \tparam Mode Whether or not the event file descriptor is non-blocking
 	 */
+	template<fd::io_mode Mode = fd::io_mode::blocking>
 	inline auto make_eventfd()
 	{
-		eventfd ret{::eventfd(0, 0)};
+		fd::tagged_file_descriptor<fd::tag_for_io_mode<eventfd_tag, Mode>> ret{
+			::eventfd(0, EFD_CLOEXEC | (Mode == fd::io_mode::nonblocking? EFD_NONBLOCK : 0))
+		};
 		if(ret == nullptr)
 		{ throw error_handling::system_error{"Failed to create eventfd", errno}; }
 		return ret;
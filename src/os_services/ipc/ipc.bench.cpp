@@ -0,0 +1,93 @@
+//@	{"target":{"name":"ipc.bench"}}
+
+#include "./pipe.hpp"
+#include "./socket_pair.hpp"
+#include "src/bench/bench.hpp"
+#include "src/os_services/io/io.hpp"
+
+#include <array>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr std::array<size_t, 5> chunk_sizes{64, 512, 4096, 16384, 65536};
+
+	/**
+	 * \brief Writes iterations chunks of chunk_size bytes to write_end, while another thread reads
+	 *        them from read_end until end of file
+	 */
+	template<class ReadEnd, class WriteEnd>
+	Pipe::bench::work_done transfer(ReadEnd read_end, WriteEnd write_end, size_t chunk_size, uint64_t iterations)
+	{
+		std::jthread reader{[read_end = std::move(read_end)]() {
+			std::vector<std::byte> buffer(65536);
+			while(true)
+			{
+				auto const res = Pipe::os_services::io::read(read_end.get(), buffer);
+				if(res.bytes_transferred() == 0)
+				{ return; }
+			}
+		}};
+
+		std::vector<std::byte> const chunk(chunk_size);
+		for(uint64_t k = 0; k != iterations; ++k)
+		{
+			std::span<std::byte const> data_to_write{chunk};
+			while(!data_to_write.empty())
+			{
+				auto const res = Pipe::os_services::io::write(write_end.get(), data_to_write);
+				data_to_write = data_to_write.subspan(res.bytes_transferred());
+			}
+		}
+		write_end.reset();
+		reader.join();
+
+		return Pipe::bench::work_done{.items = iterations, .bytes = iterations*chunk_size};
+	}
+}
+
+BENCHMARK(Pipe_os_services_ipc_pipe_throughput, context)
+{
+	for(auto const chunk_size : chunk_sizes)
+	{
+		context.measure(
+			"pipe_throughput",
+			{{"chunk_size", static_cast<int64_t>(chunk_size)}},
+			[chunk_size](uint64_t iterations) {
+				Pipe::os_services::ipc::pipe fds;
+				return transfer(fds.take_read_end(), fds.take_write_end(), chunk_size, iterations);
+			}
+		);
+	}
+}
+
+BENCHMARK(Pipe_os_services_ipc_socket_pair_stream_throughput, context)
+{
+	for(auto const chunk_size : chunk_sizes)
+	{
+		context.measure(
+			"socket_pair_stream_throughput",
+			{{"chunk_size", static_cast<int64_t>(chunk_size)}},
+			[chunk_size](uint64_t iterations) {
+				Pipe::os_services::ipc::socket_pair<SOCK_STREAM> sockets;
+				return transfer(sockets.take_socket_b(), sockets.take_socket_a(), chunk_size, iterations);
+			}
+		);
+	}
+}
+
+BENCHMARK(Pipe_os_services_ipc_socket_pair_seqpacket_throughput, context)
+{
+	for(auto const chunk_size : chunk_sizes)
+	{
+		context.measure(
+			"socket_pair_seqpacket_throughput",
+			{{"chunk_size", static_cast<int64_t>(chunk_size)}},
+			[chunk_size](uint64_t iterations) {
+				Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET> sockets;
+				return transfer(sockets.take_socket_b(), sockets.take_socket_a(), chunk_size, iterations);
+			}
+		);
+	}
+}
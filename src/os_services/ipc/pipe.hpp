@@ -11,22 +11,43 @@ namespace Pipe::os_services::ipc
 {
 	/**
 	 * \brief A pipe is a unidirectional communication channel, with a read end and a write end
+	 *
+	 * Both ends are closed on exec. An end that is redirected to a standard stream of a child
+	 * process is still inherited, since `dup2` clears the flag.
+	 *
+	 * \tparam ReadEndMode Whether or not the read end is non-blocking
+	 * \tparam WriteEndMode Whether or not the write end is non-blocking
 	 */
+	template<fd::io_mode ReadEndMode = fd::io_mode::blocking, fd::io_mode WriteEndMode = fd::io_mode::blocking>
 	class pipe
 	{
 	public:
+		using read_end_tag = fd::tag_for_io_mode<io::input_file_descriptor_tag, ReadEndMode>;
+		using write_end_tag = fd::tag_for_io_mode<io::output_file_descriptor_tag, WriteEndMode>;
+
 		/**
 		 * \brief Constructs a pipe
 		 */
 		pipe()
 		{
 			std::array<int, 2> fds{};
-			auto const res = ::pipe(std::data(fds));
+			constexpr auto both_nonblocking = ReadEndMode == fd::io_mode::nonblocking
+				&& WriteEndMode == fd::io_mode::nonblocking;
+			auto const res = ::pipe2(std::data(fds), O_CLOEXEC | (both_nonblocking? O_NONBLOCK : 0));
 			if(res == -1)
 			{ throw error_handling::system_error{"Failed to create pipe", errno}; }
 
-			m_read_end = io::input_file_descriptor{fds[0]};
-			m_write_end = io::output_file_descriptor{fds[1]};
+			m_read_end = fd::tagged_file_descriptor<read_end_tag>{fds[0]};
+			m_write_end = fd::tagged_file_descriptor<write_end_tag>{fds[1]};
+
+			if constexpr(!both_nonblocking)
+			{
+				if constexpr(ReadEndMode == fd::io_mode::nonblocking)
+				{ make_nonblocking(fds[0]); }
+
+				if constexpr(WriteEndMode == fd::io_mode::nonblocking)
+				{ make_nonblocking(fds[1]); }
+			}
 		}
 
 		/**
@@ -74,8 +95,14 @@ namespace Pipe::os_services::ipc
 		{ return std::move(m_read_end); }
 
 	private:
-		io::input_file_descriptor m_read_end;
-		io::output_file_descriptor m_write_end;
+		static void make_nonblocking(int fd)
+		{
+			if(::fcntl(fd, F_SETFL, O_NONBLOCK) == -1)
+			{ throw error_handling::system_error{"Failed to make pipe non-blocking", errno}; }
+		}
+
+		fd::tagged_file_descriptor<read_end_tag> m_read_end;
+		fd::tagged_file_descriptor<write_end_tag> m_write_end;
 	};
 }
 
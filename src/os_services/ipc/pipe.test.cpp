@@ -25,4 +25,34 @@ TESTCASE(Pipe_ipc_pipe_create_and_do_stuff)
 	the_pipe.close_write_end();
 	EXPECT_EQ(the_pipe.read_end(), nullptr);
 	EXPECT_EQ(the_pipe.write_end(), nullptr);
-}
\ No newline at end of file
+}
+TESTCASE(Pipe_ipc_pipe_nonblocking_read_end)
+{
+	Pipe::os_services::ipc::pipe<Pipe::os_services::fd::io_mode::nonblocking> the_pipe;
+	static_assert(Pipe::os_services::fd::nonblocking_fd_tag<decltype(the_pipe.read_end())::tag_type>);
+	static_assert(!Pipe::os_services::fd::nonblocking_fd_tag<decltype(the_pipe.write_end())::tag_type>);
+
+	EXPECT_NE(::fcntl(the_pipe.read_end().native_handle(), F_GETFL) & O_NONBLOCK, 0);
+	EXPECT_EQ(::fcntl(the_pipe.write_end().native_handle(), F_GETFL) & O_NONBLOCK, 0);
+	EXPECT_NE(::fcntl(the_pipe.read_end().native_handle(), F_GETFD) & FD_CLOEXEC, 0);
+	EXPECT_NE(::fcntl(the_pipe.write_end().native_handle(), F_GETFD) & FD_CLOEXEC, 0);
+
+	std::array<char, 12> buffer{};
+	auto const read_result = Pipe::os_services::io::read(the_pipe.read_end(), std::as_writable_bytes(std::span{buffer}));
+	EXPECT_EQ(read_result.operation_would_have_blocked(), true);
+}
+
+TESTCASE(Pipe_ipc_pipe_nonblocking_both_ends)
+{
+	Pipe::os_services::ipc::pipe<
+		Pipe::os_services::fd::io_mode::nonblocking,
+		Pipe::os_services::fd::io_mode::nonblocking
+	> the_pipe;
+	EXPECT_NE(::fcntl(the_pipe.read_end().native_handle(), F_GETFL) & O_NONBLOCK, 0);
+	EXPECT_NE(::fcntl(the_pipe.write_end().native_handle(), F_GETFL) & O_NONBLOCK, 0);
+
+	// Fill the pipe, which must not block
+	std::array<std::byte, 4096> buffer{};
+	while(!Pipe::os_services::io::write(the_pipe.write_end(), buffer).operation_would_have_blocked())
+	{}
+}
@@ -4,6 +4,8 @@
 #include "src/os_services/io/io.hpp"
 #include "src/os_services/error_handling/system_error.hpp"
 
+#include <span>
+#include <tuple>
 #include <sys/socket.h>
 
 namespace Pipe::os_services::ipc
@@ -42,13 +44,25 @@ namespace Pipe::os_services::ipc
 	template<auto SocketType, class AddressType>
 	using basic_socket = fd::tagged_file_descriptor<basic_socket_tag<SocketType, AddressType>>;
 
+	/**
+	 * \brief Returns the flags to pass to `socket` or `accept4`, for a socket created with mode Mode
+	 *
+	 * Sockets are always closed on exec. Use the fds_to_forward parameter of proc_mgmt::spawn to
+	 * pass a socket to a child process.
+	 */
+	template<fd::io_mode Mode>
+	constexpr int socket_flags() noexcept
+	{ return SOCK_CLOEXEC | (Mode == fd::io_mode::nonblocking? SOCK_NONBLOCK : 0); }
+
 	/**
 	 * \brief Creates a basic socket
 	 */
-	template<auto SocketType, class AddressType>
+	template<auto SocketType, class AddressType, fd::io_mode Mode = fd::io_mode::blocking>
 	auto make_socket()
 	{
-		basic_socket<SocketType, AddressType> ret{::socket(domain_v<AddressType>, SocketType, 0)};
+		fd::tagged_file_descriptor<fd::tag_for_io_mode<basic_socket_tag<SocketType, AddressType>, Mode>> ret{
+			::socket(domain_v<AddressType>, SocketType | socket_flags<Mode>(), 0)
+		};
 		if(ret == nullptr)
 		{ throw error_handling::system_error{"Failed to create a socket", errno}; }
 		return ret;
@@ -73,6 +87,22 @@ namespace Pipe::os_services::ipc
 	template<auto SocketType, class AddressType>
 	using server_socket = fd::tagged_file_descriptor<server_socket_tag<SocketType, AddressType>>;
 
+	/**
+	 * \brief A reference to a non-blocking server socket
+	 */
+	template<auto SocketType, class AddressType>
+	using nonblocking_server_socket_ref = fd::tagged_file_descriptor_ref<
+		fd::nonblocking_tag<server_socket_tag<SocketType, AddressType>>
+	>;
+
+	/**
+	 * \brief An owner of a non-blocking server socket
+	 */
+	template<auto SocketType, class AddressType>
+	using nonblocking_server_socket = fd::tagged_file_descriptor<
+		fd::nonblocking_tag<server_socket_tag<SocketType, AddressType>>
+	>;
+
 	/**
 	 * \brief A Tag type used to identify a connected socket
 	 */
@@ -109,18 +139,72 @@ namespace Pipe::os_services::ipc
 	template<auto SocketType, class AddressType>
 	using connected_socket = fd::tagged_file_descriptor<connected_socket_tag<SocketType, AddressType>>;
 
+	/**
+	 * \brief A reference to a non-blocking connected socket
+	 */
+	template<auto SocketType, class AddressType>
+	using nonblocking_connected_socket_ref = fd::tagged_file_descriptor_ref<
+		fd::nonblocking_tag<connected_socket_tag<SocketType, AddressType>>
+	>;
+
+	/**
+	 * \brief An owner of a non-blocking connected socket
+	 */
+	template<auto SocketType, class AddressType>
+	using nonblocking_connected_socket = fd::tagged_file_descriptor<
+		fd::nonblocking_tag<connected_socket_tag<SocketType, AddressType>>
+	>;
+
 	/**
 	 * \brief Accepts an incoming connection on server_socket
 	 */
 	template<auto SocketType, class AddressType>
 	connected_socket<SocketType, AddressType> accept(server_socket_ref<SocketType, AddressType> server_socket)
 	{
-		connected_socket<SocketType, AddressType> ret{::accept(server_socket.native_handle(), nullptr, nullptr)};
+		connected_socket<SocketType, AddressType> ret{
+			::accept4(server_socket.native_handle(), nullptr, nullptr, socket_flags<fd::io_mode::blocking>())
+		};
 		if(ret == nullptr)
 		{ throw error_handling::system_error{"Failed to accept connection from socket", errno}; }
 		return ret;
 	}
 
+	/**
+	 * \brief Accepts an incoming connection on server_socket, without blocking the calling thread
+	 *
+	 * The accepted socket is non-blocking, and is closed on exec.
+	 *
+	 * \return The accepted connection, or an empty socket if there are no pending connections
+	 */
+	template<auto SocketType, class AddressType>
+	nonblocking_connected_socket<SocketType, AddressType> accept_nonblocking(
+		nonblocking_server_socket_ref<SocketType, AddressType> server_socket
+	)
+	{
+		while(true)
+		{
+			nonblocking_connected_socket<SocketType, AddressType> ret{
+				error_handling::do_while_eintr(
+					::accept4,
+					server_socket.native_handle(),
+					static_cast<sockaddr*>(nullptr),
+					static_cast<socklen_t*>(nullptr),
+					socket_flags<fd::io_mode::nonblocking>()
+				)
+			};
+			if(ret != nullptr)
+			{ return ret; }
+
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{ return ret; }
+
+			// The peer gave up before the connection was accepted. There may be more connections
+			// in the queue.
+			if(errno != ECONNABORTED)
+			{ throw error_handling::system_error{"Failed to accept connection from socket", errno}; }
+		}
+	}
+
 	/**
 	 * \brief Binds socket to listening address so it becomes a server socket
 	 */
@@ -148,16 +232,21 @@ namespace Pipe::os_services::ipc
 
 	/**
 	 * \brief Creates a server socket, that can accept incoming connections
+	 * \tparam Mode Whether or not the server socket is non-blocking. A non-blocking server socket
+	 *              should be used with accept_nonblocking.
 	 */
-	template<auto SocketType, class AddressType>
-	server_socket<SocketType, AddressType> make_server_socket(
-		AddressType const& listening_address,
-		int connection_backlog
-	)
+	template<auto SocketType, fd::io_mode Mode = fd::io_mode::blocking, class AddressType>
+	auto make_server_socket(AddressType const& listening_address, int connection_backlog)
 	{
-		auto socket = make_socket<SocketType, AddressType>();
-		auto server_socket_ref = bind_and_listen(socket.release(),listening_address, connection_backlog);
-		return server_socket<SocketType, AddressType>{server_socket_ref};
+		auto socket = make_socket<SocketType, AddressType, Mode>();
+		std::ignore = bind_and_listen(
+			basic_socket_ref<SocketType, AddressType>{socket.get().native_handle()},
+			listening_address,
+			connection_backlog
+		);
+		return fd::tagged_file_descriptor<fd::tag_for_io_mode<server_socket_tag<SocketType, AddressType>, Mode>>{
+			socket.release().native_handle()
+		};
 	}
 
 	/**
@@ -193,6 +282,129 @@ namespace Pipe::os_services::ipc
 		return connected_socket<SocketType, AddressType>{conn_socket};
 	}
 
+	/**
+	 * \brief Tries to send data from buffer through socket, without blocking the calling thread
+	 *
+	 * Unlike io::write, SIGPIPE is not raised if the peer has closed the connection. Instead, an
+	 * exception is thrown.
+	 *
+	 * \return An io_result, containing the number of bytes transferred during the operation
+	 */
+	template<auto SocketType, class AddressType>
+	io::io_result send_nonblocking(
+		connected_socket_ref<SocketType, AddressType> socket,
+		std::span<std::byte const> buffer
+	)
+	{
+		return io::io_result{
+			error_handling::do_while_eintr(
+				::send,
+				socket.native_handle(),
+				static_cast<void const*>(std::data(buffer)),
+				std::size(buffer),
+				MSG_DONTWAIT | MSG_NOSIGNAL
+			),
+			errno
+		};
+	}
+
+	/**
+	 * \brief Tries to receive data from socket into buffer, without blocking the calling thread
+	 * \return An io_result, containing the number of bytes transferred during the operation
+	 */
+	template<auto SocketType, class AddressType>
+	io::io_result receive_nonblocking(
+		connected_socket_ref<SocketType, AddressType> socket,
+		std::span<std::byte> buffer
+	)
+	{
+		return io::io_result{
+			error_handling::do_while_eintr(
+				::recv,
+				socket.native_handle(),
+				static_cast<void*>(std::data(buffer)),
+				std::size(buffer),
+				MSG_DONTWAIT
+			),
+			errno
+		};
+	}
+
+	/**
+	 * \brief Checks whether or not SocketType keeps message boundaries, so that messages can be
+	 *        sent and received in batches
+	 */
+	template<auto SocketType>
+	concept message_socket_type = SocketType == SOCK_SEQPACKET || SocketType == SOCK_DGRAM;
+
+	/**
+	 * \brief Tries to send multiple messages to socket, without blocking the calling thread
+	 *
+	 * Each element of messages describes the buffers for one message. When this function returns,
+	 * the msg_len field of the sent elements holds the number of bytes sent for the corresponding
+	 * message.
+	 *
+	 * \return The number of messages sent, or 0 if the operation would have blocked
+	 */
+	template<auto SocketType, class AddressType>
+	requires(message_socket_type<SocketType>)
+	size_t send_multiple_nonblocking(
+		connected_socket_ref<SocketType, AddressType> socket,
+		std::span<mmsghdr> messages
+	)
+	{
+		auto const res = error_handling::do_while_eintr(
+			::sendmmsg,
+			socket.native_handle(),
+			std::data(messages),
+			static_cast<unsigned int>(std::size(messages)),
+			MSG_DONTWAIT | MSG_NOSIGNAL
+		);
+
+		if(res == -1)
+		{
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{ return 0; }
+			throw error_handling::system_error{"Failed to send messages", errno};
+		}
+
+		return static_cast<size_t>(res);
+	}
+
+	/**
+	 * \brief Tries to receive multiple messages from socket, without blocking the calling thread
+	 *
+	 * Each element of messages describes the buffers for one message. When this function returns,
+	 * the msg_len field of the received elements holds the size of the corresponding message.
+	 *
+	 * \return The number of messages received, or 0 if the operation would have blocked
+	 */
+	template<auto SocketType, class AddressType>
+	requires(message_socket_type<SocketType>)
+	size_t receive_multiple_nonblocking(
+		connected_socket_ref<SocketType, AddressType> socket,
+		std::span<mmsghdr> messages
+	)
+	{
+		auto const res = error_handling::do_while_eintr(
+			::recvmmsg,
+			socket.native_handle(),
+			std::data(messages),
+			static_cast<unsigned int>(std::size(messages)),
+			MSG_DONTWAIT,
+			static_cast<timespec*>(nullptr)
+		);
+
+		if(res == -1)
+		{
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{ return 0; }
+			throw error_handling::system_error{"Failed to receive messages", errno};
+		}
+
+		return static_cast<size_t>(res);
+	}
+
 	/**
 	 * \brief Enum controlling the behaviour of shutdown
 	 */
@@ -5,22 +5,56 @@
 #include "src/os_services/error_handling/system_error.hpp"
 
 #include <cstdlib>
+#include <fcntl.h>
 
 namespace Pipe::os_services::ipc
 {
-	template<auto SocketType>
+	/**
+	 * \brief A pair of connected unix domain sockets
+	 *
+	 * Both sockets are closed on exec. Use the fds_to_forward parameter of proc_mgmt::spawn to
+	 * pass one of them to a child process.
+	 *
+	 * \tparam SocketType The socket type, such as SOCK_STREAM or SOCK_SEQPACKET
+	 * \tparam ModeA Whether or not socket a is non-blocking
+	 * \tparam ModeB Whether or not socket b is non-blocking
+	 */
+	template<
+		auto SocketType,
+		fd::io_mode ModeA = fd::io_mode::blocking,
+		fd::io_mode ModeB = fd::io_mode::blocking
+	>
 	class socket_pair
 	{
 	public:
+		using socket_a_tag = fd::tag_for_io_mode<connected_socket_tag<SocketType, sockaddr_un>, ModeA>;
+		using socket_b_tag = fd::tag_for_io_mode<connected_socket_tag<SocketType, sockaddr_un>, ModeB>;
+
 		socket_pair()
 		{
 			std::array<int, 2> fds{};
-			auto const res = ::socketpair(AF_UNIX, SocketType, 0, std::data(fds));
+			constexpr auto both_nonblocking = ModeA == fd::io_mode::nonblocking
+				&& ModeB == fd::io_mode::nonblocking;
+			auto const res = ::socketpair(
+				AF_UNIX,
+				SocketType | socket_flags<both_nonblocking? fd::io_mode::nonblocking : fd::io_mode::blocking>(),
+				0,
+				std::data(fds)
+			);
 			if(res == -1)
 			{ throw error_handling::system_error{"Failed to create a socket pair", errno}; }
 
-			m_socket_a = connected_socket<SocketType, sockaddr_un>(fds[0]);
-			m_socket_b = connected_socket<SocketType, sockaddr_un>(fds[1]);
+			m_socket_a = fd::tagged_file_descriptor<socket_a_tag>(fds[0]);
+			m_socket_b = fd::tagged_file_descriptor<socket_b_tag>(fds[1]);
+
+			if constexpr(!both_nonblocking)
+			{
+				if constexpr(ModeA == fd::io_mode::nonblocking)
+				{ make_nonblocking(fds[0]); }
+
+				if constexpr(ModeB == fd::io_mode::nonblocking)
+				{ make_nonblocking(fds[1]); }
+			}
 		}
 
 		auto socket_a() const noexcept
@@ -42,8 +76,14 @@ namespace Pipe::os_services::ipc
 		{ m_socket_b.reset(); }
 
 	private:
-		connected_socket<SocketType, sockaddr_un> m_socket_a;
-		connected_socket<SocketType, sockaddr_un> m_socket_b;
+		static void make_nonblocking(int fd)
+		{
+			if(::fcntl(fd, F_SETFL, O_NONBLOCK) == -1)
+			{ throw error_handling::system_error{"Failed to make socket non-blocking", errno}; }
+		}
+
+		fd::tagged_file_descriptor<socket_a_tag> m_socket_a;
+		fd::tagged_file_descriptor<socket_b_tag> m_socket_b;
 	};
 }
 
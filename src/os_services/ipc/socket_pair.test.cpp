@@ -4,6 +4,7 @@
 #include "src/os_services/io/io.hpp"
 
 #include <testfwk/testfwk.hpp>
+#include <sys/uio.h>
 
 TESTCASE(Pipe_ipc_socket_pair_create_and_do_stuff)
 {
@@ -25,4 +26,53 @@ TESTCASE(Pipe_ipc_socket_pair_create_and_do_stuff)
 	socket_pair.close_socket_b();
 	EXPECT_EQ(socket_pair.socket_a(), nullptr);
 	EXPECT_EQ(socket_pair.socket_b(), nullptr);
-}
\ No newline at end of file
+}
+
+TESTCASE(Pipe_ipc_socket_pair_nonblocking_socket_a)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET, Pipe::os_services::fd::io_mode::nonblocking> socket_pair;
+	static_assert(Pipe::os_services::fd::nonblocking_fd_tag<decltype(socket_pair.socket_a())::tag_type>);
+	static_assert(!Pipe::os_services::fd::nonblocking_fd_tag<decltype(socket_pair.socket_b())::tag_type>);
+
+	EXPECT_NE(::fcntl(socket_pair.socket_a().native_handle(), F_GETFL) & O_NONBLOCK, 0);
+	EXPECT_EQ(::fcntl(socket_pair.socket_b().native_handle(), F_GETFL) & O_NONBLOCK, 0);
+	EXPECT_NE(::fcntl(socket_pair.socket_a().native_handle(), F_GETFD) & FD_CLOEXEC, 0);
+	EXPECT_NE(::fcntl(socket_pair.socket_b().native_handle(), F_GETFD) & FD_CLOEXEC, 0);
+
+	std::array<std::byte, 16> buffer{};
+	EXPECT_EQ(Pipe::os_services::io::read(socket_pair.socket_a(), buffer).operation_would_have_blocked(), true);
+}
+
+TESTCASE(Pipe_ipc_socket_pair_send_and_receive_multiple)
+{
+	Pipe::os_services::ipc::socket_pair<SOCK_SEQPACKET> socket_pair;
+
+	std::array<std::string_view, 3> const messages{"Hello", ", ", "World"};
+	std::array<iovec, 3> send_iovecs{};
+	std::array<mmsghdr, 3> send_headers{};
+	for(size_t k = 0; k != std::size(messages); ++k)
+	{
+		send_iovecs[k] = iovec{.iov_base = const_cast<char*>(std::data(messages[k])), .iov_len = std::size(messages[k])};
+		send_headers[k].msg_hdr.msg_iov = &send_iovecs[k];
+		send_headers[k].msg_hdr.msg_iovlen = 1;
+	}
+	EXPECT_EQ(Pipe::os_services::ipc::send_multiple_nonblocking(socket_pair.socket_a(), send_headers), 3);
+	EXPECT_EQ(send_headers[2].msg_len, 5);
+
+	std::array<std::array<char, 16>, 4> buffers{};
+	std::array<iovec, 4> receive_iovecs{};
+	std::array<mmsghdr, 4> receive_headers{};
+	for(size_t k = 0; k != std::size(buffers); ++k)
+	{
+		receive_iovecs[k] = iovec{.iov_base = std::data(buffers[k]), .iov_len = std::size(buffers[k])};
+		receive_headers[k].msg_hdr.msg_iov = &receive_iovecs[k];
+		receive_headers[k].msg_hdr.msg_iovlen = 1;
+	}
+
+	// Message boundaries are kept, so each message ends up in its own buffer
+	REQUIRE_EQ(Pipe::os_services::ipc::receive_multiple_nonblocking(socket_pair.socket_b(), receive_headers), 3);
+	for(size_t k = 0; k != std::size(messages); ++k)
+	{ EXPECT_EQ((std::string_view{std::data(buffers[k]), receive_headers[k].msg_len}), messages[k]); }
+
+	EXPECT_EQ(Pipe::os_services::ipc::receive_multiple_nonblocking(socket_pair.socket_b(), receive_headers), 0);
+}
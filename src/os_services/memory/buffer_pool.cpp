@@ -0,0 +1,234 @@
+//@	{"target":{"name":"buffer_pool.o"}}
+
+#include "./buffer_pool.hpp"
+#include "./mapped_region.hpp"
+#include "./placement.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+class Pipe::os_services::memory::buffer_pool_state:
+	public std::enable_shared_from_this<buffer_pool_state>
+{
+public:
+	explicit buffer_pool_state(buffer_pool_config const& cfg):
+		m_min_size_log2{static_cast<size_t>(std::countr_zero(std::bit_ceil(std::max(cfg.min_buffer_size, size_t{1}))))},
+		m_size_class_count{
+			static_cast<size_t>(std::countr_zero(std::bit_ceil(std::max(cfg.max_buffer_size, cfg.min_buffer_size))))
+				- m_min_size_log2 + 1
+		},
+		m_slab_size{cfg.slab_size},
+		m_thread_cache_capacity{cfg.thread_cache_capacity},
+		m_placement{cfg.placement},
+		m_free_lists(m_size_class_count),
+		m_buffer_counts(m_size_class_count)
+	{}
+
+	size_t size_class_count() const noexcept
+	{ return m_size_class_count; }
+
+	size_t max_buffer_size() const noexcept
+	{ return buffer_size(m_size_class_count - 1); }
+
+	size_t buffer_size(size_t size_class) const noexcept
+	{ return size_t{1} << (m_min_size_log2 + size_class); }
+
+	size_t size_class(size_t size) const noexcept
+	{
+		auto const size_log2 = static_cast<size_t>(std::countr_zero(std::bit_ceil(std::max(size, size_t{1}))));
+		return size_log2 <= m_min_size_log2? 0 : size_log2 - m_min_size_log2;
+	}
+
+	size_t thread_cache_capacity() const noexcept
+	{ return m_thread_cache_capacity; }
+
+	std::byte* take(size_t size_class)
+	{
+		std::lock_guard lock{m_mtx};
+		auto& free_list = m_free_lists[size_class];
+		if(free_list.empty())
+		{ add_slab(size_class); }
+
+		auto const ret = free_list.back();
+		free_list.pop_back();
+		return ret;
+	}
+
+	void give_back(std::span<std::byte* const> buffers, size_t size_class) noexcept
+	{
+		std::lock_guard lock{m_mtx};
+		// Capacity for all buffers of the size class has been reserved by add_slab
+		auto& free_list = m_free_lists[size_class];
+		free_list.insert(std::end(free_list), std::begin(buffers), std::end(buffers));
+	}
+
+	void on_borrowed() noexcept
+	{ m_buffers_in_use.fetch_add(1, std::memory_order_relaxed); }
+
+	void on_returned() noexcept
+	{ m_buffers_in_use.fetch_sub(1, std::memory_order_relaxed); }
+
+	size_t buffers_in_use() const noexcept
+	{ return m_buffers_in_use.load(std::memory_order_relaxed); }
+
+	size_t reserved_bytes() const noexcept
+	{ return m_reserved_bytes.load(std::memory_order_relaxed); }
+
+private:
+	void add_slab(size_t size_class)
+	{
+		auto const size = buffer_size(size_class);
+		auto const count = std::max(m_slab_size/size, size_t{1});
+		auto slab = make_anonymous_region(count*size, m_placement);
+
+		auto& free_list = m_free_lists[size_class];
+		m_buffer_counts[size_class] += count;
+		free_list.reserve(m_buffer_counts[size_class]);
+		for(size_t k = count; k != 0; --k)
+		{ free_list.push_back(slab.data() + (k - 1)*size); }
+
+		m_reserved_bytes.fetch_add(slab.size(), std::memory_order_relaxed);
+		m_slabs.push_back(std::move(slab));
+	}
+
+	size_t m_min_size_log2;
+	size_t m_size_class_count;
+	size_t m_slab_size;
+	size_t m_thread_cache_capacity;
+	memory_placement m_placement;
+
+	std::mutex m_mtx;
+	std::vector<std::vector<std::byte*>> m_free_lists;
+	std::vector<size_t> m_buffer_counts;
+	std::vector<mapped_region> m_slabs;
+
+	std::atomic<size_t> m_buffers_in_use{0};
+	std::atomic<size_t> m_reserved_bytes{0};
+};
+
+namespace
+{
+	struct thread_cache_entry
+	{
+		Pipe::os_services::memory::buffer_pool_state* pool;
+		std::weak_ptr<Pipe::os_services::memory::buffer_pool_state> owner;
+		std::vector<std::vector<std::byte*>> free_buffers;
+	};
+
+	class thread_cache
+	{
+	public:
+		thread_cache() = default;
+		thread_cache(thread_cache const&) = delete;
+		thread_cache& operator=(thread_cache const&) = delete;
+
+		~thread_cache()
+		{
+			for(auto& item : m_entries)
+			{
+				if(auto const pool = item.owner.lock(); pool != nullptr)
+				{ return_all(*pool, item); }
+			}
+		}
+
+		thread_cache_entry* find(Pipe::os_services::memory::buffer_pool_state const* pool) noexcept
+		{
+			auto const i = std::ranges::find_if(m_entries, [pool](auto const& item) {
+				return item.pool == pool && !item.owner.expired();
+			});
+			return i != std::end(m_entries)? &*i : nullptr;
+		}
+
+		thread_cache_entry& get(Pipe::os_services::memory::buffer_pool_state& pool)
+		{
+			if(auto const ret = find(&pool); ret != nullptr)
+			{ return *ret; }
+
+			// Entries of destroyed pools may refer to another pool at the same address
+			std::erase_if(m_entries, [](auto const& item) { return item.owner.expired(); });
+
+			std::vector<std::vector<std::byte*>> free_buffers(pool.size_class_count());
+			for(auto& item : free_buffers)
+			{ item.reserve(pool.thread_cache_capacity()); }
+
+			return m_entries.emplace_back(&pool, pool.weak_from_this(), std::move(free_buffers));
+		}
+
+	private:
+		static void return_all(Pipe::os_services::memory::buffer_pool_state& pool, thread_cache_entry& entry) noexcept
+		{
+			for(size_t k = 0; k != std::size(entry.free_buffers); ++k)
+			{
+				pool.give_back(entry.free_buffers[k], k);
+				entry.free_buffers[k].clear();
+			}
+		}
+
+		std::vector<thread_cache_entry> m_entries;
+	};
+
+	thread_local thread_cache current_thread_cache;
+}
+
+void Pipe::os_services::memory::pooled_buffer_deleter::operator()(std::byte* ptr) const noexcept
+{
+	if(ptr == nullptr)
+	{ return; }
+
+	pool->on_returned();
+	if(auto const entry = current_thread_cache.find(pool); entry != nullptr)
+	{
+		auto& free_buffers = entry->free_buffers[size_class];
+		if(std::size(free_buffers) < pool->thread_cache_capacity())
+		{
+			free_buffers.push_back(ptr);
+			return;
+		}
+	}
+
+	pool->give_back(std::span{&ptr, 1}, size_class);
+}
+
+Pipe::os_services::memory::buffer_pool::buffer_pool(buffer_pool_config const& cfg):
+	m_state{std::make_shared<buffer_pool_state>(cfg)}
+{}
+
+Pipe::os_services::memory::pooled_buffer Pipe::os_services::memory::buffer_pool::allocate(size_t size)
+{
+	if(size > m_state->max_buffer_size())
+	{ throw std::runtime_error{"Requested buffer size exceeds the max buffer size of the pool"}; }
+
+	auto const size_class = m_state->size_class(size);
+	auto& free_buffers = current_thread_cache.get(*m_state).free_buffers[size_class];
+	std::byte* ptr = nullptr;
+	if(!free_buffers.empty())
+	{
+		ptr = free_buffers.back();
+		free_buffers.pop_back();
+	}
+	else
+	{ ptr = m_state->take(size_class); }
+
+	m_state->on_borrowed();
+	return pooled_buffer{
+		ptr,
+		m_state->buffer_size(size_class),
+		pooled_buffer_deleter{m_state.get(), size_class}
+	};
+}
+
+size_t Pipe::os_services::memory::buffer_pool::reserved_bytes() const noexcept
+{ return m_state->reserved_bytes(); }
+
+size_t Pipe::os_services::memory::buffer_pool::buffers_in_use() const noexcept
+{ return m_state->buffers_in_use(); }
+
+Pipe::os_services::memory::buffer_pool& Pipe::os_services::memory::default_buffer_pool()
+{
+	static buffer_pool pool;
+	return pool;
+}
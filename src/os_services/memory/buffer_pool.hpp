@@ -0,0 +1,165 @@
+//@	{"dependencies_extra":[{"ref":"./buffer_pool.o", "rel":"implementation"}]}
+
+#ifndef PIPE_OS_SERVICES_MEMORY_BUFFER_POOL_HPP
+#define PIPE_OS_SERVICES_MEMORY_BUFFER_POOL_HPP
+
+#include "./placement.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+namespace Pipe::os_services::memory
+{
+	/**
+	 * \brief Settings for a buffer_pool
+	 */
+	struct buffer_pool_config
+	{
+		/**
+		 * \brief The size of the smallest size class. Rounded up to a power of two.
+		 */
+		size_t min_buffer_size = 4096;
+
+		/**
+		 * \brief The size of the largest size class. Rounded up to a power of two.
+		 */
+		size_t max_buffer_size = 1024*1024;
+
+		/**
+		 * \brief The size of the memory regions that buffers are carved from
+		 *
+		 * Size classes larger than slab_size get one region per buffer.
+		 */
+		size_t slab_size = 2*1024*1024;
+
+		/**
+		 * \brief The max number of free buffers of each size class that a thread keeps for itself
+		 */
+		size_t thread_cache_capacity = 4;
+
+		/**
+		 * \brief Where to place slabs. Use this to back slabs with hugepages, or to allocate them
+		 *        from the NUMA node of the thread that services the buffers.
+		 */
+		memory_placement placement{};
+	};
+
+	class buffer_pool_state;
+
+	/**
+	 * \brief A deleter that returns a buffer to the buffer_pool it was borrowed from
+	 */
+	struct pooled_buffer_deleter
+	{
+		buffer_pool_state* pool;
+		size_t size_class;
+
+		/**
+		 * \brief Function call operator that implements the delete operation
+		 */
+		void operator()(std::byte* ptr) const noexcept;
+	};
+
+	/**
+	 * \brief A buffer borrowed from a buffer_pool
+	 *
+	 * The buffer is returned to the pool when the pooled_buffer is destroyed.
+	 *
+	 * \note The buffer_pool must outlive all of its pooled_buffers
+	 */
+	class pooled_buffer
+	{
+	public:
+		/**
+		 * \brief Constructs an empty pooled_buffer
+		 */
+		pooled_buffer() = default;
+
+		explicit pooled_buffer(std::byte* ptr, size_t size, pooled_buffer_deleter deleter) noexcept:
+			m_buffer{ptr, deleter},
+			m_size{size}
+		{}
+
+		/**
+		 * \brief Returns a pointer to the first byte of the buffer
+		 */
+		std::byte* data() const noexcept
+		{ return m_buffer.get(); }
+
+		/**
+		 * \brief Returns the size of the buffer. This is the size of its size class, so it may be
+		 *        larger than requested.
+		 */
+		size_t size() const noexcept
+		{ return m_size; }
+
+		/**
+		 * \brief Returns the buffer as a span
+		 */
+		std::span<std::byte> bytes() const noexcept
+		{ return std::span{data(), size()}; }
+
+		/**
+		 * \brief Returns the buffer to its pool
+		 */
+		void reset() noexcept
+		{
+			m_buffer.reset();
+			m_size = 0;
+		}
+
+	private:
+		std::unique_ptr<std::byte, pooled_buffer_deleter> m_buffer{nullptr, pooled_buffer_deleter{nullptr, 0}};
+		size_t m_size{0};
+	};
+
+	/**
+	 * \brief A pool of I/O buffers, grouped by size into power-of-two size classes
+	 *
+	 * Buffers are carved from anonymous memory mappings, which are kept until the pool is
+	 * destroyed. A returned buffer is first put in a cache owned by the calling thread, so a
+	 * thread that repeatedly borrows and returns buffers does not have to take the lock that
+	 * protects the shared free lists.
+	 *
+	 * Borrowing a buffer for the duration of a single operation, instead of owning one per
+	 * connection, makes idle connections cost no buffer memory.
+	 */
+	class buffer_pool
+	{
+	public:
+		/**
+		 * \brief Constructs a buffer_pool
+		 */
+		explicit buffer_pool(buffer_pool_config const& cfg = buffer_pool_config{});
+
+		buffer_pool(buffer_pool const&) = delete;
+		buffer_pool& operator=(buffer_pool const&) = delete;
+
+		/**
+		 * \brief Borrows a buffer of at least size bytes
+		 * \throw std::runtime_error if size is larger than the max buffer size of the pool
+		 */
+		pooled_buffer allocate(size_t size);
+
+		/**
+		 * \brief Returns the total size of the memory regions allocated by the pool
+		 */
+		size_t reserved_bytes() const noexcept;
+
+		/**
+		 * \brief Returns the number of buffers that are currently borrowed
+		 */
+		size_t buffers_in_use() const noexcept;
+
+	private:
+		std::shared_ptr<buffer_pool_state> m_state;
+	};
+
+	/**
+	 * \brief Returns a process-wide buffer_pool with default settings
+	 */
+	buffer_pool& default_buffer_pool();
+}
+
+#endif
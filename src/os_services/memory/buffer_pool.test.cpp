@@ -0,0 +1,102 @@
+//@	{"target":{"name":"buffer_pool.test"}}
+
+#include "./buffer_pool.hpp"
+
+#include <testfwk/testfwk.hpp>
+#include <thread>
+#include <vector>
+
+TESTCASE(Pipe_os_services_memory_buffer_pool_size_classes)
+{
+	Pipe::os_services::memory::buffer_pool pool{
+		Pipe::os_services::memory::buffer_pool_config{
+			.min_buffer_size = 4000,
+			.max_buffer_size = 65536,
+			.slab_size = 65536,
+			.thread_cache_capacity = 4,
+			.placement = Pipe::os_services::memory::memory_placement{}
+		}
+	};
+	EXPECT_EQ(pool.reserved_bytes(), 0);
+
+	auto const small = pool.allocate(1);
+	EXPECT_EQ(small.size(), 4096);
+	EXPECT_EQ(pool.reserved_bytes(), 65536);
+
+	auto const medium = pool.allocate(4097);
+	EXPECT_EQ(medium.size(), 8192);
+
+	auto const large = pool.allocate(65536);
+	EXPECT_EQ(large.size(), 65536);
+	EXPECT_EQ(pool.buffers_in_use(), 3);
+	EXPECT_EQ(pool.reserved_bytes(), 3*65536);
+
+	// Buffers are usable memory
+	large.bytes()[65535] = std::byte{1};
+
+	try
+	{
+		std::ignore = pool.allocate(65537);
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Requested buffer size exceeds the max buffer size of the pool"}); }
+}
+
+TESTCASE(Pipe_os_services_memory_buffer_pool_reuse)
+{
+	Pipe::os_services::memory::buffer_pool pool;
+
+	auto buffer = pool.allocate(65536);
+	auto const first = buffer.data();
+	buffer.reset();
+	EXPECT_EQ(buffer.data(), nullptr);
+	EXPECT_EQ(pool.buffers_in_use(), 0);
+
+	// The buffer comes back from the thread cache
+	auto const reserved = pool.reserved_bytes();
+	buffer = pool.allocate(60000);
+	EXPECT_EQ(buffer.data(), first);
+	EXPECT_EQ(pool.reserved_bytes(), reserved);
+
+	// More buffers than fit in the thread cache
+	std::vector<Pipe::os_services::memory::pooled_buffer> buffers;
+	for(size_t k = 0; k != 64; ++k)
+	{ buffers.push_back(pool.allocate(4096)); }
+	EXPECT_EQ(pool.buffers_in_use(), 65);
+	auto const reserved_after_burst = pool.reserved_bytes();
+	buffers.clear();
+
+	for(size_t k = 0; k != 64; ++k)
+	{ buffers.push_back(pool.allocate(4096)); }
+	EXPECT_EQ(pool.reserved_bytes(), reserved_after_burst);
+}
+
+TESTCASE(Pipe_os_services_memory_buffer_pool_other_thread)
+{
+	Pipe::os_services::memory::buffer_pool pool{
+		Pipe::os_services::memory::buffer_pool_config{
+			.min_buffer_size = 4096,
+			.max_buffer_size = 4096,
+			.slab_size = 4096,
+			.thread_cache_capacity = 4,
+			.placement = Pipe::os_services::memory::memory_placement{
+				.hugepages = Pipe::os_services::memory::hugepage_policy::transparent,
+				.node = std::nullopt
+			}
+		}
+	};
+
+	std::byte* borrowed_by_thread = nullptr;
+	std::jthread{[&pool, &borrowed_by_thread]() {
+		auto buffer = pool.allocate(4096);
+		borrowed_by_thread = buffer.data();
+	}}.join();
+	EXPECT_EQ(pool.buffers_in_use(), 0);
+	EXPECT_EQ(pool.reserved_bytes(), 4096);
+
+	// The cache of the other thread was returned to the pool when the thread exited
+	auto const buffer = pool.allocate(4096);
+	EXPECT_EQ(buffer.data(), borrowed_by_thread);
+	EXPECT_EQ(pool.reserved_bytes(), 4096);
+}
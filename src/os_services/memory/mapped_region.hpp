@@ -0,0 +1,158 @@
+#ifndef PIPE_OS_SERVICES_MEMORY_MAPPED_REGION_HPP
+#define PIPE_OS_SERVICES_MEMORY_MAPPED_REGION_HPP
+
+#include "src/os_services/fd/file_descriptor.hpp"
+#include "src/os_services/error_handling/system_error.hpp"
+
+#include <memory>
+#include <span>
+#include <sys/mman.h>
+
+/**
+ * \brief Memory management
+ */
+namespace Pipe::os_services::memory
+{
+	/**
+	 * \brief Controls whether or not a mapped_region may be written to
+	 */
+	enum class access_mode{read_only = PROT_READ, read_write = PROT_READ | PROT_WRITE};
+
+	/**
+	 * \brief Hints about how a mapped_region will be accessed
+	 */
+	enum class access_pattern
+	{
+		normal = MADV_NORMAL,
+		sequential = MADV_SEQUENTIAL,
+		random = MADV_RANDOM,
+		will_need = MADV_WILLNEED,
+		dont_need = MADV_DONTNEED,
+		hugepage = MADV_HUGEPAGE
+	};
+
+	/**
+	 * \brief Controls whether or not mapped_region::sync waits for the data to be written
+	 */
+	enum class sync_mode{wait = MS_SYNC, schedule = MS_ASYNC};
+
+	/**
+	 * \brief A deleter for mapped memory
+	 */
+	struct mapped_region_deleter
+	{
+		size_t size;
+
+		/**
+		 * \brief Function call operator that implements the delete operation
+		 */
+		void operator()(std::byte* ptr) const noexcept
+		{
+			if(ptr != nullptr)
+			{ ::munmap(ptr, size); }
+		}
+	};
+
+	/**
+	 * \brief An owner of a memory mapping
+	 */
+	class mapped_region
+	{
+	public:
+		/**
+		 * \brief Constructs an empty mapped_region
+		 */
+		mapped_region() = default;
+
+		/**
+		 * \brief Maps size bytes of the file referred to by fd, starting at offset
+		 * \note The mapping is shared, so modifications are written back to the file
+		 */
+		template<class Tag>
+		explicit mapped_region(
+			fd::tagged_file_descriptor_ref<Tag> fd,
+			size_t size,
+			access_mode mode,
+			off_t offset = 0
+		):
+			mapped_region{size, static_cast<int>(mode), MAP_SHARED, fd.native_handle(), offset}
+		{}
+
+		/**
+		 * \brief Creates an anonymous read-write mapping of size bytes
+		 * \param size The size of the region
+		 * \param extra_flags Additional flags passed to `mmap`, such as MAP_HUGETLB
+		 */
+		explicit mapped_region(size_t size, int extra_flags = 0):
+			mapped_region{size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0}
+		{}
+
+		/**
+		 * \brief Returns a pointer to the first byte of the region
+		 */
+		std::byte* data() const noexcept
+		{ return m_region.get(); }
+
+		/**
+		 * \brief Returns the size of the region
+		 */
+		size_t size() const noexcept
+		{ return m_region.get_deleter().size; }
+
+		/**
+		 * \brief Returns the mapped memory as a span
+		 */
+		std::span<std::byte> bytes() const noexcept
+		{ return std::span{data(), size()}; }
+
+		/**
+		 * \brief Gives the kernel a hint about how the region will be accessed
+		 */
+		void advise(access_pattern pattern) const
+		{
+			if(data() == nullptr)
+			{ return; }
+
+			if(::madvise(data(), size(), static_cast<int>(pattern)) == -1)
+			{ throw error_handling::system_error{"Failed to set memory access pattern", errno}; }
+		}
+
+		/**
+		 * \brief Writes modifications of a file-backed region to the underlying file
+		 *
+		 * With sync_mode::schedule, writeback is started, but not waited for.
+		 */
+		void sync(sync_mode mode = sync_mode::wait) const
+		{
+			if(data() == nullptr)
+			{ return; }
+
+			if(::msync(data(), size(), static_cast<int>(mode)) == -1)
+			{ throw error_handling::system_error{"Failed to synchronize memory mapping", errno}; }
+		}
+
+		/**
+		 * \brief Unmaps the region
+		 */
+		void reset() noexcept
+		{ m_region.reset(); }
+
+	private:
+		explicit mapped_region(size_t size, int prot, int flags, int fd, off_t offset):
+			m_region{nullptr, mapped_region_deleter{size}}
+		{
+			if(size == 0)
+			{ return; }
+
+			auto const ret = ::mmap(nullptr, size, prot, flags, fd, offset);
+			if(ret == MAP_FAILED)
+			{ throw error_handling::system_error{"Failed to map memory", errno}; }
+
+			m_region.reset(static_cast<std::byte*>(ret));
+		}
+
+		std::unique_ptr<std::byte, mapped_region_deleter> m_region{nullptr, mapped_region_deleter{0}};
+	};
+}
+
+#endif
@@ -0,0 +1,75 @@
+//@	{"target":{"name":"mapped_region.test"}}
+
+#include "./mapped_region.hpp"
+#include "src/os_services/io/io.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+namespace
+{
+	struct memfd_tag
+	{};
+}
+
+TESTCASE(Pipe_os_services_memory_mapped_region_default)
+{
+	Pipe::os_services::memory::mapped_region region;
+	EXPECT_EQ(region.data(), nullptr);
+	EXPECT_EQ(region.size(), 0);
+	region.sync();
+	region.advise(Pipe::os_services::memory::access_pattern::sequential);
+}
+
+TESTCASE(Pipe_os_services_memory_mapped_region_anonymous)
+{
+	Pipe::os_services::memory::mapped_region region{8192};
+	REQUIRE_NE(region.data(), nullptr);
+	EXPECT_EQ(region.size(), 8192);
+	EXPECT_EQ(std::size(region.bytes()), 8192);
+	region.bytes()[8191] = std::byte{12};
+	EXPECT_EQ(region.data()[8191], std::byte{12});
+	region.reset();
+	EXPECT_EQ(region.data(), nullptr);
+}
+
+TESTCASE(Pipe_os_services_memory_mapped_region_file)
+{
+	Pipe::os_services::fd::tagged_file_descriptor<memfd_tag> fd{memfd_create("foo", 0)};
+	REQUIRE_NE(fd, nullptr);
+	REQUIRE_NE(::ftruncate(fd.get().native_handle(), 4096), -1);
+
+	{
+		Pipe::os_services::memory::mapped_region region{
+			fd.get(),
+			4096,
+			Pipe::os_services::memory::access_mode::read_write
+		};
+		memcpy(region.data(), "Hello, World", 12);
+		region.sync();
+	}
+
+	Pipe::os_services::memory::mapped_region region{
+		fd.get(),
+		4096,
+		Pipe::os_services::memory::access_mode::read_only
+	};
+	EXPECT_EQ(
+		(std::string_view{reinterpret_cast<char const*>(region.data()), 12}),
+		"Hello, World"
+	);
+}
+
+TESTCASE(Pipe_os_services_memory_mapped_region_bad_fd)
+{
+	try
+	{
+		Pipe::os_services::memory::mapped_region region{
+			Pipe::os_services::fd::tagged_file_descriptor_ref<memfd_tag>{-1},
+			4096,
+			Pipe::os_services::memory::access_mode::read_only
+		};
+		abort();
+	}
+	catch(std::runtime_error const& err)
+	{ EXPECT_EQ(err.what(), std::string_view{"Failed to map memory: Bad file descriptor"}); }
+}
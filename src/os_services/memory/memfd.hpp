@@ -0,0 +1,104 @@
+#ifndef PIPE_OS_SERVICES_MEMORY_MEMFD_HPP
+#define PIPE_OS_SERVICES_MEMORY_MEMFD_HPP
+
+#include "src/os_services/io/io.hpp"
+#include "src/os_services/fd/file_descriptor.hpp"
+#include "src/os_services/error_handling/system_error.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Pipe::os_services::memory
+{
+	/**
+	 * \brief A tag type used to identify a file descriptor referring to an anonymous memory file
+	 */
+	struct memfd_tag
+	{};
+}
+
+template<>
+struct Pipe::os_services::fd::enabled_fd_conversions<Pipe::os_services::memory::memfd_tag>
+{
+	static consteval void supports(io::input_file_descriptor_tag){}
+	static consteval void supports(io::output_file_descriptor_tag){}
+	static consteval void supports(generic_fd_tag){}
+};
+
+namespace Pipe::os_services::memory
+{
+	/**
+	 * \brief A reference to an anonymous memory file
+	 */
+	using memfd_ref = fd::tagged_file_descriptor_ref<memfd_tag>;
+
+	/**
+	 * \brief An owner of an anonymous memory file
+	 */
+	using memfd = fd::tagged_file_descriptor<memfd_tag>;
+
+	/**
+	 * \brief Creates an empty anonymous memory file, that can be sealed
+	 * \param name The name of the file. It is only used for debugging purposes.
+	 */
+	inline memfd make_memfd(char const* name)
+	{
+		memfd ret{::memfd_create(name, MFD_ALLOW_SEALING)};
+		if(ret == nullptr)
+		{ throw error_handling::system_error{"Failed to create memfd", errno}; }
+		return ret;
+	}
+
+	/**
+	 * \brief Sets the size of the file referred to by fd to new_size
+	 */
+	inline void truncate(memfd_ref fd, size_t new_size)
+	{
+		if(::ftruncate(fd.native_handle(), static_cast<off_t>(new_size)) == -1)
+		{ throw error_handling::system_error{"Failed to change the size of memfd", errno}; }
+	}
+
+	/**
+	 * \brief Returns the size of the file referred to by fd
+	 */
+	inline size_t get_size(memfd_ref fd)
+	{
+		struct stat statbuf{};
+		if(::fstat(fd.native_handle(), &statbuf) == -1)
+		{ throw error_handling::system_error{"Failed to get size of memfd", errno}; }
+		return static_cast<size_t>(statbuf.st_size);
+	}
+
+	/**
+	 * \brief The seals that make the content of a memfd immutable
+	 */
+	constexpr int immutable_seals = F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+
+	/**
+	 * \brief Makes the content of the file referred to by fd immutable
+	 *
+	 * After this call, any process that receives fd can read it without having to worry about
+	 * the content changing, or the file shrinking while it is mapped.
+	 *
+	 * \note Sealing fails if there are any writable shared mappings of the file
+	 */
+	inline void seal(memfd_ref fd)
+	{
+		if(::fcntl(fd.native_handle(), F_ADD_SEALS, immutable_seals) == -1)
+		{ throw error_handling::system_error{"Failed to seal memfd", errno}; }
+	}
+
+	/**
+	 * \brief Checks whether or not the content of the file referred to by fd is immutable
+	 */
+	inline bool is_sealed(memfd_ref fd)
+	{
+		auto const seals = ::fcntl(fd.native_handle(), F_GET_SEALS);
+		if(seals == -1)
+		{ throw error_handling::system_error{"Failed to get seals of memfd", errno}; }
+		return (seals & immutable_seals) == immutable_seals;
+	}
+}
+
+#endif
@@ -0,0 +1,57 @@
+//@	{"target":{"name":"memfd.test"}}
+
+#include "./memfd.hpp"
+#include "./mapped_region.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+TESTCASE(Pipe_os_services_memory_memfd_write_and_seal)
+{
+	auto const fd = Pipe::os_services::memory::make_memfd("foo");
+	EXPECT_EQ(Pipe::os_services::memory::get_size(fd.get()), 0);
+	EXPECT_EQ(Pipe::os_services::memory::is_sealed(fd.get()), false);
+
+	Pipe::os_services::memory::truncate(fd.get(), 4096);
+	EXPECT_EQ(Pipe::os_services::memory::get_size(fd.get()), 4096);
+	{
+		Pipe::os_services::memory::mapped_region region{
+			fd.get(),
+			4096,
+			Pipe::os_services::memory::access_mode::read_write
+		};
+		memcpy(region.data(), "Hello, World", 12);
+	}
+
+	Pipe::os_services::memory::seal(fd.get());
+	EXPECT_EQ(Pipe::os_services::memory::is_sealed(fd.get()), true);
+
+	try
+	{
+		Pipe::os_services::memory::truncate(fd.get(), 0);
+		abort();
+	}
+	catch(Pipe::os_services::error_handling::system_error const&)
+	{}
+
+	try
+	{
+		Pipe::os_services::memory::mapped_region region{
+			fd.get(),
+			4096,
+			Pipe::os_services::memory::access_mode::read_write
+		};
+		abort();
+	}
+	catch(Pipe::os_services::error_handling::system_error const&)
+	{}
+
+	Pipe::os_services::memory::mapped_region region{
+		fd.get(),
+		4096,
+		Pipe::os_services::memory::access_mode::read_only
+	};
+	EXPECT_EQ(
+		(std::string_view{reinterpret_cast<char const*>(region.data()), 12}),
+		"Hello, World"
+	);
+}
@@ -0,0 +1,208 @@
+//@	{"target":{"name":"numa.o"}}
+
+#include "./numa.hpp"
+
+#include "src/os_services/error_handling/system_error.hpp"
+#include "src/os_services/fs/file.hpp"
+#include "src/os_services/io/io.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <climits>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+	using node_mask = std::array<unsigned long, (Pipe::os_services::memory::max_numa_node + 1)/(CHAR_BIT*sizeof(unsigned long))>;
+
+	node_mask make_node_mask_unchecked(Pipe::os_services::memory::numa_node node) noexcept
+	{
+		constexpr auto bits_per_item = CHAR_BIT*sizeof(unsigned long);
+		node_mask ret{};
+		ret[node.value()/bits_per_item] = 1ul << (node.value()%bits_per_item);
+		return ret;
+	}
+
+	node_mask make_node_mask(Pipe::os_services::memory::numa_node node)
+	{
+		if(node.value() > Pipe::os_services::memory::max_numa_node)
+		{ throw std::runtime_error{std::format("NUMA node {} is out of range", node.value())}; }
+
+		return make_node_mask_unchecked(node);
+	}
+
+	// The kernel drops the last bit of the mask, so pass one more than the number of bits
+	constexpr unsigned long node_mask_bits = CHAR_BIT*sizeof(node_mask) + 1;
+
+	std::string read_sysfs_file(std::filesystem::path const& path)
+	{
+		auto const file = Pipe::os_services::fs::open(path, Pipe::os_services::fs::open_mode::read_only);
+		std::string ret;
+		std::array<char, 4096> buffer;
+		while(true)
+		{
+			auto const res = Pipe::os_services::io::read(file.get(), std::as_writable_bytes(std::span{buffer}));
+			if(res.bytes_transferred() == 0)
+			{ return ret; }
+			ret.append(std::data(buffer), res.bytes_transferred());
+		}
+	}
+}
+
+std::expected<std::vector<unsigned int>, char const*>
+Pipe::os_services::memory::parse_cpu_list(std::string_view list)
+{
+	while(!list.empty() && (list.back() == '\n' || list.back() == ' '))
+	{ list.remove_suffix(1); }
+
+	std::vector<unsigned int> ret;
+	if(list.empty())
+	{ return ret; }
+
+	while(true)
+	{
+		auto const item_end = list.find(',');
+		auto const item = list.substr(0, item_end);
+
+		auto const separator = item.find('-');
+		auto const first_str = item.substr(0, separator);
+		unsigned int first{};
+		if(auto const res = std::from_chars(std::data(first_str), std::data(first_str) + std::size(first_str), first);
+			res.ec != std::errc{} || res.ptr != std::data(first_str) + std::size(first_str))
+		{ return std::unexpected("Expected a number"); }
+
+		auto last = first;
+		if(separator != std::string_view::npos)
+		{
+			auto const last_str = item.substr(separator + 1);
+			if(auto const res = std::from_chars(std::data(last_str), std::data(last_str) + std::size(last_str), last);
+				res.ec != std::errc{} || res.ptr != std::data(last_str) + std::size(last_str))
+			{ return std::unexpected("Expected a number"); }
+
+			if(last < first)
+			{ return std::unexpected("Range is reversed"); }
+		}
+
+		for(auto k = first; k <= last; ++k)
+		{ ret.push_back(k); }
+
+		if(item_end == std::string_view::npos)
+		{ return ret; }
+
+		list = list.substr(item_end + 1);
+	}
+}
+
+Pipe::os_services::memory::numa_node Pipe::os_services::memory::current_numa_node()
+{
+	unsigned int cpu{};
+	unsigned int node{};
+	if(::syscall(SYS_getcpu, &cpu, &node, nullptr) == -1)
+	{ throw error_handling::system_error{"Failed to get current NUMA node", errno}; }
+	return numa_node{node};
+}
+
+size_t Pipe::os_services::memory::numa_node_count()
+{
+	std::filesystem::path const path{"/sys/devices/system/node/online"};
+	if(!std::filesystem::exists(path))
+	{ return 1; }
+
+	auto const nodes = parse_cpu_list(read_sysfs_file(path));
+	if(!nodes.has_value())
+	{ throw std::runtime_error{std::format("Failed to parse {}: {}", path.string(), nodes.error())}; }
+
+	return std::max(std::size(*nodes), size_t{1});
+}
+
+cpu_set_t Pipe::os_services::memory::cpus_of(numa_node node)
+{
+	auto const path = std::filesystem::path{"/sys/devices/system/node"}
+		/std::format("node{}", node.value())
+		/"cpulist";
+
+	if(!std::filesystem::exists(path))
+	{
+		if(node.value() != 0 || std::filesystem::exists("/sys/devices/system/node"))
+		{ throw std::runtime_error{std::format("NUMA node {} does not exist", node.value())}; }
+
+		// Without NUMA support, all CPUs belong to node 0
+		cpu_set_t ret{};
+		if(::sched_getaffinity(0, sizeof(ret), &ret) == -1)
+		{ throw error_handling::system_error{"Failed to get CPU affinity", errno}; }
+		return ret;
+	}
+
+	auto const cpus = parse_cpu_list(read_sysfs_file(path));
+	if(!cpus.has_value())
+	{ throw std::runtime_error{std::format("Failed to parse {}: {}", path.string(), cpus.error())}; }
+
+	cpu_set_t ret{};
+	CPU_ZERO(&ret);
+	for(auto const cpu : *cpus)
+	{
+		if(cpu < CPU_SETSIZE)
+		{ CPU_SET(cpu, &ret); }
+	}
+	return ret;
+}
+
+void Pipe::os_services::memory::bind_to_numa_node(std::span<std::byte> region, numa_node node, numa_policy policy)
+{
+	if(region.empty())
+	{ return; }
+
+	auto const mask = make_node_mask(node);
+	auto const res = ::syscall(
+		SYS_mbind,
+		std::data(region),
+		std::size(region),
+		static_cast<int>(policy),
+		std::data(mask),
+		node_mask_bits,
+		MPOL_MF_MOVE
+	);
+	if(res == -1)
+	{ throw error_handling::system_error{std::format("Failed to bind memory to NUMA node {}", node.value()), errno}; }
+}
+
+namespace
+{
+	long set_mempolicy(Pipe::os_services::memory::numa_policy policy, node_mask const& mask) noexcept
+	{ return ::syscall(SYS_set_mempolicy, static_cast<int>(policy), std::data(mask), node_mask_bits); }
+}
+
+void Pipe::os_services::memory::set_thread_numa_policy(numa_node node, numa_policy policy)
+{
+	if(set_mempolicy(policy, make_node_mask(node)) == -1)
+	{ throw error_handling::system_error{std::format("Failed to set memory policy for NUMA node {}", node.value()), errno}; }
+}
+
+Pipe::os_services::memory::numa_binding::numa_binding(numa_node node):
+	m_node{node},
+	m_cpus{cpus_of(node)}
+{ std::ignore = make_node_mask(node); }
+
+int Pipe::os_services::memory::numa_binding::apply() const noexcept
+{
+	if(::sched_setaffinity(0, sizeof(m_cpus), &m_cpus) == -1)
+	{ return errno; }
+
+	// The node has been validated by the constructor
+	if(set_mempolicy(numa_policy::preferred, make_node_mask_unchecked(m_node)) == -1)
+	{ return errno; }
+
+	return 0;
+}
+
+void Pipe::os_services::memory::bind_current_thread_to_numa_node(numa_node node)
+{
+	if(auto const err = numa_binding{node}.apply(); err != 0)
+	{ throw error_handling::system_error{std::format("Failed to move thread to NUMA node {}", node.value()), err}; }
+}
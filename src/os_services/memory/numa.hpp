@@ -0,0 +1,134 @@
+//@	{"dependencies_extra":[{"ref":"./numa.o", "rel":"implementation"}]}
+
+#ifndef PIPE_OS_SERVICES_MEMORY_NUMA_HPP
+#define PIPE_OS_SERVICES_MEMORY_NUMA_HPP
+
+#include <cstddef>
+#include <expected>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <linux/mempolicy.h>
+#include <sched.h>
+
+namespace Pipe::os_services::memory
+{
+	/**
+	 * \brief Identifies a NUMA node
+	 */
+	class numa_node
+	{
+	public:
+		constexpr explicit numa_node(unsigned int value):
+			m_value{value}
+		{}
+
+		constexpr unsigned int value() const
+		{ return m_value; }
+
+		constexpr bool operator==(numa_node const&) const = default;
+
+	private:
+		unsigned int m_value;
+	};
+
+	/**
+	 * \brief The highest NUMA node that can be used with the functions in this file
+	 */
+	constexpr unsigned int max_numa_node = 1023;
+
+	/**
+	 * \brief Controls how strictly memory is allocated from a NUMA node
+	 */
+	enum class numa_policy
+	{
+		/**
+		 * \brief Memory is only allocated from the node
+		 */
+		bind = MPOL_BIND,
+
+		/**
+		 * \brief Memory is allocated from the node when possible, and from other nodes otherwise
+		 */
+		preferred = MPOL_PREFERRED
+	};
+
+	/**
+	 * \brief Parses a list of integers on the form used by sysfs, such as `0-3,8,10-11`
+	 */
+	std::expected<std::vector<unsigned int>, char const*> parse_cpu_list(std::string_view list);
+
+	/**
+	 * \brief Returns the NUMA node of the CPU the calling thread is currently running on
+	 */
+	numa_node current_numa_node();
+
+	/**
+	 * \brief Returns the number of NUMA nodes that are online
+	 *
+	 * If the system does not expose any NUMA information, it is treated as a single node system.
+	 */
+	size_t numa_node_count();
+
+	/**
+	 * \brief Returns the set of CPUs that belong to node
+	 * \throw std::runtime_error if node does not exist
+	 */
+	cpu_set_t cpus_of(numa_node node);
+
+	/**
+	 * \brief Sets the memory policy of the pages in region, so that they are allocated from node
+	 *
+	 * Pages that have already been touched are moved to node.
+	 *
+	 * \note region must be page aligned, which is the case for mapped_regions
+	 */
+	void bind_to_numa_node(std::span<std::byte> region, numa_node node, numa_policy policy = numa_policy::bind);
+
+	/**
+	 * \brief Sets the memory policy of the calling thread, so that new allocations are made from
+	 *        node
+	 *
+	 * The policy is inherited by child processes, and is kept across `execve`.
+	 */
+	void set_thread_numa_policy(numa_node node, numa_policy policy = numa_policy::preferred);
+
+	/**
+	 * \brief Makes a thread run on the CPUs of a NUMA node, and allocate memory from it
+	 *
+	 * All information is collected by the constructor, so apply does not allocate memory. Thus,
+	 * it can be used in a child process, between `fork` and `execve`.
+	 */
+	class numa_binding
+	{
+	public:
+		/**
+		 * \brief Constructs a numa_binding for node
+		 * \throw std::runtime_error if node does not exist
+		 */
+		explicit numa_binding(numa_node node);
+
+		/**
+		 * \brief Applies the binding to the calling thread
+		 * \return 0 on success, or the errno value of the first failed syscall
+		 */
+		int apply() const noexcept;
+
+		/**
+		 * \brief Returns the node of this binding
+		 */
+		numa_node node() const noexcept
+		{ return m_node; }
+
+	private:
+		numa_node m_node;
+		cpu_set_t m_cpus;
+	};
+
+	/**
+	 * \brief Makes the calling thread run on the CPUs of node only, and allocate memory from node
+	 */
+	void bind_current_thread_to_numa_node(numa_node node);
+}
+
+#endif
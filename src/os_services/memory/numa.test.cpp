@@ -0,0 +1,43 @@
+//@	{"target":{"name":"numa.test"}}
+
+#include "./numa.hpp"
+#include "./placement.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+TESTCASE(Pipe_os_services_memory_numa_parse_cpu_list)
+{
+	auto const res = Pipe::os_services::memory::parse_cpu_list("0-3,8,10-11\n");
+	REQUIRE_EQ(res.has_value(), true);
+	EXPECT_EQ((*res == std::vector<unsigned int>{0, 1, 2, 3, 8, 10, 11}), true);
+
+	EXPECT_EQ(Pipe::os_services::memory::parse_cpu_list("").value().empty(), true);
+	EXPECT_EQ(Pipe::os_services::memory::parse_cpu_list("1-").error(), std::string_view{"Expected a number"});
+	EXPECT_EQ(Pipe::os_services::memory::parse_cpu_list("a").error(), std::string_view{"Expected a number"});
+	EXPECT_EQ(Pipe::os_services::memory::parse_cpu_list("3-1").error(), std::string_view{"Range is reversed"});
+}
+
+TESTCASE(Pipe_os_services_memory_numa_current_node)
+{
+	auto const node = Pipe::os_services::memory::current_numa_node();
+	EXPECT_LT(node.value(), Pipe::os_services::memory::numa_node_count());
+
+	// The CPU this thread runs on belongs to the current node
+	auto const cpus = Pipe::os_services::memory::cpus_of(node);
+	EXPECT_NE(CPU_COUNT(&cpus), 0);
+	EXPECT_NE(CPU_ISSET(sched_getcpu(), &cpus), 0);
+}
+
+TESTCASE(Pipe_os_services_memory_numa_make_anonymous_region)
+{
+	auto const region = Pipe::os_services::memory::make_anonymous_region(
+		4096,
+		Pipe::os_services::memory::memory_placement{
+			.hugepages = Pipe::os_services::memory::hugepage_policy::explicit_pages,
+			.node = std::nullopt
+		}
+	);
+	REQUIRE_NE(region.data(), nullptr);
+	EXPECT_GE(region.size(), 4096);
+	region.bytes()[4095] = std::byte{1};
+}
@@ -0,0 +1,110 @@
+#ifndef PIPE_OS_SERVICES_MEMORY_PLACEMENT_HPP
+#define PIPE_OS_SERVICES_MEMORY_PLACEMENT_HPP
+
+#include "./mapped_region.hpp"
+#include "./numa.hpp"
+
+#include "src/os_services/error_handling/system_error.hpp"
+
+#include <optional>
+
+namespace Pipe::os_services::memory
+{
+	/**
+	 * \brief Controls whether or not memory should be backed by hugepages
+	 */
+	enum class hugepage_policy
+	{
+		/**
+		 * \brief Use normal pages
+		 */
+		none,
+
+		/**
+		 * \brief Ask the kernel to use transparent hugepages, when available
+		 */
+		transparent,
+
+		/**
+		 * \brief Use pages reserved in the hugetlb pool, through MAP_HUGETLB. Falls back to
+		 *        transparent hugepages if the pool is empty.
+		 */
+		explicit_pages
+	};
+
+	/**
+	 * \brief The size of a hugepage, when using hugepage_policy::explicit_pages
+	 */
+	constexpr size_t explicit_hugepage_size = 2*1024*1024;
+
+	/**
+	 * \brief Describes where memory should be placed
+	 */
+	struct memory_placement
+	{
+		/**
+		 * \brief Whether or not to use hugepages
+		 */
+		hugepage_policy hugepages = hugepage_policy::none;
+
+		/**
+		 * \brief The NUMA node to allocate memory from. If empty, the memory policy of the
+		 *        calling thread is used.
+		 */
+		std::optional<numa_node> node;
+	};
+
+	/**
+	 * \brief Applies placement to region
+	 *
+	 * This is useful for shared mappings, such as a mapped memfd, which are not created by
+	 * make_anonymous_region. Since MAP_HUGETLB can only be requested when a mapping is created,
+	 * hugepage_policy::explicit_pages is treated as hugepage_policy::transparent.
+	 */
+	inline void apply(memory_placement const& placement, mapped_region const& region)
+	{
+		if(region.data() == nullptr)
+		{ return; }
+
+		if(placement.hugepages != hugepage_policy::none)
+		{
+			// Transparent hugepages are only a hint, so failing to enable them is not an error
+			::madvise(region.data(), region.size(), MADV_HUGEPAGE);
+		}
+
+		if(placement.node.has_value())
+		{ bind_to_numa_node(region.bytes(), *placement.node); }
+	}
+
+	/**
+	 * \brief Creates an anonymous read-write mapping of at least size bytes, placed as specified
+	 *        by placement
+	 *
+	 * With hugepage_policy::explicit_pages, size is rounded up to a multiple of
+	 * explicit_hugepage_size.
+	 */
+	inline mapped_region make_anonymous_region(size_t size, memory_placement const& placement)
+	{
+		if(placement.hugepages == hugepage_policy::explicit_pages)
+		{
+			try
+			{
+				auto const rounded_size = explicit_hugepage_size*((size + explicit_hugepage_size - 1)/explicit_hugepage_size);
+				mapped_region ret{rounded_size, MAP_HUGETLB};
+				if(placement.node.has_value())
+				{ bind_to_numa_node(ret.bytes(), *placement.node); }
+				return ret;
+			}
+			catch(error_handling::system_error const&)
+			{
+				// No hugepages have been reserved. Continue with transparent hugepages.
+			}
+		}
+
+		mapped_region ret{size};
+		apply(placement, ret);
+		return ret;
+	}
+}
+
+#endif
@@ -0,0 +1,16 @@
+//@	{"target":{"name":"proc_mgmt.bench"}}
+
+#include "./proc_mgmt.hpp"
+#include "src/bench/bench.hpp"
+
+BENCHMARK(Pipe_os_services_proc_mgmt_spawn_rate, context)
+{
+	context.measure("spawn_rate", {}, [](uint64_t iterations) {
+		for(uint64_t k = 0; k != iterations; ++k)
+		{
+			auto const proc = Pipe::os_services::proc_mgmt::spawn("/usr/bin/true");
+			std::ignore = wait(proc.second.get());
+		}
+		return Pipe::bench::work_done{.items = iterations, .bytes = 0};
+	});
+}
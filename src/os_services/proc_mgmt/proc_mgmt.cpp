@@ -8,6 +8,7 @@
 #include "src/utils/utils.hpp"
 
 #include <cstdint>
+#include <fcntl.h>
 #include <linux/close_range.h>
 #include <unistd.h>
 #include <utility>
@@ -34,9 +35,19 @@ namespace
 		char* const* env,
 		Pipe::os_services::proc_mgmt::io_redirection const& io_redir,
 		Pipe::utils::immutable_flat_set<unsigned int> fds_to_keep,
+		std::optional<Pipe::os_services::memory::numa_binding> const& numa,
 		Pipe::os_services::io::output_file_descriptor_ref errstream
 	) noexcept
 	{
+		if(numa.has_value())
+		{
+			if(auto const err = numa->apply(); err != 0)
+			{
+				errno = err;
+				goto fail;
+			}
+		}
+
 		if(io_redir.sysin != nullptr)
 		{
 			if(::dup2(io_redir.sysin.get(), STDIN_FILENO) == -1)
@@ -54,6 +65,14 @@ namespace
 			{ goto fail; }
 		}
 
+		// File descriptors are created with FD_CLOEXEC set, so it has to be cleared for those that
+		// should be forwarded
+		for(auto const fd : fds_to_keep)
+		{
+			if(::fcntl(static_cast<int>(fd), F_SETFD, 0) == -1)
+			{ goto fail; }
+		}
+
 		for_each_disjoint_segment(
 			Pipe::utils::inclusive_integral_range{
 				.start_at = static_cast<unsigned int>(STDERR_FILENO + 1),
@@ -100,7 +119,8 @@ Pipe::os_services::proc_mgmt::spawn(
 	std::span<char const*> argv,
 	std::span<char const*> env,
 	io_redirection const& io_redir,
-	std::span<fd::file_descriptor> fds_to_forward
+	std::span<fd::file_descriptor> fds_to_forward,
+	std::optional<memory::numa_binding> const& numa
 )
 {
 	ipc::pipe exec_err_pipe;
@@ -137,6 +157,7 @@ Pipe::os_services::proc_mgmt::spawn(
 				std::data(env_out),
 				io_redir,
 				fds_to_keep,
+				numa,
 				exec_err_pipe.write_end()
 			);
 			exec_err_pipe.close_write_end();
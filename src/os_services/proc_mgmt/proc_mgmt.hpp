@@ -6,10 +6,12 @@
 #include "src/os_services/io/io.hpp"
 #include "src/os_services/fd/file_descriptor.hpp"
 #include "src/os_services/error_handling/system_error.hpp"
+#include "src/os_services/memory/numa.hpp"
 
 #include <csignal>
 #include <sys/wait.h>
 #include <filesystem>
+#include <optional>
 
 /**
  * \brief Process management
@@ -94,16 +96,26 @@ struct Pipe::os_services::fd::file_descriptor_deleter<Pipe::os_services::proc_mg
 		if(pid == nullptr)
 		{ return; }
 
-		if(::syscall(SYS_pidfd_send_signal, pid, SIGKILL, nullptr, 0) == -1)
-		{ return; }
-
-		siginfo_t siginfo{};
-		::waitid(P_PIDFD, pid, &siginfo, WEXITED);
+		// If the process has already been waited for, there is nothing to kill, but the pidfd
+		// must still be closed
+		if(::syscall(SYS_pidfd_send_signal, pid, SIGKILL, nullptr, 0) != -1)
+		{
+			siginfo_t siginfo{};
+			::waitid(P_PIDFD, pid, &siginfo, WEXITED);
+		}
 
 		::close(pid);
 	}
 };
 
+/**
+ * \brief A pidfd is reported readable when the process has terminated, so waiting for it does
+ *        not block once it has been signaled by an epoll_instance
+ */
+template<>
+struct Pipe::os_services::fd::is_nonblocking<Pipe::os_services::proc_mgmt::pidfd_tag> : std::true_type
+{};
+
 namespace Pipe::os_services::proc_mgmt
 {
 
@@ -136,13 +148,16 @@ namespace Pipe::os_services::proc_mgmt
 	 * \param io_redir An io_redirection object used to configure redirection of the standard streams.
 	 *
 	 * \param fds_to_forward A list of file descriptors to forward to the child process
+	 *
+	 * \param numa If set, the child process runs on, and allocates memory from, the given NUMA node
 	 */
 	std::pair<pid_t, pidfd> spawn(
 		char const* path,
 		std::span<char const*> argv = std::span<char const*>{},
 		std::span<char const*> env = std::span<char const*>{},
 		io_redirection const& io_redir = io_redirection{},
-		std::span<fd::file_descriptor> fds_to_forward = std::span<fd::file_descriptor>{}
+		std::span<fd::file_descriptor> fds_to_forward = std::span<fd::file_descriptor>{},
+		std::optional<memory::numa_binding> const& numa = std::nullopt
 	);
 
 	class process
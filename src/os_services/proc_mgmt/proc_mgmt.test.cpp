@@ -222,3 +222,19 @@ TESTCASE(Pipe_proc_mgmt_spawn_run_with_extra_fd)
 	EXPECT_NE(std::ranges::find(open_fds, STDERR_FILENO), std::end(open_fds));
 	EXPECT_NE(std::ranges::find(open_fds, fd_to_look_for), std::end(open_fds));
 }
+
+TESTCASE(Pipe_proc_mgmt_spawn_run_on_numa_node)
+{
+	auto const node = Pipe::os_services::memory::current_numa_node();
+	auto const proc = Pipe::os_services::proc_mgmt::spawn(
+		"/usr/bin/true",
+		std::span<char const*>{},
+		std::span<char const*>{},
+		Pipe::os_services::proc_mgmt::io_redirection{},
+		std::span<Pipe::os_services::fd::file_descriptor>{},
+		Pipe::os_services::memory::numa_binding{node}
+	);
+
+	auto res = wait(proc.second.get());
+	EXPECT_EQ(std::get<Pipe::os_services::proc_mgmt::process_exited>(res).return_value, 0);
+}
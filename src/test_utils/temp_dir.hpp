@@ -0,0 +1,52 @@
+#ifndef PIPE_TEST_UTILS_TEMP_DIR_HPP
+#define PIPE_TEST_UTILS_TEMP_DIR_HPP
+
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <stdlib.h>
+
+/**
+ * \brief Helpers shared by tests
+ */
+namespace Pipe::test_utils
+{
+	/**
+	 * \brief A directory in the system temporary directory, that is removed together with its
+	 *        contents when the temp_dir is destroyed
+	 */
+	class temp_dir
+	{
+	public:
+		/**
+		 * \brief Creates a new directory, whose name starts with prefix
+		 * \throw std::runtime_error if the directory could not be created
+		 */
+		explicit temp_dir(std::string_view prefix = "pipe")
+		{
+			std::string name_template = std::filesystem::temp_directory_path()/std::format("{}_XXXXXX", prefix);
+			if(mkdtemp(std::data(name_template)) == nullptr)
+			{ throw std::runtime_error{"Failed to create temporary directory"}; }
+			m_path = std::move(name_template);
+		}
+
+		temp_dir(temp_dir const&) = delete;
+		temp_dir& operator=(temp_dir const&) = delete;
+
+		~temp_dir()
+		{ std::filesystem::remove_all(m_path); }
+
+		/**
+		 * \brief Returns the path of the directory
+		 */
+		std::filesystem::path const& path() const noexcept
+		{ return m_path; }
+
+	private:
+		std::filesystem::path m_path;
+	};
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef PIPE_UTILS_HISTOGRAM_HPP
+#define PIPE_UTILS_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace Pipe::utils
+{
+	/**
+	 * \brief A histogram with logarithmically sized buckets
+	 *
+	 * Each power of two is split into sub_bucket_count linear buckets, so the relative error of
+	 * any recorded value is at most 1/sub_bucket_count, across the whole range of uint64_t.
+	 * Recording a value is a couple of bit operations and an increment, and the memory use is
+	 * fixed, which makes the histogram cheap enough to use on hot paths.
+	 */
+	class log_histogram
+	{
+	public:
+		/**
+		 * \brief The number of bits used to select a linear bucket within a power of two
+		 */
+		static constexpr size_t sub_bucket_bits = 3;
+
+		/**
+		 * \brief The number of linear buckets within each power of two
+		 */
+		static constexpr size_t sub_bucket_count = size_t{1} << sub_bucket_bits;
+
+		/**
+		 * \brief The total number of buckets
+		 */
+		static constexpr size_t bucket_count = (64 - sub_bucket_bits + 1)*sub_bucket_count;
+
+		/**
+		 * \brief Returns the index of the bucket that value belongs to
+		 */
+		static constexpr size_t bucket_index(uint64_t value) noexcept
+		{
+			if(value < sub_bucket_count)
+			{ return static_cast<size_t>(value); }
+
+			auto const exponent = static_cast<size_t>(std::bit_width(value)) - 1;
+			auto const shift = exponent - sub_bucket_bits;
+			auto const sub_bucket = static_cast<size_t>(value >> shift) & (sub_bucket_count - 1);
+			return (shift + 1)*sub_bucket_count + sub_bucket;
+		}
+
+		/**
+		 * \brief Returns the smallest value that belongs to the bucket at index
+		 */
+		static constexpr uint64_t bucket_lower_bound(size_t index) noexcept
+		{
+			if(index < sub_bucket_count)
+			{ return index; }
+
+			auto const shift = index/sub_bucket_count - 1;
+			auto const sub_bucket = index % sub_bucket_count;
+			return static_cast<uint64_t>(sub_bucket_count + sub_bucket) << shift;
+		}
+
+		/**
+		 * \brief Returns the largest value that belongs to the bucket at index
+		 */
+		static constexpr uint64_t bucket_upper_bound(size_t index) noexcept
+		{
+			if(index < sub_bucket_count)
+			{ return index; }
+
+			auto const shift = index/sub_bucket_count - 1;
+			return bucket_lower_bound(index) + ((uint64_t{1} << shift) - 1);
+		}
+
+		/**
+		 * \brief Records count occurrences of value
+		 */
+		constexpr void record(uint64_t value, uint64_t count = 1) noexcept
+		{
+			m_buckets[bucket_index(value)] += count;
+			m_count += count;
+			m_sum += value*count;
+			m_min = std::min(m_min, value);
+			m_max = std::max(m_max, value);
+		}
+
+		/**
+		 * \brief Adds all values recorded by other to this histogram
+		 */
+		constexpr void merge(log_histogram const& other) noexcept
+		{
+			for(size_t k = 0; k != bucket_count; ++k)
+			{ m_buckets[k] += other.m_buckets[k]; }
+			m_count += other.m_count;
+			m_sum += other.m_sum;
+			m_min = std::min(m_min, other.m_min);
+			m_max = std::max(m_max, other.m_max);
+		}
+
+		/**
+		 * \brief Removes all recorded values
+		 */
+		constexpr void reset() noexcept
+		{ *this = log_histogram{}; }
+
+		/**
+		 * \brief Returns the number of recorded values
+		 */
+		constexpr uint64_t count() const noexcept
+		{ return m_count; }
+
+		/**
+		 * \brief Returns the sum of all recorded values
+		 */
+		constexpr uint64_t sum() const noexcept
+		{ return m_sum; }
+
+		/**
+		 * \brief Returns the smallest recorded value, or 0 if no value has been recorded
+		 */
+		constexpr uint64_t min() const noexcept
+		{ return m_count == 0? 0 : m_min; }
+
+		/**
+		 * \brief Returns the largest recorded value
+		 */
+		constexpr uint64_t max() const noexcept
+		{ return m_max; }
+
+		/**
+		 * \brief Returns the mean of all recorded values, or 0 if no value has been recorded
+		 */
+		constexpr double mean() const noexcept
+		{ return m_count == 0? 0.0 : static_cast<double>(m_sum)/static_cast<double>(m_count); }
+
+		/**
+		 * \brief Returns an upper bound of the value below which a fraction q of all recorded
+		 *        values fall
+		 *
+		 * \param q The quantile, in the range [0, 1]. For example, 0.99 gives the 99th percentile.
+		 */
+		constexpr uint64_t value_at_quantile(double q) const noexcept
+		{
+			if(m_count == 0)
+			{ return 0; }
+
+			auto const rank = std::max(
+				static_cast<uint64_t>(std::clamp(q, 0.0, 1.0)*static_cast<double>(m_count) + 0.5),
+				uint64_t{1}
+			);
+			uint64_t accumulated = 0;
+			for(size_t k = 0; k != bucket_count; ++k)
+			{
+				accumulated += m_buckets[k];
+				if(accumulated >= rank)
+				{ return std::clamp(bucket_upper_bound(k), min(), m_max); }
+			}
+			return m_max;
+		}
+
+		/**
+		 * \brief Returns the number of values recorded in each bucket
+		 */
+		constexpr std::span<uint64_t const, bucket_count> buckets() const noexcept
+		{ return m_buckets; }
+
+	private:
+		std::array<uint64_t, bucket_count> m_buckets{};
+		uint64_t m_count{0};
+		uint64_t m_sum{0};
+		uint64_t m_min{std::numeric_limits<uint64_t>::max()};
+		uint64_t m_max{0};
+	};
+}
+
+#endif
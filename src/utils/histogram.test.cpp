@@ -0,0 +1,84 @@
+//@	{"target":{"name":"histogram.test"}}
+
+#include "./histogram.hpp"
+
+#include <testfwk/testfwk.hpp>
+
+TESTCASE(Pipe_utils_log_histogram_bucket_bounds)
+{
+	using histogram = Pipe::utils::log_histogram;
+	static_assert(histogram::bucket_index(0) == 0);
+	static_assert(histogram::bucket_index(7) == 7);
+	static_assert(histogram::bucket_index(8) == 8);
+	static_assert(histogram::bucket_index(16) == 16);
+	static_assert(histogram::bucket_index(17) == 16);
+	static_assert(histogram::bucket_index(~uint64_t{0}) == histogram::bucket_count - 1);
+	static_assert(histogram::bucket_upper_bound(histogram::bucket_count - 1) == ~uint64_t{0});
+
+	for(size_t k = 0; k != histogram::bucket_count; ++k)
+	{
+		auto const lower = histogram::bucket_lower_bound(k);
+		auto const upper = histogram::bucket_upper_bound(k);
+		EXPECT_EQ(histogram::bucket_index(lower), k);
+		EXPECT_EQ(histogram::bucket_index(upper), k);
+		if(k + 1 != histogram::bucket_count)
+		{ EXPECT_EQ(histogram::bucket_lower_bound(k + 1), upper + 1); }
+
+		// The width of a bucket is at most 1/8 of its lower bound
+		EXPECT_LE((upper - lower)*histogram::sub_bucket_count, std::max(lower, uint64_t{1}));
+	}
+}
+
+TESTCASE(Pipe_utils_log_histogram_empty)
+{
+	Pipe::utils::log_histogram const hist;
+	EXPECT_EQ(hist.count(), 0);
+	EXPECT_EQ(hist.min(), 0);
+	EXPECT_EQ(hist.max(), 0);
+	EXPECT_EQ(hist.mean(), 0.0);
+	EXPECT_EQ(hist.value_at_quantile(0.5), 0);
+}
+
+TESTCASE(Pipe_utils_log_histogram_record_and_quantiles)
+{
+	Pipe::utils::log_histogram hist;
+	for(uint64_t k = 1; k <= 1000; ++k)
+	{ hist.record(k*1000); }
+
+	EXPECT_EQ(hist.count(), 1000);
+	EXPECT_EQ(hist.min(), 1000);
+	EXPECT_EQ(hist.max(), 1000000);
+	EXPECT_EQ(hist.mean(), 500500.0);
+
+	auto const median = hist.value_at_quantile(0.5);
+	EXPECT_GE(median, 500000);
+	EXPECT_LE(median, 500000 + 500000/8);
+
+	auto const p99 = hist.value_at_quantile(0.99);
+	EXPECT_GE(p99, 990000);
+	EXPECT_LE(p99, 1000000);
+
+	EXPECT_EQ(hist.value_at_quantile(0.0), 1023);
+	EXPECT_EQ(hist.value_at_quantile(1.0), 1000000);
+}
+
+TESTCASE(Pipe_utils_log_histogram_merge_and_reset)
+{
+	Pipe::utils::log_histogram a;
+	a.record(10, 3);
+
+	Pipe::utils::log_histogram b;
+	b.record(5);
+	b.record(1000);
+
+	a.merge(b);
+	EXPECT_EQ(a.count(), 5);
+	EXPECT_EQ(a.sum(), 1035);
+	EXPECT_EQ(a.min(), 5);
+	EXPECT_EQ(a.max(), 1000);
+	EXPECT_EQ(a.buckets()[Pipe::utils::log_histogram::bucket_index(10)], 3);
+
+	a.reset();
+	EXPECT_EQ(a.count(), 0);
+	EXPECT_EQ(a.buckets()[Pipe::utils::log_histogram::bucket_index(10)], 0);
+}
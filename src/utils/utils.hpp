@@ -266,29 +266,44 @@ namespace Pipe::utils
 		size_t alignment;
 	};
 
-	template<size_t FieldCount>
-	constexpr struct_info<FieldCount> compute_struct_info(
-		std::array<struct_field_info, FieldCount> const& fields
+	/**
+	 * \brief Computes the offset of each field in a struct with the given fields, using the
+	 *        same rules as the compiler
+	 *
+	 * \param fields The size and alignment of each field
+	 * \param offsets Receives the offset of each field. It must have the same size as fields.
+	 * \return The size of the struct, including any trailing padding
+	 */
+	constexpr size_t compute_struct_layout(
+		std::span<struct_field_info const> fields,
+		std::span<size_t> offsets
 	)
 	{
-		struct_info<FieldCount> ret{};
-
 		size_t current_offset = 0;
 		size_t max_alignment = 1;
-		for(size_t k = 0; k != FieldCount; ++k)
+		for(size_t k = 0; k != std::size(fields); ++k)
 		{
 			max_alignment = std::max(max_alignment, fields[k].alignment);
 			current_offset = (
 				current_offset/fields[k].alignment + (current_offset % fields[k].alignment != 0)
 			)*fields[k].alignment;
 
-			ret.offsets[k] = current_offset;
+			offsets[k] = current_offset;
 			current_offset += fields[k].size;
 		}
 
-		ret.total_size = (
+		return (
 			current_offset/max_alignment + (current_offset % max_alignment != 0)
 		)*max_alignment;
+	}
+
+	template<size_t FieldCount>
+	constexpr struct_info<FieldCount> compute_struct_info(
+		std::array<struct_field_info, FieldCount> const& fields
+	)
+	{
+		struct_info<FieldCount> ret{};
+		ret.total_size = compute_struct_layout(fields, ret.offsets);
 		return ret;
 	}
 };
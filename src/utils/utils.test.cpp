@@ -372,4 +372,19 @@ TESTCASE(Pipe_utils_compute_struct_info)
 		EXPECT_EQ(result.offsets[1], 16);
 		EXPECT_EQ(result.total_size, 32);
 	}
-}
\ No newline at end of file
+}
+TESTCASE(Pipe_utils_compute_struct_layout)
+{
+	std::vector const fields{
+		Pipe::utils::struct_field_info{.size = 2, .alignment = 2},
+		Pipe::utils::struct_field_info{.size = 8, .alignment = 8},
+		Pipe::utils::struct_field_info{.size = 1, .alignment = 1}
+	};
+	std::vector<size_t> offsets(std::size(fields));
+
+	EXPECT_EQ(Pipe::utils::compute_struct_layout(fields, offsets), 24);
+	EXPECT_EQ(offsets[0], 0);
+	EXPECT_EQ(offsets[1], 8);
+	EXPECT_EQ(offsets[2], 16);
+	EXPECT_EQ(Pipe::utils::compute_struct_layout(std::span<Pipe::utils::struct_field_info const>{}, std::span<size_t>{}), 0);
+}